@@ -125,6 +125,9 @@ gst_rtp_h264_depay_init (GstRtpH264Depay * rtph264depay)
 {
   rtph264depay->adapter = gst_adapter_new ();
   rtph264depay->picture_adapter = gst_adapter_new ();
+  rtph264depay->sync_mem = gst_memory_new_wrapped (GST_MEMORY_FLAG_READONLY,
+      (gpointer) sync_bytes, sizeof (sync_bytes), 0, sizeof (sync_bytes),
+      NULL, NULL);
   rtph264depay->byte_stream = DEFAULT_BYTE_STREAM;
   rtph264depay->merge = DEFAULT_ACCESS_UNIT;
   rtph264depay->sps = g_ptr_array_new_with_free_func (
@@ -137,8 +140,10 @@ static void
 gst_rtp_h264_depay_reset (GstRtpH264Depay * rtph264depay)
 {
   gst_adapter_clear (rtph264depay->adapter);
+  rtph264depay->adapter_n_mem = 0;
   rtph264depay->wait_start = TRUE;
   gst_adapter_clear (rtph264depay->picture_adapter);
+  rtph264depay->picture_n_mem = 0;
   rtph264depay->picture_start = FALSE;
   rtph264depay->last_keyframe = FALSE;
   rtph264depay->last_ts = 0;
@@ -160,6 +165,7 @@ gst_rtp_h264_depay_finalize (GObject * object)
 
   g_object_unref (rtph264depay->adapter);
   g_object_unref (rtph264depay->picture_adapter);
+  gst_memory_unref (rtph264depay->sync_mem);
 
   g_ptr_array_free (rtph264depay->sps, TRUE);
   g_ptr_array_free (rtph264depay->pps, TRUE);
@@ -634,17 +640,66 @@ incomplete_caps:
   }
 }
 
+/* the start code or the 4 bytes NAL size that goes before a NAL unit */
+static GstMemory *
+gst_rtp_h264_depay_nal_prefix (GstRtpH264Depay * rtph264depay, guint nal_size)
+{
+  GstMemory *mem;
+  GstMapInfo map;
+
+  if (rtph264depay->byte_stream)
+    return gst_memory_ref (rtph264depay->sync_mem);
+
+  mem = gst_allocator_alloc (NULL, 4, NULL);
+  gst_memory_map (mem, &map, GST_MAP_WRITE);
+  GST_WRITE_UINT32_BE (map.data, nal_size);
+  gst_memory_unmap (mem, &map);
+
+  return mem;
+}
+
+/* make a NAL unit from @size bytes of the payload at @offset, the payload is
+ * not copied */
+static GstBuffer *
+gst_rtp_h264_depay_wrap_nal (GstRtpH264Depay * rtph264depay,
+    GstRTPBuffer * rtp, guint offset, guint size)
+{
+  GstBuffer *nal;
+
+  nal = gst_rtp_buffer_get_payload_subbuffer (rtp, offset, size);
+  gst_buffer_prepend_memory (nal,
+      gst_rtp_h264_depay_nal_prefix (rtph264depay, size));
+
+  return nal;
+}
+
+/* take everything from @adapter that holds @n_mem memory blocks. The memory
+ * is not copied unless there are more blocks than a buffer can hold, then it
+ * is merged once instead of every time the buffer overflows. */
+static GstBuffer *
+gst_rtp_h264_depay_take_all (GstAdapter * adapter, guint n_mem)
+{
+  gsize size;
+
+  size = gst_adapter_available (adapter);
+
+  if (n_mem > gst_buffer_get_max_memory ())
+    return gst_adapter_take_buffer (adapter, size);
+
+  return gst_adapter_take_buffer_fast (adapter, size);
+}
+
 static GstBuffer *
 gst_rtp_h264_complete_au (GstRtpH264Depay * rtph264depay,
     GstClockTime * out_timestamp, gboolean * out_keyframe)
 {
-  guint outsize;
   GstBuffer *outbuf;
 
   /* we had a picture in the adapter and we completed it */
   GST_DEBUG_OBJECT (rtph264depay, "taking completed AU");
-  outsize = gst_adapter_available (rtph264depay->picture_adapter);
-  outbuf = gst_adapter_take_buffer (rtph264depay->picture_adapter, outsize);
+  outbuf = gst_rtp_h264_depay_take_all (rtph264depay->picture_adapter,
+      rtph264depay->picture_n_mem);
+  rtph264depay->picture_n_mem = 0;
 
   *out_timestamp = rtph264depay->last_ts;
   *out_keyframe = rtph264depay->last_keyframe;
@@ -665,16 +720,18 @@ gst_rtp_h264_depay_handle_nal (GstRtpH264Depay * rtph264depay, GstBuffer * nal,
 {
   GstRTPBaseDepayload *depayload = GST_RTP_BASE_DEPAYLOAD (rtph264depay);
   gint nal_type;
-  GstMapInfo map;
+  guint8 header[6];
+  gsize size;
   GstBuffer *outbuf = NULL;
   GstClockTime out_timestamp;
   gboolean keyframe, out_keyframe;
 
-  gst_buffer_map (nal, &map, GST_MAP_READ);
-  if (G_UNLIKELY (map.size < 5))
+  /* only read the header, mapping would merge the memory blocks */
+  size = gst_buffer_extract (nal, 0, header, sizeof (header));
+  if (G_UNLIKELY (size < 5))
     goto short_nal;
 
-  nal_type = map.data[4] & 0x1f;
+  nal_type = header[4] & 0x1f;
   GST_DEBUG_OBJECT (rtph264depay, "handle NAL type %d", nal_type);
 
   keyframe = NAL_TYPE_IS_KEY (nal_type);
@@ -687,7 +744,6 @@ gst_rtp_h264_depay_handle_nal (GstRtpH264Depay * rtph264depay, GstBuffer * nal,
       gst_rtp_h264_depay_add_sps_pps (rtph264depay,
           gst_buffer_copy_region (nal, GST_BUFFER_COPY_ALL,
               4, gst_buffer_get_size (nal) - 4));
-      gst_buffer_unmap (nal, &map);
       gst_buffer_unref (nal);
       return NULL;
     } else if (rtph264depay->sps->len == 0 || rtph264depay->pps->len == 0) {
@@ -698,7 +754,6 @@ gst_rtp_h264_depay_handle_nal (GstRtpH264Depay * rtph264depay, GstBuffer * nal,
           gst_event_new_custom (GST_EVENT_CUSTOM_UPSTREAM,
               gst_structure_new ("GstForceKeyUnit",
                   "all-headers", G_TYPE_BOOLEAN, TRUE, NULL)));
-      gst_buffer_unmap (nal, &map);
       gst_buffer_unref (nal);
       return NULL;
     }
@@ -727,7 +782,7 @@ gst_rtp_h264_depay_handle_nal (GstRtpH264Depay * rtph264depay, GstBuffer * nal,
       if (nal_type == 1 || nal_type == 2 || nal_type == 5) {
         /* we have a picture start */
         start = TRUE;
-        if (map.data[5] & 0x80) {
+        if (size > 5 && (header[5] & 0x80)) {
           /* first_mb_in_slice == 0 completes a picture */
           complete = TRUE;
         }
@@ -742,9 +797,8 @@ gst_rtp_h264_depay_handle_nal (GstRtpH264Depay * rtph264depay, GstBuffer * nal,
             &out_keyframe);
     }
     /* add to adapter */
-    gst_buffer_unmap (nal, &map);
-
     GST_DEBUG_OBJECT (depayload, "adding NAL to picture adapter");
+    rtph264depay->picture_n_mem += gst_buffer_n_memory (nal);
     gst_adapter_push (rtph264depay->picture_adapter, nal);
     rtph264depay->last_ts = in_timestamp;
     rtph264depay->last_keyframe |= keyframe;
@@ -757,7 +811,6 @@ gst_rtp_h264_depay_handle_nal (GstRtpH264Depay * rtph264depay, GstBuffer * nal,
     /* no merge, output is input nal */
     GST_DEBUG_OBJECT (depayload, "using NAL as output");
     outbuf = nal;
-    gst_buffer_unmap (nal, &map);
   }
 
   if (outbuf) {
@@ -784,7 +837,6 @@ gst_rtp_h264_depay_handle_nal (GstRtpH264Depay * rtph264depay, GstBuffer * nal,
 short_nal:
   {
     GST_WARNING_OBJECT (depayload, "dropping short NAL");
-    gst_buffer_unmap (nal, &map);
     gst_buffer_unref (nal);
     return NULL;
   }
@@ -795,25 +847,18 @@ gst_rtp_h264_push_fragmentation_unit (GstRtpH264Depay * rtph264depay,
     gboolean send)
 {
   guint outsize;
-  GstMapInfo map;
   GstBuffer *outbuf;
 
   outsize = gst_adapter_available (rtph264depay->adapter);
-  outbuf = gst_adapter_take_buffer (rtph264depay->adapter, outsize);
+  /* one more memory block for the prefix */
+  outbuf = gst_rtp_h264_depay_take_all (rtph264depay->adapter,
+      rtph264depay->adapter_n_mem + 1);
+  rtph264depay->adapter_n_mem = 0;
 
-  gst_buffer_map (outbuf, &map, GST_MAP_WRITE);
   GST_DEBUG_OBJECT (rtph264depay, "output %d bytes", outsize);
 
-  if (rtph264depay->byte_stream) {
-    memcpy (map.data, sync_bytes, sizeof (sync_bytes));
-  } else {
-    outsize -= 4;
-    map.data[0] = (outsize >> 24);
-    map.data[1] = (outsize >> 16);
-    map.data[2] = (outsize >> 8);
-    map.data[3] = (outsize);
-  }
-  gst_buffer_unmap (outbuf, &map);
+  gst_buffer_prepend_memory (outbuf,
+      gst_rtp_h264_depay_nal_prefix (rtph264depay, outsize));
 
   rtph264depay->current_fu_type = 0;
 
@@ -840,6 +885,7 @@ gst_rtp_h264_depay_process (GstRTPBaseDepayload * depayload, GstBuffer * buf)
   /* flush remaining data on discont */
   if (GST_BUFFER_IS_DISCONT (buf)) {
     gst_adapter_clear (rtph264depay->adapter);
+    rtph264depay->adapter_n_mem = 0;
     rtph264depay->wait_start = TRUE;
     rtph264depay->current_fu_type = 0;
   }
@@ -849,8 +895,7 @@ gst_rtp_h264_depay_process (GstRTPBaseDepayload * depayload, GstBuffer * buf)
     guint8 *payload;
     guint header_len;
     guint8 nal_ref_idc;
-    GstMapInfo map;
-    guint outsize, nalu_size;
+    guint offset, outsize, nalu_size;
     GstClockTime timestamp;
     gboolean marker;
 
@@ -907,9 +952,11 @@ gst_rtp_h264_depay_process (GstRTPBaseDepayload * depayload, GstBuffer * buf)
         /* strip headers */
         payload += header_len;
         payload_len -= header_len;
+        offset = header_len;
 
         rtph264depay->wait_start = FALSE;
 
+        outbuf = gst_buffer_new ();
 
         /* STAP-A    Single-time aggregation packet     5.7.1 */
         while (payload_len > 2) {
@@ -925,34 +972,20 @@ gst_rtp_h264_depay_process (GstRTPBaseDepayload * depayload, GstBuffer * buf)
           if (nalu_size > (payload_len - 2))
             nalu_size = payload_len - 2;
 
-          outsize = nalu_size + sizeof (sync_bytes);
-          outbuf = gst_buffer_new_and_alloc (outsize);
-
-          gst_buffer_map (outbuf, &map, GST_MAP_WRITE);
-          if (rtph264depay->byte_stream) {
-            memcpy (map.data, sync_bytes, sizeof (sync_bytes));
-          } else {
-            map.data[0] = map.data[1] = 0;
-            map.data[2] = payload[0];
-            map.data[3] = payload[1];
-          }
-
           /* strip NALU size */
           payload += 2;
           payload_len -= 2;
+          offset += 2;
 
-          memcpy (map.data + sizeof (sync_bytes), payload, nalu_size);
-          gst_buffer_unmap (outbuf, &map);
-
-          gst_adapter_push (rtph264depay->adapter, outbuf);
+          outbuf = gst_buffer_append (outbuf,
+              gst_rtp_h264_depay_wrap_nal (rtph264depay, &rtp, offset,
+                  nalu_size));
 
           payload += nalu_size;
           payload_len -= nalu_size;
+          offset += nalu_size;
         }
 
-        outsize = gst_adapter_available (rtph264depay->adapter);
-        outbuf = gst_adapter_take_buffer (rtph264depay->adapter, outsize);
-
         outbuf = gst_rtp_h264_depay_handle_nal (rtph264depay, outbuf, timestamp,
             marker);
         break;
@@ -973,6 +1006,9 @@ gst_rtp_h264_depay_process (GstRTPBaseDepayload * depayload, GstBuffer * buf)
         /* FU-B      Fragmentation unit                 5.8 */
         gboolean S, E;
 
+        if (G_UNLIKELY (payload_len < 2))
+          goto short_packet;
+
         /* +---------------+
          * |0|1|2|3|4|5|6|7|
          * +-+-+-+-+-+-+-+-+
@@ -1007,23 +1043,18 @@ gst_rtp_h264_depay_process (GstRTPBaseDepayload * depayload, GstBuffer * buf)
           /* reconstruct NAL header */
           nal_header = (payload[0] & 0xe0) | (payload[1] & 0x1f);
 
-          /* strip type header, keep FU header, we'll reuse it to reconstruct
-           * the NAL header. */
-          payload += 1;
-          payload_len -= 1;
-
-          nalu_size = payload_len;
-          outsize = nalu_size + sizeof (sync_bytes);
-          outbuf = gst_buffer_new_and_alloc (outsize);
-
-          gst_buffer_map (outbuf, &map, GST_MAP_WRITE);
-          memcpy (map.data + sizeof (sync_bytes), payload, nalu_size);
-          map.data[sizeof (sync_bytes)] = nal_header;
-          gst_buffer_unmap (outbuf, &map);
+          /* strip off FU indicator and FU header bytes, the NAL header goes
+           * in its own memory block before the payload. */
+          outsize = payload_len - 1;
+          outbuf = gst_buffer_new_allocate (NULL, 1, NULL);
+          gst_buffer_fill (outbuf, 0, &nal_header, 1);
+          outbuf = gst_buffer_append (outbuf,
+              gst_rtp_buffer_get_payload_subbuffer (&rtp, 2, payload_len - 2));
 
           GST_DEBUG_OBJECT (rtph264depay, "queueing %d bytes", outsize);
 
           /* and assemble in the adapter */
+          rtph264depay->adapter_n_mem += gst_buffer_n_memory (outbuf);
           gst_adapter_push (rtph264depay->adapter, outbuf);
         } else {
           /* strip off FU indicator and FU header bytes */
@@ -1031,12 +1062,12 @@ gst_rtp_h264_depay_process (GstRTPBaseDepayload * depayload, GstBuffer * buf)
           payload_len -= 2;
 
           outsize = payload_len;
-          outbuf = gst_buffer_new_and_alloc (outsize);
-          gst_buffer_fill (outbuf, 0, payload, outsize);
+          outbuf = gst_rtp_buffer_get_payload_subbuffer (&rtp, 2, outsize);
 
           GST_DEBUG_OBJECT (rtph264depay, "queueing %d bytes", outsize);
 
           /* and assemble in the adapter */
+          rtph264depay->adapter_n_mem += gst_buffer_n_memory (outbuf);
           gst_adapter_push (rtph264depay->adapter, outbuf);
         }
 
@@ -1055,19 +1086,7 @@ gst_rtp_h264_depay_process (GstRTPBaseDepayload * depayload, GstBuffer * buf)
         /* 1-23   NAL unit  Single NAL unit packet per H.264   5.6 */
         /* the entire payload is the output buffer */
         nalu_size = payload_len;
-        outsize = nalu_size + sizeof (sync_bytes);
-        outbuf = gst_buffer_new_and_alloc (outsize);
-
-        gst_buffer_map (outbuf, &map, GST_MAP_WRITE);
-        if (rtph264depay->byte_stream) {
-          memcpy (map.data, sync_bytes, sizeof (sync_bytes));
-        } else {
-          map.data[0] = map.data[1] = 0;
-          map.data[2] = nalu_size >> 8;
-          map.data[3] = nalu_size & 0xff;
-        }
-        memcpy (map.data + sizeof (sync_bytes), payload, nalu_size);
-        gst_buffer_unmap (outbuf, &map);
+        outbuf = gst_rtp_h264_depay_wrap_nal (rtph264depay, &rtp, 0, nalu_size);
 
         outbuf = gst_rtp_h264_depay_handle_nal (rtph264depay, outbuf, timestamp,
             marker);
@@ -1086,6 +1105,12 @@ empty_packet:
     gst_rtp_buffer_unmap (&rtp);
     return NULL;
   }
+short_packet:
+  {
+    GST_WARNING_OBJECT (rtph264depay, "dropping short packet");
+    gst_rtp_buffer_unmap (&rtp);
+    return NULL;
+  }
 undefined_type:
   {
     GST_ELEMENT_WARNING (rtph264depay, STREAM, DECODE,
@@ -48,11 +48,16 @@ struct _GstRtpH264Depay
 
   GstBuffer  *codec_data;
   GstAdapter *adapter;
+  guint       adapter_n_mem;
   gboolean    wait_start;
 
+  /* shared start code memory */
+  GstMemory  *sync_mem;
+
   /* nal merging */
   gboolean    merge;
   GstAdapter *picture_adapter;
+  guint       picture_n_mem;
   gboolean    picture_start;
   GstClockTime last_ts;
   gboolean    last_keyframe;
@@ -36,6 +36,7 @@
 #define IDR_TYPE_ID  5
 #define SPS_TYPE_ID  7
 #define PPS_TYPE_ID  8
+#define STAP_A_TYPE_ID 24
 
 GST_DEBUG_CATEGORY_STATIC (rtph264pay_debug);
 #define GST_CAT_DEFAULT (rtph264pay_debug)
@@ -67,12 +68,14 @@ GST_STATIC_PAD_TEMPLATE ("src",
 
 #define DEFAULT_SPROP_PARAMETER_SETS    NULL
 #define DEFAULT_CONFIG_INTERVAL		      0
+#define DEFAULT_AGGREGATE               FALSE
 
 enum
 {
   PROP_0,
   PROP_SPROP_PARAMETER_SETS,
   PROP_CONFIG_INTERVAL,
+  PROP_AGGREGATE,
   PROP_LAST
 };
 
@@ -131,6 +134,27 @@ gst_rtp_h264_pay_class_init (GstRtpH264PayClass * klass)
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)
       );
 
+  /**
+   * GstRtpH264Pay:aggregate:
+   *
+   * Pack consecutive NAL units of the same access unit that fit in the MTU
+   * into STAP-A packets instead of sending each of them in its own packet.
+   * Aggregated packets are sent at the end of the access unit, when the next
+   * NAL unit does not fit anymore or when the timestamp changes.
+   *
+   * With byte-stream input that is not aligned to access units, the end of
+   * the access unit is only known from the marker flag on the input buffer.
+   * Without it, the last NAL units of an access unit are held back until the
+   * next access unit starts.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (G_OBJECT_CLASS (klass),
+      PROP_AGGREGATE,
+      g_param_spec_boolean ("aggregate", "Aggregate",
+          "Aggregate small NAL units of an access unit into STAP-A packets",
+          DEFAULT_AGGREGATE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gobject_class->finalize = gst_rtp_h264_pay_finalize;
 
   gst_element_class_add_pad_template (gstelement_class,
@@ -166,6 +190,7 @@ gst_rtp_h264_pay_init (GstRtpH264Pay * rtph264pay)
       (GDestroyNotify) gst_buffer_unref);
   rtph264pay->last_spspps = -1;
   rtph264pay->spspps_interval = DEFAULT_CONFIG_INTERVAL;
+  rtph264pay->aggregate = DEFAULT_AGGREGATE;
 
   rtph264pay->adapter = gst_adapter_new ();
 }
@@ -177,6 +202,19 @@ gst_rtp_h264_pay_clear_sps_pps (GstRtpH264Pay * rtph264pay)
   g_ptr_array_set_size (rtph264pay->pps, 0);
 }
 
+static void
+gst_rtp_h264_pay_clear_bundle (GstRtpH264Pay * rtph264pay)
+{
+  if (rtph264pay->bundle)
+    gst_buffer_unref (rtph264pay->bundle);
+  rtph264pay->bundle = NULL;
+  rtph264pay->bundle_size = 0;
+  rtph264pay->bundle_count = 0;
+  rtph264pay->bundle_nri = 0;
+  rtph264pay->bundle_f = 0;
+  rtph264pay->bundle_contains_vcl = FALSE;
+}
+
 static void
 gst_rtp_h264_pay_finalize (GObject * object)
 {
@@ -193,6 +231,8 @@ gst_rtp_h264_pay_finalize (GObject * object)
 
   g_object_unref (rtph264pay->adapter);
 
+  gst_rtp_h264_pay_clear_bundle (rtph264pay);
+
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
@@ -749,6 +789,128 @@ gst_rtp_h264_pay_send_sps_pps (GstRTPBasePayload * basepayload,
   return ret;
 }
 
+/* push the pending aggregated NAL units. A bundle of only one NAL unit is
+ * sent as a single NAL unit packet. */
+static GstFlowReturn
+gst_rtp_h264_pay_send_bundle (GstRTPBasePayload * basepayload,
+    gboolean end_of_au)
+{
+  GstRtpH264Pay *rtph264pay;
+  GstBuffer *bundle, *outbuf;
+  GstBufferList *list;
+  GstRTPBuffer rtp = { NULL };
+  guint8 *payload;
+
+  rtph264pay = GST_RTP_H264_PAY (basepayload);
+
+  if (rtph264pay->bundle == NULL)
+    return GST_FLOW_OK;
+
+  GST_DEBUG_OBJECT (rtph264pay, "sending bundle of %u NAL units, size %u",
+      rtph264pay->bundle_count, rtph264pay->bundle_size);
+
+  if (rtph264pay->bundle_count == 1) {
+    /* strip the 2 bytes size of the NAL unit */
+    bundle = gst_buffer_copy_region (rtph264pay->bundle,
+        GST_BUFFER_COPY_MEMORY, 2, -1);
+    outbuf = gst_rtp_buffer_new_allocate (0, 0, 0);
+    gst_rtp_buffer_map (outbuf, GST_MAP_WRITE, &rtp);
+  } else {
+    bundle = gst_buffer_ref (rtph264pay->bundle);
+    outbuf = gst_rtp_buffer_new_allocate (1, 0, 0);
+    gst_rtp_buffer_map (outbuf, GST_MAP_WRITE, &rtp);
+
+    /* STAP-A NAL header, F is set when any of the NAL units has it set and
+     * NRI is the highest of the NAL units */
+    payload = gst_rtp_buffer_get_payload (&rtp);
+    payload[0] = rtph264pay->bundle_f | rtph264pay->bundle_nri |
+        STAP_A_TYPE_ID;
+  }
+
+  /* only set the marker bit on packets containing access units */
+  if (rtph264pay->bundle_contains_vcl && end_of_au)
+    gst_rtp_buffer_set_marker (&rtp, 1);
+
+  gst_rtp_buffer_unmap (&rtp);
+
+  GST_BUFFER_PTS (outbuf) = rtph264pay->bundle_pts;
+  GST_BUFFER_DTS (outbuf) = rtph264pay->bundle_dts;
+
+  gst_rtp_h264_pay_clear_bundle (rtph264pay);
+
+  /* insert payload memory blocks */
+  outbuf = gst_buffer_append (outbuf, bundle);
+
+  list = gst_buffer_list_new ();
+  gst_buffer_list_add (list, outbuf);
+
+  return gst_rtp_base_payload_push_list (basepayload, list);
+}
+
+/* add a NAL unit that fits in a STAP-A packet to the pending bundle, the
+ * bundle is sent first when the NAL unit belongs to another access unit or
+ * when it would not fit anymore. Takes ownership of @paybuf. */
+static GstFlowReturn
+gst_rtp_h264_pay_bundle_nal (GstRTPBasePayload * basepayload,
+    GstBuffer * paybuf, GstClockTime dts, GstClockTime pts, gboolean end_of_au,
+    guint8 nalHeader)
+{
+  GstRtpH264Pay *rtph264pay;
+  GstFlowReturn ret = GST_FLOW_OK;
+  GstBuffer *sizebuf;
+  guint8 sizehdr[2];
+  guint size, max_size;
+
+  rtph264pay = GST_RTP_H264_PAY (basepayload);
+  size = gst_buffer_get_size (paybuf);
+  max_size =
+      gst_rtp_buffer_calc_payload_len (GST_RTP_BASE_PAYLOAD_MTU (basepayload),
+      0, 0);
+
+  if (rtph264pay->bundle) {
+    if (rtph264pay->bundle_pts != pts) {
+      GST_DEBUG_OBJECT (rtph264pay, "timestamp changed, sending bundle");
+      ret = gst_rtp_h264_pay_send_bundle (basepayload, FALSE);
+    } else if (rtph264pay->bundle_size + 2 + size > max_size) {
+      GST_DEBUG_OBJECT (rtph264pay, "NAL unit does not fit, sending bundle");
+      ret = gst_rtp_h264_pay_send_bundle (basepayload, FALSE);
+    }
+    if (ret != GST_FLOW_OK) {
+      gst_buffer_unref (paybuf);
+      return ret;
+    }
+  }
+
+  if (rtph264pay->bundle == NULL) {
+    rtph264pay->bundle = gst_buffer_new ();
+    /* the STAP-A NAL header */
+    rtph264pay->bundle_size = 1;
+    rtph264pay->bundle_dts = dts;
+    rtph264pay->bundle_pts = pts;
+  }
+
+  GST_DEBUG_OBJECT (rtph264pay, "adding NAL unit of size %u to bundle", size);
+
+  sizehdr[0] = size >> 8;
+  sizehdr[1] = size & 0xff;
+  sizebuf = gst_buffer_new_allocate (NULL, 2, NULL);
+  gst_buffer_fill (sizebuf, 0, sizehdr, 2);
+
+  rtph264pay->bundle = gst_buffer_append (rtph264pay->bundle, sizebuf);
+  rtph264pay->bundle = gst_buffer_append (rtph264pay->bundle, paybuf);
+  rtph264pay->bundle_size += 2 + size;
+  rtph264pay->bundle_count++;
+  rtph264pay->bundle_nri = MAX (rtph264pay->bundle_nri, nalHeader & 0x60);
+  rtph264pay->bundle_f |= nalHeader & 0x80;
+  if (IS_ACCESS_UNIT (nalHeader & 0x1f))
+    rtph264pay->bundle_contains_vcl = TRUE;
+
+  if (end_of_au)
+    ret = gst_rtp_h264_pay_send_bundle (basepayload, TRUE);
+
+  return ret;
+}
+
 static GstFlowReturn
 gst_rtp_h264_pay_payload_nal (GstRTPBasePayload * basepayload,
     GstBuffer * paybuf, GstClockTime dts, GstClockTime pts, gboolean end_of_au)
@@ -821,6 +983,20 @@ gst_rtp_h264_pay_payload_nal (GstRTPBasePayload * basepayload,
       return ret;
   }
 
+  /* aggregate when the NAL unit fits in a STAP-A packet with its 1 byte
+   * NAL header and 2 bytes size */
+  if (rtph264pay->aggregate
+      && gst_rtp_buffer_calc_packet_len (size + 3, 0, 0) <= mtu)
+    return gst_rtp_h264_pay_bundle_nal (basepayload, paybuf, dts, pts,
+        end_of_au, nalHeader);
+
+  /* keep the order, send what we aggregated before this NAL unit */
+  ret = gst_rtp_h264_pay_send_bundle (basepayload, FALSE);
+  if (ret != GST_FLOW_OK) {
+    gst_buffer_unref (paybuf);
+    return ret;
+  }
+
   packet_len = gst_rtp_buffer_calc_packet_len (size, 0, 0);
 
   if (packet_len < mtu) {
@@ -946,6 +1122,7 @@ gst_rtp_h264_pay_handle_buffer (GstRTPBasePayload * basepayload,
   gboolean avc;
   GstBuffer *paybuf = NULL;
   gsize skip;
+  gboolean marker = FALSE;
 
   rtph264pay = GST_RTP_H264_PAY (basepayload);
 
@@ -971,6 +1148,10 @@ gst_rtp_h264_pay_handle_buffer (GstRTPBasePayload * basepayload,
         dts = GST_BUFFER_DTS (buffer);
       if (!GST_CLOCK_TIME_IS_VALID (pts))
         pts = GST_BUFFER_PTS (buffer);
+      /* with aggregation, the buffer can end an access unit and we don't
+       * wait for the next one */
+      if (rtph264pay->aggregate)
+        marker = GST_BUFFER_FLAG_IS_SET (buffer, GST_BUFFER_FLAG_MARKER);
 
       gst_adapter_push (rtph264pay->adapter, buffer);
     }
@@ -986,10 +1167,8 @@ gst_rtp_h264_pay_handle_buffer (GstRTPBasePayload * basepayload,
 
   ret = GST_FLOW_OK;
 
-  /* now loop over all NAL units and put them in a packet
-   * FIXME, we should really try to pack multiple NAL units into one RTP packet
-   * if we can, especially for the config packets that wont't cause decoder 
-   * latency. */
+  /* now loop over all NAL units and put them in a packet, small NAL units
+   * are packed into STAP-A packets when aggregation is enabled */
   if (avc) {
     guint nal_length_size;
     gsize offset = 0;
@@ -1073,9 +1252,9 @@ gst_rtp_h264_pay_handle_buffer (GstRTPBasePayload * basepayload,
        */
       next = next_start_code (data, size);
 
-      if (next == size && buffer != NULL) {
-        /* Didn't find the start of next NAL and it's not EOS,
-         * handle it next time */
+      if (next == size && buffer != NULL && !marker) {
+        /* Didn't find the start of next NAL and it's not EOS or the end of
+         * an access unit, handle it next time */
         break;
       }
 
@@ -1140,7 +1319,7 @@ gst_rtp_h264_pay_handle_buffer (GstRTPBasePayload * basepayload,
        * trailing 0x0 that can be discarded */
       size = nal_len;
       data = gst_adapter_map (rtph264pay->adapter, size);
-      if (i + 1 != nal_queue->len || buffer != NULL)
+      if (i + 1 != nal_queue->len || (buffer != NULL && !marker))
         for (; size > 1 && data[size - 1] == 0x0; size--)
           /* skip */ ;
 
@@ -1152,8 +1331,8 @@ gst_rtp_h264_pay_handle_buffer (GstRTPBasePayload * basepayload,
        * actually payload the NAL so we can know if the current NAL is
        * the last one of an access unit or not if we are in bytestream mode
        */
-      if ((rtph264pay->alignment == GST_H264_ALIGNMENT_AU || buffer == NULL) &&
-          i == nal_queue->len - 1)
+      if ((rtph264pay->alignment == GST_H264_ALIGNMENT_AU || buffer == NULL
+              || marker) && i == nal_queue->len - 1)
         end_of_au = TRUE;
       paybuf = gst_adapter_take_buffer (rtph264pay->adapter, size);
       g_assert (paybuf);
@@ -1202,6 +1381,7 @@ gst_rtp_h264_pay_sink_event (GstRTPBasePayload * payload, GstEvent * event)
   switch (GST_EVENT_TYPE (event)) {
     case GST_EVENT_FLUSH_STOP:
       gst_adapter_clear (rtph264pay->adapter);
+      gst_rtp_h264_pay_clear_bundle (rtph264pay);
       break;
     case GST_EVENT_CUSTOM_DOWNSTREAM:
       s = gst_event_get_structure (event);
@@ -1219,6 +1399,8 @@ gst_rtp_h264_pay_sink_event (GstRTPBasePayload * payload, GstEvent * event)
        * in byte-stream mode
        */
       gst_rtp_h264_pay_handle_buffer (payload, NULL);
+      /* and whatever is still aggregated */
+      gst_rtp_h264_pay_send_bundle (payload, TRUE);
       break;
     }
     case GST_EVENT_STREAM_START:
@@ -1244,10 +1426,12 @@ gst_rtp_h264_pay_change_state (GstElement * element, GstStateChange transition)
     case GST_STATE_CHANGE_READY_TO_PAUSED:
       rtph264pay->send_spspps = FALSE;
       gst_adapter_clear (rtph264pay->adapter);
+      gst_rtp_h264_pay_clear_bundle (rtph264pay);
       break;
     case GST_STATE_CHANGE_PAUSED_TO_READY:
       rtph264pay->last_spspps = -1;
       gst_rtp_h264_pay_clear_sps_pps (rtph264pay);
+      gst_rtp_h264_pay_clear_bundle (rtph264pay);
       break;
     default:
       break;
@@ -1275,6 +1459,9 @@ gst_rtp_h264_pay_set_property (GObject * object, guint prop_id,
     case PROP_CONFIG_INTERVAL:
       rtph264pay->spspps_interval = g_value_get_uint (value);
       break;
+    case PROP_AGGREGATE:
+      rtph264pay->aggregate = g_value_get_boolean (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -1296,6 +1483,9 @@ gst_rtp_h264_pay_get_property (GObject * object, guint prop_id,
     case PROP_CONFIG_INTERVAL:
       g_value_set_uint (value, rtph264pay->spspps_interval);
       break;
+    case PROP_AGGREGATE:
+      g_value_set_boolean (value, rtph264pay->aggregate);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -74,6 +74,16 @@ struct _GstRtpH264Pay
   guint spspps_interval;
   gboolean send_spspps;
   GstClockTime last_spspps;
+
+  /* STAP-A aggregation */
+  gboolean aggregate;
+  GstBuffer *bundle;
+  guint bundle_size;
+  guint bundle_count;
+  guint8 bundle_nri;
+  guint8 bundle_f;
+  gboolean bundle_contains_vcl;
+  GstClockTime bundle_dts, bundle_pts;
 };
 
 struct _GstRtpH264PayClass
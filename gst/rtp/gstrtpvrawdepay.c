@@ -46,6 +46,31 @@ GST_STATIC_PAD_TEMPLATE ("sink",
         "clock-rate = (int) 90000, " "encoding-name = (string) \"RAW\"")
     );
 
+#define DEFAULT_N_THREADS 1
+
+enum
+{
+  PROP_0,
+  PROP_N_THREADS,
+  PROP_LAST
+};
+
+/* a line segment of a packet to write into the frame */
+typedef struct
+{
+  const guint8 *data;
+  guint length;
+  guint line;
+  guint offs;
+} GstRtpVRawSegment;
+
+/* a range of segments written by one thread */
+typedef struct
+{
+  guint first;
+  guint count;
+} GstRtpVRawJob;
+
 #define gst_rtp_vraw_depay_parent_class parent_class
 G_DEFINE_TYPE (GstRtpVRawDepay, gst_rtp_vraw_depay,
     GST_TYPE_RTP_BASE_DEPAYLOAD);
@@ -61,15 +86,46 @@ static GstStateChangeReturn gst_rtp_vraw_depay_change_state (GstElement *
 static gboolean gst_rtp_vraw_depay_handle_event (GstRTPBaseDepayload * filter,
     GstEvent * event);
 
+static GstFlowReturn gst_rtp_vraw_depay_chain_list (GstPad * pad,
+    GstObject * parent, GstBufferList * list);
+
+static void gst_rtp_vraw_depay_finalize (GObject * object);
+static void gst_rtp_vraw_depay_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec);
+static void gst_rtp_vraw_depay_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec);
+
 static void
 gst_rtp_vraw_depay_class_init (GstRtpVRawDepayClass * klass)
 {
+  GObjectClass *gobject_class;
   GstElementClass *gstelement_class;
   GstRTPBaseDepayloadClass *gstrtpbasedepayload_class;
 
+  gobject_class = (GObjectClass *) klass;
   gstelement_class = (GstElementClass *) klass;
   gstrtpbasedepayload_class = (GstRTPBaseDepayloadClass *) klass;
 
+  gobject_class->finalize = gst_rtp_vraw_depay_finalize;
+  gobject_class->set_property = gst_rtp_vraw_depay_set_property;
+  gobject_class->get_property = gst_rtp_vraw_depay_get_property;
+
+  /**
+   * GstRtpVRawDepay:n-threads:
+   *
+   * The number of threads that write the lines of the packets of a buffer
+   * list into the frame. Lines are independent so the packets of a list are
+   * split over the threads. With 1, all lines are written by the streaming
+   * thread as the packets arrive.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (gobject_class, PROP_N_THREADS,
+      g_param_spec_uint ("n-threads", "Number of threads",
+          "Number of threads to write the lines of buffer lists with",
+          1, 64, DEFAULT_N_THREADS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gstelement_class->change_state = gst_rtp_vraw_depay_change_state;
 
   gstrtpbasedepayload_class->set_caps = gst_rtp_vraw_depay_setcaps;
@@ -93,16 +149,67 @@ gst_rtp_vraw_depay_class_init (GstRtpVRawDepayClass * klass)
 static void
 gst_rtp_vraw_depay_init (GstRtpVRawDepay * rtpvrawdepay)
 {
+  GstPad *sinkpad = GST_RTP_BASE_DEPAYLOAD_SINKPAD (rtpvrawdepay);
+
+  rtpvrawdepay->n_threads = DEFAULT_N_THREADS;
+  rtpvrawdepay->segments =
+      g_array_new (FALSE, FALSE, sizeof (GstRtpVRawSegment));
+  rtpvrawdepay->packets = g_array_new (FALSE, FALSE, sizeof (GstRTPBuffer));
+  g_mutex_init (&rtpvrawdepay->lock);
+  g_cond_init (&rtpvrawdepay->cond);
+
+  /* buffers of a list go through the chain function of the base class */
+  rtpvrawdepay->chain = GST_PAD_CHAINFUNC (sinkpad);
+  gst_pad_set_chain_list_function (sinkpad, gst_rtp_vraw_depay_chain_list);
+}
+
+static void
+gst_rtp_vraw_depay_finalize (GObject * object)
+{
+  GstRtpVRawDepay *rtpvrawdepay = GST_RTP_VRAW_DEPAY (object);
+
+  if (rtpvrawdepay->workers)
+    g_thread_pool_free (rtpvrawdepay->workers, FALSE, TRUE);
+  g_free (rtpvrawdepay->jobs);
+  g_array_free (rtpvrawdepay->segments, TRUE);
+  g_array_free (rtpvrawdepay->packets, TRUE);
+  g_mutex_clear (&rtpvrawdepay->lock);
+  g_cond_clear (&rtpvrawdepay->cond);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+/* release the packets whose segments were queued */
+static void
+gst_rtp_vraw_depay_release_packets (GstRtpVRawDepay * rtpvrawdepay)
+{
+  guint i;
+
+  for (i = 0; i < rtpvrawdepay->packets->len; i++) {
+    GstRTPBuffer *rtp = &g_array_index (rtpvrawdepay->packets, GstRTPBuffer, i);
+    GstBuffer *buffer = rtp->buffer;
+
+    gst_rtp_buffer_unmap (rtp);
+    gst_buffer_unref (buffer);
+  }
+  g_array_set_size (rtpvrawdepay->packets, 0);
+  g_array_set_size (rtpvrawdepay->segments, 0);
 }
 
 static void
 gst_rtp_vraw_depay_reset (GstRtpVRawDepay * rtpvrawdepay)
 {
+  gst_rtp_vraw_depay_release_packets (rtpvrawdepay);
+  if (rtpvrawdepay->frame_mapped) {
+    gst_video_frame_unmap (&rtpvrawdepay->frame);
+    rtpvrawdepay->frame_mapped = FALSE;
+  }
   if (rtpvrawdepay->outbuf) {
     gst_buffer_unref (rtpvrawdepay->outbuf);
     rtpvrawdepay->outbuf = NULL;
   }
   rtpvrawdepay->timestamp = -1;
+  rtpvrawdepay->field = 0;
   if (rtpvrawdepay->pool) {
     gst_buffer_pool_set_active (rtpvrawdepay->pool, FALSE);
     gst_object_unref (rtpvrawdepay->pool);
@@ -172,6 +279,7 @@ gst_rtp_vraw_depay_setcaps (GstRTPBaseDepayload * depayload, GstCaps * caps)
   gint clock_rate;
   const gchar *str;
   gint format, width, height, depth, pgroup, xinc, yinc;
+  gboolean interlaced;
   GstCaps *srccaps;
   gboolean res;
   GstFlowReturn ret;
@@ -198,10 +306,9 @@ gst_rtp_vraw_depay_setcaps (GstRTPBaseDepayload * depayload, GstCaps * caps)
     goto no_depth;
   depth = atoi (str);
 
-  /* optional interlace value but we don't handle interlaced
-   * formats yet */
-  if (gst_structure_get_string (structure, "interlace"))
-    goto interlaced;
+  /* optional interlace value, the fields are sent one after the other and
+   * written interleaved into one frame */
+  interlaced = gst_structure_get_string (structure, "interlace") != NULL;
 
   if (!(str = gst_structure_get_string (structure, "sampling")))
     goto no_sampling;
@@ -244,6 +351,9 @@ gst_rtp_vraw_depay_setcaps (GstRTPBaseDepayload * depayload, GstCaps * caps)
 
   gst_video_info_init (&rtpvrawdepay->vinfo);
   gst_video_info_set_format (&rtpvrawdepay->vinfo, format, width, height);
+  if (interlaced)
+    GST_VIDEO_INFO_INTERLACE_MODE (&rtpvrawdepay->vinfo) =
+        GST_VIDEO_INTERLACE_MODE_INTERLEAVED;
   GST_VIDEO_INFO_FPS_N (&rtpvrawdepay->vinfo) = 0;
   GST_VIDEO_INFO_FPS_D (&rtpvrawdepay->vinfo) = 1;
 
@@ -283,11 +393,6 @@ no_depth:
     GST_ERROR_OBJECT (depayload, "no depth specified");
     return FALSE;
   }
-interlaced:
-  {
-    GST_ERROR_OBJECT (depayload, "interlaced formats not supported yet");
-    return FALSE;
-  }
 no_sampling:
   {
     GST_ERROR_OBJECT (depayload, "no sampling specified");
@@ -305,17 +410,241 @@ no_bufferpool:
   }
 }
 
+/* write a line segment into @frame */
+static void
+gst_rtp_vraw_depay_write_segment (GstRtpVRawDepay * rtpvrawdepay,
+    GstVideoFrame * frame, const GstRtpVRawSegment * seg)
+{
+  guint8 *yp, *up, *vp, *datap;
+  const guint8 *payload;
+  guint ystride, uvstride, pgroup, plen, line, offs;
+  gint xinc, yinc;
+
+  /* get pointer and strides of the planes */
+  yp = GST_VIDEO_FRAME_COMP_DATA (frame, 0);
+  up = GST_VIDEO_FRAME_COMP_DATA (frame, 1);
+  vp = GST_VIDEO_FRAME_COMP_DATA (frame, 2);
+
+  ystride = GST_VIDEO_FRAME_COMP_STRIDE (frame, 0);
+  uvstride = GST_VIDEO_FRAME_COMP_STRIDE (frame, 1);
+
+  pgroup = rtpvrawdepay->pgroup;
+  xinc = rtpvrawdepay->xinc;
+  yinc = rtpvrawdepay->yinc;
+
+  payload = seg->data;
+  plen = seg->length;
+  line = seg->line;
+  offs = seg->offs;
+
+  switch (GST_VIDEO_INFO_FORMAT (&rtpvrawdepay->vinfo)) {
+    case GST_VIDEO_FORMAT_RGB:
+    case GST_VIDEO_FORMAT_RGBA:
+    case GST_VIDEO_FORMAT_BGR:
+    case GST_VIDEO_FORMAT_BGRA:
+    case GST_VIDEO_FORMAT_UYVY:
+    case GST_VIDEO_FORMAT_UYVP:
+      /* samples are packed just like gstreamer packs them */
+      offs /= xinc;
+      datap = yp + (line * ystride) + (offs * pgroup);
+
+      memcpy (datap, payload, plen);
+      break;
+    case GST_VIDEO_FORMAT_AYUV:
+    {
+      gint i;
+      const guint8 *p;
+
+      datap = yp + (line * ystride) + (offs * 4);
+      p = payload;
+
+      /* samples are packed in order Cb-Y-Cr for both interlaced and
+       * progressive frames */
+      for (i = 0; i < plen; i += pgroup) {
+        *datap++ = 0;
+        *datap++ = p[1];
+        *datap++ = p[0];
+        *datap++ = p[2];
+        p += pgroup;
+      }
+      break;
+    }
+    case GST_VIDEO_FORMAT_I420:
+    {
+      gint i;
+      guint uvoff;
+      guint8 *yd1p, *yd2p, *udp, *vdp;
+      const guint8 *p;
+
+      yd1p = yp + (line * ystride) + (offs);
+      yd2p = yd1p + ystride;
+      uvoff = (line / yinc * uvstride) + (offs / xinc);
+
+      udp = up + uvoff;
+      vdp = vp + uvoff;
+      p = payload;
+
+      /* line 0/1: Y00-Y01-Y10-Y11-Cb00-Cr00 Y02-Y03-Y12-Y13-Cb01-Cr01 ...  */
+      for (i = 0; i < plen; i += pgroup) {
+        *yd1p++ = p[0];
+        *yd1p++ = p[1];
+        *yd2p++ = p[2];
+        *yd2p++ = p[3];
+        *udp++ = p[4];
+        *vdp++ = p[5];
+        p += pgroup;
+      }
+      break;
+    }
+    case GST_VIDEO_FORMAT_Y41B:
+    {
+      gint i;
+      guint uvoff;
+      guint8 *ydp, *udp, *vdp;
+      const guint8 *p;
+
+      ydp = yp + (line * ystride) + (offs);
+      uvoff = (line / yinc * uvstride) + (offs / xinc);
+
+      udp = up + uvoff;
+      vdp = vp + uvoff;
+      p = payload;
+
+      /* Samples are packed in order Cb0-Y0-Y1-Cr0-Y2-Y3 for both interlaced
+       * and progressive scan lines */
+      for (i = 0; i < plen; i += pgroup) {
+        *udp++ = p[0];
+        *ydp++ = p[1];
+        *ydp++ = p[2];
+        *vdp++ = p[3];
+        *ydp++ = p[4];
+        *ydp++ = p[5];
+        p += pgroup;
+      }
+      break;
+    }
+    default:
+      /* the caps only accept the formats above */
+      g_assert_not_reached ();
+      break;
+  }
+}
+
+static void
+gst_rtp_vraw_depay_write_job (GstRtpVRawDepay * rtpvrawdepay,
+    GstRtpVRawJob * job)
+{
+  guint i;
+
+  for (i = job->first; i < job->first + job->count; i++)
+    gst_rtp_vraw_depay_write_segment (rtpvrawdepay, &rtpvrawdepay->frame,
+        &g_array_index (rtpvrawdepay->segments, GstRtpVRawSegment, i));
+}
+
+static void
+gst_rtp_vraw_depay_worker (GstRtpVRawJob * job, GstRtpVRawDepay * rtpvrawdepay)
+{
+  gst_rtp_vraw_depay_write_job (rtpvrawdepay, job);
+
+  g_mutex_lock (&rtpvrawdepay->lock);
+  if (--rtpvrawdepay->pending == 0)
+    g_cond_signal (&rtpvrawdepay->cond);
+  g_mutex_unlock (&rtpvrawdepay->lock);
+}
+
+/* write all queued segments into the frame, split over the worker threads
+ * and the calling thread, and wait until they are written */
+static void
+gst_rtp_vraw_depay_write_segments (GstRtpVRawDepay * rtpvrawdepay)
+{
+  GstRtpVRawJob *jobs;
+  guint i, n_segments, n_jobs, per_job, first;
+
+  n_segments = rtpvrawdepay->segments->len;
+  if (n_segments == 0)
+    goto done;
+
+  n_jobs = MIN (rtpvrawdepay->n_threads, n_segments);
+
+  if (n_jobs > 1) {
+    if (rtpvrawdepay->workers == NULL) {
+      GError *err = NULL;
+
+      rtpvrawdepay->workers =
+          g_thread_pool_new ((GFunc) gst_rtp_vraw_depay_worker, rtpvrawdepay,
+          rtpvrawdepay->n_threads - 1, TRUE, &err);
+      if (rtpvrawdepay->workers == NULL) {
+        GST_WARNING_OBJECT (rtpvrawdepay, "could not create threads: %s",
+            err->message);
+        g_error_free (err);
+        n_jobs = 1;
+      }
+    } else if (g_thread_pool_get_max_threads (rtpvrawdepay->workers) !=
+        rtpvrawdepay->n_threads - 1) {
+      g_thread_pool_set_max_threads (rtpvrawdepay->workers,
+          rtpvrawdepay->n_threads - 1, NULL);
+    }
+  }
+
+  if (rtpvrawdepay->n_jobs < n_jobs) {
+    g_free (rtpvrawdepay->jobs);
+    rtpvrawdepay->jobs = g_new (GstRtpVRawJob, n_jobs);
+    rtpvrawdepay->n_jobs = n_jobs;
+  }
+  jobs = rtpvrawdepay->jobs;
+
+  per_job = (n_segments + n_jobs - 1) / n_jobs;
+  for (i = 0, first = 0; i < n_jobs; i++, first += per_job) {
+    jobs[i].first = first;
+    jobs[i].count = MIN (per_job, n_segments - MIN (first, n_segments));
+  }
+
+  GST_LOG_OBJECT (rtpvrawdepay, "writing %u segments in %u jobs", n_segments,
+      n_jobs);
+
+  rtpvrawdepay->pending = n_jobs - 1;
+  for (i = 1; i < n_jobs; i++)
+    g_thread_pool_push (rtpvrawdepay->workers, &jobs[i], NULL);
+
+  /* do the first part ourselves */
+  gst_rtp_vraw_depay_write_job (rtpvrawdepay, &jobs[0]);
+
+  g_mutex_lock (&rtpvrawdepay->lock);
+  while (rtpvrawdepay->pending > 0)
+    g_cond_wait (&rtpvrawdepay->cond, &rtpvrawdepay->lock);
+  g_mutex_unlock (&rtpvrawdepay->lock);
+
+done:
+  gst_rtp_vraw_depay_release_packets (rtpvrawdepay);
+}
+
+/* complete the current frame and take it */
+static GstBuffer *
+gst_rtp_vraw_depay_take_frame (GstRtpVRawDepay * rtpvrawdepay)
+{
+  GstBuffer *outbuf;
+
+  gst_rtp_vraw_depay_write_segments (rtpvrawdepay);
+  if (rtpvrawdepay->frame_mapped) {
+    gst_video_frame_unmap (&rtpvrawdepay->frame);
+    rtpvrawdepay->frame_mapped = FALSE;
+  }
+  outbuf = rtpvrawdepay->outbuf;
+  rtpvrawdepay->outbuf = NULL;
+
+  return outbuf;
+}
+
 static GstBuffer *
 gst_rtp_vraw_depay_process (GstRTPBaseDepayload * depayload, GstBuffer * buf)
 {
   GstRtpVRawDepay *rtpvrawdepay;
-  guint8 *payload, *yp, *up, *vp, *headers;
+  guint8 *payload, *headers;
   guint32 timestamp;
-  guint cont, ystride, uvstride, pgroup, payload_len;
-  gint width, height, xinc, yinc;
+  guint cont, pgroup, payload_len, n_segments;
+  gint width, height, xinc, yinc, field;
   GstRTPBuffer rtp = { NULL };
-  GstVideoFrame frame;
-  gboolean marker;
+  gboolean marker, interlaced;
   GstBuffer *outbuf = NULL;
 
   rtpvrawdepay = GST_RTP_VRAW_DEPAY (depayload);
@@ -324,16 +653,49 @@ gst_rtp_vraw_depay_process (GstRTPBaseDepayload * depayload, GstBuffer * buf)
 
   timestamp = gst_rtp_buffer_get_timestamp (&rtp);
 
+  payload = gst_rtp_buffer_get_payload (&rtp);
+  payload_len = gst_rtp_buffer_get_payload_len (&rtp);
+
+  if (payload_len < 3)
+    goto short_packet;
+
+  /* skip extended seqnum */
+  payload += 2;
+  payload_len -= 2;
+
+  /* remember header position */
+  headers = payload;
+
+  /* find data start. The F bit of the line headers is only set for the
+   * lines of the second field of interlaced video, the field of the packet
+   * is the field of its last line, which the marker refers to */
+  do {
+    if (payload_len < 6)
+      goto short_packet;
+
+    field = payload[2] >> 7;
+    cont = payload[4] & 0x80;
+
+    payload += 6;
+    payload_len -= 6;
+  } while (cont);
+
+  if (timestamp != rtpvrawdepay->timestamp && rtpvrawdepay->outbuf != NULL
+      && field > rtpvrawdepay->field) {
+    /* the second field has its own timestamp but goes in the same frame */
+    GST_LOG_OBJECT (depayload, "second field with timestamp %u", timestamp);
+    rtpvrawdepay->timestamp = timestamp;
+  }
+
   if (timestamp != rtpvrawdepay->timestamp || rtpvrawdepay->outbuf == NULL) {
     GstBuffer *outbuf;
     GstFlowReturn ret;
 
     GST_LOG_OBJECT (depayload, "new frame with timestamp %u", timestamp);
     /* new timestamp, flush old buffer and create new output buffer */
-    if (rtpvrawdepay->outbuf) {
-      gst_rtp_base_depayload_push (depayload, rtpvrawdepay->outbuf);
-      rtpvrawdepay->outbuf = NULL;
-    }
+    if (rtpvrawdepay->outbuf)
+      gst_rtp_base_depayload_push (depayload,
+          gst_rtp_vraw_depay_take_frame (rtpvrawdepay));
 
     if (gst_pad_check_reconfigure (GST_RTP_BASE_DEPAYLOAD_SRCPAD (depayload))) {
       GstCaps *caps;
@@ -352,55 +714,35 @@ gst_rtp_vraw_depay_process (GstRTPBaseDepayload * depayload, GstBuffer * buf)
     /* clear timestamp from alloc... */
     GST_BUFFER_TIMESTAMP (outbuf) = -1;
 
+    if (GST_VIDEO_INFO_IS_INTERLACED (&rtpvrawdepay->vinfo))
+      GST_BUFFER_FLAG_SET (outbuf, GST_VIDEO_BUFFER_FLAG_INTERLACED |
+          GST_VIDEO_BUFFER_FLAG_TFF);
+
     rtpvrawdepay->outbuf = outbuf;
     rtpvrawdepay->timestamp = timestamp;
   }
-
-  if (!gst_video_frame_map (&frame, &rtpvrawdepay->vinfo, rtpvrawdepay->outbuf,
-          GST_MAP_WRITE))
-    goto invalid_frame;
-
-  /* get pointer and strides of the planes */
-  yp = GST_VIDEO_FRAME_COMP_DATA (&frame, 0);
-  up = GST_VIDEO_FRAME_COMP_DATA (&frame, 1);
-  vp = GST_VIDEO_FRAME_COMP_DATA (&frame, 2);
-
-  ystride = GST_VIDEO_FRAME_COMP_STRIDE (&frame, 0);
-  uvstride = GST_VIDEO_FRAME_COMP_STRIDE (&frame, 1);
+  rtpvrawdepay->field = field;
+
+  /* the frame stays mapped until it is complete */
+  if (!rtpvrawdepay->frame_mapped) {
+    if (!gst_video_frame_map (&rtpvrawdepay->frame, &rtpvrawdepay->vinfo,
+            rtpvrawdepay->outbuf, GST_MAP_WRITE))
+      goto invalid_frame;
+    rtpvrawdepay->frame_mapped = TRUE;
+  }
 
   pgroup = rtpvrawdepay->pgroup;
   width = GST_VIDEO_INFO_WIDTH (&rtpvrawdepay->vinfo);
   height = GST_VIDEO_INFO_HEIGHT (&rtpvrawdepay->vinfo);
   xinc = rtpvrawdepay->xinc;
   yinc = rtpvrawdepay->yinc;
+  interlaced = GST_VIDEO_INFO_IS_INTERLACED (&rtpvrawdepay->vinfo);
 
-  payload = gst_rtp_buffer_get_payload (&rtp);
-  payload_len = gst_rtp_buffer_get_payload_len (&rtp);
-
-  if (payload_len < 3)
-    goto short_packet;
-
-  /* skip extended seqnum */
-  payload += 2;
-  payload_len -= 2;
-
-  /* remember header position */
-  headers = payload;
-
-  /* find data start */
-  do {
-    if (payload_len < 6)
-      goto short_packet;
-
-    cont = payload[4] & 0x80;
-
-    payload += 6;
-    payload_len -= 6;
-  } while (cont);
+  n_segments = rtpvrawdepay->segments->len;
 
   while (TRUE) {
+    GstRtpVRawSegment seg;
     guint length, line, offs, plen;
-    guint8 *datap;
 
     /* stop when we run out of data */
     if (payload_len == 0)
@@ -410,6 +752,9 @@ gst_rtp_vraw_depay_process (GstRTPBaseDepayload * depayload, GstBuffer * buf)
      * above. */
     length = (headers[0] << 8) | headers[1];
     line = ((headers[2] & 0x7f) << 8) | headers[3];
+    /* interlaced video has the line in the field of the F bit */
+    if (interlaced)
+      line = 2 * line + (headers[2] >> 7);
     offs = ((headers[4] & 0x7f) << 8) | headers[5];
     cont = headers[4] & 0x80;
     headers += 6;
@@ -443,93 +788,17 @@ gst_rtp_vraw_depay_process (GstRTPBaseDepayload * depayload, GstBuffer * buf)
         "writing length %u/%u, line %u, offset %u, remaining %u", plen, length,
         line, offs, payload_len);
 
-    switch (GST_VIDEO_INFO_FORMAT (&rtpvrawdepay->vinfo)) {
-      case GST_VIDEO_FORMAT_RGB:
-      case GST_VIDEO_FORMAT_RGBA:
-      case GST_VIDEO_FORMAT_BGR:
-      case GST_VIDEO_FORMAT_BGRA:
-      case GST_VIDEO_FORMAT_UYVY:
-      case GST_VIDEO_FORMAT_UYVP:
-        /* samples are packed just like gstreamer packs them */
-        offs /= xinc;
-        datap = yp + (line * ystride) + (offs * pgroup);
-
-        memcpy (datap, payload, plen);
-        break;
-      case GST_VIDEO_FORMAT_AYUV:
-      {
-        gint i;
-        guint8 *p;
-
-        datap = yp + (line * ystride) + (offs * 4);
-        p = payload;
-
-        /* samples are packed in order Cb-Y-Cr for both interlaced and
-         * progressive frames */
-        for (i = 0; i < plen; i += pgroup) {
-          *datap++ = 0;
-          *datap++ = p[1];
-          *datap++ = p[0];
-          *datap++ = p[2];
-          p += pgroup;
-        }
-        break;
-      }
-      case GST_VIDEO_FORMAT_I420:
-      {
-        gint i;
-        guint uvoff;
-        guint8 *yd1p, *yd2p, *udp, *vdp, *p;
-
-        yd1p = yp + (line * ystride) + (offs);
-        yd2p = yd1p + ystride;
-        uvoff = (line / yinc * uvstride) + (offs / xinc);
-
-        udp = up + uvoff;
-        vdp = vp + uvoff;
-        p = payload;
-
-        /* line 0/1: Y00-Y01-Y10-Y11-Cb00-Cr00 Y02-Y03-Y12-Y13-Cb01-Cr01 ...  */
-        for (i = 0; i < plen; i += pgroup) {
-          *yd1p++ = p[0];
-          *yd1p++ = p[1];
-          *yd2p++ = p[2];
-          *yd2p++ = p[3];
-          *udp++ = p[4];
-          *vdp++ = p[5];
-          p += pgroup;
-        }
-        break;
-      }
-      case GST_VIDEO_FORMAT_Y41B:
-      {
-        gint i;
-        guint uvoff;
-        guint8 *ydp, *udp, *vdp, *p;
-
-        ydp = yp + (line * ystride) + (offs);
-        uvoff = (line / yinc * uvstride) + (offs / xinc);
-
-        udp = up + uvoff;
-        vdp = vp + uvoff;
-        p = payload;
-
-        /* Samples are packed in order Cb0-Y0-Y1-Cr0-Y2-Y3 for both interlaced
-         * and progressive scan lines */
-        for (i = 0; i < plen; i += pgroup) {
-          *udp++ = p[0];
-          *ydp++ = p[1];
-          *ydp++ = p[2];
-          *vdp++ = p[3];
-          *ydp++ = p[4];
-          *ydp++ = p[5];
-          p += pgroup;
-        }
-        break;
-      }
-      default:
-        goto unknown_sampling;
-    }
+    seg.data = payload;
+    seg.length = plen;
+    seg.line = line;
+    seg.offs = offs;
+
+    /* in a list the segments are written together, by several threads */
+    if (rtpvrawdepay->in_list)
+      g_array_append_val (rtpvrawdepay->segments, seg);
+    else
+      gst_rtp_vraw_depay_write_segment (rtpvrawdepay, &rtpvrawdepay->frame,
+          &seg);
 
   next:
     if (!cont)
@@ -539,27 +808,25 @@ gst_rtp_vraw_depay_process (GstRTPBaseDepayload * depayload, GstBuffer * buf)
     payload_len -= length;
   }
 
-  gst_video_frame_unmap (&frame);
   marker = gst_rtp_buffer_get_marker (&rtp);
-  gst_rtp_buffer_unmap (&rtp);
 
-  if (marker) {
+  if (rtpvrawdepay->segments->len > n_segments) {
+    /* keep the packet until its segments are written */
+    gst_buffer_ref (buf);
+    g_array_append_val (rtpvrawdepay->packets, rtp);
+  } else {
+    gst_rtp_buffer_unmap (&rtp);
+  }
+
+  /* the marker is set at the end of each field */
+  if (marker && (field || !interlaced)) {
     GST_LOG_OBJECT (depayload, "marker, flushing frame");
-    outbuf = rtpvrawdepay->outbuf;
-    rtpvrawdepay->outbuf = NULL;
+    outbuf = gst_rtp_vraw_depay_take_frame (rtpvrawdepay);
     rtpvrawdepay->timestamp = -1;
   }
   return outbuf;
 
   /* ERRORS */
-unknown_sampling:
-  {
-    GST_ELEMENT_ERROR (depayload, STREAM, FORMAT,
-        (NULL), ("unimplemented sampling"));
-    gst_video_frame_unmap (&frame);
-    gst_rtp_buffer_unmap (&rtp);
-    return NULL;
-  }
 alloc_failed:
   {
     GST_WARNING_OBJECT (depayload, "failed to alloc output buffer");
@@ -575,19 +842,50 @@ invalid_frame:
 wrong_length:
   {
     GST_WARNING_OBJECT (depayload, "length not multiple of pgroup");
-    gst_video_frame_unmap (&frame);
+    /* forget the segments of this packet */
+    g_array_set_size (rtpvrawdepay->segments, n_segments);
     gst_rtp_buffer_unmap (&rtp);
     return NULL;
   }
 short_packet:
   {
     GST_WARNING_OBJECT (depayload, "short packet");
-    gst_video_frame_unmap (&frame);
     gst_rtp_buffer_unmap (&rtp);
     return NULL;
   }
 }
 
+static GstFlowReturn
+gst_rtp_vraw_depay_chain_list (GstPad * pad, GstObject * parent,
+    GstBufferList * list)
+{
+  GstRtpVRawDepay *rtpvrawdepay;
+  GstFlowReturn ret = GST_FLOW_OK;
+  guint i, len;
+
+  rtpvrawdepay = GST_RTP_VRAW_DEPAY (parent);
+
+  /* queue the segments of the packets and write them with the worker threads
+   * at the end of a frame or of the list */
+  rtpvrawdepay->in_list = rtpvrawdepay->n_threads > 1;
+
+  len = gst_buffer_list_length (list);
+  for (i = 0; i < len; i++) {
+    GstBuffer *buffer = gst_buffer_list_get (list, i);
+
+    ret = rtpvrawdepay->chain (pad, parent, gst_buffer_ref (buffer));
+    if (ret != GST_FLOW_OK)
+      break;
+  }
+
+  gst_rtp_vraw_depay_write_segments (rtpvrawdepay);
+  rtpvrawdepay->in_list = FALSE;
+
+  gst_buffer_list_unref (list);
+
+  return ret;
+}
+
 static gboolean
 gst_rtp_vraw_depay_handle_event (GstRTPBaseDepayload * filter, GstEvent * event)
 {
@@ -643,6 +941,42 @@ gst_rtp_vraw_depay_change_state (GstElement * element,
   return ret;
 }
 
+static void
+gst_rtp_vraw_depay_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstRtpVRawDepay *rtpvrawdepay;
+
+  rtpvrawdepay = GST_RTP_VRAW_DEPAY (object);
+
+  switch (prop_id) {
+    case PROP_N_THREADS:
+      rtpvrawdepay->n_threads = g_value_get_uint (value);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_rtp_vraw_depay_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstRtpVRawDepay *rtpvrawdepay;
+
+  rtpvrawdepay = GST_RTP_VRAW_DEPAY (object);
+
+  switch (prop_id) {
+    case PROP_N_THREADS:
+      g_value_set_uint (value, rtpvrawdepay->n_threads);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
 gboolean
 gst_rtp_vraw_depay_plugin_init (GstPlugin * plugin)
 {
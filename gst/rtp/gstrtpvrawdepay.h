@@ -52,9 +52,28 @@ struct _GstRtpVRawDepay
   GstBuffer *outbuf;
   guint32 timestamp;
   guint outsize;
+  /* the field of the last packet of an interlaced frame */
+  gint field;
 
   gint pgroup;
   gint xinc, yinc;
+
+  /* the mapped outbuf */
+  GstVideoFrame frame;
+  gboolean frame_mapped;
+
+  /* writing the lines of buffer lists with worker threads */
+  guint n_threads;
+  GstPadChainFunction chain;
+  gboolean in_list;
+  GArray *segments;
+  GArray *packets;
+  GThreadPool *workers;
+  gpointer jobs;
+  guint n_jobs;
+  GMutex lock;
+  GCond cond;
+  guint pending;
 };
 
 struct _GstRtpVRawDepayClass
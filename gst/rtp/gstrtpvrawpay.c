@@ -66,6 +66,24 @@ GST_STATIC_PAD_TEMPLATE ("src",
     )
     );
 
+#define DEFAULT_CHUNKS_PER_FRAME 10
+
+enum
+{
+  PROP_0,
+  PROP_CHUNKS_PER_FRAME,
+  PROP_LAST
+};
+
+static void gst_rtp_vraw_pay_finalize (GObject * object);
+static void gst_rtp_vraw_pay_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec);
+static void gst_rtp_vraw_pay_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec);
+
+static GstStateChangeReturn gst_rtp_vraw_pay_change_state (GstElement *
+    element, GstStateChange transition);
+
 static gboolean gst_rtp_vraw_pay_setcaps (GstRTPBasePayload * payload,
     GstCaps * caps);
 static GstFlowReturn gst_rtp_vraw_pay_handle_buffer (GstRTPBasePayload *
@@ -75,12 +93,35 @@ G_DEFINE_TYPE (GstRtpVRawPay, gst_rtp_vraw_pay, GST_TYPE_RTP_BASE_PAYLOAD)
 
      static void gst_rtp_vraw_pay_class_init (GstRtpVRawPayClass * klass)
 {
+  GObjectClass *gobject_class;
   GstRTPBasePayloadClass *gstrtpbasepayload_class;
   GstElementClass *gstelement_class;
 
+  gobject_class = (GObjectClass *) klass;
   gstelement_class = (GstElementClass *) klass;
   gstrtpbasepayload_class = (GstRTPBasePayloadClass *) klass;
 
+  gobject_class->finalize = gst_rtp_vraw_pay_finalize;
+  gobject_class->set_property = gst_rtp_vraw_pay_set_property;
+  gobject_class->get_property = gst_rtp_vraw_pay_get_property;
+
+  /**
+   * GstRtpVRawPay:chunks-per-frame:
+   *
+   * The packets of a frame are pushed in this many buffer lists. Fewer chunks
+   * reduce the per-packet overhead, more chunks lower the latency.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (gobject_class, PROP_CHUNKS_PER_FRAME,
+      g_param_spec_int ("chunks-per-frame", "Chunks per Frame",
+          "Split and send out each frame in multiple chunks to reduce overhead",
+          1, G_MAXINT, DEFAULT_CHUNKS_PER_FRAME,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  gstelement_class->change_state =
+      GST_DEBUG_FUNCPTR (gst_rtp_vraw_pay_change_state);
+
   gstrtpbasepayload_class->set_caps = gst_rtp_vraw_pay_setcaps;
   gstrtpbasepayload_class->handle_buffer = gst_rtp_vraw_pay_handle_buffer;
 
@@ -101,6 +142,98 @@ G_DEFINE_TYPE (GstRtpVRawPay, gst_rtp_vraw_pay, GST_TYPE_RTP_BASE_PAYLOAD)
 static void
 gst_rtp_vraw_pay_init (GstRtpVRawPay * rtpvrawpay)
 {
+  rtpvrawpay->chunks_per_frame = DEFAULT_CHUNKS_PER_FRAME;
+}
+
+static void
+gst_rtp_vraw_pay_clear_pool (GstRtpVRawPay * rtpvrawpay)
+{
+  if (rtpvrawpay->pool) {
+    gst_buffer_pool_set_active (rtpvrawpay->pool, FALSE);
+    gst_object_unref (rtpvrawpay->pool);
+    rtpvrawpay->pool = NULL;
+  }
+  rtpvrawpay->pool_size = 0;
+}
+
+static void
+gst_rtp_vraw_pay_finalize (GObject * object)
+{
+  GstRtpVRawPay *rtpvrawpay = GST_RTP_VRAW_PAY (object);
+
+  gst_rtp_vraw_pay_clear_pool (rtpvrawpay);
+  g_free (rtpvrawpay->scratch);
+
+  G_OBJECT_CLASS (gst_rtp_vraw_pay_parent_class)->finalize (object);
+}
+
+/* make sure we have an active pool of packets of @size bytes */
+static gboolean
+gst_rtp_vraw_pay_ensure_pool (GstRtpVRawPay * rtpvrawpay, guint size)
+{
+  GstStructure *config;
+
+  if (rtpvrawpay->pool && rtpvrawpay->pool_size == size)
+    return TRUE;
+
+  gst_rtp_vraw_pay_clear_pool (rtpvrawpay);
+
+  GST_DEBUG_OBJECT (rtpvrawpay, "new pool of packets of %u bytes", size);
+
+  rtpvrawpay->pool = gst_buffer_pool_new ();
+  config = gst_buffer_pool_get_config (rtpvrawpay->pool);
+  gst_buffer_pool_config_set_params (config, NULL, size, 0, 0);
+  if (!gst_buffer_pool_set_config (rtpvrawpay->pool, config))
+    goto config_failed;
+  if (!gst_buffer_pool_set_active (rtpvrawpay->pool, TRUE))
+    goto activate_failed;
+
+  rtpvrawpay->pool_size = size;
+
+  return TRUE;
+
+  /* ERRORS */
+config_failed:
+  {
+    GST_WARNING_OBJECT (rtpvrawpay, "failed to configure pool");
+    gst_rtp_vraw_pay_clear_pool (rtpvrawpay);
+    return FALSE;
+  }
+activate_failed:
+  {
+    GST_WARNING_OBJECT (rtpvrawpay, "failed to activate pool");
+    gst_rtp_vraw_pay_clear_pool (rtpvrawpay);
+    return FALSE;
+  }
+}
+
+/* get a packet with room for @payload_len bytes from the pool, its RTP header
+ * is filled in when it is pushed */
+static GstBuffer *
+gst_rtp_vraw_pay_alloc_packet (GstRtpVRawPay * rtpvrawpay, guint payload_len)
+{
+  GstBuffer *out = NULL;
+  GstMapInfo map;
+  guint size, header_len;
+
+  size = gst_rtp_buffer_calc_packet_len (payload_len, 0, 0);
+
+  if (!gst_rtp_vraw_pay_ensure_pool (rtpvrawpay, size) ||
+      gst_buffer_pool_acquire_buffer (rtpvrawpay->pool, &out,
+          NULL) != GST_FLOW_OK)
+    return gst_rtp_buffer_new_allocate (payload_len, 0, 0);
+
+  /* a recycled packet can have been resized */
+  gst_buffer_set_size (out, size);
+
+  /* version 2 without padding, extension or CSRCs */
+  header_len = gst_rtp_buffer_calc_header_len (0);
+  gst_buffer_map (out, &map, GST_MAP_WRITE);
+  memset (map.data, 0, header_len);
+  map.data[0] = 0x80;
+  gst_buffer_unmap (out, &map);
+
+  return out;
 }
 
 static gboolean
@@ -248,6 +381,10 @@ gst_rtp_vraw_pay_handle_buffer (GstRTPBasePayload * payload, GstBuffer * buffer)
   gint field;
   GstVideoFrame frame;
   gint interlaced;
+  gboolean zero_copy;
+  gsize poffset;
+  guint lines_delay, last_line;
+  GstBufferList *list = NULL;
   GstRTPBuffer rtp = { NULL, };
 
   rtpvrawpay = GST_RTP_VRAW_PAY (payload);
@@ -274,35 +411,62 @@ gst_rtp_vraw_pay_handle_buffer (GstRTPBasePayload * payload, GstBuffer * buffer)
 
   interlaced = GST_VIDEO_INFO_IS_INTERLACED (&rtpvrawpay->vinfo);
 
+  /* the pixels of these formats are sent in the order of the frame, the
+   * packets refer to the frame memory instead of copying it */
+  switch (GST_VIDEO_INFO_FORMAT (&rtpvrawpay->vinfo)) {
+    case GST_VIDEO_FORMAT_RGB:
+    case GST_VIDEO_FORMAT_RGBA:
+    case GST_VIDEO_FORMAT_BGR:
+    case GST_VIDEO_FORMAT_BGRA:
+    case GST_VIDEO_FORMAT_UYVY:
+    case GST_VIDEO_FORMAT_UYVP:
+      zero_copy = TRUE;
+      break;
+    default:
+      zero_copy = FALSE;
+      break;
+  }
+  poffset = GST_VIDEO_FRAME_PLANE_OFFSET (&frame, 0);
+
+  /* push a buffer list every lines_delay lines */
+  lines_delay = MAX (height / rtpvrawpay->chunks_per_frame, 1);
+
   /* start with line 0, offset 0 */
   for (field = 0; field < 1 + interlaced; field++) {
     line = field;
     offset = 0;
+    last_line = line;
 
     /* write all lines */
     while (line < height) {
       guint left;
-      GstBuffer *out;
-      guint8 *outdata, *headers;
+      GstBuffer *out = NULL, *data = NULL;
+      guint8 *outdata, *headers, *start;
       gboolean next_line;
-      guint length, cont, pixels;
+      guint length, cont, pixels, used, hline;
 
       /* get the max allowed payload length size, we try to fill the complete MTU */
       left = gst_rtp_buffer_calc_payload_len (mtu, 0, 0);
-      out = gst_rtp_buffer_new_allocate (left, 0, 0);
 
-      if (field == 0) {
-        GST_BUFFER_TIMESTAMP (out) = GST_BUFFER_TIMESTAMP (buffer);
+      if (zero_copy) {
+        /* write the headers aside, the packet only gets the headers and
+         * refers to the pixels in the frame */
+        if (rtpvrawpay->scratch_size < left) {
+          g_free (rtpvrawpay->scratch);
+          rtpvrawpay->scratch = g_malloc (left);
+          rtpvrawpay->scratch_size = left;
+        }
+        outdata = rtpvrawpay->scratch;
+        data = gst_buffer_new ();
       } else {
-        GST_BUFFER_TIMESTAMP (out) = GST_BUFFER_TIMESTAMP (buffer) +
-            GST_BUFFER_DURATION (buffer) / 2;
-      }
+        out = gst_rtp_vraw_pay_alloc_packet (rtpvrawpay, left);
+        gst_rtp_buffer_map (out, GST_MAP_WRITE, &rtp);
+        outdata = gst_rtp_buffer_get_payload (&rtp);
 
-      gst_rtp_buffer_map (out, GST_MAP_WRITE, &rtp);
-      outdata = gst_rtp_buffer_get_payload (&rtp);
-
-      GST_LOG_OBJECT (rtpvrawpay, "created buffer of size %u for MTU %u", left,
-          mtu);
+        GST_LOG_OBJECT (rtpvrawpay, "created buffer of size %u for MTU %u",
+            left, mtu);
+      }
+      start = outdata;
 
       /*
        *   0                   1                   2                   3
@@ -357,9 +521,11 @@ gst_rtp_vraw_pay_handle_buffer (GstRTPBasePayload * payload, GstBuffer * buffer)
         *outdata++ = (length >> 8) & 0xff;
         *outdata++ = length & 0xff;
 
-        /* write line no */
-        *outdata++ = ((line >> 8) & 0x7f) | ((field << 7) & 0x80);
-        *outdata++ = line & 0xff;
+        /* write line no, for interlaced video the number of the line in
+         * its field, the frame line is 2 * line no + F */
+        hline = interlaced ? line / 2 : line;
+        *outdata++ = ((hline >> 8) & 0x7f) | ((field << 7) & 0x80);
+        *outdata++ = hline & 0xff;
 
         if (next_line) {
           /* go to next line we do this here to make the check below easier */
@@ -388,6 +554,9 @@ gst_rtp_vraw_pay_handle_buffer (GstRTPBasePayload * payload, GstBuffer * buffer)
       GST_LOG_OBJECT (rtpvrawpay, "consumed %u bytes",
           (guint) (outdata - headers));
 
+      /* extended sequence number and headers */
+      used = outdata - start;
+
       /* second pass, read headers and write the data */
       while (TRUE) {
         guint offs, lin;
@@ -395,6 +564,8 @@ gst_rtp_vraw_pay_handle_buffer (GstRTPBasePayload * payload, GstBuffer * buffer)
         /* read length and cont */
         length = (headers[0] << 8) | headers[1];
         lin = ((headers[2] & 0x7f) << 8) | headers[3];
+        if (interlaced)
+          lin = 2 * lin + (headers[2] >> 7);
         offs = ((headers[4] & 0x7f) << 8) | headers[5];
         cont = headers[4] & 0x80;
         pixels = length / pgroup;
@@ -412,8 +583,9 @@ gst_rtp_vraw_pay_handle_buffer (GstRTPBasePayload * payload, GstBuffer * buffer)
           case GST_VIDEO_FORMAT_UYVY:
           case GST_VIDEO_FORMAT_UYVP:
             offs /= rtpvrawpay->xinc;
-            memcpy (outdata, yp + (lin * ystride) + (offs * pgroup), length);
-            outdata += length;
+            data = gst_buffer_append (data,
+                gst_buffer_copy_region (buffer, GST_BUFFER_COPY_MEMORY,
+                    poffset + (lin * ystride) + (offs * pgroup), length));
             break;
           case GST_VIDEO_FORMAT_AYUV:
           {
@@ -476,8 +648,12 @@ gst_rtp_vraw_pay_handle_buffer (GstRTPBasePayload * payload, GstBuffer * buffer)
             break;
           }
           default:
-            gst_rtp_buffer_unmap (&rtp);
-            gst_buffer_unref (out);
+            if (out) {
+              gst_rtp_buffer_unmap (&rtp);
+              gst_buffer_unref (out);
+            }
+            if (data)
+              gst_buffer_unref (data);
             goto unknown_sampling;
         }
 
@@ -485,20 +661,50 @@ gst_rtp_vraw_pay_handle_buffer (GstRTPBasePayload * payload, GstBuffer * buffer)
           break;
       }
 
+      if (data) {
+        /* header only packet of just the size of the headers, the pixels
+         * follow in the memory of the frame */
+        out = gst_rtp_buffer_new_allocate (used, 0, 0);
+        gst_rtp_buffer_map (out, GST_MAP_WRITE, &rtp);
+        memcpy (gst_rtp_buffer_get_payload (&rtp), start, used);
+      }
+
       if (line >= height) {
         GST_LOG_OBJECT (rtpvrawpay, "field/frame complete, set marker");
         gst_rtp_buffer_set_marker (&rtp, TRUE);
       }
       gst_rtp_buffer_unmap (&rtp);
-      if (left > 0) {
+      if (data) {
+        out = gst_buffer_append (out, data);
+      } else if (left > 0) {
         GST_LOG_OBJECT (rtpvrawpay, "we have %u bytes left", left);
         gst_buffer_resize (out, 0, gst_buffer_get_size (out) - left);
       }
 
-      /* push buffer */
-      ret = gst_rtp_base_payload_push (payload, out);
-    }
+      if (field == 0) {
+        GST_BUFFER_TIMESTAMP (out) = GST_BUFFER_TIMESTAMP (buffer);
+      } else {
+        GST_BUFFER_TIMESTAMP (out) = GST_BUFFER_TIMESTAMP (buffer) +
+            GST_BUFFER_DURATION (buffer) / 2;
+      }
 
+      if (list == NULL)
+        list = gst_buffer_list_new ();
+      gst_buffer_list_add (list, out);
+
+      /* push the chunk when it is complete or at the end of the field */
+      if (line >= height || line >= last_line + lines_delay) {
+        GST_LOG_OBJECT (rtpvrawpay, "pushing list of %u packets",
+            gst_buffer_list_length (list));
+        ret = gst_rtp_base_payload_push_list (payload, list);
+        list = NULL;
+        last_line = line;
+        if (ret != GST_FLOW_OK)
+          break;
+      }
+    }
+    if (ret != GST_FLOW_OK)
+      break;
   }
 
   gst_video_frame_unmap (&frame);
@@ -511,12 +717,73 @@ unknown_sampling:
   {
     GST_ELEMENT_ERROR (payload, STREAM, FORMAT,
         (NULL), ("unimplemented sampling"));
+    if (list)
+      gst_buffer_list_unref (list);
     gst_video_frame_unmap (&frame);
     gst_buffer_unref (buffer);
     return GST_FLOW_NOT_SUPPORTED;
   }
 }
 
+static void
+gst_rtp_vraw_pay_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstRtpVRawPay *rtpvrawpay;
+
+  rtpvrawpay = GST_RTP_VRAW_PAY (object);
+
+  switch (prop_id) {
+    case PROP_CHUNKS_PER_FRAME:
+      rtpvrawpay->chunks_per_frame = g_value_get_int (value);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_rtp_vraw_pay_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstRtpVRawPay *rtpvrawpay;
+
+  rtpvrawpay = GST_RTP_VRAW_PAY (object);
+
+  switch (prop_id) {
+    case PROP_CHUNKS_PER_FRAME:
+      g_value_set_int (value, rtpvrawpay->chunks_per_frame);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static GstStateChangeReturn
+gst_rtp_vraw_pay_change_state (GstElement * element, GstStateChange transition)
+{
+  GstRtpVRawPay *rtpvrawpay;
+  GstStateChangeReturn ret;
+
+  rtpvrawpay = GST_RTP_VRAW_PAY (element);
+
+  ret =
+      GST_ELEMENT_CLASS (gst_rtp_vraw_pay_parent_class)->change_state (element,
+      transition);
+
+  switch (transition) {
+    case GST_STATE_CHANGE_PAUSED_TO_READY:
+      gst_rtp_vraw_pay_clear_pool (rtpvrawpay);
+      break;
+    default:
+      break;
+  }
+
+  return ret;
+}
+
 gboolean
 gst_rtp_vraw_pay_plugin_init (GstPlugin * plugin)
 {
@@ -53,6 +53,16 @@ struct _GstRtpVRawPay
 //   gint uvstride;
 //   gboolean interlaced;
   gint depth;
+
+  gint chunks_per_frame;
+
+  /* pool of packets */
+  GstBufferPool *pool;
+  guint pool_size;
+
+  /* headers of packets that refer to the frame */
+  guint8 *scratch;
+  guint scratch_size;
 };
 
 struct _GstRtpVRawPayClass
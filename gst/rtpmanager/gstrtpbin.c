@@ -39,6 +39,11 @@
  * rtpbin with the session number, SSRC and payload type respectively as the pad
  * name.
  *
+ * With the #GstRtpBin:lightweight property, rtpbin does not create a
+ * #GstRtpJitterBuffer and a #GstRtpPtDemux element for each SSRC but reorders
+ * and demuxes the packets itself, with the same recv_rtp_src_\%u_\%u_\%u
+ * pads.
+ *
  * To also use #GstRtpBin as an RTCP receiver, request a recv_rtcp_sink_\%u pad. The
  * session number must be specified in the pad name.
  *
@@ -209,6 +214,11 @@ static GstStaticPadTemplate rtpbin_send_rtp_src_template =
 #define GST_RTP_BIN_DYN_LOCK(bin)    g_mutex_lock (&(bin)->priv->dyn_lock)
 #define GST_RTP_BIN_DYN_UNLOCK(bin)  g_mutex_unlock (&(bin)->priv->dyn_lock)
 
+/* lock to protect the clients and the sync state of the streams. Can be taken
+ * while holding the RTP_BIN_LOCK */
+#define GST_RTP_BIN_SYNC_LOCK(bin)    g_mutex_lock (&(bin)->priv->sync_lock)
+#define GST_RTP_BIN_SYNC_UNLOCK(bin)  g_mutex_unlock (&(bin)->priv->sync_lock)
+
 /* lock for shutdown */
 #define GST_RTP_BIN_SHUTDOWN_LOCK(bin,label)     \
 G_STMT_START {                                   \
@@ -232,6 +242,11 @@ struct _GstRtpBinPrivate
   /* lock protecting dynamic adding/removing */
   GMutex dyn_lock;
 
+  /* lock protecting the clients */
+  GMutex sync_lock;
+  /* the clients indexed by CNAME */
+  GHashTable *clients_by_cname;
+
   /* if we are shutting down or not */
   gint shutdown;
 
@@ -290,6 +305,7 @@ enum
 #define DEFAULT_RTCP_SYNC_INTERVAL   0
 #define DEFAULT_DO_SYNC_EVENT        FALSE
 #define DEFAULT_DO_RETRANSMISSION    FALSE
+#define DEFAULT_LIGHTWEIGHT          FALSE
 
 enum
 {
@@ -307,6 +323,7 @@ enum
   PROP_USE_PIPELINE_CLOCK,
   PROP_DO_SYNC_EVENT,
   PROP_DO_RETRANSMISSION,
+  PROP_LIGHTWEIGHT,
   PROP_LAST
 };
 
@@ -352,6 +369,8 @@ static void remove_send_rtp (GstRtpBin * rtpbin, GstRtpBinSession * session);
 static void remove_rtcp (GstRtpBin * rtpbin, GstRtpBinSession * session);
 static void free_client (GstRtpBinClient * client, GstRtpBin * bin);
 static void free_stream (GstRtpBinStream * stream, GstRtpBin * bin);
+static gboolean lw_stream_forward_event (GstRtpBinStream * stream,
+    GstEvent * event);
 
 /* Manages the RTP stream for one SSRC.
  *
@@ -385,6 +404,30 @@ struct _GstRtpBinStream
   gulong demux_ptreq_sig;
   gulong demux_ptchange_sig;
 
+  /* in lightweight mode there are no jitterbuffer and PT demuxer elements.
+   * The pads below are linked to the SSRC demuxer and feed an internal
+   * jitterbuffer, the packets are pushed on a pad of rtpbin for each PT. The
+   * LW_STREAM_LOCK protects the fields below. */
+  GstPad *sink;
+  GstPad *rtcp_sink;
+  GMutex lock;
+  RTPJitterBuffer *jbuf;
+  GstSegment segment;
+  GstClockTime latency;
+  gint64 ts_offset;
+  gboolean flushing;
+  gboolean eos;
+  gboolean discont;
+  /* the PT of the last received packet and its clock-rate and clock-base */
+  gint last_pt;
+  gint clock_rate;
+  gint64 rtp_clock_base;
+  gint last_popped_seqnum;
+  /* list of GstRtpBinPtPad */
+  GSList *ptpads;
+  /* the PT of the last pushed packet, only used by the streaming thread */
+  gint last_out_pt;
+
   /* if we have calculated a valid rt_delta for this stream */
   gboolean have_sync;
   /* mapping to local RTP and NTP time */
@@ -394,6 +437,18 @@ struct _GstRtpBinStream
   gint64 clock_base;
 };
 
+#define LW_STREAM_IS_LIGHTWEIGHT(stream) ((stream)->jbuf != NULL)
+#define LW_STREAM_LOCK(stream)   g_mutex_lock (&(stream)->lock)
+#define LW_STREAM_UNLOCK(stream) g_mutex_unlock (&(stream)->lock)
+
+/* A pad of rtpbin for one payload type of a lightweight stream */
+typedef struct
+{
+  gint pt;
+  GstPad *pad;
+  gboolean newcaps;
+} GstRtpBinPtPad;
+
 #define GST_RTP_SESSION_LOCK(sess)   g_mutex_lock (&(sess)->lock)
 #define GST_RTP_SESSION_UNLOCK(sess) g_mutex_unlock (&(sess)->lock)
 
@@ -851,7 +906,7 @@ gst_rtp_bin_reset_sync (GstRtpBin * rtpbin)
 
   GST_DEBUG_OBJECT (rtpbin, "Reset sync on all clients");
 
-  GST_RTP_BIN_LOCK (rtpbin);
+  GST_RTP_BIN_SYNC_LOCK (rtpbin);
   for (clients = rtpbin->clients; clients; clients = g_slist_next (clients)) {
     GstRtpBinClient *client = (GstRtpBinClient *) clients->data;
 
@@ -867,7 +922,7 @@ gst_rtp_bin_reset_sync (GstRtpBin * rtpbin)
       stream->clock_base = -100 * GST_SECOND;
     }
   }
-  GST_RTP_BIN_UNLOCK (rtpbin);
+  GST_RTP_BIN_SYNC_UNLOCK (rtpbin);
 }
 
 static void
@@ -890,6 +945,16 @@ gst_rtp_bin_clear_pt_map (GstRtpBin * bin)
       GstRtpBinStream *stream = (GstRtpBinStream *) streams->data;
 
       GST_DEBUG_OBJECT (bin, "clearing stream %p", stream);
+      if (LW_STREAM_IS_LIGHTWEIGHT (stream)) {
+        GSList *walk;
+
+        LW_STREAM_LOCK (stream);
+        stream->last_pt = -1;
+        for (walk = stream->ptpads; walk; walk = g_slist_next (walk))
+          ((GstRtpBinPtPad *) walk->data)->newcaps = TRUE;
+        LW_STREAM_UNLOCK (stream);
+        continue;
+      }
       g_signal_emit_by_name (stream->buffer, "clear-pt-map", NULL);
       if (stream->demux)
         g_signal_emit_by_name (stream->demux, "clear-pt-map", NULL);
@@ -949,6 +1014,15 @@ gst_rtp_bin_propagate_property_to_jitterbuffer (GstRtpBin * bin,
     for (streams = session->streams; streams; streams = g_slist_next (streams)) {
       GstRtpBinStream *stream = (GstRtpBinStream *) streams->data;
 
+      if (LW_STREAM_IS_LIGHTWEIGHT (stream)) {
+        /* the internal jitterbuffer only follows the latency */
+        if (g_str_equal (name, "latency")) {
+          LW_STREAM_LOCK (stream);
+          stream->latency = g_value_get_uint (value) * GST_MSECOND;
+          LW_STREAM_UNLOCK (stream);
+        }
+        continue;
+      }
       g_object_set_property (G_OBJECT (stream->buffer), name, value);
     }
     GST_RTP_SESSION_UNLOCK (session);
@@ -956,33 +1030,28 @@ gst_rtp_bin_propagate_property_to_jitterbuffer (GstRtpBin * bin,
   GST_RTP_BIN_UNLOCK (bin);
 }
 
-/* get a client with the given SDES name. Must be called with RTP_BIN_LOCK */
+/* get a client with the given SDES name. Must be called with RTP_BIN_SYNC_LOCK */
 static GstRtpBinClient *
 get_client (GstRtpBin * bin, guint8 len, guint8 * data, gboolean * created)
 {
-  GstRtpBinClient *result = NULL;
-  GSList *walk;
-
-  for (walk = bin->clients; walk; walk = g_slist_next (walk)) {
-    GstRtpBinClient *client = (GstRtpBinClient *) walk->data;
-
-    if (len != client->cname_len)
-      continue;
+  GstRtpBinClient *result;
+  gchar cname[256];
 
-    if (!strncmp ((gchar *) data, client->cname, client->cname_len)) {
-      GST_DEBUG_OBJECT (bin, "found existing client %p with CNAME %s", client,
-          client->cname);
-      result = client;
-      break;
-    }
-  }
+  /* SDES items are at most 255 bytes */
+  memcpy (cname, data, len);
+  cname[len] = '\0';
 
-  /* nothing found, create one */
-  if (result == NULL) {
+  result = g_hash_table_lookup (bin->priv->clients_by_cname, cname);
+  if (result) {
+    GST_DEBUG_OBJECT (bin, "found existing client %p with CNAME %s", result,
+        result->cname);
+  } else {
+    /* nothing found, create one */
     result = g_new0 (GstRtpBinClient, 1);
     result->cname = g_strndup ((gchar *) data, len);
     result->cname_len = len;
     bin->clients = g_slist_prepend (bin->clients, result);
+    g_hash_table_insert (bin->priv->clients_by_cname, result->cname, result);
     GST_DEBUG_OBJECT (bin, "created new client %p with CNAME %s", result,
         result->cname);
   }
@@ -993,6 +1062,7 @@ static void
 free_client (GstRtpBinClient * client, GstRtpBin * bin)
 {
   GST_DEBUG_OBJECT (bin, "freeing client %p", client);
+  g_hash_table_remove (bin->priv->clients_by_cname, client->cname);
   g_slist_free (client->streams);
   g_free (client->cname);
   g_free (client);
@@ -1048,7 +1118,13 @@ stream_set_ts_offset (GstRtpBin * bin, GstRtpBinStream * stream,
 {
   gint64 prev_ts_offset;
 
-  g_object_get (stream->buffer, "ts-offset", &prev_ts_offset, NULL);
+  if (LW_STREAM_IS_LIGHTWEIGHT (stream)) {
+    LW_STREAM_LOCK (stream);
+    prev_ts_offset = stream->ts_offset;
+    LW_STREAM_UNLOCK (stream);
+  } else {
+    g_object_get (stream->buffer, "ts-offset", &prev_ts_offset, NULL);
+  }
 
   /* delta changed, see how much */
   if (prev_ts_offset != ts_offset) {
@@ -1073,7 +1149,13 @@ stream_set_ts_offset (GstRtpBin * bin, GstRtpBinStream * stream,
         return;
       }
     }
-    g_object_set (stream->buffer, "ts-offset", ts_offset, NULL);
+    if (LW_STREAM_IS_LIGHTWEIGHT (stream)) {
+      LW_STREAM_LOCK (stream);
+      stream->ts_offset = ts_offset;
+      LW_STREAM_UNLOCK (stream);
+    } else {
+      g_object_set (stream->buffer, "ts-offset", ts_offset, NULL);
+    }
   }
   GST_DEBUG_OBJECT (bin, "stream SSRC %08x, delta %" G_GINT64_FORMAT,
       stream->ssrc, ts_offset);
@@ -1092,6 +1174,11 @@ gst_rtp_bin_send_sync_event (GstRtpBinStream * stream)
     event = gst_event_new_custom (GST_EVENT_CUSTOM_DOWNSTREAM,
         gst_structure_new_empty ("GstRTCPSRReceived"));
 
+    if (LW_STREAM_IS_LIGHTWEIGHT (stream)) {
+      lw_stream_forward_event (stream, event);
+      return;
+    }
+
     srcpad = gst_element_get_static_pad (stream->buffer, "src");
     gst_pad_push_event (srcpad, event);
     gst_object_unref (srcpad);
@@ -1099,9 +1186,10 @@ gst_rtp_bin_send_sync_event (GstRtpBinStream * stream)
 }
 
 /* associate a stream to the given CNAME. This will make sure all streams for
- * that CNAME are synchronized together.
- * Must be called with GST_RTP_BIN_LOCK */
-static void
+ * that CNAME are synchronized together. Returns TRUE when the offsets of the
+ * streams were updated and the sync event should be sent.
+ * Must be called with GST_RTP_BIN_SYNC_LOCK */
+static gboolean
 gst_rtp_bin_associate (GstRtpBin * bin, GstRtpBinStream * stream, guint8 len,
     guint8 * data, guint64 ntptime, guint64 last_extrtptime,
     guint64 base_rtptime, guint64 base_time, guint clock_rate,
@@ -1149,7 +1237,7 @@ gst_rtp_bin_associate (GstRtpBin * bin, GstRtpBinStream * stream, guint8 len,
     } else {
       /* nothing we can do with this data in this case */
       GST_DEBUG_OBJECT (bin, "bailing out");
-      return;
+      return FALSE;
     }
   }
 
@@ -1266,7 +1354,7 @@ gst_rtp_bin_associate (GstRtpBin * bin, GstRtpBinStream * stream, guint8 len,
       /* warn and bail for clarity out if no sane values */
       if (!use_rtp) {
         GST_WARNING_OBJECT (bin, "unable to sync to provided rtptime");
-        return;
+        return FALSE;
       }
       /* store to track changes */
       clock_base = rtp_clock_base;
@@ -1309,7 +1397,7 @@ gst_rtp_bin_associate (GstRtpBin * bin, GstRtpBinStream * stream, guint8 len,
 
     /* may need init performed above later on, but nothing more to do now */
     if (client->nstreams <= 1)
-      return;
+      return FALSE;
 
     GST_DEBUG_OBJECT (bin, "client %p min delta %" G_GINT64_FORMAT
         " all sync %d", client, min, all_sync);
@@ -1326,7 +1414,7 @@ gst_rtp_bin_associate (GstRtpBin * bin, GstRtpBinStream * stream, guint8 len,
         /* if all have been synced already, do not bother further */
         if (all_sync) {
           GST_DEBUG_OBJECT (bin, "all streams already synced; done");
-          return;
+          return FALSE;
         }
         break;
       default:
@@ -1339,7 +1427,7 @@ gst_rtp_bin_associate (GstRtpBin * bin, GstRtpBinStream * stream, guint8 len,
       GST_DEBUG_OBJECT (bin, "discarding RTCP sender packet for sync; "
           "previous sender info too recent "
           "(previous UNIX %" G_GUINT64_FORMAT ")", bin->priv->last_unix);
-      return;
+      return FALSE;
     }
     bin->priv->last_unix = last_unix;
 
@@ -1364,9 +1452,8 @@ gst_rtp_bin_associate (GstRtpBin * bin, GstRtpBinStream * stream, guint8 len,
       stream_set_ts_offset (bin, ostream, ts_offset, TRUE);
     }
   }
-  gst_rtp_bin_send_sync_event (stream);
 
-  return;
+  return TRUE;
 }
 
 #define GST_RTCP_BUFFER_FOR_PACKETS(b,buffer,packet) \
@@ -1464,12 +1551,18 @@ gst_rtp_bin_handle_sync (GstElement * jitterbuffer, GstStructure * s,
             gst_rtcp_packet_sdes_get_entry (&packet, &type, &len, &data);
 
             if (type == GST_RTCP_SDES_CNAME) {
-              GST_RTP_BIN_LOCK (bin);
+              gboolean synced;
+
+              GST_RTP_BIN_SYNC_LOCK (bin);
               /* associate the stream to CNAME */
-              gst_rtp_bin_associate (bin, stream, len, data,
+              synced = gst_rtp_bin_associate (bin, stream, len, data,
                   ntptime, extrtptime, base_rtptime, base_time, clock_rate,
                   clock_base);
-              GST_RTP_BIN_UNLOCK (bin);
+              GST_RTP_BIN_SYNC_UNLOCK (bin);
+
+              /* push the event without holding the lock */
+              if (synced)
+                gst_rtp_bin_send_sync_event (stream);
             }
           }
         }
@@ -1484,6 +1577,970 @@ gst_rtp_bin_handle_sync (GstElement * jitterbuffer, GstStructure * s,
   gst_rtcp_buffer_unmap (&rtcp);
 }
 
+/* Lightweight streams
+ *
+ * In lightweight mode, a stream has no rtpjitterbuffer and rtpptdemux
+ * elements. rtpbin links the SSRC demuxer to the pads of the stream, which
+ * are not added to any element, and drives an RTPJitterBuffer and a list of
+ * pads for the payload types itself.
+ *
+ * The packets are reordered in the streaming thread of the SSRC demuxer. A
+ * packet that follows the last pushed packet is pushed right away, a packet
+ * after a gap waits for the latency, measured with the arrival times of the
+ * later packets. The packets that wait when no more packets arrive are
+ * pushed on EOS or on the next serialized event.
+ */
+static void
+lw_free_item (RTPJitterBufferItem * item)
+{
+  if (item->data)
+    gst_buffer_unref (item->data);
+  g_slice_free (RTPJitterBufferItem, item);
+}
+
+/* get the caps for @pt, from the pt map or else from the caps of the
+ * stream */
+static GstCaps *
+lw_stream_get_caps (GstRtpBinStream * stream, guint8 pt)
+{
+  GstCaps *caps;
+
+  caps = get_pt_map (stream->session, pt);
+  if (caps == NULL)
+    caps = gst_pad_get_current_caps (stream->sink);
+
+  GST_DEBUG_OBJECT (stream->bin, "pt %d, got caps %" GST_PTR_FORMAT, pt, caps);
+
+  return caps;
+}
+
+/* push @event on all the pads of @stream, takes ownership of @event */
+static gboolean
+lw_stream_forward_event (GstRtpBinStream * stream, GstEvent * event)
+{
+  GSList *pads = NULL, *walk;
+
+  LW_STREAM_LOCK (stream);
+  for (walk = stream->ptpads; walk; walk = g_slist_next (walk)) {
+    GstRtpBinPtPad *ptpad = walk->data;
+
+    pads = g_slist_prepend (pads, gst_object_ref (ptpad->pad));
+  }
+  LW_STREAM_UNLOCK (stream);
+
+  for (walk = pads; walk; walk = g_slist_next (walk)) {
+    GstPad *pad = walk->data;
+
+    gst_pad_push_event (pad, gst_event_ref (event));
+    gst_object_unref (pad);
+  }
+  g_slist_free (pads);
+  gst_event_unref (event);
+
+  return TRUE;
+}
+
+/* pop the packet in @item and make the output buffer. Must be called with
+ * the LW_STREAM_LOCK */
+static GstBuffer *
+lw_stream_prepare_output (GstRtpBinStream * stream, RTPJitterBufferItem * item)
+{
+  GstBuffer *outbuf;
+  GstClockTime dts, pts;
+
+  outbuf = gst_buffer_make_writable (item->data);
+  item->data = NULL;
+
+  if (G_UNLIKELY (stream->discont)) {
+    GST_BUFFER_FLAG_SET (outbuf, GST_BUFFER_FLAG_DISCONT);
+    stream->discont = FALSE;
+  }
+
+  dts = gst_segment_to_position (&stream->segment, GST_FORMAT_TIME, item->dts);
+  pts = gst_segment_to_position (&stream->segment, GST_FORMAT_TIME, item->pts);
+
+  /* apply the timestamp offset, this is used for inter stream sync */
+  GST_BUFFER_DTS (outbuf) = dts == -1 ? -1 : dts + stream->ts_offset;
+  GST_BUFFER_PTS (outbuf) = pts == -1 ? -1 : pts + stream->ts_offset;
+
+  stream->last_popped_seqnum = item->seqnum;
+  lw_free_item (item);
+
+  return outbuf;
+}
+
+/* pop the packets that can be pushed at running time @now and add them to
+ * @outlist. With @drain, all packets are popped. Must be called with the
+ * LW_STREAM_LOCK */
+static void
+lw_stream_pop_ready (GstRtpBinStream * stream, GstClockTime now,
+    gboolean drain, GstBufferList ** outlist)
+{
+  RTPJitterBufferItem *item;
+
+  while ((item = rtp_jitter_buffer_peek (stream->jbuf))) {
+    gboolean expected;
+
+    expected = stream->last_popped_seqnum != -1 &&
+        item->seqnum == ((stream->last_popped_seqnum + 1) & 0xffff);
+
+    if (!expected) {
+      /* the first packet or a packet after a gap, give the packets before it
+       * the latency to arrive. Without arrival times we can't wait. */
+      if (!drain && GST_CLOCK_TIME_IS_VALID (now) &&
+          GST_CLOCK_TIME_IS_VALID (item->dts) &&
+          item->dts + stream->latency > now)
+        break;
+
+      if (stream->last_popped_seqnum != -1) {
+        GST_DEBUG_OBJECT (stream->bin, "SSRC %08x, missing packets before #%d",
+            stream->ssrc, item->seqnum);
+        stream->discont = TRUE;
+      }
+    }
+    item = rtp_jitter_buffer_pop (stream->jbuf, NULL);
+
+    if (*outlist == NULL)
+      *outlist = gst_buffer_list_new ();
+    gst_buffer_list_add (*outlist, lw_stream_prepare_output (stream, item));
+  }
+}
+
+/* insert @buffer in the jitterbuffer of @stream and update @now with its
+ * arrival running time. Takes ownership of @buffer. */
+static GstFlowReturn
+lw_stream_insert (GstRtpBinStream * stream, GstBuffer * buffer,
+    GstClockTime * now)
+{
+  GstRTPBuffer rtp = GST_RTP_BUFFER_INIT;
+  RTPJitterBufferItem *item;
+  GstClockTime dts, pts;
+  guint16 seqnum;
+  guint32 rtptime;
+  guint8 pt;
+
+  if (G_UNLIKELY (!gst_rtp_buffer_map (buffer, GST_MAP_READ, &rtp)))
+    goto invalid_buffer;
+
+  pt = gst_rtp_buffer_get_payload_type (&rtp);
+  seqnum = gst_rtp_buffer_get_seq (&rtp);
+  rtptime = gst_rtp_buffer_get_timestamp (&rtp);
+  gst_rtp_buffer_unmap (&rtp);
+
+  /* make sure we have PTS and DTS set */
+  pts = GST_BUFFER_PTS (buffer);
+  dts = GST_BUFFER_DTS (buffer);
+  if (dts == -1)
+    dts = pts;
+  else if (pts == -1)
+    pts = dts;
+
+  LW_STREAM_LOCK (stream);
+  if (G_UNLIKELY (stream->flushing))
+    goto flushing;
+
+  if (G_UNLIKELY (stream->last_pt != pt)) {
+    GstCaps *caps;
+    gint clock_rate = -1;
+    gint64 clock_base = -1;
+
+    /* get the clock-rate of the new PT without the lock, the pt map can emit
+     * a signal */
+    LW_STREAM_UNLOCK (stream);
+    if ((caps = lw_stream_get_caps (stream, pt))) {
+      GstStructure *s = gst_caps_get_structure (caps, 0);
+      guint val;
+
+      gst_structure_get_int (s, "clock-rate", &clock_rate);
+      if (gst_structure_get_uint (s, "clock-base", &val))
+        clock_base = val;
+      gst_caps_unref (caps);
+    }
+    LW_STREAM_LOCK (stream);
+
+    stream->last_pt = pt;
+    stream->clock_rate = clock_rate;
+    stream->rtp_clock_base = clock_base;
+    if (clock_rate > 0)
+      rtp_jitter_buffer_set_clock_rate (stream->jbuf, clock_rate);
+  }
+  if (G_UNLIKELY (stream->clock_rate <= 0))
+    goto no_clock_rate;
+
+  /* don't accept more data on EOS */
+  if (G_UNLIKELY (stream->eos))
+    goto have_eos;
+
+  /* bring to running time */
+  dts = gst_segment_to_running_time (&stream->segment, GST_FORMAT_TIME, dts);
+  if (GST_CLOCK_TIME_IS_VALID (dts) && (*now == -1 || dts > *now))
+    *now = dts;
+
+  if (G_LIKELY (stream->last_popped_seqnum != -1)) {
+    gint gap;
+
+    gap = gst_rtp_buffer_compare_seqnum (stream->last_popped_seqnum, seqnum);
+
+    if (G_UNLIKELY (gap < -RTP_MAX_MISORDER || gap > RTP_MAX_DROPOUT)) {
+      GST_DEBUG_OBJECT (stream->bin, "SSRC %08x, reset: gap %d", stream->ssrc,
+          gap);
+      rtp_jitter_buffer_flush (stream->jbuf, (GFunc) lw_free_item, NULL);
+      rtp_jitter_buffer_reset_skew (stream->jbuf);
+      stream->last_popped_seqnum = -1;
+      stream->discont = TRUE;
+    } else if (G_UNLIKELY (gap <= 0)) {
+      /* we already pushed a later packet */
+      goto too_late;
+    }
+  }
+
+  item = g_slice_new (RTPJitterBufferItem);
+  item->data = buffer;
+  item->next = NULL;
+  item->prev = NULL;
+  item->type = 0;
+  item->dts = dts;
+  item->pts = pts;
+  item->seqnum = seqnum;
+  item->count = 1;
+  item->rtptime = rtptime;
+
+  if (G_UNLIKELY (!rtp_jitter_buffer_insert (stream->jbuf, item, NULL, NULL)))
+    goto duplicate;
+
+  LW_STREAM_UNLOCK (stream);
+
+  return GST_FLOW_OK;
+
+  /* ERRORS */
+invalid_buffer:
+  {
+    /* this is not fatal but should be filtered earlier */
+    GST_ELEMENT_WARNING (stream->bin, STREAM, DECODE, (NULL),
+        ("Received invalid RTP payload, dropping"));
+    gst_buffer_unref (buffer);
+    return GST_FLOW_OK;
+  }
+flushing:
+  {
+    LW_STREAM_UNLOCK (stream);
+    gst_buffer_unref (buffer);
+    return GST_FLOW_FLUSHING;
+  }
+no_clock_rate:
+  {
+    LW_STREAM_UNLOCK (stream);
+    GST_WARNING_OBJECT (stream->bin,
+        "SSRC %08x, no clock-rate for pt %d, dropping", stream->ssrc, pt);
+    gst_buffer_unref (buffer);
+    return GST_FLOW_OK;
+  }
+have_eos:
+  {
+    LW_STREAM_UNLOCK (stream);
+    GST_WARNING_OBJECT (stream->bin, "SSRC %08x, dropping buffer after EOS",
+        stream->ssrc);
+    gst_buffer_unref (buffer);
+    return GST_FLOW_EOS;
+  }
+too_late:
+  {
+    LW_STREAM_UNLOCK (stream);
+    GST_DEBUG_OBJECT (stream->bin, "SSRC %08x, packet #%d too late",
+        stream->ssrc, seqnum);
+    gst_buffer_unref (buffer);
+    return GST_FLOW_OK;
+  }
+duplicate:
+  {
+    LW_STREAM_UNLOCK (stream);
+    GST_DEBUG_OBJECT (stream->bin, "SSRC %08x, duplicate packet #%d",
+        stream->ssrc, seqnum);
+    lw_free_item (item);
+    return GST_FLOW_OK;
+  }
+}
+
+static gboolean
+lw_stream_src_event (GstPad * pad, GstObject * parent, GstEvent * event)
+{
+  GstRtpBinStream *stream = gst_pad_get_element_private (pad);
+  const GstStructure *s;
+
+  switch (GST_EVENT_TYPE (event)) {
+    case GST_EVENT_CUSTOM_UPSTREAM:
+    case GST_EVENT_CUSTOM_BOTH:
+    case GST_EVENT_CUSTOM_BOTH_OOB:
+      /* add the payload type of the pad, like rtpptdemux */
+      s = gst_event_get_structure (event);
+      if (s && !gst_structure_has_field (s, "payload")) {
+        GSList *walk;
+
+        LW_STREAM_LOCK (stream);
+        for (walk = stream->ptpads; walk; walk = g_slist_next (walk)) {
+          GstRtpBinPtPad *ptpad = walk->data;
+
+          if (ptpad->pad == pad) {
+            GstStructure *ws;
+
+            event =
+                GST_EVENT_CAST (gst_mini_object_make_writable
+                (GST_MINI_OBJECT_CAST (event)));
+            ws = gst_event_writable_structure (event);
+            gst_structure_set (ws, "payload", G_TYPE_UINT, ptpad->pt, NULL);
+            break;
+          }
+        }
+        LW_STREAM_UNLOCK (stream);
+      }
+      break;
+    default:
+      break;
+  }
+
+  return gst_pad_push_event (stream->sink, event);
+}
+
+static gboolean
+lw_stream_src_query (GstPad * pad, GstObject * parent, GstQuery * query)
+{
+  GstRtpBinStream *stream = gst_pad_get_element_private (pad);
+  gboolean res;
+
+  switch (GST_QUERY_TYPE (query)) {
+    case GST_QUERY_LATENCY:
+    {
+      GstClockTime min_latency, max_latency, latency;
+      gboolean live;
+
+      /* add our latency to the upstream latency, like rtpjitterbuffer */
+      if ((res = gst_pad_peer_query (stream->sink, query))) {
+        gst_query_parse_latency (query, &live, &min_latency, &max_latency);
+
+        LW_STREAM_LOCK (stream);
+        latency = stream->latency;
+        LW_STREAM_UNLOCK (stream);
+
+        min_latency += latency;
+        if (max_latency != -1)
+          max_latency += latency;
+
+        gst_query_set_latency (query, live, min_latency, max_latency);
+      }
+      break;
+    }
+    default:
+      res = gst_pad_query_default (pad, parent, query);
+      break;
+  }
+  return res;
+}
+
+static GstIterator *
+lw_stream_iterate_internal_links (GstPad * pad, GstObject * parent)
+{
+  GstRtpBinStream *stream = gst_pad_get_element_private (pad);
+  GstIterator *it;
+  GValue val = { 0, };
+
+  g_value_init (&val, GST_TYPE_PAD);
+  g_value_set_object (&val, stream->sink);
+  it = gst_iterator_new_single (GST_TYPE_PAD, &val);
+  g_value_unset (&val);
+
+  return it;
+}
+
+static gboolean
+lw_forward_sticky_events (GstPad * pad, GstEvent ** event, gpointer user_data)
+{
+  GstPad *srcpad = GST_PAD_CAST (user_data);
+
+  /* stream start and caps have already been pushed */
+  if (GST_EVENT_TYPE (*event) >= GST_EVENT_SEGMENT)
+    gst_pad_push_event (srcpad, gst_event_ref (*event));
+
+  return TRUE;
+}
+
+/* get the pad of rtpbin for @pt in @srcpad, creating it when needed, and
+ * make sure it has the current caps. Called from the streaming thread. */
+static GstFlowReturn
+lw_stream_get_pad (GstRtpBinStream * stream, guint8 pt, GstPad ** result)
+{
+  GstRtpBin *rtpbin = stream->bin;
+  GstPad *srcpad = NULL;
+  GstCaps *caps;
+  gboolean newcaps = FALSE;
+  gint key;
+  GSList *walk;
+
+  /* without demuxing, all payload types go to one pad */
+  key = rtpbin->ignore_pt ? 255 : pt;
+
+  LW_STREAM_LOCK (stream);
+  for (walk = stream->ptpads; walk; walk = g_slist_next (walk)) {
+    GstRtpBinPtPad *ptpad = walk->data;
+
+    if (ptpad->pt == key) {
+      srcpad = gst_object_ref (ptpad->pad);
+      newcaps = ptpad->newcaps;
+      ptpad->newcaps = FALSE;
+      break;
+    }
+  }
+  LW_STREAM_UNLOCK (stream);
+
+  if (srcpad == NULL) {
+    GstRtpBinPtPad *ptpad;
+    GstElementClass *klass;
+    GstPadTemplate *templ;
+    GstEvent *event;
+    gchar *padname;
+
+    caps = lw_stream_get_caps (stream, pt);
+    if (!caps)
+      goto no_caps;
+
+    GST_RTP_BIN_SHUTDOWN_LOCK (rtpbin, shutdown);
+
+    klass = GST_ELEMENT_GET_CLASS (rtpbin);
+    templ = gst_element_class_get_pad_template (klass, "recv_rtp_src_%u_%u_%u");
+    padname = g_strdup_printf ("recv_rtp_src_%u_%u_%u",
+        stream->session->id, stream->ssrc, key);
+    srcpad = gst_pad_new_from_template (templ, padname);
+    g_free (padname);
+    gst_pad_use_fixed_caps (srcpad);
+    gst_pad_set_element_private (srcpad, stream);
+    gst_pad_set_event_function (srcpad, lw_stream_src_event);
+    gst_pad_set_query_function (srcpad, lw_stream_src_query);
+    gst_pad_set_iterate_internal_links_function (srcpad,
+        lw_stream_iterate_internal_links);
+
+    GST_DEBUG_OBJECT (rtpbin, "new payload pad %d", key);
+
+    gst_pad_set_active (srcpad, TRUE);
+
+    /* stream start first, then the caps and the other sticky events */
+    event = gst_pad_get_sticky_event (stream->sink, GST_EVENT_STREAM_START, 0);
+    if (event)
+      gst_pad_push_event (srcpad, event);
+
+    caps = gst_caps_make_writable (caps);
+    if (!rtpbin->ignore_pt)
+      gst_caps_set_simple (caps, "payload", G_TYPE_INT, pt, NULL);
+    gst_pad_set_caps (srcpad, caps);
+    gst_caps_unref (caps);
+
+    gst_pad_sticky_events_foreach (stream->sink, lw_forward_sticky_events,
+        srcpad);
+
+    ptpad = g_slice_new (GstRtpBinPtPad);
+    ptpad->pt = key;
+    ptpad->pad = gst_object_ref (srcpad);
+    ptpad->newcaps = FALSE;
+    LW_STREAM_LOCK (stream);
+    stream->ptpads = g_slist_append (stream->ptpads, ptpad);
+    LW_STREAM_UNLOCK (stream);
+
+    GST_RTP_BIN_SHUTDOWN_UNLOCK (rtpbin);
+
+    gst_element_add_pad (GST_ELEMENT_CAST (rtpbin), srcpad);
+  } else if (G_UNLIKELY (newcaps)) {
+    GST_DEBUG_OBJECT (rtpbin, "need new caps for %d", pt);
+    caps = lw_stream_get_caps (stream, pt);
+    if (!caps)
+      goto no_caps;
+
+    caps = gst_caps_make_writable (caps);
+    if (!rtpbin->ignore_pt)
+      gst_caps_set_simple (caps, "payload", G_TYPE_INT, pt, NULL);
+    gst_pad_set_caps (srcpad, caps);
+    gst_caps_unref (caps);
+  }
+
+  if (!rtpbin->ignore_pt && pt != stream->last_out_pt) {
+    stream->last_out_pt = pt;
+    payload_type_change (NULL, pt, stream->session);
+  }
+
+  *result = srcpad;
+
+  return GST_FLOW_OK;
+
+  /* ERRORS */
+no_caps:
+  {
+    GST_ELEMENT_ERROR (rtpbin, STREAM, DECODE, (NULL),
+        ("Could not get caps for payload"));
+    if (srcpad)
+      gst_object_unref (srcpad);
+    return GST_FLOW_ERROR;
+  }
+shutdown:
+  {
+    GST_DEBUG_OBJECT (rtpbin, "ignoring, we are shutting down");
+    gst_caps_unref (caps);
+    return GST_FLOW_FLUSHING;
+  }
+}
+
+struct LwPushData
+{
+  GstRtpBinStream *stream;
+  /* consecutive buffers of pt */
+  GstBufferList *sublist;
+  guint8 pt;
+  GstFlowReturn ret;
+};
+
+static GstFlowReturn
+lw_push_sublist (struct LwPushData *data)
+{
+  GstPad *srcpad;
+  GstFlowReturn ret;
+
+  ret = lw_stream_get_pad (data->stream, data->pt, &srcpad);
+  if (ret != GST_FLOW_OK) {
+    gst_buffer_list_unref (data->sublist);
+  } else {
+    if (gst_buffer_list_length (data->sublist) == 1) {
+      ret = gst_pad_push (srcpad,
+          gst_buffer_ref (gst_buffer_list_get (data->sublist, 0)));
+      gst_buffer_list_unref (data->sublist);
+    } else {
+      ret = gst_pad_push_list (srcpad, data->sublist);
+    }
+    gst_object_unref (srcpad);
+  }
+  data->sublist = NULL;
+
+  return ret;
+}
+
+static gboolean
+lw_split_list_buffer (GstBuffer ** buffer, guint idx, gpointer user_data)
+{
+  struct LwPushData *data = user_data;
+  GstRTPBuffer rtp = GST_RTP_BUFFER_INIT;
+  guint8 pt;
+
+  /* the buffer was mapped when it was inserted */
+  gst_rtp_buffer_map (*buffer, GST_MAP_READ, &rtp);
+  pt = gst_rtp_buffer_get_payload_type (&rtp);
+  gst_rtp_buffer_unmap (&rtp);
+
+  if (data->sublist && pt != data->pt) {
+    /* other payload type, push what we collected so far */
+    data->ret = lw_push_sublist (data);
+    if (data->ret != GST_FLOW_OK)
+      return FALSE;
+  }
+  if (data->sublist == NULL) {
+    data->sublist = gst_buffer_list_new ();
+    data->pt = pt;
+  }
+  /* take the buffer out of the list */
+  gst_buffer_list_add (data->sublist, *buffer);
+  *buffer = NULL;
+
+  return TRUE;
+}
+
+/* push the buffers of @outlist on the pads of their payload type, in
+ * sublists of consecutive buffers with the same payload type */
+static GstFlowReturn
+lw_stream_push (GstRtpBinStream * stream, GstBufferList * outlist)
+{
+  struct LwPushData data;
+
+  data.stream = stream;
+  data.sublist = NULL;
+  data.pt = 0;
+  data.ret = GST_FLOW_OK;
+
+  gst_buffer_list_foreach (outlist, lw_split_list_buffer, &data);
+  gst_buffer_list_unref (outlist);
+
+  if (data.sublist) {
+    if (data.ret == GST_FLOW_OK)
+      data.ret = lw_push_sublist (&data);
+    else
+      gst_buffer_list_unref (data.sublist);
+  }
+
+  return data.ret;
+}
+
+/* push all the packets that wait in the jitterbuffer */
+static GstFlowReturn
+lw_stream_drain (GstRtpBinStream * stream)
+{
+  GstBufferList *outlist = NULL;
+
+  LW_STREAM_LOCK (stream);
+  lw_stream_pop_ready (stream, GST_CLOCK_TIME_NONE, TRUE, &outlist);
+  LW_STREAM_UNLOCK (stream);
+
+  if (outlist == NULL)
+    return GST_FLOW_OK;
+
+  return lw_stream_push (stream, outlist);
+}
+
+static GstFlowReturn
+lw_stream_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
+{
+  GstRtpBinStream *stream = gst_pad_get_element_private (pad);
+  GstBufferList *outlist = NULL;
+  GstClockTime now = GST_CLOCK_TIME_NONE;
+  GstFlowReturn ret;
+
+  ret = lw_stream_insert (stream, buffer, &now);
+  if (ret != GST_FLOW_OK)
+    return ret;
+
+  LW_STREAM_LOCK (stream);
+  lw_stream_pop_ready (stream, now, FALSE, &outlist);
+  LW_STREAM_UNLOCK (stream);
+
+  if (outlist)
+    ret = lw_stream_push (stream, outlist);
+
+  return ret;
+}
+
+static GstFlowReturn
+lw_stream_chain_list (GstPad * pad, GstObject * parent, GstBufferList * list)
+{
+  GstRtpBinStream *stream = gst_pad_get_element_private (pad);
+  GstBufferList *outlist = NULL;
+  GstClockTime now = GST_CLOCK_TIME_NONE;
+  GstFlowReturn ret = GST_FLOW_OK;
+  guint i, len;
+
+  /* insert all packets first and pop them with one lock */
+  len = gst_buffer_list_length (list);
+  for (i = 0; i < len && ret == GST_FLOW_OK; i++)
+    ret = lw_stream_insert (stream,
+        gst_buffer_ref (gst_buffer_list_get (list, i)), &now);
+  gst_buffer_list_unref (list);
+
+  if (ret != GST_FLOW_OK)
+    return ret;
+
+  LW_STREAM_LOCK (stream);
+  lw_stream_pop_ready (stream, now, FALSE, &outlist);
+  LW_STREAM_UNLOCK (stream);
+
+  if (outlist)
+    ret = lw_stream_push (stream, outlist);
+
+  return ret;
+}
+
+static gboolean
+lw_stream_sink_event (GstPad * pad, GstObject * parent, GstEvent * event)
+{
+  GstRtpBinStream *stream = gst_pad_get_element_private (pad);
+  GSList *walk;
+
+  GST_DEBUG_OBJECT (stream->bin, "SSRC %08x, received %s", stream->ssrc,
+      GST_EVENT_TYPE_NAME (event));
+
+  switch (GST_EVENT_TYPE (event)) {
+    case GST_EVENT_FLUSH_START:
+      LW_STREAM_LOCK (stream);
+      stream->flushing = TRUE;
+      LW_STREAM_UNLOCK (stream);
+      break;
+    case GST_EVENT_FLUSH_STOP:
+      LW_STREAM_LOCK (stream);
+      rtp_jitter_buffer_flush (stream->jbuf, (GFunc) lw_free_item, NULL);
+      rtp_jitter_buffer_reset_skew (stream->jbuf);
+      stream->last_popped_seqnum = -1;
+      stream->flushing = FALSE;
+      stream->eos = FALSE;
+      LW_STREAM_UNLOCK (stream);
+      break;
+    default:
+      /* keep the events in order with the packets */
+      if (GST_EVENT_IS_SERIALIZED (event))
+        lw_stream_drain (stream);
+      break;
+  }
+
+  switch (GST_EVENT_TYPE (event)) {
+    case GST_EVENT_CAPS:
+      /* don't forward the caps, the pads get the caps of their payload type
+       * with the next packet, which gets a new clock-rate too */
+      LW_STREAM_LOCK (stream);
+      stream->last_pt = -1;
+      for (walk = stream->ptpads; walk; walk = g_slist_next (walk))
+        ((GstRtpBinPtPad *) walk->data)->newcaps = TRUE;
+      LW_STREAM_UNLOCK (stream);
+      gst_event_unref (event);
+      return TRUE;
+    case GST_EVENT_SEGMENT:
+    {
+      GstSegment segment;
+
+      gst_event_copy_segment (event, &segment);
+      /* we need time for now */
+      if (segment.format != GST_FORMAT_TIME)
+        goto newseg_wrong_format;
+
+      LW_STREAM_LOCK (stream);
+      stream->segment = segment;
+      LW_STREAM_UNLOCK (stream);
+      break;
+    }
+    case GST_EVENT_EOS:
+      LW_STREAM_LOCK (stream);
+      stream->eos = TRUE;
+      LW_STREAM_UNLOCK (stream);
+      break;
+    default:
+      break;
+  }
+
+  return lw_stream_forward_event (stream, event);
+
+  /* ERRORS */
+newseg_wrong_format:
+  {
+    GST_DEBUG_OBJECT (stream->bin, "received non TIME newsegment");
+    gst_event_unref (event);
+    return FALSE;
+  }
+}
+
+static gboolean
+lw_stream_sink_query (GstPad * pad, GstObject * parent, GstQuery * query)
+{
+  gboolean res;
+
+  switch (GST_QUERY_TYPE (query)) {
+    case GST_QUERY_CAPS:
+    {
+      GstCaps *filter, *caps;
+
+      gst_query_parse_caps (query, &filter);
+      caps = gst_caps_new_empty_simple ("application/x-rtp");
+      if (filter) {
+        GstCaps *tmp;
+
+        tmp = gst_caps_intersect_full (filter, caps, GST_CAPS_INTERSECT_FIRST);
+        gst_caps_unref (caps);
+        caps = tmp;
+      }
+      gst_query_set_caps_result (query, caps);
+      gst_caps_unref (caps);
+      res = TRUE;
+      break;
+    }
+    default:
+      res = gst_pad_query_default (pad, parent, query);
+      break;
+  }
+  return res;
+}
+
+/* the RTCP of the stream, collect the SR info and the sync values of the
+ * jitterbuffer, like rtpjitterbuffer does before it emits handle-sync */
+static GstFlowReturn
+lw_stream_chain_rtcp (GstPad * pad, GstObject * parent, GstBuffer * buffer)
+{
+  GstRtpBinStream *stream = gst_pad_get_element_private (pad);
+  GstRTCPBuffer rtcp = { NULL, };
+  GstRTCPPacket packet;
+  guint64 base_rtptime, base_time, last_rtptime, ext_rtptime, diff;
+  gint64 clock_base;
+  guint32 clock_rate;
+  guint32 ssrc, rtptime;
+  GstStructure *s;
+
+  if (G_UNLIKELY (!gst_rtcp_buffer_validate (buffer)))
+    goto invalid_buffer;
+
+  gst_rtcp_buffer_map (buffer, GST_MAP_READ, &rtcp);
+
+  /* first packet must be SR or RR or else the validate would have failed */
+  if (!gst_rtcp_buffer_get_first_packet (&rtcp, &packet) ||
+      gst_rtcp_packet_get_type (&packet) != GST_RTCP_TYPE_SR)
+    goto ignore_buffer;
+
+  gst_rtcp_packet_sr_get_sender_info (&packet, &ssrc, NULL, &rtptime, NULL,
+      NULL);
+  gst_rtcp_buffer_unmap (&rtcp);
+
+  GST_DEBUG_OBJECT (stream->bin, "received RTCP of SSRC %08x", ssrc);
+
+  LW_STREAM_LOCK (stream);
+  /* convert the RTP timestamp to our extended timestamp, using the same offset
+   * we used in the jitterbuffer */
+  ext_rtptime = stream->jbuf->ext_rtptime;
+  ext_rtptime = gst_rtp_buffer_ext_timestamp (&ext_rtptime, rtptime);
+  rtp_jitter_buffer_get_sync (stream->jbuf, &base_rtptime, &base_time,
+      &clock_rate, &last_rtptime);
+  clock_base = stream->rtp_clock_base;
+  LW_STREAM_UNLOCK (stream);
+
+  if (base_rtptime == -1 || clock_rate == -1 || base_time == -1)
+    goto no_sync;
+  /* we can't accept anything that happened before we did the last resync */
+  if (base_rtptime > ext_rtptime)
+    goto no_sync;
+
+  /* the SR RTP timestamp must be something close to what we last observed
+   * in the jitterbuffer */
+  if (ext_rtptime > last_rtptime) {
+    diff = ext_rtptime - last_rtptime;
+    /* way too far ahead, still sync but invalidate the RTCP data */
+    if (diff > clock_rate)
+      ext_rtptime = -1;
+  }
+
+  s = gst_structure_new ("application/x-rtp-sync",
+      "base-rtptime", G_TYPE_UINT64, base_rtptime,
+      "base-time", G_TYPE_UINT64, base_time,
+      "clock-rate", G_TYPE_UINT, clock_rate,
+      "clock-base", G_TYPE_UINT64, clock_base,
+      "sr-ext-rtptime", G_TYPE_UINT64, ext_rtptime,
+      "sr-buffer", GST_TYPE_BUFFER, buffer, NULL);
+  gst_rtp_bin_handle_sync (NULL, s, stream);
+  gst_structure_free (s);
+
+done:
+  gst_buffer_unref (buffer);
+
+  return GST_FLOW_OK;
+
+  /* ERRORS */
+invalid_buffer:
+  {
+    /* this is not fatal but should be filtered earlier */
+    GST_ELEMENT_WARNING (stream->bin, STREAM, DECODE, (NULL),
+        ("Received invalid RTCP payload, dropping"));
+    goto done;
+  }
+ignore_buffer:
+  {
+    GST_DEBUG_OBJECT (stream->bin, "ignoring RTCP packet");
+    gst_rtcp_buffer_unmap (&rtcp);
+    goto done;
+  }
+no_sync:
+  {
+    GST_DEBUG_OBJECT (stream->bin, "dropping RTCP packet, no RTP values");
+    goto done;
+  }
+}
+
+static gboolean
+lw_stream_sink_rtcp_event (GstPad * pad, GstObject * parent, GstEvent * event)
+{
+  /* the RTCP of the stream is not forwarded */
+  gst_event_unref (event);
+
+  return TRUE;
+}
+
+/* make the pads and the jitterbuffer of a lightweight stream */
+static void
+lw_stream_init (GstRtpBinStream * stream)
+{
+  GstRtpBin *rtpbin = stream->bin;
+  RTPJitterBufferMode mode;
+  gchar *padname;
+
+  g_mutex_init (&stream->lock);
+
+  stream->jbuf = rtp_jitter_buffer_new ();
+  /* there are no buffering messages, buffer mode timestamps like slave mode */
+  mode = rtpbin->buffer_mode;
+  if (mode == RTP_JITTER_BUFFER_MODE_BUFFER)
+    mode = RTP_JITTER_BUFFER_MODE_SLAVE;
+  rtp_jitter_buffer_set_mode (stream->jbuf, mode);
+  rtp_jitter_buffer_set_delay (stream->jbuf, rtpbin->latency_ns);
+
+  gst_segment_init (&stream->segment, GST_FORMAT_TIME);
+  stream->latency = rtpbin->latency_ns;
+  stream->last_pt = -1;
+  stream->clock_rate = -1;
+  stream->rtp_clock_base = -1;
+  stream->last_popped_seqnum = -1;
+  stream->last_out_pt = -1;
+
+  padname = g_strdup_printf ("sink_%u", stream->ssrc);
+  stream->sink = gst_pad_new (padname, GST_PAD_SINK);
+  g_free (padname);
+  gst_pad_set_element_private (stream->sink, stream);
+  gst_pad_set_chain_function (stream->sink, lw_stream_chain);
+  gst_pad_set_chain_list_function (stream->sink, lw_stream_chain_list);
+  gst_pad_set_event_function (stream->sink, lw_stream_sink_event);
+  gst_pad_set_query_function (stream->sink, lw_stream_sink_query);
+  gst_object_ref_sink (stream->sink);
+  gst_pad_set_active (stream->sink, TRUE);
+
+  padname = g_strdup_printf ("rtcp_sink_%u", stream->ssrc);
+  stream->rtcp_sink = gst_pad_new (padname, GST_PAD_SINK);
+  g_free (padname);
+  gst_pad_set_element_private (stream->rtcp_sink, stream);
+  gst_pad_set_chain_function (stream->rtcp_sink, lw_stream_chain_rtcp);
+  gst_pad_set_event_function (stream->rtcp_sink, lw_stream_sink_rtcp_event);
+  gst_object_ref_sink (stream->rtcp_sink);
+  gst_pad_set_active (stream->rtcp_sink, TRUE);
+}
+
+/* unlink the pads of a lightweight stream and wait for the streaming
+ * threads, after this the stream doesn't call the sync handler anymore */
+static void
+lw_stream_stop (GstRtpBinStream * stream)
+{
+  GstPad *peer;
+
+  /* the SSRC demuxer might still have its pads */
+  if ((peer = gst_pad_get_peer (stream->sink))) {
+    gst_pad_unlink (peer, stream->sink);
+    gst_object_unref (peer);
+  }
+  if ((peer = gst_pad_get_peer (stream->rtcp_sink))) {
+    gst_pad_unlink (peer, stream->rtcp_sink);
+    gst_object_unref (peer);
+  }
+
+  /* wait for the streaming threads */
+  gst_pad_set_active (stream->sink, FALSE);
+  gst_pad_set_active (stream->rtcp_sink, FALSE);
+}
+
+/* remove the pads of a stopped lightweight stream and free its resources.
+ * Called with RTP_BIN_LOCK */
+static void
+lw_stream_clear (GstRtpBinStream * stream, GstRtpBin * bin)
+{
+  GSList *walk;
+
+  for (walk = stream->ptpads; walk; walk = g_slist_next (walk)) {
+    GstRtpBinPtPad *ptpad = walk->data;
+
+    gst_pad_set_active (ptpad->pad, FALSE);
+    gst_element_remove_pad (GST_ELEMENT_CAST (bin), ptpad->pad);
+    gst_object_unref (ptpad->pad);
+    g_slice_free (GstRtpBinPtPad, ptpad);
+  }
+  g_slist_free (stream->ptpads);
+  stream->ptpads = NULL;
+
+  gst_object_unref (stream->sink);
+  gst_object_unref (stream->rtcp_sink);
+
+  rtp_jitter_buffer_flush (stream->jbuf, (GFunc) lw_free_item, NULL);
+  g_object_unref (stream->jbuf);
+  g_mutex_clear (&stream->lock);
+}
+
 /* create a new stream with @ssrc in @session. Must be called with
  * RTP_SESSION_LOCK. */
 static GstRtpBinStream *
@@ -1496,6 +2553,22 @@ create_stream (GstRtpBinSession * session, guint32 ssrc)
 
   rtpbin = session->bin;
 
+  if (rtpbin->lightweight) {
+    stream = g_new0 (GstRtpBinStream, 1);
+    stream->ssrc = ssrc;
+    stream->bin = rtpbin;
+    stream->session = session;
+    stream->have_sync = FALSE;
+    stream->rt_delta = 0;
+    stream->rtp_delta = 0;
+    stream->percent = 100;
+    stream->clock_base = -100 * GST_SECOND;
+    lw_stream_init (stream);
+    session->streams = g_slist_prepend (session->streams, stream);
+
+    return stream;
+  }
+
   if (!(buffer = gst_element_factory_make ("rtpjitterbuffer", NULL)))
     goto no_jitterbuffer;
 
@@ -1588,32 +2661,38 @@ free_stream (GstRtpBinStream * stream, GstRtpBin * bin)
 
   GST_DEBUG_OBJECT (bin, "freeing stream %p", stream);
 
-  if (stream->demux) {
-    g_signal_handler_disconnect (stream->demux, stream->demux_newpad_sig);
-    g_signal_handler_disconnect (stream->demux, stream->demux_ptreq_sig);
-    g_signal_handler_disconnect (stream->demux, stream->demux_ptchange_sig);
+  if (LW_STREAM_IS_LIGHTWEIGHT (stream)) {
+    lw_stream_stop (stream);
+  } else {
+    if (stream->demux) {
+      g_signal_handler_disconnect (stream->demux, stream->demux_newpad_sig);
+      g_signal_handler_disconnect (stream->demux, stream->demux_ptreq_sig);
+      g_signal_handler_disconnect (stream->demux, stream->demux_ptchange_sig);
+    }
+    g_signal_handler_disconnect (stream->buffer,
+        stream->buffer_handlesync_sig);
+    g_signal_handler_disconnect (stream->buffer, stream->buffer_ptreq_sig);
+    g_signal_handler_disconnect (stream->buffer, stream->buffer_ntpstop_sig);
+
+    if (stream->demux)
+      gst_element_set_locked_state (stream->demux, TRUE);
+    gst_element_set_locked_state (stream->buffer, TRUE);
+
+    if (stream->demux)
+      gst_element_set_state (stream->demux, GST_STATE_NULL);
+    gst_element_set_state (stream->buffer, GST_STATE_NULL);
+
+    /* now remove this signal, we need this while going to NULL because it to
+     * do some cleanups */
+    if (stream->demux)
+      g_signal_handler_disconnect (stream->demux,
+          stream->demux_padremoved_sig);
   }
-  g_signal_handler_disconnect (stream->buffer, stream->buffer_handlesync_sig);
-  g_signal_handler_disconnect (stream->buffer, stream->buffer_ptreq_sig);
-  g_signal_handler_disconnect (stream->buffer, stream->buffer_ntpstop_sig);
-
-  if (stream->demux)
-    gst_element_set_locked_state (stream->demux, TRUE);
-  gst_element_set_locked_state (stream->buffer, TRUE);
-
-  if (stream->demux)
-    gst_element_set_state (stream->demux, GST_STATE_NULL);
-  gst_element_set_state (stream->buffer, GST_STATE_NULL);
-
-  /* now remove this signal, we need this while going to NULL because it to
-   * do some cleanups */
-  if (stream->demux)
-    g_signal_handler_disconnect (stream->demux, stream->demux_padremoved_sig);
-
-  gst_bin_remove (GST_BIN_CAST (bin), stream->buffer);
-  if (stream->demux)
-    gst_bin_remove (GST_BIN_CAST (bin), stream->demux);
 
+  /* the jitterbuffer can't call the sync handler anymore, remove the stream
+   * from its clients before the jitterbuffer goes away because the sync
+   * handler of other streams uses it */
+  GST_RTP_BIN_SYNC_LOCK (bin);
   for (clients = bin->clients; clients; clients = next_client) {
     GstRtpBinClient *client = (GstRtpBinClient *) clients->data;
     GSList *streams, *next_stream;
@@ -1637,6 +2716,16 @@ free_stream (GstRtpBinStream * stream, GstRtpBin * bin)
       }
     }
   }
+  GST_RTP_BIN_SYNC_UNLOCK (bin);
+
+  if (LW_STREAM_IS_LIGHTWEIGHT (stream)) {
+    lw_stream_clear (stream, bin);
+  } else {
+    gst_bin_remove (GST_BIN_CAST (bin), stream->buffer);
+    if (stream->demux)
+      gst_bin_remove (GST_BIN_CAST (bin), stream->demux);
+  }
+
   g_free (stream);
 }
 
@@ -2127,6 +3216,29 @@ gst_rtp_bin_class_init (GstRtpBinClass * klass)
           DEFAULT_DO_RETRANSMISSION,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstRtpBin:lightweight:
+   *
+   * Handle each received SSRC without rtpjitterbuffer and rtpptdemux
+   * elements. The packets are reordered by an internal jitterbuffer in the
+   * streaming thread and pushed on a pad of rtpbin for each payload type.
+   * This saves the elements, threads and pads of large sessions.
+   *
+   * The pads and the #GstRtpBin::request-pt-map and
+   * #GstRtpBin::payload-type-change signals are the same as without this
+   * property. The #GstRtpBin::new-jitterbuffer and #GstRtpBin::on-npt-stop
+   * signals are not emitted. Of the jitterbuffer properties, only the
+   * latency is used. Packets after a gap wait until a later packet arrives
+   * after the latency or until the next serialized event and there is no
+   * buffering mode. Applies to the streams created after it was set.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (gobject_class, PROP_LIGHTWEIGHT,
+      g_param_spec_boolean ("lightweight", "Lightweight",
+          "Reorder and demux the received streams without an element per SSRC",
+          DEFAULT_LIGHTWEIGHT, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gstelement_class->change_state = GST_DEBUG_FUNCPTR (gst_rtp_bin_change_state);
   gstelement_class->request_new_pad =
       GST_DEBUG_FUNCPTR (gst_rtp_bin_request_new_pad);
@@ -2175,6 +3287,8 @@ gst_rtp_bin_init (GstRtpBin * rtpbin)
   rtpbin->priv = GST_RTP_BIN_GET_PRIVATE (rtpbin);
   g_mutex_init (&rtpbin->priv->bin_lock);
   g_mutex_init (&rtpbin->priv->dyn_lock);
+  g_mutex_init (&rtpbin->priv->sync_lock);
+  rtpbin->priv->clients_by_cname = g_hash_table_new (g_str_hash, g_str_equal);
 
   rtpbin->latency_ms = DEFAULT_LATENCY_MS;
   rtpbin->latency_ns = DEFAULT_LATENCY_MS * GST_MSECOND;
@@ -2189,6 +3303,7 @@ gst_rtp_bin_init (GstRtpBin * rtpbin)
   rtpbin->use_pipeline_clock = DEFAULT_USE_PIPELINE_CLOCK;
   rtpbin->send_sync_event = DEFAULT_DO_SYNC_EVENT;
   rtpbin->do_retransmission = DEFAULT_DO_RETRANSMISSION;
+  rtpbin->lightweight = DEFAULT_LIGHTWEIGHT;
 
   /* some default SDES entries */
   cname = g_strdup_printf ("user%u@host-%x", g_random_int (), g_random_int ());
@@ -2226,6 +3341,8 @@ gst_rtp_bin_finalize (GObject * object)
 
   g_mutex_clear (&rtpbin->priv->bin_lock);
   g_mutex_clear (&rtpbin->priv->dyn_lock);
+  g_mutex_clear (&rtpbin->priv->sync_lock);
+  g_hash_table_destroy (rtpbin->priv->clients_by_cname);
 
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
@@ -2349,6 +3466,11 @@ gst_rtp_bin_set_property (GObject * object, guint prop_id,
       gst_rtp_bin_propagate_property_to_jitterbuffer (rtpbin,
           "do-retransmission", value);
       break;
+    case PROP_LIGHTWEIGHT:
+      GST_RTP_BIN_LOCK (rtpbin);
+      rtpbin->lightweight = g_value_get_boolean (value);
+      GST_RTP_BIN_UNLOCK (rtpbin);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -2411,6 +3533,11 @@ gst_rtp_bin_get_property (GObject * object, guint prop_id,
       g_value_set_boolean (value, rtpbin->do_retransmission);
       GST_RTP_BIN_UNLOCK (rtpbin);
       break;
+    case PROP_LIGHTWEIGHT:
+      GST_RTP_BIN_LOCK (rtpbin);
+      g_value_set_boolean (value, rtpbin->lightweight);
+      GST_RTP_BIN_UNLOCK (rtpbin);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -2573,6 +3700,10 @@ gst_rtp_bin_handle_message (GstBin * bin, GstMessage * message)
               GstElement *element = stream->buffer;
               guint64 last_out;
 
+              /* lightweight streams don't buffer */
+              if (LW_STREAM_IS_LIGHTWEIGHT (stream))
+                continue;
+
               g_signal_emit_by_name (element, "set-active", active, offset,
                   &last_out);
 
@@ -2848,6 +3979,22 @@ new_ssrc_pad_found (GstElement * element, guint ssrc, GstPad * pad,
   if (!stream)
     goto no_stream;
 
+  if (LW_STREAM_IS_LIGHTWEIGHT (stream)) {
+    GST_DEBUG_OBJECT (rtpbin, "linking lightweight stream");
+    padname = g_strdup_printf ("src_%u", ssrc);
+    srcpad = gst_element_get_static_pad (element, padname);
+    g_free (padname);
+    gst_pad_link_full (srcpad, stream->sink, GST_PAD_LINK_CHECK_NOTHING);
+    gst_object_unref (srcpad);
+
+    padname = g_strdup_printf ("rtcp_src_%u", ssrc);
+    srcpad = gst_element_get_static_pad (element, padname);
+    g_free (padname);
+    gst_pad_link_full (srcpad, stream->rtcp_sink, GST_PAD_LINK_CHECK_NOTHING);
+    gst_object_unref (srcpad);
+    goto done;
+  }
+
   /* get pad and link */
   GST_DEBUG_OBJECT (rtpbin, "linking jitterbuffer RTP");
   padname = g_strdup_printf ("src_%u", ssrc);
@@ -2912,6 +4059,7 @@ new_ssrc_pad_found (GstElement * element, guint ssrc, GstPad * pad,
     gst_object_unref (pad);
   }
 
+done:
   GST_RTP_SESSION_UNLOCK (session);
   GST_RTP_BIN_SHUTDOWN_UNLOCK (rtpbin);
 
@@ -59,6 +59,7 @@ struct _GstRtpBin {
   gboolean        send_sync_event;
   GstClockTime    buffer_start;
   gboolean        do_retransmission;
+  gboolean        lightweight;
   /* a list of session */
   GSList         *sessions;
 
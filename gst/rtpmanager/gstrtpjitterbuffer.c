@@ -106,6 +106,7 @@
 #include "gstrtpjitterbuffer.h"
 #include "rtpjitterbuffer.h"
 #include "rtpstats.h"
+#include "rtptimerservice.h"
 
 #include <gst/glib-compat-private.h>
 
@@ -134,6 +135,7 @@ enum
 #define DEFAULT_RTX_DELAY_REORDER   3
 #define DEFAULT_RTX_RETRY_TIMEOUT   -1
 #define DEFAULT_RTX_RETRY_PERIOD    -1
+#define DEFAULT_SHARED_TIMER        FALSE
 
 #define DEFAULT_AUTO_RTX_DELAY (20 * GST_MSECOND)
 #define DEFAULT_AUTO_RTX_TIMEOUT (40 * GST_MSECOND)
@@ -153,6 +155,7 @@ enum
   PROP_RTX_RETRY_TIMEOUT,
   PROP_RTX_RETRY_PERIOD,
   PROP_STATS,
+  PROP_SHARED_TIMER,
   PROP_LAST
 };
 
@@ -175,10 +178,18 @@ enum
 #define JBUF_SIGNAL_TIMER(priv) G_STMT_START {            \
   if (G_UNLIKELY ((priv)->waiting_timer)) {               \
     GST_DEBUG ("signal timer");                           \
-    g_cond_signal (&(priv)->jbuf_timer);                  \
+    if ((priv)->timer_entry) {                            \
+      (priv)->waiting_timer = FALSE;                      \
+      rtp_timer_service_schedule ((priv)->timer_service,  \
+          (priv)->timer_entry, 0);                        \
+    } else                                                \
+      g_cond_signal (&(priv)->jbuf_timer);                \
   }                                                       \
 } G_STMT_END
 
+/* when we are waiting for a timer to expire */
+#define TIMER_SCHEDULED(priv) ((priv)->clock_id != NULL || (priv)->timer_scheduled)
+
 #define JBUF_WAIT_EVENT(priv,label) G_STMT_START {       \
   GST_DEBUG ("waiting event");                           \
   (priv)->waiting_event = TRUE;                          \
@@ -234,6 +245,11 @@ struct _GstRtpJitterBufferPrivate
 
   gboolean timer_running;
   GThread *timer_thread;
+  /* when using the shared timer service */
+  gboolean timer_shared;
+  RTPTimerService *timer_service;
+  RTPTimerServiceEntry *timer_entry;
+  gboolean timer_scheduled;
 
   /* properties */
   guint latency_ms;
@@ -246,6 +262,7 @@ struct _GstRtpJitterBufferPrivate
   gint rtx_delay_reorder;
   gint rtx_retry_timeout;
   gint rtx_retry_period;
+  gboolean shared_timer;
 
   /* the last seqnum we pushed out */
   guint32 last_popped_seqnum;
@@ -263,7 +280,14 @@ struct _GstRtpJitterBufferPrivate
   guint32 last_in_seqnum;
   guint32 next_in_seqnum;
 
-  GArray *timers;
+  /* pending timers in two binary heaps ordered by timeout. EXPECTED timers
+   * have their own heap because their timeout does not include the latency
+   * and offset that is added to the timeout of the other timers. */
+  GPtrArray *timers[2];
+  /* pending timers by seqnum */
+  GHashTable *timer_index;
+  /* EXPECTED timers up to this seqnum were checked for a too large gap */
+  guint32 timers_checked_seqnum;
 
   /* start and stop ranges */
   GstClockTime npt_start;
@@ -321,9 +345,13 @@ typedef enum
   TIMER_TYPE_EOS
 } TimerType;
 
-typedef struct
+typedef struct _TimerData TimerData;
+
+struct _TimerData
 {
+  guint heap;
   guint idx;
+  TimerData *next;
   guint16 seqnum;
   guint num;
   TimerType type;
@@ -334,7 +362,9 @@ typedef struct
   GstClockTime rtx_retry;
   GstClockTime rtx_last;
   guint num_rtx_retry;
-} TimerData;
+};
+
+#define TIMER_HEAP(type) ((type) == TIMER_TYPE_EXPECTED ? 0 : 1)
 
 #define GST_RTP_JITTER_BUFFER_GET_PRIVATE(o) \
   (G_TYPE_INSTANCE_GET_PRIVATE ((o), GST_TYPE_RTP_JITTER_BUFFER, \
@@ -389,6 +419,8 @@ static GstPad *gst_rtp_jitter_buffer_request_new_pad (GstElement * element,
 static void gst_rtp_jitter_buffer_release_pad (GstElement * element,
     GstPad * pad);
 static GstClock *gst_rtp_jitter_buffer_provide_clock (GstElement * element);
+static gboolean gst_rtp_jitter_buffer_set_clock (GstElement * element,
+    GstClock * clock);
 
 /* pad overrides */
 static GstCaps *gst_rtp_jitter_buffer_getcaps (GstPad * pad, GstCaps * filter);
@@ -426,6 +458,8 @@ gst_rtp_jitter_buffer_set_active (GstRtpJitterBuffer * jitterbuffer,
 static void do_handle_sync (GstRtpJitterBuffer * jitterbuffer);
 
 static void unschedule_current_timer (GstRtpJitterBuffer * jitterbuffer);
+static void attach_timer_service (GstRtpJitterBuffer * jitterbuffer);
+static void detach_timer_service (GstRtpJitterBuffer * jitterbuffer);
 static void remove_all_timers (GstRtpJitterBuffer * jitterbuffer);
 
 static void wait_next_timeout (GstRtpJitterBuffer * jitterbuffer);
@@ -603,6 +637,19 @@ gst_rtp_jitter_buffer_class_init (GstRtpJitterBufferClass * klass)
       g_param_spec_boxed ("stats", "Statistics",
           "Various statistics", GST_TYPE_STRUCTURE,
           G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+  /**
+   * GstRtpJitterBuffer:shared-timer:
+   *
+   * Handle the timers of this jitterbuffer in a small pool of threads that
+   * is shared with all other jitterbuffers using the same clock instead of
+   * in a thread of its own. This reduces the number of threads and context
+   * switches when receiving many streams. Changes take effect when going to
+   * PAUSED.
+   */
+  g_object_class_install_property (gobject_class, PROP_SHARED_TIMER,
+      g_param_spec_boolean ("shared-timer", "Shared Timer",
+          "Handle timers in a thread shared with other jitterbuffers",
+          DEFAULT_SHARED_TIMER, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
   /**
    * GstRtpJitterBuffer::request-pt-map:
@@ -679,6 +726,8 @@ gst_rtp_jitter_buffer_class_init (GstRtpJitterBufferClass * klass)
       GST_DEBUG_FUNCPTR (gst_rtp_jitter_buffer_release_pad);
   gstelement_class->provide_clock =
       GST_DEBUG_FUNCPTR (gst_rtp_jitter_buffer_provide_clock);
+  gstelement_class->set_clock =
+      GST_DEBUG_FUNCPTR (gst_rtp_jitter_buffer_set_clock);
 
   gst_element_class_add_pad_template (gstelement_class,
       gst_static_pad_template_get (&gst_rtp_jitter_buffer_src_template));
@@ -717,11 +766,15 @@ gst_rtp_jitter_buffer_init (GstRtpJitterBuffer * jitterbuffer)
   priv->rtx_delay_reorder = DEFAULT_RTX_DELAY_REORDER;
   priv->rtx_retry_timeout = DEFAULT_RTX_RETRY_TIMEOUT;
   priv->rtx_retry_period = DEFAULT_RTX_RETRY_PERIOD;
+  priv->shared_timer = DEFAULT_SHARED_TIMER;
 
   priv->last_dts = -1;
   priv->last_rtptime = -1;
   priv->avg_jitter = 0;
-  priv->timers = g_array_new (FALSE, TRUE, sizeof (TimerData));
+  priv->timers[0] = g_ptr_array_new ();
+  priv->timers[1] = g_ptr_array_new ();
+  priv->timer_index = g_hash_table_new (NULL, NULL);
+  priv->timers_checked_seqnum = -1;
   priv->jbuf = rtp_jitter_buffer_new ();
   g_mutex_init (&priv->jbuf_lock);
   g_cond_init (&priv->jbuf_timer);
@@ -806,7 +859,10 @@ gst_rtp_jitter_buffer_finalize (GObject * object)
   jitterbuffer = GST_RTP_JITTER_BUFFER (object);
   priv = jitterbuffer->priv;
 
-  g_array_free (priv->timers, TRUE);
+  remove_all_timers (jitterbuffer);
+  g_ptr_array_free (priv->timers[0], TRUE);
+  g_ptr_array_free (priv->timers[1], TRUE);
+  g_hash_table_destroy (priv->timer_index);
   g_mutex_clear (&priv->jbuf_lock);
   g_cond_clear (&priv->jbuf_timer);
   g_cond_clear (&priv->jbuf_event);
@@ -960,6 +1016,34 @@ gst_rtp_jitter_buffer_provide_clock (GstElement * element)
   return gst_system_clock_obtain ();
 }
 
+static gboolean
+gst_rtp_jitter_buffer_set_clock (GstElement * element, GstClock * clock)
+{
+  GstRtpJitterBuffer *jitterbuffer = GST_RTP_JITTER_BUFFER (element);
+  GstRtpJitterBufferPrivate *priv = jitterbuffer->priv;
+  gboolean res, attached;
+
+  res = GST_ELEMENT_CLASS (parent_class)->set_clock (element, clock);
+
+  /* the timer service waits on the clock it was made for, move to the
+   * service of the new clock */
+  JBUF_LOCK (priv);
+  attached = priv->timer_entry != NULL;
+  JBUF_UNLOCK (priv);
+
+  if (attached) {
+    GST_DEBUG_OBJECT (jitterbuffer, "clock changed, moving to the timer "
+        "service of %" GST_PTR_FORMAT, clock);
+    detach_timer_service (jitterbuffer);
+    JBUF_LOCK (priv);
+    if (!priv->blocked)
+      attach_timer_service (jitterbuffer);
+    JBUF_UNLOCK (priv);
+  }
+
+  return res;
+}
+
 static void
 gst_rtp_jitter_buffer_clear_pt_map (GstRtpJitterBuffer * jitterbuffer)
 {
@@ -1250,8 +1334,12 @@ gst_rtp_jitter_buffer_change_state (GstElement * element,
       /* block until we go to PLAYING */
       priv->blocked = TRUE;
       priv->timer_running = TRUE;
-      priv->timer_thread =
-          g_thread_new ("timer", (GThreadFunc) wait_next_timeout, jitterbuffer);
+      /* with a shared timer, the timer service is attached in PLAYING when
+       * we know the clock */
+      priv->timer_shared = priv->shared_timer;
+      if (!priv->timer_shared)
+        priv->timer_thread = g_thread_new ("timer",
+            (GThreadFunc) wait_next_timeout, jitterbuffer);
       JBUF_UNLOCK (priv);
       break;
     case GST_STATE_CHANGE_PAUSED_TO_PLAYING:
@@ -1259,7 +1347,10 @@ gst_rtp_jitter_buffer_change_state (GstElement * element,
       /* unblock to allow streaming in PLAYING */
       priv->blocked = FALSE;
       JBUF_SIGNAL_EVENT (priv);
-      JBUF_SIGNAL_TIMER (priv);
+      if (priv->timer_shared)
+        attach_timer_service (jitterbuffer);
+      else
+        JBUF_SIGNAL_TIMER (priv);
       JBUF_UNLOCK (priv);
       break;
     default:
@@ -1281,6 +1372,7 @@ gst_rtp_jitter_buffer_change_state (GstElement * element,
       priv->blocked = TRUE;
       unschedule_current_timer (jitterbuffer);
       JBUF_UNLOCK (priv);
+      detach_timer_service (jitterbuffer);
       if (ret != GST_STATE_CHANGE_FAILURE)
         ret = GST_STATE_CHANGE_NO_PREROLL;
       break;
@@ -1292,8 +1384,10 @@ gst_rtp_jitter_buffer_change_state (GstElement * element,
       JBUF_SIGNAL_TIMER (priv);
       JBUF_SIGNAL_QUERY (priv, FALSE);
       JBUF_UNLOCK (priv);
-      g_thread_join (priv->timer_thread);
-      priv->timer_thread = NULL;
+      if (priv->timer_thread) {
+        g_thread_join (priv->timer_thread);
+        priv->timer_thread = NULL;
+      }
       break;
     case GST_STATE_CHANGE_READY_TO_NULL:
       break;
@@ -1606,20 +1700,157 @@ apply_offset (GstRtpJitterBuffer * jitterbuffer, GstClockTime timestamp)
   return timestamp;
 }
 
+/* TRUE when a timer with @timeout and @seqnum needs to be handled before a
+ * timer with @other_timeout and @other_seqnum. Immediate timers (timeout -1)
+ * go first and timers with the same timeout go in seqnum order. */
+static inline gboolean
+timer_before (GstClockTime timeout, guint16 seqnum, GstClockTime other_timeout,
+    guint16 other_seqnum)
+{
+  if (timeout == other_timeout)
+    return gst_rtp_buffer_compare_seqnum (seqnum, other_seqnum) > 0;
+  if (timeout == -1)
+    return TRUE;
+  if (other_timeout == -1)
+    return FALSE;
+  return timeout < other_timeout;
+}
+
+static inline void
+timer_heap_set (GPtrArray * heap, guint idx, TimerData * timer)
+{
+  g_ptr_array_index (heap, idx) = timer;
+  timer->idx = idx;
+}
+
+/* restore the heap order after the timeout of the timer at @idx changed */
+static void
+timer_heap_update (GPtrArray * heap, guint idx)
+{
+  TimerData *timer = g_ptr_array_index (heap, idx);
+
+  /* move up while we are before our parent */
+  while (idx > 0) {
+    guint parent = (idx - 1) / 2;
+    TimerData *ptimer = g_ptr_array_index (heap, parent);
+
+    if (!timer_before (timer->timeout, timer->seqnum, ptimer->timeout,
+            ptimer->seqnum))
+      break;
+
+    timer_heap_set (heap, idx, ptimer);
+    idx = parent;
+  }
+  /* move down while one of our children is before us */
+  while (TRUE) {
+    guint child = 2 * idx + 1;
+    TimerData *ctimer;
+
+    if (child >= heap->len)
+      break;
+
+    ctimer = g_ptr_array_index (heap, child);
+    if (child + 1 < heap->len) {
+      TimerData *rtimer = g_ptr_array_index (heap, child + 1);
+
+      if (timer_before (rtimer->timeout, rtimer->seqnum, ctimer->timeout,
+              ctimer->seqnum)) {
+        child++;
+        ctimer = rtimer;
+      }
+    }
+    if (!timer_before (ctimer->timeout, ctimer->seqnum, timer->timeout,
+            timer->seqnum))
+      break;
+
+    timer_heap_set (heap, idx, ctimer);
+    idx = child;
+  }
+  timer_heap_set (heap, idx, timer);
+}
+
+static void
+timer_heap_add (GstRtpJitterBuffer * jitterbuffer, TimerData * timer)
+{
+  GPtrArray *heap;
+
+  timer->heap = TIMER_HEAP (timer->type);
+  heap = jitterbuffer->priv->timers[timer->heap];
+
+  g_ptr_array_add (heap, timer);
+  timer_heap_update (heap, heap->len - 1);
+}
+
+static void
+timer_heap_remove (GstRtpJitterBuffer * jitterbuffer, TimerData * timer)
+{
+  GPtrArray *heap = jitterbuffer->priv->timers[timer->heap];
+  guint idx = timer->idx;
+
+  /* moves the last timer into our place */
+  g_ptr_array_remove_index_fast (heap, idx);
+  if (idx < heap->len) {
+    ((TimerData *) g_ptr_array_index (heap, idx))->idx = idx;
+    timer_heap_update (heap, idx);
+  }
+}
+
+/* all timers with the same seqnum are chained in the index */
+static void
+timer_index_add (GstRtpJitterBuffer * jitterbuffer, TimerData * timer)
+{
+  GHashTable *index = jitterbuffer->priv->timer_index;
+  gpointer key = GUINT_TO_POINTER (timer->seqnum);
+
+  timer->next = g_hash_table_lookup (index, key);
+  g_hash_table_insert (index, key, timer);
+
+  /* an EXPECTED timer behind the seqnums that were already checked would be
+   * missed, check all timers on the next packet */
+  if (timer->type == TIMER_TYPE_EXPECTED &&
+      jitterbuffer->priv->timers_checked_seqnum != -1 &&
+      gst_rtp_buffer_compare_seqnum (timer->seqnum,
+          jitterbuffer->priv->timers_checked_seqnum) >= 0)
+    jitterbuffer->priv->timers_checked_seqnum = -1;
+}
+
+static void
+timer_index_remove (GstRtpJitterBuffer * jitterbuffer, TimerData * timer)
+{
+  GHashTable *index = jitterbuffer->priv->timer_index;
+  gpointer key = GUINT_TO_POINTER (timer->seqnum);
+  TimerData *prev;
+
+  prev = g_hash_table_lookup (index, key);
+  if (prev == timer) {
+    if (timer->next)
+      g_hash_table_insert (index, key, timer->next);
+    else
+      g_hash_table_remove (index, key);
+  } else {
+    while (prev->next != timer)
+      prev = prev->next;
+    prev->next = timer->next;
+  }
+  timer->next = NULL;
+}
+
+static inline TimerData *
+timer_index_lookup (GstRtpJitterBuffer * jitterbuffer, guint16 seqnum)
+{
+  return g_hash_table_lookup (jitterbuffer->priv->timer_index,
+      GUINT_TO_POINTER (seqnum));
+}
+
 static TimerData *
 find_timer (GstRtpJitterBuffer * jitterbuffer, TimerType type, guint16 seqnum)
 {
-  GstRtpJitterBufferPrivate *priv = jitterbuffer->priv;
-  TimerData *timer = NULL;
-  gint i, len;
+  TimerData *timer;
 
-  len = priv->timers->len;
-  for (i = 0; i < len; i++) {
-    TimerData *test = &g_array_index (priv->timers, TimerData, i);
-    if (test->seqnum == seqnum && test->type == type) {
-      timer = test;
+  for (timer = timer_index_lookup (jitterbuffer, seqnum); timer;
+      timer = timer->next) {
+    if (timer->type == type)
       break;
-    }
   }
   return timer;
 }
@@ -1633,6 +1864,11 @@ unschedule_current_timer (GstRtpJitterBuffer * jitterbuffer)
     GST_DEBUG_OBJECT (jitterbuffer, "unschedule current timer");
     gst_clock_id_unschedule (priv->clock_id);
     priv->clock_id = NULL;
+  } else if (priv->timer_scheduled) {
+    GST_DEBUG_OBJECT (jitterbuffer, "reschedule shared timer");
+    /* let the timer service call us right away to pick the next timer */
+    priv->timer_scheduled = FALSE;
+    rtp_timer_service_schedule (priv->timer_service, priv->timer_entry, 0);
   }
 }
 
@@ -1658,7 +1894,7 @@ recalculate_timer (GstRtpJitterBuffer * jitterbuffer, TimerData * timer)
 {
   GstRtpJitterBufferPrivate *priv = jitterbuffer->priv;
 
-  if (priv->clock_id) {
+  if (TIMER_SCHEDULED (priv)) {
     GstClockTime timeout = get_timeout (jitterbuffer, timer);
 
     GST_DEBUG ("%" GST_TIME_FORMAT " <> %" GST_TIME_FORMAT,
@@ -1676,16 +1912,12 @@ add_timer (GstRtpJitterBuffer * jitterbuffer, TimerType type,
 {
   GstRtpJitterBufferPrivate *priv = jitterbuffer->priv;
   TimerData *timer;
-  gint len;
 
   GST_DEBUG_OBJECT (jitterbuffer,
       "add timer for seqnum %d to %" GST_TIME_FORMAT ", delay %"
       GST_TIME_FORMAT, seqnum, GST_TIME_ARGS (timeout), GST_TIME_ARGS (delay));
 
-  len = priv->timers->len;
-  g_array_set_size (priv->timers, len + 1);
-  timer = &g_array_index (priv->timers, TimerData, len);
-  timer->idx = len;
+  timer = g_slice_new0 (TimerData);
   timer->type = type;
   timer->seqnum = seqnum;
   timer->num = num;
@@ -1697,6 +1929,8 @@ add_timer (GstRtpJitterBuffer * jitterbuffer, TimerType type,
     timer->rtx_retry = 0;
   }
   timer->num_rtx_retry = 0;
+  timer_heap_add (jitterbuffer, timer);
+  timer_index_add (jitterbuffer, timer);
   recalculate_timer (jitterbuffer, timer);
   JBUF_SIGNAL_TIMER (priv);
 
@@ -1714,7 +1948,7 @@ reschedule_timer (GstRtpJitterBuffer * jitterbuffer, TimerData * timer,
   seqchange = timer->seqnum != seqnum;
   timechange = timer->timeout != timeout;
 
-  if (!seqchange && !timechange)
+  if (!seqchange && !timechange && timer->heap == TIMER_HEAP (timer->type))
     return;
 
   oldseq = timer->seqnum;
@@ -1723,8 +1957,23 @@ reschedule_timer (GstRtpJitterBuffer * jitterbuffer, TimerData * timer,
       "replace timer for seqnum %d->%d to %" GST_TIME_FORMAT,
       oldseq, seqnum, GST_TIME_ARGS (timeout + delay));
 
+  if (seqchange)
+    timer_index_remove (jitterbuffer, timer);
+
   timer->timeout = timeout + delay;
   timer->seqnum = seqnum;
+
+  if (seqchange)
+    timer_index_add (jitterbuffer, timer);
+
+  if (timer->heap != TIMER_HEAP (timer->type)) {
+    /* the type changed, move to the other heap */
+    timer_heap_remove (jitterbuffer, timer);
+    timer_heap_add (jitterbuffer, timer);
+  } else {
+    timer_heap_update (priv->timers[timer->heap], timer->idx);
+  }
+
   if (reset) {
     timer->rtx_base = timeout;
     timer->rtx_delay = delay;
@@ -1733,7 +1982,7 @@ reschedule_timer (GstRtpJitterBuffer * jitterbuffer, TimerData * timer,
   if (seqchange)
     timer->num_rtx_retry = 0;
 
-  if (priv->clock_id) {
+  if (TIMER_SCHEDULED (priv)) {
     /* we changed the seqnum and there is a timer currently waiting with this
      * seqnum, unschedule it */
     if (seqchange && priv->timer_seqnum == oldseq)
@@ -1765,26 +2014,130 @@ static void
 remove_timer (GstRtpJitterBuffer * jitterbuffer, TimerData * timer)
 {
   GstRtpJitterBufferPrivate *priv = jitterbuffer->priv;
-  guint idx;
 
-  if (priv->clock_id && priv->timer_seqnum == timer->seqnum)
+  if (TIMER_SCHEDULED (priv) && priv->timer_seqnum == timer->seqnum)
     unschedule_current_timer (jitterbuffer);
 
-  idx = timer->idx;
-  GST_DEBUG_OBJECT (jitterbuffer, "removed index %d", idx);
-  g_array_remove_index_fast (priv->timers, idx);
-  timer->idx = idx;
+  GST_DEBUG_OBJECT (jitterbuffer, "removed timer for seqnum %d",
+      timer->seqnum);
+  timer_heap_remove (jitterbuffer, timer);
+  timer_index_remove (jitterbuffer, timer);
+  g_slice_free (TimerData, timer);
 }
 
 static void
 remove_all_timers (GstRtpJitterBuffer * jitterbuffer)
 {
   GstRtpJitterBufferPrivate *priv = jitterbuffer->priv;
+  guint i, j;
+
   GST_DEBUG_OBJECT (jitterbuffer, "removed all timers");
-  g_array_set_size (priv->timers, 0);
+  for (i = 0; i < G_N_ELEMENTS (priv->timers); i++) {
+    for (j = 0; j < priv->timers[i]->len; j++)
+      g_slice_free (TimerData, g_ptr_array_index (priv->timers[i], j));
+    g_ptr_array_set_size (priv->timers[i], 0);
+  }
+  g_hash_table_remove_all (priv->timer_index);
+  priv->timers_checked_seqnum = -1;
   unschedule_current_timer (jitterbuffer);
 }
 
+/* get the timer that needs to be handled first and its timeout */
+static TimerData *
+get_next_timer (GstRtpJitterBuffer * jitterbuffer, GstClockTime * timeout)
+{
+  GstRtpJitterBufferPrivate *priv = jitterbuffer->priv;
+  TimerData *timer = NULL;
+  GstClockTime timer_timeout = -1;
+  guint i;
+
+  for (i = 0; i < G_N_ELEMENTS (priv->timers); i++) {
+    TimerData *test;
+    GstClockTime test_timeout;
+
+    if (priv->timers[i]->len == 0)
+      continue;
+
+    test = g_ptr_array_index (priv->timers[i], 0);
+    test_timeout = get_timeout (jitterbuffer, test);
+
+    GST_DEBUG_OBJECT (jitterbuffer, "%d, %d, %" GST_TIME_FORMAT,
+        test->type, test->seqnum, GST_TIME_ARGS (test_timeout));
+
+    if (timer == NULL || timer_before (test_timeout, test->seqnum,
+            timer_timeout, timer->seqnum)) {
+      timer = test;
+      timer_timeout = test_timeout;
+    }
+  }
+  *timeout = timer_timeout;
+
+  return timer;
+}
+
+static void
+expire_expected_timer (GstRtpJitterBuffer * jitterbuffer, TimerData * timer)
+{
+  if (timer->num_rtx_retry == 0 && timer->type == TIMER_TYPE_EXPECTED)
+    reschedule_timer (jitterbuffer, timer, timer->seqnum, -1, 0, FALSE);
+}
+
+/* Unschedule the EXPECTED timers that have a too large gap with @seqnum, we
+ * exceeded the max reorder distance and we don't expect the missing packet to
+ * be this reordered. A timer only needs to be checked when its seqnum leaves
+ * the reorder window so we only look at the seqnums that left the window
+ * since the previous packet. After a reset, a discont or a timer that was
+ * added behind the checked seqnums, all timers are checked. */
+static void
+expire_reordered_timers (GstRtpJitterBuffer * jitterbuffer, guint16 seqnum)
+{
+  GstRtpJitterBufferPrivate *priv = jitterbuffer->priv;
+  guint16 limit;
+  gint gap;
+
+  if (priv->rtx_delay_reorder > G_MAXINT16)
+    return;
+
+  /* the last seqnum outside of the reorder window */
+  limit = seqnum - MAX (priv->rtx_delay_reorder, 0) - 1;
+
+  if (priv->timers_checked_seqnum != -1)
+    gap = gst_rtp_buffer_compare_seqnum (priv->timers_checked_seqnum, limit);
+  else
+    gap = G_MAXINT;
+
+  if (gap <= 0)
+    return;
+
+  if ((guint) gap > g_hash_table_size (priv->timer_index)) {
+    GHashTableIter iter;
+    gpointer value;
+
+    /* fewer timers than seqnums to check, check all timers */
+    g_hash_table_iter_init (&iter, priv->timer_index);
+    while (g_hash_table_iter_next (&iter, NULL, &value)) {
+      TimerData *test;
+
+      for (test = value; test; test = test->next) {
+        if (gst_rtp_buffer_compare_seqnum (test->seqnum, limit) >= 0)
+          expire_expected_timer (jitterbuffer, test);
+      }
+    }
+  } else {
+    guint16 check = priv->timers_checked_seqnum;
+
+    while (gap-- > 0) {
+      TimerData *test;
+
+      check++;
+      for (test = timer_index_lookup (jitterbuffer, check); test;
+          test = test->next)
+        expire_expected_timer (jitterbuffer, test);
+    }
+  }
+  priv->timers_checked_seqnum = limit;
+}
+
 /* we just received a packet with seqnum and dts.
  *
  * First check for old seqnum that we are still expecting. If the gap with the
@@ -1800,32 +2153,14 @@ update_timers (GstRtpJitterBuffer * jitterbuffer, guint16 seqnum,
     GstClockTime dts, gboolean do_next_seqnum)
 {
   GstRtpJitterBufferPrivate *priv = jitterbuffer->priv;
-  TimerData *timer = NULL;
-  gint i, len;
-
-  /* go through all timers and unschedule the ones with a large gap, also find
-   * the timer for the seqnum */
-  len = priv->timers->len;
-  for (i = 0; i < len; i++) {
-    TimerData *test = &g_array_index (priv->timers, TimerData, i);
-    gint gap;
-
-    gap = gst_rtp_buffer_compare_seqnum (test->seqnum, seqnum);
+  TimerData *timer;
 
-    GST_DEBUG_OBJECT (jitterbuffer, "%d, #%d<->#%d gap %d", i,
-        test->seqnum, seqnum, gap);
+  /* unschedule the timers with a large gap */
+  expire_reordered_timers (jitterbuffer, seqnum);
 
-    if (gap == 0) {
-      GST_DEBUG ("found timer for current seqnum");
-      /* the timer for the current seqnum */
-      timer = test;
-    } else if (gap > priv->rtx_delay_reorder) {
-      /* max gap, we exceeded the max reorder distance and we don't expect the
-       * missing packet to be this reordered */
-      if (test->num_rtx_retry == 0 && test->type == TIMER_TYPE_EXPECTED)
-        reschedule_timer (jitterbuffer, test, test->seqnum, -1, 0, FALSE);
-    }
-  }
+  /* find the timer for the seqnum */
+  if ((timer = timer_index_lookup (jitterbuffer, seqnum)))
+    GST_DEBUG ("found timer for current seqnum");
 
   do_next_seqnum = do_next_seqnum && priv->packet_spacing > 0
       && priv->do_retransmission;
@@ -2118,6 +2453,10 @@ gst_rtp_jitter_buffer_chain (GstPad * pad, GstObject * parent,
 
   JBUF_LOCK_CHECK (priv, out_flushing);
 
+  /* the seqnums might not follow the ones we checked the timers for */
+  if (G_UNLIKELY (GST_BUFFER_IS_DISCONT (buffer)))
+    priv->timers_checked_seqnum = -1;
+
   if (G_UNLIKELY (priv->last_pt != pt)) {
     GstCaps *caps;
 
@@ -2283,7 +2622,7 @@ gst_rtp_jitter_buffer_chain (GstPad * pad, GstObject * parent,
 
   /* let's unschedule and unblock any waiting buffers. We only want to do this
    * when the tail buffer changed */
-  if (G_UNLIKELY (priv->clock_id && tail)) {
+  if (G_UNLIKELY (TIMER_SCHEDULED (priv) && tail)) {
     GST_DEBUG_OBJECT (jitterbuffer, "Unscheduling waiting new buffer");
     unschedule_current_timer (jitterbuffer);
   }
@@ -2439,6 +2778,83 @@ update_estimated_eos (GstRtpJitterBuffer * jitterbuffer,
   }
 }
 
+/* make the buffer of @item ready to be pushed */
+static GstBuffer *
+prepare_output_buffer (GstRtpJitterBuffer * jitterbuffer,
+    RTPJitterBufferItem * item)
+{
+  GstRtpJitterBufferPrivate *priv = jitterbuffer->priv;
+  GstBuffer *outbuf;
+  GstClockTime dts, pts;
+
+  /* we need to make writable to change the flags and timestamps */
+  outbuf = gst_buffer_make_writable (item->data);
+
+  if (G_UNLIKELY (priv->discont)) {
+    /* set DISCONT flag when we missed a packet. We pushed the buffer writable
+     * into the jitterbuffer so we can modify now. */
+    GST_DEBUG_OBJECT (jitterbuffer, "mark output buffer discont");
+    GST_BUFFER_FLAG_SET (outbuf, GST_BUFFER_FLAG_DISCONT);
+    priv->discont = FALSE;
+  }
+  if (G_UNLIKELY (priv->ts_discont)) {
+    GST_BUFFER_FLAG_SET (outbuf, GST_BUFFER_FLAG_RESYNC);
+    priv->ts_discont = FALSE;
+  }
+
+  dts = gst_segment_to_position (&priv->segment, GST_FORMAT_TIME, item->dts);
+  pts = gst_segment_to_position (&priv->segment, GST_FORMAT_TIME, item->pts);
+
+  /* apply timestamp with offset to buffer now */
+  GST_BUFFER_DTS (outbuf) = apply_offset (jitterbuffer, dts);
+  GST_BUFFER_PTS (outbuf) = apply_offset (jitterbuffer, pts);
+
+  /* update the elapsed time when we need to check against the npt stop time. */
+  update_estimated_eos (jitterbuffer, item);
+
+  priv->last_out_time = GST_BUFFER_PTS (outbuf);
+
+  return outbuf;
+}
+
+/* After popping the buffer in @outbuf, also pop the packets that directly
+ * follow it and can be pushed right away, like after a retransmission filled
+ * a gap. Returns %NULL when there are no such packets or else a list with
+ * @outbuf and the following buffers, @outbuf is then set to %NULL. */
+static GstBufferList *
+pop_consecutive_buffers (GstRtpJitterBuffer * jitterbuffer,
+    GstBuffer ** outbuf, gint * percent)
+{
+  GstRtpJitterBufferPrivate *priv = jitterbuffer->priv;
+  GstBufferList *outlist = NULL;
+  RTPJitterBufferItem *item;
+
+  while ((item = rtp_jitter_buffer_peek (priv->jbuf))) {
+    if (item->type != ITEM_TYPE_BUFFER || item->seqnum != priv->next_seqnum)
+      break;
+    /* same checks as handle_next_buffer() */
+    if (priv->blocked || !priv->active ||
+        rtp_jitter_buffer_is_buffering (priv->jbuf))
+      break;
+
+    item = rtp_jitter_buffer_pop (priv->jbuf, percent);
+
+    if (outlist == NULL) {
+      outlist = gst_buffer_list_new ();
+      gst_buffer_list_add (outlist, *outbuf);
+      *outbuf = NULL;
+    }
+    gst_buffer_list_add (outlist, prepare_output_buffer (jitterbuffer, item));
+
+    priv->last_popped_seqnum = item->seqnum;
+    priv->next_seqnum = (item->seqnum + item->count) & 0xffff;
+
+    item->data = NULL;
+    free_item (item);
+  }
+  return outlist;
+}
+
 /* take a buffer from the queue and push it */
 static GstFlowReturn
 pop_and_push_next (GstRtpJitterBuffer * jitterbuffer, guint seqnum)
@@ -2447,9 +2863,9 @@ pop_and_push_next (GstRtpJitterBuffer * jitterbuffer, guint seqnum)
   GstFlowReturn result = GST_FLOW_OK;
   RTPJitterBufferItem *item;
   GstBuffer *outbuf = NULL;
+  GstBufferList *outlist = NULL;
   GstEvent *outevent = NULL;
   GstQuery *outquery = NULL;
-  GstClockTime dts, pts;
   gint percent = -1;
   gboolean do_push = TRUE;
   guint type;
@@ -2461,35 +2877,7 @@ pop_and_push_next (GstRtpJitterBuffer * jitterbuffer, guint seqnum)
 
   switch (type) {
     case ITEM_TYPE_BUFFER:
-
-      /* we need to make writable to change the flags and timestamps */
-      outbuf = gst_buffer_make_writable (item->data);
-
-      if (G_UNLIKELY (priv->discont)) {
-        /* set DISCONT flag when we missed a packet. We pushed the buffer writable
-         * into the jitterbuffer so we can modify now. */
-        GST_DEBUG_OBJECT (jitterbuffer, "mark output buffer discont");
-        GST_BUFFER_FLAG_SET (outbuf, GST_BUFFER_FLAG_DISCONT);
-        priv->discont = FALSE;
-      }
-      if (G_UNLIKELY (priv->ts_discont)) {
-        GST_BUFFER_FLAG_SET (outbuf, GST_BUFFER_FLAG_RESYNC);
-        priv->ts_discont = FALSE;
-      }
-
-      dts =
-          gst_segment_to_position (&priv->segment, GST_FORMAT_TIME, item->dts);
-      pts =
-          gst_segment_to_position (&priv->segment, GST_FORMAT_TIME, item->pts);
-
-      /* apply timestamp with offset to buffer now */
-      GST_BUFFER_DTS (outbuf) = apply_offset (jitterbuffer, dts);
-      GST_BUFFER_PTS (outbuf) = apply_offset (jitterbuffer, pts);
-
-      /* update the elapsed time when we need to check against the npt stop time. */
-      update_estimated_eos (jitterbuffer, item);
-
-      priv->last_out_time = GST_BUFFER_PTS (outbuf);
+      outbuf = prepare_output_buffer (jitterbuffer, item);
       break;
     case ITEM_TYPE_LOST:
       priv->discont = TRUE;
@@ -2510,23 +2898,33 @@ pop_and_push_next (GstRtpJitterBuffer * jitterbuffer, guint seqnum)
     priv->last_popped_seqnum = seqnum;
     priv->next_seqnum = (seqnum + item->count) & 0xffff;
   }
-  msg = check_buffering_percent (jitterbuffer, percent);
-  JBUF_UNLOCK (priv);
-
   item->data = NULL;
   free_item (item);
 
+  if (type == ITEM_TYPE_BUFFER)
+    outlist = pop_consecutive_buffers (jitterbuffer, &outbuf, &percent);
+
+  msg = check_buffering_percent (jitterbuffer, percent);
+  JBUF_UNLOCK (priv);
+
   if (msg)
     gst_element_post_message (GST_ELEMENT_CAST (jitterbuffer), msg);
 
   switch (type) {
     case ITEM_TYPE_BUFFER:
-      /* push buffer */
-      GST_DEBUG_OBJECT (jitterbuffer,
-          "Pushing buffer %d, dts %" GST_TIME_FORMAT ", pts %" GST_TIME_FORMAT,
-          seqnum, GST_TIME_ARGS (GST_BUFFER_DTS (outbuf)),
-          GST_TIME_ARGS (GST_BUFFER_PTS (outbuf)));
-      result = gst_pad_push (priv->srcpad, outbuf);
+      if (outlist) {
+        /* push the buffer and the consecutive ones in one go */
+        GST_DEBUG_OBJECT (jitterbuffer, "Pushing list of %u buffers from %d",
+            gst_buffer_list_length (outlist), seqnum);
+        result = gst_pad_push_list (priv->srcpad, outlist);
+      } else {
+        /* push buffer */
+        GST_DEBUG_OBJECT (jitterbuffer,
+            "Pushing buffer %d, dts %" GST_TIME_FORMAT ", pts %"
+            GST_TIME_FORMAT, seqnum, GST_TIME_ARGS (GST_BUFFER_DTS (outbuf)),
+            GST_TIME_ARGS (GST_BUFFER_PTS (outbuf)));
+        result = gst_pad_push (priv->srcpad, outbuf);
+      }
 
       JBUF_LOCK_CHECK (priv, out_flushing);
       break;
@@ -2846,7 +3244,8 @@ do_timeout (GstRtpJitterBuffer * jitterbuffer, TimerData * timer,
 
 /* called when we need to wait for the next timeout.
  *
- * We loop over the array of recorded timeouts and wait for the earliest one.
+ * We take the earliest of the recorded timeouts from the timer heaps and wait
+ * for it.
  * When it timed out, do the logic associated with the timer.
  *
  * If there are no timers, we wait on a gcond until something new happens.
@@ -2859,50 +3258,14 @@ wait_next_timeout (GstRtpJitterBuffer * jitterbuffer)
 
   JBUF_LOCK (priv);
   while (priv->timer_running) {
-    TimerData *timer = NULL;
-    GstClockTime timer_timeout = -1;
-    gint i, len;
+    TimerData *timer;
+    GstClockTime timer_timeout;
 
     GST_DEBUG_OBJECT (jitterbuffer, "now %" GST_TIME_FORMAT,
         GST_TIME_ARGS (now));
 
-    len = priv->timers->len;
-    for (i = 0; i < len; i++) {
-      TimerData *test = &g_array_index (priv->timers, TimerData, i);
-      GstClockTime test_timeout = get_timeout (jitterbuffer, test);
-      gboolean save_best = FALSE;
-
-      GST_DEBUG_OBJECT (jitterbuffer, "%d, %d, %d, %" GST_TIME_FORMAT,
-          i, test->type, test->seqnum, GST_TIME_ARGS (test_timeout));
-
-      /* find the smallest timeout */
-      if (timer == NULL) {
-        save_best = TRUE;
-      } else if (timer_timeout == -1) {
-        /* we already have an immediate timeout, the new timer must be an
-         * immediate timer with smaller seqnum to become the best */
-        if (test_timeout == -1
-            && (gst_rtp_buffer_compare_seqnum (test->seqnum,
-                    timer->seqnum) > 0))
-          save_best = TRUE;
-      } else if (test_timeout == -1) {
-        /* first immediate timer */
-        save_best = TRUE;
-      } else if (test_timeout < timer_timeout) {
-        /* earlier timer */
-        save_best = TRUE;
-      } else if (test_timeout == timer_timeout
-          && (gst_rtp_buffer_compare_seqnum (test->seqnum,
-                  timer->seqnum) > 0)) {
-        /* same timer, smaller seqnum */
-        save_best = TRUE;
-      }
-      if (save_best) {
-        GST_DEBUG_OBJECT (jitterbuffer, "new best %d", i);
-        timer = test;
-        timer_timeout = test_timeout;
-      }
-    }
+    /* find the smallest timeout */
+    timer = get_next_timer (jitterbuffer, &timer_timeout);
     if (timer && !priv->blocked) {
       GstClock *clock;
       GstClockTime sync_time;
@@ -2976,6 +3339,128 @@ wait_next_timeout (GstRtpJitterBuffer * jitterbuffer)
   return;
 }
 
+/* called from a thread of the timer service when the timer of the
+ * jitterbuffer expired or when it needs to pick a new timer */
+static void
+shared_timer_expired (RTPTimerServiceEntry * entry, GstClockTime time,
+    GstRtpJitterBuffer * jitterbuffer)
+{
+  GstRtpJitterBufferPrivate *priv = jitterbuffer->priv;
+  GstClockTime now, base_time;
+  gboolean have_clock;
+
+  JBUF_LOCK (priv);
+  if (priv->timer_entry != entry)
+    goto done;
+
+  priv->timer_scheduled = FALSE;
+
+  GST_OBJECT_LOCK (jitterbuffer);
+  base_time = GST_ELEMENT_CAST (jitterbuffer)->base_time;
+  GST_OBJECT_UNLOCK (jitterbuffer);
+
+  /* convert the clock time to the time of the timers */
+  have_clock = GST_CLOCK_TIME_IS_VALID (time);
+  if (have_clock && time > base_time + priv->peer_latency)
+    now = time - base_time - priv->peer_latency;
+  else
+    now = 0;
+
+  GST_DEBUG_OBJECT (jitterbuffer, "now %" GST_TIME_FORMAT,
+      GST_TIME_ARGS (now));
+
+  /* do_timeout can release the lock, check if we are still attached */
+  while (priv->timer_entry == entry && !priv->blocked) {
+    TimerData *timer;
+    GstClockTime timer_timeout;
+
+    timer = get_next_timer (jitterbuffer, &timer_timeout);
+    if (timer == NULL) {
+      /* no timers, JBUF_SIGNAL_TIMER will reschedule us */
+      priv->waiting_timer = TRUE;
+      break;
+    }
+
+    if (timer_timeout == -1 || timer_timeout <= now) {
+      do_timeout (jitterbuffer, timer, now);
+      continue;
+    }
+
+    if (!have_clock) {
+      /* let's just push if there is no clock */
+      GST_DEBUG_OBJECT (jitterbuffer, "No clock, timeout right away");
+      now = timer_timeout;
+      continue;
+    }
+
+    GST_DEBUG_OBJECT (jitterbuffer, "schedule timer at %" GST_TIME_FORMAT,
+        GST_TIME_ARGS (timer_timeout));
+
+    priv->timer_timeout = timer_timeout;
+    priv->timer_seqnum = timer->seqnum;
+    priv->timer_scheduled = TRUE;
+    rtp_timer_service_schedule (priv->timer_service, entry,
+        timer_timeout + base_time + priv->peer_latency);
+    break;
+  }
+
+done:
+  JBUF_UNLOCK (priv);
+}
+
+/* called with JBUF_LOCK */
+static void
+attach_timer_service (GstRtpJitterBuffer * jitterbuffer)
+{
+  GstRtpJitterBufferPrivate *priv = jitterbuffer->priv;
+  GstClock *clock;
+
+  if (priv->timer_entry)
+    return;
+
+  GST_OBJECT_LOCK (jitterbuffer);
+  if ((clock = GST_ELEMENT_CLOCK (jitterbuffer)))
+    gst_object_ref (clock);
+  GST_OBJECT_UNLOCK (jitterbuffer);
+
+  GST_DEBUG_OBJECT (jitterbuffer, "using shared timer service for %"
+      GST_PTR_FORMAT, clock);
+
+  priv->timer_service = rtp_timer_service_get (clock);
+  priv->timer_entry = rtp_timer_service_add (priv->timer_service,
+      (RTPTimerServiceFunc) shared_timer_expired, jitterbuffer);
+  priv->timer_scheduled = FALSE;
+  priv->waiting_timer = FALSE;
+  rtp_timer_service_schedule (priv->timer_service, priv->timer_entry, 0);
+
+  if (clock)
+    gst_object_unref (clock);
+}
+
+/* called without JBUF_LOCK because it waits for shared_timer_expired */
+static void
+detach_timer_service (GstRtpJitterBuffer * jitterbuffer)
+{
+  GstRtpJitterBufferPrivate *priv = jitterbuffer->priv;
+  RTPTimerService *service;
+  RTPTimerServiceEntry *entry;
+
+  JBUF_LOCK (priv);
+  service = priv->timer_service;
+  entry = priv->timer_entry;
+  priv->timer_service = NULL;
+  priv->timer_entry = NULL;
+  priv->timer_scheduled = FALSE;
+  priv->waiting_timer = FALSE;
+  JBUF_UNLOCK (priv);
+
+  if (entry) {
+    GST_DEBUG_OBJECT (jitterbuffer, "stop using shared timer service");
+    rtp_timer_service_remove (service, entry);
+    rtp_timer_service_unref (service);
+  }
+}
+
 /*
  * This funcion implements the main pushing loop on the source pad.
  *
@@ -3412,6 +3897,7 @@ gst_rtp_jitter_buffer_set_property (GObject * object,
     case PROP_RTX_DELAY_REORDER:
       JBUF_LOCK (priv);
       priv->rtx_delay_reorder = g_value_get_int (value);
+      priv->timers_checked_seqnum = -1;
       JBUF_UNLOCK (priv);
       break;
     case PROP_RTX_RETRY_TIMEOUT:
@@ -3424,6 +3910,11 @@ gst_rtp_jitter_buffer_set_property (GObject * object,
       priv->rtx_retry_period = g_value_get_int (value);
       JBUF_UNLOCK (priv);
       break;
+    case PROP_SHARED_TIMER:
+      JBUF_LOCK (priv);
+      priv->shared_timer = g_value_get_boolean (value);
+      JBUF_UNLOCK (priv);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -3509,6 +4000,11 @@ gst_rtp_jitter_buffer_get_property (GObject * object,
       g_value_take_boxed (value,
           gst_rtp_jitter_buffer_create_stats (jitterbuffer));
       break;
+    case PROP_SHARED_TIMER:
+      JBUF_LOCK (priv);
+      g_value_set_boolean (value, priv->shared_timer);
+      JBUF_UNLOCK (priv);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -126,6 +126,8 @@ static gboolean gst_rtp_pt_demux_setup (GstRtpPtDemux * ptdemux);
 
 static gboolean gst_rtp_pt_demux_sink_event (GstPad * pad, GstObject * parent,
     GstEvent * event);
+static GstFlowReturn gst_rtp_pt_demux_chain_list (GstPad * pad,
+    GstObject * parent, GstBufferList * list);
 static GstFlowReturn gst_rtp_pt_demux_chain (GstPad * pad, GstObject * parent,
     GstBuffer * buf);
 static GstStateChangeReturn gst_rtp_pt_demux_change_state (GstElement * element,
@@ -233,6 +235,7 @@ gst_rtp_pt_demux_init (GstRtpPtDemux * ptdemux)
   g_assert (ptdemux->sink != NULL);
 
   gst_pad_set_chain_function (ptdemux->sink, gst_rtp_pt_demux_chain);
+  gst_pad_set_chain_list_function (ptdemux->sink, gst_rtp_pt_demux_chain_list);
   gst_pad_set_event_function (ptdemux->sink, gst_rtp_pt_demux_sink_event);
 
   gst_element_add_pad (GST_ELEMENT (ptdemux), ptdemux->sink);
@@ -342,25 +345,13 @@ forward_sticky_events (GstPad * pad, GstEvent ** event, gpointer user_data)
   return TRUE;
 }
 
-static GstFlowReturn
-gst_rtp_pt_demux_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
+/* get the src pad for @pt, creating it when needed, and make sure it has the
+ * current caps. Returns NULL when there are no caps for @pt */
+static GstPad *
+gst_rtp_pt_demux_get_pad (GstRtpPtDemux * rtpdemux, guint8 pt)
 {
-  GstFlowReturn ret = GST_FLOW_OK;
-  GstRtpPtDemux *rtpdemux;
-  guint8 pt;
   GstPad *srcpad;
   GstCaps *caps;
-  GstRTPBuffer rtp = { NULL };
-
-  rtpdemux = GST_RTP_PT_DEMUX (parent);
-
-  if (!gst_rtp_buffer_map (buf, GST_MAP_READ, &rtp))
-    goto invalid_buffer;
-
-  pt = gst_rtp_buffer_get_payload_type (&rtp);
-  gst_rtp_buffer_unmap (&rtp);
-
-  GST_DEBUG_OBJECT (rtpdemux, "received buffer for pt %d", pt);
 
   srcpad = find_pad_for_pt (rtpdemux, pt);
   if (srcpad == NULL) {
@@ -440,6 +431,42 @@ gst_rtp_pt_demux_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
     gst_caps_unref (caps);
   }
 
+  return srcpad;
+
+  /* ERRORS */
+no_caps:
+  {
+    GST_ELEMENT_ERROR (rtpdemux, STREAM, DECODE, (NULL),
+        ("Could not get caps for payload"));
+    if (srcpad)
+      gst_object_unref (srcpad);
+    return NULL;
+  }
+}
+
+static GstFlowReturn
+gst_rtp_pt_demux_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
+{
+  GstFlowReturn ret = GST_FLOW_OK;
+  GstRtpPtDemux *rtpdemux;
+  guint8 pt;
+  GstPad *srcpad;
+  GstRTPBuffer rtp = { NULL };
+
+  rtpdemux = GST_RTP_PT_DEMUX (parent);
+
+  if (!gst_rtp_buffer_map (buf, GST_MAP_READ, &rtp))
+    goto invalid_buffer;
+
+  pt = gst_rtp_buffer_get_payload_type (&rtp);
+  gst_rtp_buffer_unmap (&rtp);
+
+  GST_DEBUG_OBJECT (rtpdemux, "received buffer for pt %d", pt);
+
+  srcpad = gst_rtp_pt_demux_get_pad (rtpdemux, pt);
+  if (srcpad == NULL)
+    goto no_pad;
+
   /* push to srcpad */
   ret = gst_pad_push (srcpad, buf);
 
@@ -456,17 +483,111 @@ invalid_buffer:
     gst_buffer_unref (buf);
     return GST_FLOW_ERROR;
   }
-no_caps:
+no_pad:
   {
-    GST_ELEMENT_ERROR (rtpdemux, STREAM, DECODE, (NULL),
-        ("Could not get caps for payload"));
     gst_buffer_unref (buf);
-    if (srcpad)
-      gst_object_unref (srcpad);
     return GST_FLOW_ERROR;
   }
 }
 
+struct SplitListData
+{
+  GstRtpPtDemux *rtpdemux;
+  /* consecutive buffers of pt */
+  GstBufferList *sublist;
+  guint8 pt;
+  GstFlowReturn ret;
+};
+
+static GstFlowReturn
+push_sublist (struct SplitListData *data)
+{
+  GstPad *srcpad;
+  GstFlowReturn ret;
+
+  srcpad = gst_rtp_pt_demux_get_pad (data->rtpdemux, data->pt);
+  if (srcpad == NULL) {
+    gst_buffer_list_unref (data->sublist);
+    ret = GST_FLOW_ERROR;
+  } else {
+    ret = gst_pad_push_list (srcpad, data->sublist);
+    gst_object_unref (srcpad);
+  }
+  data->sublist = NULL;
+
+  return ret;
+}
+
+static gboolean
+split_list_buffer (GstBuffer ** buffer, guint idx, gpointer user_data)
+{
+  struct SplitListData *data = user_data;
+  GstRTPBuffer rtp = { NULL };
+  guint8 pt;
+
+  if (!gst_rtp_buffer_map (*buffer, GST_MAP_READ, &rtp))
+    goto invalid_buffer;
+
+  pt = gst_rtp_buffer_get_payload_type (&rtp);
+  gst_rtp_buffer_unmap (&rtp);
+
+  if (data->sublist && pt != data->pt) {
+    /* other payload type, push what we collected so far */
+    data->ret = push_sublist (data);
+    if (data->ret != GST_FLOW_OK)
+      return FALSE;
+  }
+  if (data->sublist == NULL) {
+    data->sublist = gst_buffer_list_new ();
+    data->pt = pt;
+  }
+  /* take the buffer out of the list */
+  gst_buffer_list_add (data->sublist, *buffer);
+  *buffer = NULL;
+
+  return TRUE;
+
+  /* ERRORS */
+invalid_buffer:
+  {
+    /* this is fatal and should be filtered earlier */
+    GST_ELEMENT_ERROR (data->rtpdemux, STREAM, DECODE, (NULL),
+        ("Dropping invalid RTP payload"));
+    data->ret = GST_FLOW_ERROR;
+    return FALSE;
+  }
+}
+
+/* push the buffers of a list in sublists of consecutive buffers with the same
+ * payload type */
+static GstFlowReturn
+gst_rtp_pt_demux_chain_list (GstPad * pad, GstObject * parent,
+    GstBufferList * list)
+{
+  struct SplitListData data;
+
+  data.rtpdemux = GST_RTP_PT_DEMUX (parent);
+  data.sublist = NULL;
+  data.pt = 0;
+  data.ret = GST_FLOW_OK;
+
+  GST_DEBUG_OBJECT (data.rtpdemux, "received list of %u buffers",
+      gst_buffer_list_length (list));
+
+  list = gst_buffer_list_make_writable (list);
+  gst_buffer_list_foreach (list, split_list_buffer, &data);
+  gst_buffer_list_unref (list);
+
+  if (data.sublist) {
+    if (data.ret == GST_FLOW_OK)
+      data.ret = push_sublist (&data);
+    else
+      gst_buffer_list_unref (data.sublist);
+  }
+
+  return data.ret;
+}
+
 static GstPad *
 find_pad_for_pt (GstRtpPtDemux * rtpdemux, guint8 pt)
 {
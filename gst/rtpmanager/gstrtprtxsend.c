@@ -53,6 +53,13 @@ GST_DEBUG_CATEGORY_STATIC (gst_rtp_rtx_send_debug);
 #define DEFAULT_MAX_SIZE_TIME    0
 #define DEFAULT_MAX_SIZE_PACKETS 100
 
+/* initial number of slots in the history of a stream, the history grows up
+ * to half the seqnum space when more packets need to be kept */
+#define HISTORY_MIN_SIZE 128
+#define HISTORY_MAX_SIZE 32768
+/* packets this much older than the history are considered reordered */
+#define HISTORY_MAX_MISORDER 100
+
 enum
 {
   PROP_0,
@@ -109,21 +116,20 @@ typedef struct
   GstBuffer *buffer;
 } BufferQueueItem;
 
-static void
-buffer_queue_item_free (BufferQueueItem * item)
-{
-  gst_buffer_unref (item->buffer);
-  g_slice_free (BufferQueueItem, item);
-}
-
 typedef struct
 {
   guint32 rtx_ssrc;
   guint16 next_seqnum;
   gint clock_rate;
 
-  /* history of rtp packets */
-  GSequence *queue;
+  /* history of rtp packets, a ring of slots indexed by seqnum. The history
+   * covers the history_len seqnums starting at history_head, the slot of
+   * history_head and of the last seqnum always have a buffer, slots outside
+   * of the range are empty */
+  BufferQueueItem *history;
+  guint history_mask;
+  guint16 history_head;
+  guint history_len;
 } SSRCRtxData;
 
 static SSRCRtxData *
@@ -133,7 +139,6 @@ ssrc_rtx_data_new (guint32 rtx_ssrc)
 
   data->rtx_ssrc = rtx_ssrc;
   data->next_seqnum = g_random_int_range (0, G_MAXUINT16);
-  data->queue = g_sequence_new ((GDestroyNotify) buffer_queue_item_free);
 
   return data;
 }
@@ -141,10 +146,153 @@ ssrc_rtx_data_new (guint32 rtx_ssrc)
 static void
 ssrc_rtx_data_free (SSRCRtxData * data)
 {
-  g_sequence_free (data->queue);
+  guint i;
+
+  for (i = 0; i < data->history_len; i++) {
+    BufferQueueItem *item;
+
+    item = &data->history[(data->history_head + i) & data->history_mask];
+    if (item->buffer)
+      gst_buffer_unref (item->buffer);
+  }
+  g_free (data->history);
   g_slice_free (SSRCRtxData, data);
 }
 
+#define HISTORY_ITEM(data,seqnum) (&(data)->history[(seqnum) & (data)->history_mask])
+
+/* remove the oldest packet from the history */
+static void
+history_drop_head (SSRCRtxData * data)
+{
+  BufferQueueItem *item;
+
+  do {
+    item = HISTORY_ITEM (data, data->history_head);
+    if (item->buffer) {
+      gst_buffer_unref (item->buffer);
+      item->buffer = NULL;
+    }
+    data->history_head++;
+    data->history_len--;
+    /* skip over the seqnums we never received */
+  } while (data->history_len > 0 &&
+      HISTORY_ITEM (data, data->history_head)->buffer == NULL);
+}
+
+/* make room for at least @len seqnums */
+static void
+history_resize (SSRCRtxData * data, guint len)
+{
+  BufferQueueItem *history;
+  guint i, size, mask;
+
+  size = 1 << g_bit_storage (MAX (len, HISTORY_MIN_SIZE) - 1);
+  if (data->history && size <= data->history_mask + 1)
+    return;
+
+  history = g_new0 (BufferQueueItem, size);
+  mask = size - 1;
+  for (i = 0; i < data->history_len; i++) {
+    guint16 seqnum = data->history_head + i;
+
+    history[seqnum & mask] = *HISTORY_ITEM (data, seqnum);
+  }
+  g_free (data->history);
+  data->history = history;
+  data->history_mask = mask;
+}
+
+static void
+history_flush (SSRCRtxData * data)
+{
+  guint i;
+
+  for (i = 0; i < data->history_len; i++) {
+    BufferQueueItem *item = HISTORY_ITEM (data, data->history_head + i);
+
+    if (item->buffer) {
+      gst_buffer_unref (item->buffer);
+      item->buffer = NULL;
+    }
+  }
+  data->history_len = 0;
+}
+
+/* add a packet to the history, @max_packets is the maximum span of seqnums
+ * to keep or 0 for no limit */
+static void
+history_add (SSRCRtxData * data, guint16 seqnum, guint32 timestamp,
+    GstBuffer * buffer, guint max_packets)
+{
+  BufferQueueItem *item;
+  gint diff;
+
+  if (data->history_len > 0) {
+    guint limit = max_packets ? max_packets : HISTORY_MAX_SIZE;
+
+    diff = gst_rtp_buffer_compare_seqnum (data->history_head, seqnum);
+    if (diff < 0 && diff >= -HISTORY_MAX_MISORDER) {
+      GST_LOG ("seqnum %u older than history, not kept", seqnum);
+      return;
+    }
+    if (diff < 0 || (guint) diff >= data->history_len + limit - 1) {
+      /* a jump in either direction, nothing in the history would be kept
+       * anyway so restart it at the new seqnum */
+      GST_DEBUG ("seqnum %u outside of history (head %u, len %u), restarting",
+          seqnum, data->history_head, data->history_len);
+      history_flush (data);
+    } else if ((guint) diff >= data->history_len) {
+      /* newer packet, drop what no longer fits */
+      while (data->history_len > 0 && ((max_packets
+                  && (guint) diff >= max_packets)
+              || diff >= HISTORY_MAX_SIZE)) {
+        history_drop_head (data);
+        diff = gst_rtp_buffer_compare_seqnum (data->history_head, seqnum);
+      }
+    }
+  }
+  if (data->history_len == 0) {
+    data->history_head = seqnum;
+    diff = 0;
+  }
+  if ((guint) diff >= data->history_len) {
+    history_resize (data, diff + 1);
+    data->history_len = diff + 1;
+  }
+
+  item = HISTORY_ITEM (data, seqnum);
+  if (item->buffer)
+    gst_buffer_unref (item->buffer);
+  item->seqnum = seqnum;
+  item->timestamp = timestamp;
+  item->buffer = gst_buffer_ref (buffer);
+
+  /* the limit could have been lowered */
+  while (max_packets && data->history_len > max_packets)
+    history_drop_head (data);
+}
+
+static BufferQueueItem *
+history_lookup (SSRCRtxData * data, guint16 seqnum)
+{
+  BufferQueueItem *item;
+  gint diff;
+
+  if (data->history_len == 0)
+    return NULL;
+
+  diff = gst_rtp_buffer_compare_seqnum (data->history_head, seqnum);
+  if (diff < 0 || (guint) diff >= data->history_len)
+    return NULL;
+
+  item = HISTORY_ITEM (data, seqnum);
+  if (item->buffer == NULL || item->seqnum != seqnum)
+    return NULL;
+
+  return item;
+}
+
 static void
 gst_rtp_rtx_send_class_init (GstRtpRtxSendClass * klass)
 {
@@ -176,7 +324,8 @@ gst_rtp_rtx_send_class_init (GstRtpRtxSendClass * klass)
 
   g_object_class_install_property (gobject_class, PROP_MAX_SIZE_PACKETS,
       g_param_spec_uint ("max-size-packets", "Max Size Packets",
-          "Amount of packets to queue (0 = unlimited)", 0, G_MAXINT16,
+          "Maximum span of sequence numbers to keep for retransmission "
+          "(0 = unlimited)", 0, G_MAXINT16,
           DEFAULT_MAX_SIZE_PACKETS,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
@@ -429,16 +578,6 @@ gst_rtp_rtx_buffer_new (GstRtpRtxSend * rtx, GstBuffer * buffer)
   return new_buffer;
 }
 
-static gint
-buffer_queue_items_cmp (BufferQueueItem * a, BufferQueueItem * b,
-    gpointer user_data)
-{
-  /* gst_rtp_buffer_compare_seqnum returns the opposite of what we want,
-   * it returns negative when seqnum1 > seqnum2 and we want negative
-   * when b > a, i.e. a is smaller, so it comes first in the sequence */
-  return gst_rtp_buffer_compare_seqnum (b->seqnum, a->seqnum);
-}
-
 static gboolean
 gst_rtp_rtx_send_src_event (GstPad * pad, GstObject * parent, GstEvent * event)
 {
@@ -472,19 +611,15 @@ gst_rtp_rtx_send_src_event (GstPad * pad, GstObject * parent, GstEvent * event)
         /* check if request is for us */
         if (g_hash_table_contains (rtx->ssrc_data, GUINT_TO_POINTER (ssrc))) {
           SSRCRtxData *data;
-          GSequenceIter *iter;
-          BufferQueueItem search_item;
+          BufferQueueItem *item;
 
           /* update statistics */
           ++rtx->num_rtx_requests;
 
           data = gst_rtp_rtx_send_get_ssrc_data (rtx, ssrc);
 
-          search_item.seqnum = seqnum;
-          iter = g_sequence_lookup (data->queue, &search_item,
-              (GCompareDataFunc) buffer_queue_items_cmp, NULL);
-          if (iter) {
-            BufferQueueItem *item = g_sequence_get (iter);
+          item = history_lookup (data, seqnum);
+          if (item) {
             GST_DEBUG_OBJECT (rtx, "found %" G_GUINT16_FORMAT, item->seqnum);
             rtx_buf = gst_rtp_rtx_buffer_new (rtx, item->buffer);
           }
@@ -618,14 +753,12 @@ gst_rtp_rtx_send_get_ts_diff (SSRCRtxData * data)
   BufferQueueItem *high_buf, *low_buf;
   guint32 result;
 
-  high_buf =
-      g_sequence_get (g_sequence_iter_prev (g_sequence_get_end_iter
-          (data->queue)));
-  low_buf = g_sequence_get (g_sequence_get_begin_iter (data->queue));
-
-  if (!high_buf || !low_buf || high_buf == low_buf)
+  if (data->history_len < 2)
     return 0;
 
+  high_buf = HISTORY_ITEM (data, data->history_head + data->history_len - 1);
+  low_buf = HISTORY_ITEM (data, data->history_head);
+
   high_ts = high_buf->timestamp;
   low_ts = low_buf->timestamp;
 
@@ -646,7 +779,6 @@ gst_rtp_rtx_send_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
   GstRtpRtxSend *rtx = GST_RTP_RTX_SEND (parent);
   GstFlowReturn ret = GST_FLOW_ERROR;
   GstRTPBuffer rtp = GST_RTP_BUFFER_INIT;
-  BufferQueueItem *item;
   SSRCRtxData *data;
   guint16 seqnum;
   guint8 payload_type;
@@ -666,21 +798,13 @@ gst_rtp_rtx_send_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
   if (g_hash_table_contains (rtx->rtx_pt_map, GUINT_TO_POINTER (payload_type))) {
     data = gst_rtp_rtx_send_get_ssrc_data (rtx, ssrc);
 
-    /* add current rtp buffer to queue history */
-    item = g_slice_new0 (BufferQueueItem);
-    item->seqnum = seqnum;
-    item->timestamp = rtptime;
-    item->buffer = gst_buffer_ref (buffer);
-    g_sequence_append (data->queue, item);
-
-    /* remove oldest packets from history if they are too many */
-    if (rtx->max_size_packets) {
-      while (g_sequence_get_length (data->queue) > rtx->max_size_packets)
-        g_sequence_remove (g_sequence_get_begin_iter (data->queue));
-    }
+    /* add current rtp buffer to queue history, this also removes the
+     * oldest packets when there are too many */
+    history_add (data, seqnum, rtptime, buffer, rtx->max_size_packets);
+
     if (rtx->max_size_time) {
       while (gst_rtp_rtx_send_get_ts_diff (data) > rtx->max_size_time)
-        g_sequence_remove (g_sequence_get_begin_iter (data->queue));
+        history_drop_head (data);
     }
   }
 
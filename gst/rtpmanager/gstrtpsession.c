@@ -254,6 +254,10 @@ struct _GstRtpSessionPrivate
   gboolean use_pipeline_clock;
 
   guint rtx_count;
+
+  /* collects the received packets while a list is processed, only used from
+   * the streaming thread of recv_rtp_sink */
+  GstBufferList *recv_rtp_list;
 };
 
 /* callbacks to handle actions from the session manager */
@@ -1124,6 +1128,13 @@ gst_rtp_session_process_rtp (RTPSession * sess, RTPSource * src,
 
   rtpsession = GST_RTP_SESSION (user_data);
 
+  if (rtpsession->priv->recv_rtp_list) {
+    /* processing a list, the packets are pushed together afterwards */
+    GST_LOG_OBJECT (rtpsession, "collecting received RTP packet");
+    gst_buffer_list_add (rtpsession->priv->recv_rtp_list, buffer);
+    return GST_FLOW_OK;
+  }
+
   GST_RTP_SESSION_LOCK (rtpsession);
   if ((rtp_src = rtpsession->recv_rtp_src))
     gst_object_ref (rtp_src);
@@ -1744,6 +1755,96 @@ push_error:
   }
 }
 
+/* receive a list of packets from senders, send them to the RTP session
+ * manager and forward the resulting packets as one list on the rtp_src pad
+ */
+static GstFlowReturn
+gst_rtp_session_chain_recv_rtp_list (GstPad * pad, GstObject * parent,
+    GstBufferList * list)
+{
+  GstRtpSession *rtpsession;
+  GstRtpSessionPrivate *priv;
+  GstFlowReturn ret, pret;
+  GstClockTime current_time, now_running_time;
+  GstClockTime *running_times;
+  GstBufferList *outlist;
+  GstPad *rtp_src;
+  guint64 *ntpnstimes, now_ntpnstime;
+  guint i, len;
+
+  rtpsession = GST_RTP_SESSION (parent);
+  priv = rtpsession->priv;
+
+  len = gst_buffer_list_length (list);
+
+  GST_LOG_OBJECT (rtpsession, "received RTP list of %u packets", len);
+
+  if (len == 0) {
+    gst_buffer_list_unref (list);
+    return GST_FLOW_OK;
+  }
+
+  /* get the running time and NTP time of each packet like in the chain
+   * function, the current times are used for packets without timestamp and
+   * are only read once for the list */
+  running_times = g_new (GstClockTime, len);
+  ntpnstimes = g_new (guint64, len);
+  now_running_time = now_ntpnstime = GST_CLOCK_TIME_NONE;
+  for (i = 0; i < len; i++) {
+    GstClockTime timestamp;
+
+    timestamp = GST_BUFFER_TIMESTAMP (gst_buffer_list_get (list, i));
+    if (GST_CLOCK_TIME_IS_VALID (timestamp)) {
+      running_times[i] =
+          gst_segment_to_running_time (&rtpsession->recv_rtp_seg,
+          GST_FORMAT_TIME, timestamp);
+      ntpnstimes[i] = GST_CLOCK_TIME_NONE;
+    } else {
+      if (!GST_CLOCK_TIME_IS_VALID (now_ntpnstime))
+        get_current_times (rtpsession, &now_running_time, &now_ntpnstime);
+      running_times[i] = now_running_time;
+      ntpnstimes[i] = now_ntpnstime;
+    }
+  }
+  current_time = gst_clock_get_time (priv->sysclock);
+
+  priv->recv_rtp_list = gst_buffer_list_new_sized (len);
+  ret = rtp_session_process_rtp_list (priv->session, list, current_time,
+      running_times, ntpnstimes);
+  outlist = priv->recv_rtp_list;
+  priv->recv_rtp_list = NULL;
+  g_free (running_times);
+  g_free (ntpnstimes);
+
+  if (ret != GST_FLOW_OK)
+    GST_DEBUG_OBJECT (rtpsession, "process returned %s",
+        gst_flow_get_name (ret));
+
+  if (gst_buffer_list_length (outlist) == 0) {
+    gst_buffer_list_unref (outlist);
+    return ret;
+  }
+
+  GST_RTP_SESSION_LOCK (rtpsession);
+  if ((rtp_src = rtpsession->recv_rtp_src))
+    gst_object_ref (rtp_src);
+  GST_RTP_SESSION_UNLOCK (rtpsession);
+
+  if (rtp_src) {
+    GST_LOG_OBJECT (rtpsession, "pushing received RTP list");
+    pret = gst_pad_push_list (rtp_src, outlist);
+    gst_object_unref (rtp_src);
+  } else {
+    GST_DEBUG_OBJECT (rtpsession, "dropping received RTP list");
+    gst_buffer_list_unref (outlist);
+    pret = GST_FLOW_OK;
+  }
+  if (ret == GST_FLOW_OK)
+    ret = pret;
+
+  return ret;
+}
+
 static gboolean
 gst_rtp_session_event_recv_rtcp_sink (GstPad * pad, GstObject * parent,
     GstEvent * event)
@@ -2118,6 +2219,8 @@ create_recv_rtp_sink (GstRtpSession * rtpsession)
       "recv_rtp_sink");
   gst_pad_set_chain_function (rtpsession->recv_rtp_sink,
       gst_rtp_session_chain_recv_rtp);
+  gst_pad_set_chain_list_function (rtpsession->recv_rtp_sink,
+      gst_rtp_session_chain_recv_rtp_list);
   gst_pad_set_event_function (rtpsession->recv_rtp_sink,
       gst_rtp_session_event_recv_rtp_sink);
   gst_pad_set_iterate_internal_links_function (rtpsession->recv_rtp_sink,
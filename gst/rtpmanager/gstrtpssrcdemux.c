@@ -85,6 +85,11 @@ GST_STATIC_PAD_TEMPLATE ("rtcp_src_%u",
 #define GST_PAD_LOCK(obj)   (g_rec_mutex_lock (&(obj)->padlock))
 #define GST_PAD_UNLOCK(obj) (g_rec_mutex_unlock (&(obj)->padlock))
 
+#define GST_SSRC_READ_LOCK(obj)    (g_rw_lock_reader_lock (&(obj)->ssrc_lock))
+#define GST_SSRC_READ_UNLOCK(obj)  (g_rw_lock_reader_unlock (&(obj)->ssrc_lock))
+#define GST_SSRC_WRITE_LOCK(obj)   (g_rw_lock_writer_lock (&(obj)->ssrc_lock))
+#define GST_SSRC_WRITE_UNLOCK(obj) (g_rw_lock_writer_unlock (&(obj)->ssrc_lock))
+
 typedef enum
 {
   RTP_PAD,
@@ -115,6 +120,8 @@ static void gst_rtp_ssrc_demux_clear_ssrc (GstRtpSsrcDemux * demux,
     guint32 ssrc);
 
 /* sinkpad stuff */
+static GstFlowReturn gst_rtp_ssrc_demux_chain_list (GstPad * pad,
+    GstObject * parent, GstBufferList * list);
 static GstFlowReturn gst_rtp_ssrc_demux_chain (GstPad * pad, GstObject * parent,
     GstBuffer * buf);
 static gboolean gst_rtp_ssrc_demux_sink_event (GstPad * pad, GstObject * parent,
@@ -145,24 +152,40 @@ struct _GstRtpSsrcDemuxPad
   GstCaps *caps;
   GstPad *rtcp_pad;
 
+  /* read with the ssrc_lock or the padlock taken, written with the padlock
+   * and the ssrc_lock for writing taken */
   gboolean pushed_initial_rtp_events;
   gboolean pushed_initial_rtcp_events;
 };
 
-/* find a src pad for a given SSRC, returns NULL if the SSRC was not found
+/* find a src pad for a given SSRC, returns NULL if the SSRC was not found.
+ * Must be called with the ssrc_lock, or the padlock, taken.
  */
 static GstRtpSsrcDemuxPad *
 find_demux_pad_for_ssrc (GstRtpSsrcDemux * demux, guint32 ssrc)
 {
-  GSList *walk;
+  GstRtpSsrcDemuxPad *pad;
 
-  for (walk = demux->srcpads; walk; walk = g_slist_next (walk)) {
-    GstRtpSsrcDemuxPad *pad = (GstRtpSsrcDemuxPad *) walk->data;
+  /* most of the time we get packets of the same SSRC in a row */
+  pad = g_atomic_pointer_get (&demux->last_pad);
+  if (pad && pad->ssrc == ssrc)
+    return pad;
 
-    if (pad->ssrc == ssrc)
-      return pad;
-  }
-  return NULL;
+  pad = g_hash_table_lookup (demux->ssrc_pads, GUINT_TO_POINTER (ssrc));
+  if (pad)
+    g_atomic_pointer_set (&demux->last_pad, pad);
+
+  return pad;
+}
+
+/* the ssrc_lock must be taken for writing */
+static void
+remove_demux_pad (GstRtpSsrcDemux * demux, GstRtpSsrcDemuxPad * dpad)
+{
+  demux->srcpads = g_slist_remove (demux->srcpads, dpad);
+  g_hash_table_remove (demux->ssrc_pads, GUINT_TO_POINTER (dpad->ssrc));
+  if (demux->last_pad == dpad)
+    g_atomic_pointer_set (&demux->last_pad, NULL);
 }
 
 static GstEvent *
@@ -241,9 +264,25 @@ find_or_create_demux_pad_for_ssrc (GstRtpSsrcDemux * demux, guint32 ssrc,
   GstPadTemplate *templ;
   gchar *padname;
   GstRtpSsrcDemuxPad *demuxpad;
-  GstPad *retpad;
+  GstPad *retpad = NULL;
   gulong rtp_block, rtcp_block;
 
+  /* fast path, the pad exists and the initial events were pushed. This only
+   * takes the read lock so that it does not wait for other pads being
+   * created */
+  GST_SSRC_READ_LOCK (demux);
+  demuxpad = find_demux_pad_for_ssrc (demux, ssrc);
+  if (demuxpad != NULL) {
+    if (padtype == RTP_PAD && demuxpad->pushed_initial_rtp_events)
+      retpad = gst_object_ref (demuxpad->rtp_pad);
+    else if (padtype == RTCP_PAD && demuxpad->pushed_initial_rtcp_events)
+      retpad = gst_object_ref (demuxpad->rtcp_pad);
+  }
+  GST_SSRC_READ_UNLOCK (demux);
+
+  if (retpad)
+    return retpad;
+
   GST_PAD_LOCK (demux);
 
   demuxpad = find_demux_pad_for_ssrc (demux, ssrc);
@@ -255,14 +294,18 @@ find_or_create_demux_pad_for_ssrc (GstRtpSsrcDemux * demux, guint32 ssrc,
         retpad = gst_object_ref (demuxpad->rtp_pad);
         if (!demuxpad->pushed_initial_rtp_events) {
           forward = TRUE;
+          GST_SSRC_WRITE_LOCK (demux);
           demuxpad->pushed_initial_rtp_events = TRUE;
+          GST_SSRC_WRITE_UNLOCK (demux);
         }
         break;
       case RTCP_PAD:
         retpad = gst_object_ref (demuxpad->rtcp_pad);
         if (!demuxpad->pushed_initial_rtcp_events) {
           forward = TRUE;
+          GST_SSRC_WRITE_LOCK (demux);
           demuxpad->pushed_initial_rtcp_events = TRUE;
+          GST_SSRC_WRITE_UNLOCK (demux);
         }
         break;
       default:
@@ -299,7 +342,14 @@ find_or_create_demux_pad_for_ssrc (GstRtpSsrcDemux * demux, guint32 ssrc,
   gst_pad_set_element_private (rtp_pad, demuxpad);
   gst_pad_set_element_private (rtcp_pad, demuxpad);
 
+  GST_SSRC_WRITE_LOCK (demux);
+  if (padtype == RTP_PAD)
+    demuxpad->pushed_initial_rtp_events = TRUE;
+  else if (padtype == RTCP_PAD)
+    demuxpad->pushed_initial_rtcp_events = TRUE;
   demux->srcpads = g_slist_prepend (demux->srcpads, demuxpad);
+  g_hash_table_insert (demux->ssrc_pads, GUINT_TO_POINTER (ssrc), demuxpad);
+  GST_SSRC_WRITE_UNLOCK (demux);
 
   gst_pad_set_query_function (rtp_pad, gst_rtp_ssrc_demux_src_query);
   gst_pad_set_iterate_internal_links_function (rtp_pad,
@@ -315,10 +365,8 @@ find_or_create_demux_pad_for_ssrc (GstRtpSsrcDemux * demux, guint32 ssrc,
   gst_pad_set_active (rtcp_pad, TRUE);
 
   if (padtype == RTP_PAD) {
-    demuxpad->pushed_initial_rtp_events = TRUE;
     forward_initial_events (demux, ssrc, rtp_pad, padtype);
   } else if (padtype == RTCP_PAD) {
-    demuxpad->pushed_initial_rtcp_events = TRUE;
     forward_initial_events (demux, ssrc, rtcp_pad, padtype);
   } else {
     g_assert_not_reached ();
@@ -450,6 +498,8 @@ gst_rtp_ssrc_demux_init (GstRtpSsrcDemux * demux)
       gst_pad_new_from_template (gst_element_class_get_pad_template (klass,
           "sink"), "sink");
   gst_pad_set_chain_function (demux->rtp_sink, gst_rtp_ssrc_demux_chain);
+  gst_pad_set_chain_list_function (demux->rtp_sink,
+      gst_rtp_ssrc_demux_chain_list);
   gst_pad_set_event_function (demux->rtp_sink, gst_rtp_ssrc_demux_sink_event);
   gst_pad_set_iterate_internal_links_function (demux->rtp_sink,
       gst_rtp_ssrc_demux_iterate_internal_links_sink);
@@ -465,14 +515,23 @@ gst_rtp_ssrc_demux_init (GstRtpSsrcDemux * demux)
   gst_element_add_pad (GST_ELEMENT_CAST (demux), demux->rtcp_sink);
 
   g_rec_mutex_init (&demux->padlock);
+  g_rw_lock_init (&demux->ssrc_lock);
+  demux->ssrc_pads = g_hash_table_new (NULL, NULL);
 }
 
 static void
 gst_rtp_ssrc_demux_reset (GstRtpSsrcDemux * demux)
 {
-  GSList *walk;
+  GSList *srcpads, *walk;
 
-  for (walk = demux->srcpads; walk; walk = g_slist_next (walk)) {
+  GST_SSRC_WRITE_LOCK (demux);
+  srcpads = demux->srcpads;
+  demux->srcpads = NULL;
+  g_hash_table_remove_all (demux->ssrc_pads);
+  demux->last_pad = NULL;
+  GST_SSRC_WRITE_UNLOCK (demux);
+
+  for (walk = srcpads; walk; walk = g_slist_next (walk)) {
     GstRtpSsrcDemuxPad *dpad = (GstRtpSsrcDemuxPad *) walk->data;
 
     gst_pad_set_active (dpad->rtp_pad, FALSE);
@@ -482,8 +541,7 @@ gst_rtp_ssrc_demux_reset (GstRtpSsrcDemux * demux)
     gst_element_remove_pad (GST_ELEMENT_CAST (demux), dpad->rtcp_pad);
     g_free (dpad);
   }
-  g_slist_free (demux->srcpads);
-  demux->srcpads = NULL;
+  g_slist_free (srcpads);
 }
 
 static void
@@ -505,6 +563,8 @@ gst_rtp_ssrc_demux_finalize (GObject * object)
 
   demux = GST_RTP_SSRC_DEMUX (object);
   g_rec_mutex_clear (&demux->padlock);
+  g_rw_lock_clear (&demux->ssrc_lock);
+  g_hash_table_unref (demux->ssrc_pads);
 
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
@@ -523,7 +583,9 @@ gst_rtp_ssrc_demux_clear_ssrc (GstRtpSsrcDemux * demux, guint32 ssrc)
 
   GST_DEBUG_OBJECT (demux, "clearing pad for SSRC %08x", ssrc);
 
-  demux->srcpads = g_slist_remove (demux->srcpads, dpad);
+  GST_SSRC_WRITE_LOCK (demux);
+  remove_demux_pad (demux, dpad);
+  GST_SSRC_WRITE_UNLOCK (demux);
   GST_PAD_UNLOCK (demux);
 
   gst_pad_set_active (dpad->rtp_pad, FALSE);
@@ -606,48 +668,69 @@ gst_rtp_ssrc_demux_sink_event (GstPad * pad, GstObject * parent,
   return fdata.res;
 }
 
+/* push a buffer or a list of buffers on the RTP pad of @ssrc */
 static GstFlowReturn
-gst_rtp_ssrc_demux_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
+gst_rtp_ssrc_demux_push_rtp (GstRtpSsrcDemux * demux, guint32 ssrc,
+    gpointer data, gboolean is_list)
 {
   GstFlowReturn ret;
-  GstRtpSsrcDemux *demux;
-  guint32 ssrc;
-  GstRTPBuffer rtp = { NULL };
   GstPad *srcpad;
   GstRtpSsrcDemuxPad *dpad;
 
-  demux = GST_RTP_SSRC_DEMUX (parent);
-
-  if (!gst_rtp_buffer_map (buf, GST_MAP_READ, &rtp))
-    goto invalid_payload;
-
-  ssrc = gst_rtp_buffer_get_ssrc (&rtp);
-  gst_rtp_buffer_unmap (&rtp);
-
-  GST_DEBUG_OBJECT (demux, "received buffer of SSRC %08x", ssrc);
-
   srcpad = find_or_create_demux_pad_for_ssrc (demux, ssrc, RTP_PAD);
   if (srcpad == NULL)
     goto create_failed;
 
   /* push to srcpad */
-  ret = gst_pad_push (srcpad, buf);
+  if (is_list)
+    ret = gst_pad_push_list (srcpad, GST_BUFFER_LIST_CAST (data));
+  else
+    ret = gst_pad_push (srcpad, GST_BUFFER_CAST (data));
 
   if (ret != GST_FLOW_OK) {
     /* check if the ssrc still there, may have been removed */
-    GST_PAD_LOCK (demux);
+    GST_SSRC_READ_LOCK (demux);
     dpad = find_demux_pad_for_ssrc (demux, ssrc);
     if (dpad == NULL || dpad->rtp_pad != srcpad) {
       /* SSRC was removed during the push ... ignore the error */
       ret = GST_FLOW_OK;
     }
-    GST_PAD_UNLOCK (demux);
+    GST_SSRC_READ_UNLOCK (demux);
   }
 
   gst_object_unref (srcpad);
 
   return ret;
 
+  /* ERRORS */
+create_failed:
+  {
+    GST_ELEMENT_ERROR (demux, STREAM, DECODE, (NULL),
+        ("Could not create new pad"));
+    gst_mini_object_unref (GST_MINI_OBJECT_CAST (data));
+    return GST_FLOW_ERROR;
+  }
+}
+
+static GstFlowReturn
+gst_rtp_ssrc_demux_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
+{
+  GstRtpSsrcDemux *demux;
+  guint32 ssrc;
+  GstRTPBuffer rtp = { NULL };
+
+  demux = GST_RTP_SSRC_DEMUX (parent);
+
+  if (!gst_rtp_buffer_map (buf, GST_MAP_READ, &rtp))
+    goto invalid_payload;
+
+  ssrc = gst_rtp_buffer_get_ssrc (&rtp);
+  gst_rtp_buffer_unmap (&rtp);
+
+  GST_DEBUG_OBJECT (demux, "received buffer of SSRC %08x", ssrc);
+
+  return gst_rtp_ssrc_demux_push_rtp (demux, ssrc, buf, FALSE);
+
   /* ERRORS */
 invalid_payload:
   {
@@ -657,15 +740,90 @@ invalid_payload:
     gst_buffer_unref (buf);
     return GST_FLOW_ERROR;
   }
-create_failed:
+}
+
+struct SplitListData
+{
+  GstRtpSsrcDemux *demux;
+  /* consecutive buffers of ssrc */
+  GstBufferList *sublist;
+  guint32 ssrc;
+  GstFlowReturn ret;
+};
+
+static gboolean
+split_list_buffer (GstBuffer ** buffer, guint idx, gpointer user_data)
+{
+  struct SplitListData *data = user_data;
+  GstRTPBuffer rtp = { NULL };
+  guint32 ssrc;
+
+  if (!gst_rtp_buffer_map (*buffer, GST_MAP_READ, &rtp))
+    goto invalid_payload;
+
+  ssrc = gst_rtp_buffer_get_ssrc (&rtp);
+  gst_rtp_buffer_unmap (&rtp);
+
+  if (data->sublist && ssrc != data->ssrc) {
+    /* other SSRC, push what we collected so far */
+    data->ret = gst_rtp_ssrc_demux_push_rtp (data->demux, data->ssrc,
+        data->sublist, TRUE);
+    data->sublist = NULL;
+    if (data->ret != GST_FLOW_OK)
+      return FALSE;
+  }
+  if (data->sublist == NULL) {
+    data->sublist = gst_buffer_list_new ();
+    data->ssrc = ssrc;
+  }
+  /* take the buffer out of the list */
+  gst_buffer_list_add (data->sublist, *buffer);
+  *buffer = NULL;
+
+  return TRUE;
+
+  /* ERRORS */
+invalid_payload:
   {
-    GST_ELEMENT_ERROR (demux, STREAM, DECODE, (NULL),
-        ("Could not create new pad"));
-    gst_buffer_unref (buf);
-    return GST_FLOW_ERROR;
+    /* this is fatal and should be filtered earlier */
+    GST_ELEMENT_ERROR (data->demux, STREAM, DECODE, (NULL),
+        ("Dropping invalid RTP payload"));
+    data->ret = GST_FLOW_ERROR;
+    return FALSE;
   }
 }
 
+/* push the buffers of a list in sublists of consecutive buffers with the same
+ * SSRC */
+static GstFlowReturn
+gst_rtp_ssrc_demux_chain_list (GstPad * pad, GstObject * parent,
+    GstBufferList * list)
+{
+  struct SplitListData data;
+
+  data.demux = GST_RTP_SSRC_DEMUX (parent);
+  data.sublist = NULL;
+  data.ssrc = 0;
+  data.ret = GST_FLOW_OK;
+
+  GST_DEBUG_OBJECT (data.demux, "received list of %u buffers",
+      gst_buffer_list_length (list));
+
+  list = gst_buffer_list_make_writable (list);
+  gst_buffer_list_foreach (list, split_list_buffer, &data);
+  gst_buffer_list_unref (list);
+
+  if (data.sublist) {
+    if (data.ret == GST_FLOW_OK)
+      data.ret = gst_rtp_ssrc_demux_push_rtp (data.demux, data.ssrc,
+          data.sublist, TRUE);
+    else
+      gst_buffer_list_unref (data.sublist);
+  }
+
+  return data.ret;
+}
+
 static GstFlowReturn
 gst_rtp_ssrc_demux_rtcp_chain (GstPad * pad, GstObject * parent,
     GstBuffer * buf)
@@ -712,13 +870,13 @@ gst_rtp_ssrc_demux_rtcp_chain (GstPad * pad, GstObject * parent,
 
   if (ret != GST_FLOW_OK) {
     /* check if the ssrc still there, may have been removed */
-    GST_PAD_LOCK (demux);
+    GST_SSRC_READ_LOCK (demux);
     dpad = find_demux_pad_for_ssrc (demux, ssrc);
     if (dpad == NULL || dpad->rtcp_pad != srcpad) {
       /* SSRC was removed during the push ... ignore the error */
       ret = GST_FLOW_OK;
     }
-    GST_PAD_UNLOCK (demux);
+    GST_SSRC_READ_UNLOCK (demux);
   }
 
   gst_object_unref (srcpad);
@@ -41,6 +41,14 @@ struct _GstRtpSsrcDemux
 
   GRecMutex padlock;
   GSList *srcpads;
+
+  /* protects the lookup of the pads on the data path, only taken for
+   * writing while holding the padlock */
+  GRWLock ssrc_lock;
+  /* ssrc -> GstRtpSsrcDemuxPad */
+  GHashTable *ssrc_pads;
+  /* the last pad found, set atomically with the read lock */
+  GstRtpSsrcDemuxPad *last_pad;
 };
 
 struct _GstRtpSsrcDemuxClass
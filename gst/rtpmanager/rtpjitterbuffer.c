@@ -30,6 +30,14 @@ GST_DEBUG_CATEGORY_STATIC (rtp_jitter_buffer_debug);
 #define MAX_WINDOW	RTP_JITTER_BUFFER_MAX_WINDOW
 #define MAX_TIME	(2 * GST_SECOND)
 
+/* the seqnum index starts small and doubles when two queued packets map to
+ * the same slot, at its maximum size every seqnum has its own slot */
+#define INDEX_MIN_SIZE	128
+#define INDEX_MAX_SIZE	65536
+/* how many seqnums around a new packet we look at in the index before we
+ * walk the queue to find its position */
+#define INDEX_MAX_SCAN	64
+
 /* signals and args */
 enum
 {
@@ -43,6 +51,7 @@ enum
 
 /* GObject vmethods */
 static void rtp_jitter_buffer_finalize (GObject * object);
+static void index_reset (RTPJitterBuffer * jbuf, guint size);
 
 GType
 rtp_jitter_buffer_mode_get_type (void)
@@ -87,6 +96,7 @@ rtp_jitter_buffer_init (RTPJitterBuffer * jbuf)
 {
   jbuf->packets = g_queue_new ();
   jbuf->mode = RTP_JITTER_BUFFER_MODE_SLAVE;
+  index_reset (jbuf, INDEX_MIN_SIZE);
 
   rtp_jitter_buffer_reset_skew (jbuf);
 }
@@ -99,6 +109,7 @@ rtp_jitter_buffer_finalize (GObject * object)
   jbuf = RTP_JITTER_BUFFER_CAST (object);
 
   g_queue_free (jbuf->packets);
+  g_free (jbuf->index);
 
   G_OBJECT_CLASS (rtp_jitter_buffer_parent_class)->finalize (object);
 }
@@ -621,6 +632,145 @@ no_skew:
   return out_time;
 }
 
+static void
+index_reset (RTPJitterBuffer * jbuf, guint size)
+{
+  g_free (jbuf->index);
+  jbuf->index = g_new0 (RTPJitterBufferItem *, size);
+  jbuf->index_mask = size - 1;
+}
+
+/* make a new index of at least @size slots for all queued packets */
+static void
+index_rebuild (RTPJitterBuffer * jbuf, guint size)
+{
+  GList *list;
+
+again:
+  GST_DEBUG ("rebuilding index with %u slots", size);
+  index_reset (jbuf, size);
+
+  for (list = jbuf->packets->head; list; list = g_list_next (list)) {
+    RTPJitterBufferItem *qitem = (RTPJitterBufferItem *) list;
+    RTPJitterBufferItem **slot;
+
+    if (qitem->seqnum == -1)
+      continue;
+
+    slot = &jbuf->index[qitem->seqnum & jbuf->index_mask];
+    if (G_UNLIKELY (*slot != NULL && size < INDEX_MAX_SIZE)) {
+      size <<= 1;
+      goto again;
+    }
+    *slot = qitem;
+  }
+}
+
+static inline RTPJitterBufferItem *
+index_lookup (RTPJitterBuffer * jbuf, guint16 seqnum)
+{
+  RTPJitterBufferItem *item;
+
+  item = jbuf->index[seqnum & jbuf->index_mask];
+  if (item && item->seqnum == seqnum)
+    return item;
+
+  return NULL;
+}
+
+/* called after @item was inserted in the queue */
+static void
+index_add (RTPJitterBuffer * jbuf, RTPJitterBufferItem * item)
+{
+  RTPJitterBufferItem **slot;
+
+  if (item->seqnum == -1)
+    return;
+
+  slot = &jbuf->index[item->seqnum & jbuf->index_mask];
+  if (G_UNLIKELY (*slot != NULL))
+    index_rebuild (jbuf, (jbuf->index_mask + 1) << 1);
+  else
+    *slot = item;
+}
+
+static inline void
+index_remove (RTPJitterBuffer * jbuf, RTPJitterBufferItem * item)
+{
+  RTPJitterBufferItem **slot;
+
+  if (item->seqnum == -1)
+    return;
+
+  slot = &jbuf->index[item->seqnum & jbuf->index_mask];
+  if (*slot == item)
+    *slot = NULL;
+}
+
+/* Find the position in the queue for a new packet with @seqnum. @list is set
+ * to the first packet with a bigger seqnum or %NULL when the packet needs to
+ * be appended. All queued packets are in the index so, for the common case of
+ * in-order or slightly reordered packets, looking at the neighbouring seqnums
+ * finds the position. Only for packets far away from any other packet we walk
+ * the queue.
+ *
+ * Returns: %FALSE if a packet with @seqnum is already queued. */
+static gboolean
+find_position (RTPJitterBuffer * jbuf, guint16 seqnum, GList ** list)
+{
+  RTPJitterBufferItem *qitem;
+  GList *l;
+  guint i;
+
+  if (G_UNLIKELY (index_lookup (jbuf, seqnum)))
+    return FALSE;
+
+  for (i = 1; i <= INDEX_MAX_SCAN; i++) {
+    /* closest packet before us, we go after it and after any events that
+     * follow it */
+    if ((qitem = index_lookup (jbuf, seqnum - i))) {
+      for (l = g_list_next ((GList *) qitem); l; l = g_list_next (l)) {
+        if (((RTPJitterBufferItem *) l)->seqnum != -1)
+          break;
+      }
+      *list = l;
+      return TRUE;
+    }
+    /* closest packet after us, we go right before it */
+    if ((qitem = index_lookup (jbuf, seqnum + i))) {
+      *list = (GList *) qitem;
+      return TRUE;
+    }
+  }
+
+  /* loop the list to skip strictly smaller seqnum buffers */
+  for (l = jbuf->packets->head; l; l = g_list_next (l)) {
+    guint16 qseq;
+    gint gap;
+
+    qitem = (RTPJitterBufferItem *) l;
+
+    if (qitem->seqnum == -1)
+      continue;
+
+    qseq = qitem->seqnum;
+
+    /* compare the new seqnum to the one in the buffer */
+    gap = gst_rtp_buffer_compare_seqnum (seqnum, qseq);
+
+    /* we hit a packet with the same seqnum, notify a duplicate */
+    if (G_UNLIKELY (gap == 0))
+      return FALSE;
+
+    /* seqnum < qseq, we can stop looking */
+    if (G_LIKELY (gap > 0))
+      break;
+  }
+  *list = l;
+
+  return TRUE;
+}
+
 static void
 queue_do_insert (RTPJitterBuffer * jbuf, GList * list, GList * item)
 {
@@ -678,28 +828,9 @@ rtp_jitter_buffer_insert (RTPJitterBuffer * jbuf, RTPJitterBufferItem * item,
 
   seqnum = item->seqnum;
 
-  /* loop the list to skip strictly smaller seqnum buffers */
-  for (list = jbuf->packets->head; list; list = g_list_next (list)) {
-    guint16 qseq;
-    gint gap;
-    RTPJitterBufferItem *qitem = (RTPJitterBufferItem *) list;
-
-    if (qitem->seqnum == -1)
-      continue;
-
-    qseq = qitem->seqnum;
-
-    /* compare the new seqnum to the one in the buffer */
-    gap = gst_rtp_buffer_compare_seqnum (seqnum, qseq);
-
-    /* we hit a packet with the same seqnum, notify a duplicate */
-    if (G_UNLIKELY (gap == 0))
-      goto duplicate;
-
-    /* seqnum < qseq, we can stop looking */
-    if (G_LIKELY (gap > 0))
-      break;
-  }
+  /* find the first packet with a bigger seqnum */
+  if (G_UNLIKELY (!find_position (jbuf, seqnum, &list)))
+    goto duplicate;
 
   dts = item->dts;
   if (item->rtptime == -1)
@@ -755,6 +886,7 @@ rtp_jitter_buffer_insert (RTPJitterBuffer * jbuf, RTPJitterBufferItem * item,
 
 append:
   queue_do_insert (jbuf, list, (GList *) item);
+  index_add (jbuf, item);
 
   /* buffering mode, update buffer stats */
   if (jbuf->mode == RTP_JITTER_BUFFER_MODE_BUFFER)
@@ -806,6 +938,7 @@ rtp_jitter_buffer_pop (RTPJitterBuffer * jbuf, gint * percent)
     else
       queue->tail = NULL;
     queue->length--;
+    index_remove (jbuf, (RTPJitterBufferItem *) item);
   }
 
   /* buffering mode, update buffer stats */
@@ -854,6 +987,8 @@ rtp_jitter_buffer_flush (RTPJitterBuffer * jbuf, GFunc free_func,
 
   while ((item = g_queue_pop_head_link (jbuf->packets)))
     free_func ((RTPJitterBufferItem *) item, user_data);
+
+  index_reset (jbuf, INDEX_MIN_SIZE);
 }
 
 /**
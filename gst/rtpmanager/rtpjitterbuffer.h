@@ -76,6 +76,10 @@ struct _RTPJitterBuffer {
 
   GQueue        *packets;
 
+  /* packets indexed by seqnum modulo the index size */
+  RTPJitterBufferItem **index;
+  guint          index_mask;
+
   RTPJitterBufferMode mode;
 
   GstClockTime   delay;
@@ -484,6 +484,9 @@ rtp_session_init (RTPSession * sess)
         g_hash_table_new_full (NULL, NULL, NULL,
         (GDestroyNotify) g_object_unref);
   }
+  sess->report_sources = g_hash_table_new_full (NULL, NULL,
+      (GDestroyNotify) g_object_unref, NULL);
+  sess->timeout_sources = g_sequence_new (NULL);
 
   rtp_stats_init_defaults (&sess->stats);
   INIT_AVG (sess->stats.avg_rtcp_packet_size, 100);
@@ -546,6 +549,8 @@ rtp_session_finalize (GObject * object)
 
   gst_structure_free (sess->sdes);
 
+  g_sequence_free (sess->timeout_sources);
+  g_hash_table_destroy (sess->report_sources);
   for (i = 0; i < 32; i++)
     g_hash_table_destroy (sess->ssrcs[i]);
 
@@ -1266,6 +1271,7 @@ check_collision (RTPSession * sess, RTPSource * source,
               rtp_source_set_rtp_from (source, pinfo->address);
             else
               rtp_source_set_rtcp_from (source, pinfo->address);
+            sess->update_ptp = TRUE;
 
             g_free (buf1);
             g_free (buf2);
@@ -1283,6 +1289,7 @@ check_collision (RTPSession * sess, RTPSource * source,
         rtp_source_set_rtp_from (source, pinfo->address);
       else
         rtp_source_set_rtcp_from (source, pinfo->address);
+      sess->update_ptp = TRUE;
       return FALSE;
     }
 
@@ -1378,6 +1385,8 @@ session_update_ptp (RTPSession * sess)
   gboolean is_doing_rtcp_ptp = FALSE;
   CompareAddrData data;
 
+  sess->update_ptp = FALSE;
+
   /* compare the first remote source's ip addr that receive rtp packets
    * with other remote rtp source.
    * it's enough because the session just needs to know if they are all
@@ -1403,6 +1412,53 @@ session_update_ptp (RTPSession * sess)
   GST_DEBUG ("doing point-to-point: %d", sess->is_doing_ptp);
 }
 
+static gint
+compare_timeout_time (RTPSource * a, RTPSource * b, gpointer user_data)
+{
+  if (a->timeout_time < b->timeout_time)
+    return -1;
+  if (a->timeout_time > b->timeout_time)
+    return 1;
+  return 0;
+}
+
+/* make sure @source is looked at in every RTCP interval */
+static void
+session_watch_source (RTPSession * sess, RTPSource * source)
+{
+  /* removed sources stay removed */
+  if (source->closing)
+    return;
+
+  if (source->timeout_iter) {
+    g_sequence_remove (source->timeout_iter);
+    source->timeout_iter = NULL;
+  }
+  if (!g_hash_table_contains (sess->report_sources, source))
+    g_hash_table_add (sess->report_sources, g_object_ref (source));
+}
+
+/* only look at @source again in the RTCP interval after its timeout_time */
+static void
+session_schedule_source (RTPSession * sess, RTPSource * source)
+{
+  if (source->timeout_iter)
+    g_sequence_remove (source->timeout_iter);
+  source->timeout_iter = g_sequence_insert_sorted (sess->timeout_sources,
+      source, (GCompareDataFunc) compare_timeout_time, NULL);
+  g_hash_table_remove (sess->report_sources, source);
+}
+
+static void
+session_forget_source (RTPSession * sess, RTPSource * source)
+{
+  if (source->timeout_iter) {
+    g_sequence_remove (source->timeout_iter);
+    source->timeout_iter = NULL;
+  }
+  g_hash_table_remove (sess->report_sources, source);
+}
+
 static void
 add_source (RTPSession * sess, RTPSource * src)
 {
@@ -1410,6 +1466,7 @@ add_source (RTPSession * sess, RTPSource * src)
       GINT_TO_POINTER (src->ssrc), src);
   /* report the new source ASAP */
   src->generation = sess->generation;
+  session_watch_source (sess, src);
   /* we have one more source now */
   sess->total_sources++;
   if (RTP_SOURCE_IS_ACTIVE (src))
@@ -1821,6 +1878,7 @@ source_update_sender (RTPSession * sess, RTPSource * source,
     sess->stats.sender_sources++;
     if (source->internal)
       sess->stats.internal_sender_sources++;
+    session_watch_source (sess, source);
     GST_DEBUG ("source: %08x became sender, %d sender sources", ssrc,
         sess->stats.sender_sources);
   } else {
@@ -1833,20 +1891,10 @@ source_update_sender (RTPSession * sess, RTPSource * source,
   return TRUE;
 }
 
-/**
- * rtp_session_process_rtp:
- * @sess: and #RTPSession
- * @buffer: an RTP buffer
- * @current_time: the current system time
- * @running_time: the running_time of @buffer
- *
- * Process an RTP buffer in the session manager. This function takes ownership
- * of @buffer.
- *
- * Returns: a #GstFlowReturn.
- */
-GstFlowReturn
-rtp_session_process_rtp (RTPSession * sess, GstBuffer * buffer,
+/* process one RTP buffer, takes ownership of @buffer. Must be called with
+ * the SESSION lock */
+static GstFlowReturn
+process_rtp_packet (RTPSession * sess, GstBuffer * buffer,
     GstClockTime current_time, GstClockTime running_time, guint64 ntpnstime)
 {
   GstFlowReturn result;
@@ -1857,17 +1905,14 @@ rtp_session_process_rtp (RTPSession * sess, GstBuffer * buffer,
   RTPPacketInfo pinfo = { 0, };
   guint64 oldrate;
 
-  g_return_val_if_fail (RTP_IS_SESSION (sess), GST_FLOW_ERROR);
-  g_return_val_if_fail (GST_IS_BUFFER (buffer), GST_FLOW_ERROR);
-
-  RTP_SESSION_LOCK (sess);
-
   /* update pinfo stats */
   if (!update_packet_info (sess, &pinfo, FALSE, TRUE, FALSE, buffer,
           current_time, running_time, ntpnstime)) {
     GST_DEBUG ("invalid RTP packet received");
     RTP_SESSION_UNLOCK (sess);
-    return rtp_session_process_rtcp (sess, buffer, current_time, ntpnstime);
+    result = rtp_session_process_rtcp (sess, buffer, current_time, ntpnstime);
+    RTP_SESSION_LOCK (sess);
+    return result;
   }
 
   ssrc = pinfo.ssrc;
@@ -1922,8 +1967,6 @@ rtp_session_process_rtp (RTPSession * sess, GstBuffer * buffer,
   }
   g_object_unref (source);
 
-  RTP_SESSION_UNLOCK (sess);
-
   clean_packet_info (&pinfo);
 
   return result;
@@ -1931,13 +1974,117 @@ rtp_session_process_rtp (RTPSession * sess, GstBuffer * buffer,
   /* ERRORS */
 collision:
   {
-    RTP_SESSION_UNLOCK (sess);
     clean_packet_info (&pinfo);
     GST_DEBUG ("ignoring packet because its collisioning");
     return GST_FLOW_OK;
   }
 }
 
+/**
+ * rtp_session_process_rtp:
+ * @sess: and #RTPSession
+ * @buffer: an RTP buffer
+ * @current_time: the current system time
+ * @running_time: the running_time of @buffer
+ *
+ * Process an RTP buffer in the session manager. This function takes ownership
+ * of @buffer.
+ *
+ * Returns: a #GstFlowReturn.
+ */
+GstFlowReturn
+rtp_session_process_rtp (RTPSession * sess, GstBuffer * buffer,
+    GstClockTime current_time, GstClockTime running_time, guint64 ntpnstime)
+{
+  GstFlowReturn result;
+
+  g_return_val_if_fail (RTP_IS_SESSION (sess), GST_FLOW_ERROR);
+  g_return_val_if_fail (GST_IS_BUFFER (buffer), GST_FLOW_ERROR);
+
+  RTP_SESSION_LOCK (sess);
+  result = process_rtp_packet (sess, buffer, current_time, running_time,
+      ntpnstime);
+  RTP_SESSION_UNLOCK (sess);
+
+  return result;
+}
+
+typedef struct
+{
+  RTPSession *sess;
+  GstClockTime current_time;
+  const GstClockTime *running_times;
+  const guint64 *ntpnstimes;
+  guint idx;
+  GstFlowReturn result;
+} ProcessRTPListData;
+
+static gboolean
+process_rtp_list_packet (GstBuffer ** buffer, guint idx,
+    ProcessRTPListData * data)
+{
+  /* take the buffer out of the list so that it stays writable, this also
+   * keeps @idx at 0 so we count the buffers ourselves */
+  data->result = process_rtp_packet (data->sess, *buffer, data->current_time,
+      data->running_times[data->idx], data->ntpnstimes[data->idx]);
+  data->idx++;
+  *buffer = NULL;
+
+  /* stop at the first error, the remaining buffers are freed with the list */
+  return data->result == GST_FLOW_OK;
+}
+
+/**
+ * rtp_session_process_rtp_list:
+ * @sess: and #RTPSession
+ * @list: a list of RTP buffers
+ * @current_time: the current system time
+ * @running_times: the running_time of each buffer in @list
+ * @ntpnstimes: the NTP time in nanoseconds of each buffer in @list
+ *
+ * Process the RTP buffers in @list in the session manager, like calling
+ * rtp_session_process_rtp() for each buffer with the matching entries of
+ * @running_times and @ntpnstimes. The session lock is taken once for the
+ * list but, like for a single buffer, it is released while a processed
+ * buffer is pushed out and while an invalid RTP buffer is processed as
+ * RTCP.
+ *
+ * Processing stops at the first buffer that does not return %GST_FLOW_OK,
+ * the remaining buffers are dropped. This function takes ownership of @list.
+ *
+ * Returns: a #GstFlowReturn.
+ */
+GstFlowReturn
+rtp_session_process_rtp_list (RTPSession * sess, GstBufferList * list,
+    GstClockTime current_time, const GstClockTime * running_times,
+    const guint64 * ntpnstimes)
+{
+  ProcessRTPListData data;
+
+  g_return_val_if_fail (RTP_IS_SESSION (sess), GST_FLOW_ERROR);
+  g_return_val_if_fail (GST_IS_BUFFER_LIST (list), GST_FLOW_ERROR);
+  g_return_val_if_fail (running_times != NULL, GST_FLOW_ERROR);
+  g_return_val_if_fail (ntpnstimes != NULL, GST_FLOW_ERROR);
+
+  data.sess = sess;
+  data.current_time = current_time;
+  data.running_times = running_times;
+  data.ntpnstimes = ntpnstimes;
+  data.idx = 0;
+  data.result = GST_FLOW_OK;
+
+  list = gst_buffer_list_make_writable (list);
+
+  RTP_SESSION_LOCK (sess);
+  gst_buffer_list_foreach (list, (GstBufferListFunc) process_rtp_list_packet,
+      &data);
+  RTP_SESSION_UNLOCK (sess);
+
+  gst_buffer_list_unref (list);
+
+  return data.result;
+}
+
 static void
 rtp_session_process_rb (RTPSession * sess, RTPSource * source,
     GstRTCPPacket * packet, RTPPacketInfo * pinfo)
@@ -2198,6 +2345,7 @@ rtp_session_process_bye (RTPSession * sess, GstRTCPPacket * packet,
 
     /* mark the source BYE */
     rtp_source_mark_bye (source, reason);
+    session_watch_source (sess, source);
 
     pmembers = sess->stats.active_sources;
 
@@ -2905,6 +3053,11 @@ typedef struct
   GstBuffer *buffer;
 } ReportOutput;
 
+/* number of sources that are handled with the session lock held when looping
+ * over all sources for RTCP. The lock is released between the batches so that
+ * processing RTP packets does not have to wait for the complete loop */
+#define RTCP_SCAN_BATCH 64
+
 typedef struct
 {
   GstRTCPBuffer rtcpbuf;
@@ -2925,8 +3078,29 @@ typedef struct
   gboolean may_suppress;
   GQueue output;
   guint nacked_seqnums;
+  /* the sources of the session when the RTCP timeout started */
+  GPtrArray *sources;
 } ReportData;
 
+/* call @func for all sources in the snapshot of @data. Must be called with
+ * the session lock, which is released after every RTCP_SCAN_BATCH sources.
+ * The snapshot keeps a ref to the sources so they stay valid, sources that
+ * are added in the meantime are handled in the next timeout. */
+static void
+foreach_snapshot_source (ReportData * data, GHFunc func)
+{
+  RTPSession *sess = data->sess;
+  guint i;
+
+  for (i = 0; i < data->sources->len; i++) {
+    if (i > 0 && i % RTCP_SCAN_BATCH == 0) {
+      RTP_SESSION_UNLOCK (sess);
+      RTP_SESSION_LOCK (sess);
+    }
+    func (NULL, g_ptr_array_index (data->sources, i), data);
+  }
+}
+
 static void
 session_start_rtcp (RTPSession * sess, ReportData * data)
 {
@@ -3068,8 +3242,7 @@ session_fir (RTPSession * sess, ReportData * data)
   gst_rtcp_packet_fb_set_sender_ssrc (packet, data->source->ssrc);
   gst_rtcp_packet_fb_set_media_ssrc (packet, 0);
 
-  g_hash_table_foreach (sess->ssrcs[sess->mask_idx],
-      (GHFunc) session_add_fir, data);
+  foreach_snapshot_source (data, (GHFunc) session_add_fir);
 
   if (gst_rtcp_packet_fb_get_fci_length (packet) == 0)
     gst_rtcp_packet_remove (packet);
@@ -3175,6 +3348,9 @@ session_cleanup (const gchar * key, RTPSource * source, ReportData * data)
 
   GST_DEBUG ("look at %08x, generation %u", source->ssrc, source->generation);
 
+  /* look at the source in every interval unless we know when it times out */
+  source->timeout_time = GST_CLOCK_TIME_NONE;
+
   /* check for outdated collisions */
   if (source->internal) {
     GST_DEBUG ("Timing out collisions for %x", source->ssrc);
@@ -3229,14 +3405,20 @@ session_cleanup (const gchar * key, RTPSource * source, ReportData * data)
      * interval get timed out. the min timeout is 5 seconds. */
     /* mind old time that might pre-date last time going to PLAYING */
     btime = MAX (source->last_activity, sess->start_time);
+    interval = MAX (binterval * 5, 5 * GST_SECOND);
     if (data->current_time > btime) {
-      interval = MAX (binterval * 5, 5 * GST_SECOND);
       if (data->current_time - btime > interval) {
         GST_DEBUG ("removing timeout source %08x, last %" GST_TIME_FORMAT,
             source->ssrc, GST_TIME_ARGS (btime));
         remove = TRUE;
       }
     }
+    /* the earliest time this source can be removed with the current
+     * interval. A longer interval later only makes us look too early. */
+    source->timeout_time = btime + interval;
+    if (source->marked_bye)
+      source->timeout_time = MIN (source->timeout_time,
+          source->bye_time + sess->stats.bye_timeout);
   }
 
   /* senders that did not send for a long time become a receiver, this also
@@ -3467,26 +3649,48 @@ early:
 }
 
 static void
-clone_ssrcs_hashtable (gchar * key, RTPSource * source, GHashTable * hash_table)
+add_to_snapshot (gpointer key, RTPSource * source, GPtrArray * sources)
 {
-  g_hash_table_insert (hash_table, key, g_object_ref (source));
+  g_ptr_array_add (sources, g_object_ref (source));
 }
 
-static gboolean
-remove_closing_sources (const gchar * key, RTPSource * source,
-    ReportData * data)
+/* remove the sources that were marked by session_cleanup() from the session
+ * and from the snapshot. The other sources are either kept in the report
+ * sources or moved to the timeout sources when nothing needs to be done for
+ * them until they can time out. */
+static void
+remove_closing_sources (RTPSession * sess, ReportData * data)
 {
-  if (source->closing)
-    return TRUE;
-
-  if (source->send_fir)
-    data->have_fir = TRUE;
-  if (source->send_pli)
-    data->have_pli = TRUE;
-  if (source->send_nack)
-    data->have_nack = TRUE;
+  guint i = 0;
+
+  while (i < data->sources->len) {
+    RTPSource *source = g_ptr_array_index (data->sources, i);
+
+    if (source->closing) {
+      session_forget_source (sess, source);
+      if (find_source (sess, source->ssrc) == source)
+        g_hash_table_remove (sess->ssrcs[sess->mask_idx],
+            GINT_TO_POINTER (source->ssrc));
+      g_ptr_array_remove_index_fast (data->sources, i);
+      sess->update_ptp = TRUE;
+      continue;
+    }
 
-  return FALSE;
+    if (source->internal || RTP_SOURCE_IS_SENDER (source) ||
+        source->send_fir || source->send_pli || source->send_nack ||
+        source->timeout_time == GST_CLOCK_TIME_NONE)
+      session_watch_source (sess, source);
+    else
+      session_schedule_source (sess, source);
+
+    if (source->send_fir)
+      data->have_fir = TRUE;
+    if (source->send_pli)
+      data->have_pli = TRUE;
+    if (source->send_nack)
+      data->have_nack = TRUE;
+    i++;
+  }
 }
 
 static void
@@ -3516,8 +3720,7 @@ generate_rtcp (const gchar * key, RTPSource * source, ReportData * data)
   } else if (!data->is_early) {
     /* loop over all known sources and add report blocks. If we are early, we
      * just make a minimal RTCP packet and skip this step */
-    g_hash_table_foreach (sess->ssrcs[sess->mask_idx],
-        (GHFunc) session_report_blocks, data);
+    foreach_snapshot_source (data, (GHFunc) session_report_blocks);
   }
   if (!data->has_sdes)
     session_sdes (sess, data);
@@ -3526,12 +3729,10 @@ generate_rtcp (const gchar * key, RTPSource * source, ReportData * data)
     session_fir (sess, data);
 
   if (data->have_pli)
-    g_hash_table_foreach (sess->ssrcs[sess->mask_idx],
-        (GHFunc) session_pli, data);
+    foreach_snapshot_source (data, (GHFunc) session_pli);
 
   if (data->have_nack)
-    g_hash_table_foreach (sess->ssrcs[sess->mask_idx],
-        (GHFunc) session_nack, data);
+    foreach_snapshot_source (data, (GHFunc) session_nack);
 
   gst_rtcp_buffer_unmap (&data->rtcpbuf);
 
@@ -3589,7 +3790,6 @@ rtp_session_on_timeout (RTPSession * sess, GstClockTime current_time,
 {
   GstFlowReturn result = GST_FLOW_OK;
   ReportData data = { GST_RTCP_BUFFER_INIT };
-  GHashTable *table_copy;
   ReportOutput *output;
 
   g_return_val_if_fail (RTP_IS_SESSION (sess), GST_FLOW_ERROR);
@@ -3622,24 +3822,40 @@ rtp_session_on_timeout (RTPSession * sess, GstClockTime current_time,
     g_object_unref (source);
   }
 
-  /* Make a local copy of the hashtable. We need to do this because the
-   * cleanup stage below releases the session lock. */
-  table_copy = g_hash_table_new_full (NULL, NULL, NULL,
+  /* Make a snapshot of the sources we need to look at. We need to do this
+   * because the stages below release the session lock. */
+  data.sources =
+      g_ptr_array_new_full (g_hash_table_size (sess->report_sources),
       (GDestroyNotify) g_object_unref);
-  g_hash_table_foreach (sess->ssrcs[sess->mask_idx],
-      (GHFunc) clone_ssrcs_hashtable, table_copy);
+  g_hash_table_foreach (sess->report_sources, (GHFunc) add_to_snapshot,
+      data.sources);
+  /* and the sources that can have timed out */
+  while (TRUE) {
+    GSequenceIter *iter;
+    RTPSource *source;
+
+    iter = g_sequence_get_begin_iter (sess->timeout_sources);
+    if (g_sequence_iter_is_end (iter))
+      break;
+    source = g_sequence_get (iter);
+    if (source->timeout_time > current_time)
+      break;
+
+    g_sequence_remove (iter);
+    source->timeout_iter = NULL;
+    g_ptr_array_add (data.sources, g_object_ref (source));
+  }
 
   /* Clean up the session, mark the source for removing, this might release the
    * session lock. */
-  g_hash_table_foreach (table_copy, (GHFunc) session_cleanup, &data);
-  g_hash_table_destroy (table_copy);
+  foreach_snapshot_source (&data, (GHFunc) session_cleanup);
 
   /* Now remove the marked sources */
-  g_hash_table_foreach_remove (sess->ssrcs[sess->mask_idx],
-      (GHRFunc) remove_closing_sources, &data);
+  remove_closing_sources (sess, &data);
 
   /* update point-to-point status */
-  session_update_ptp (sess);
+  if (sess->update_ptp)
+    session_update_ptp (sess);
 
   /* see if we need to generate SR or RR packets */
   if (!is_rtcp_time (sess, current_time, &data))
@@ -3649,12 +3865,10 @@ rtp_session_on_timeout (RTPSession * sess, GstClockTime current_time,
       sess->generation, data.num_to_report, data.is_early);
 
   /* generate RTCP for all internal sources */
-  g_hash_table_foreach (sess->ssrcs[sess->mask_idx],
-      (GHFunc) generate_rtcp, &data);
+  foreach_snapshot_source (&data, (GHFunc) generate_rtcp);
 
   /* update the generation for all the sources that have been reported */
-  g_hash_table_foreach (sess->ssrcs[sess->mask_idx],
-      (GHFunc) update_generation, &data);
+  foreach_snapshot_source (&data, (GHFunc) update_generation);
 
   /* we keep track of the last report time in order to timeout inactive
    * receivers or senders */
@@ -3667,6 +3881,8 @@ rtp_session_on_timeout (RTPSession * sess, GstClockTime current_time,
 done:
   RTP_SESSION_UNLOCK (sess);
 
+  g_ptr_array_unref (data.sources);
+
   /* push out the RTCP packets */
   while ((output = g_queue_pop_head (&data.output))) {
     gboolean do_not_suppress;
@@ -3830,6 +4046,7 @@ rtp_session_request_key_unit (RTPSession * sess, guint32 ssrc,
   } else if (!src->send_fir) {
     src->send_pli = TRUE;
   }
+  session_watch_source (sess, src);
   RTP_SESSION_UNLOCK (sess);
 
   rtp_session_send_rtcp (sess, 200 * GST_MSECOND);
@@ -3868,6 +4085,7 @@ rtp_session_request_nack (RTPSession * sess, guint32 ssrc, guint16 seqnum,
 
   GST_DEBUG ("request NACK for %08x, #%u", ssrc, seqnum);
   rtp_source_register_nack (source, seqnum);
+  session_watch_source (sess, source);
   RTP_SESSION_UNLOCK (sess);
 
   rtp_session_send_rtcp (sess, max_delay);
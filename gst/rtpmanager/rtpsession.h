@@ -235,6 +235,12 @@ struct _RTPSession {
   GHashTable   *ssrcs[32];
   guint         total_sources;
 
+  /* sources that are looked at in every RTCP interval: senders, internal
+   * sources and sources with pending feedback */
+  GHashTable   *report_sources;
+  /* the other sources, sorted by the time they can time out */
+  GSequence    *timeout_sources;
+
   guint16       generation;
   GstClockTime  next_rtcp_check_time;
   GstClockTime  last_rtcp_send_time;
@@ -269,6 +275,7 @@ struct _RTPSession {
   gboolean     last_keyframe_all_headers;
 
   gboolean      is_doing_ptp;
+  gboolean      update_ptp;
 };
 
 /**
@@ -352,6 +359,10 @@ GstFlowReturn   rtp_session_process_rtp            (RTPSession *sess, GstBuffer
                                                     GstClockTime current_time,
 						    GstClockTime running_time,
                                                     guint64 ntpnstime);
+GstFlowReturn   rtp_session_process_rtp_list       (RTPSession *sess, GstBufferList *list,
+                                                    GstClockTime current_time,
+                                                    const GstClockTime *running_times,
+                                                    const guint64 *ntpnstimes);
 GstFlowReturn   rtp_session_process_rtcp           (RTPSession *sess, GstBuffer *buffer,
                                                     GstClockTime current_time,
                                                     guint64 ntpnstime);
@@ -250,6 +250,7 @@ rtp_source_init (RTPSource * src)
   src->probation = DEFAULT_PROBATION;
   src->curr_probation = src->probation;
   src->closing = FALSE;
+  src->timeout_time = GST_CLOCK_TIME_NONE;
 
   src->sdes = gst_structure_new_empty ("application/x-rtp-source-sdes");
 
@@ -146,6 +146,11 @@ struct _RTPSource {
   gboolean      is_sender;
   gboolean      closing;
 
+  /* when the source can time out and its position in the timeout sources of
+   * the session */
+  GstClockTime  timeout_time;
+  GSequenceIter *timeout_iter;
+
   GstStructure  *sdes;
 
   gboolean      marked_bye;
@@ -0,0 +1,402 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/*
+ * The timer service multiplexes the timers of many elements onto one thread
+ * per clock. Each user adds an entry and schedules it at the clock time it
+ * wants to be called. The service thread waits for the earliest entry with a
+ * single clock id and hands the entries that expired to a small pool of
+ * threads that call their functions, so that a function that blocks, for
+ * example while pushing an event, does not delay the entries of other
+ * users. The function of one entry is never called from two threads at the
+ * same time. Deadlines are rounded up to RTP_TIMER_SERVICE_GRANULARITY so
+ * that entries with deadlines close together are handled after the same
+ * wait.
+ */
+
+#include "rtptimerservice.h"
+
+GST_DEBUG_CATEGORY_STATIC (rtp_timer_service_debug);
+#define GST_CAT_DEFAULT rtp_timer_service_debug
+
+/* maximum number of threads that call the functions of the entries */
+#define MAX_DISPATCH_THREADS 4
+
+struct _RTPTimerServiceEntry
+{
+  GstClockTime time;
+  GSequenceIter *iter;
+  RTPTimerServiceFunc func;
+  gpointer user_data;
+
+  /* the entry was handed to the pool and its function is being called from
+   * dispatch_thread */
+  gboolean dispatching;
+  GThread *dispatch_thread;
+  /* the entry expired again while it was being dispatched */
+  gboolean redispatch;
+  GstClockTime dispatch_time;
+  /* removed from its own function, freed after the function returns */
+  gboolean removed;
+};
+
+struct _RTPTimerService
+{
+  gint refcount;
+  GstClock *clock;
+
+  GMutex lock;
+  GCond cond;
+  GThread *thread;
+  gboolean running;
+  GThreadPool *pool;
+
+  /* scheduled entries, sorted by time */
+  GSequence *entries;
+  /* the clock id we are waiting on */
+  GstClockID clock_id;
+  GstClockTime wait_time;
+};
+
+/* one service per clock */
+static GMutex services_lock;
+static GList *services;
+
+static gint
+compare_entries (gconstpointer a, gconstpointer b, gpointer user_data)
+{
+  const RTPTimerServiceEntry *ea = a, *eb = b;
+
+  if (ea->time < eb->time)
+    return -1;
+  if (ea->time > eb->time)
+    return 1;
+  return 0;
+}
+
+/* called from a thread of the pool */
+static void
+rtp_timer_service_dispatch (RTPTimerServiceEntry * entry,
+    RTPTimerService * service)
+{
+  g_mutex_lock (&service->lock);
+  entry->dispatch_thread = g_thread_self ();
+  do {
+    GstClockTime time = entry->dispatch_time;
+
+    entry->redispatch = FALSE;
+    g_mutex_unlock (&service->lock);
+
+    entry->func (entry, time, entry->user_data);
+
+    g_mutex_lock (&service->lock);
+  } while (entry->redispatch && !entry->removed);
+
+  entry->dispatching = FALSE;
+  entry->dispatch_thread = NULL;
+  /* wake up a remove waiting for us */
+  g_cond_broadcast (&service->cond);
+  g_mutex_unlock (&service->lock);
+
+  if (entry->removed)
+    g_slice_free (RTPTimerServiceEntry, entry);
+}
+
+static gpointer
+rtp_timer_service_thread (RTPTimerService * service)
+{
+  g_mutex_lock (&service->lock);
+  while (service->running) {
+    GSequenceIter *iter;
+    RTPTimerServiceEntry *entry;
+    GstClockTime now;
+
+    iter = g_sequence_get_begin_iter (service->entries);
+    if (g_sequence_iter_is_end (iter)) {
+      /* nothing scheduled, wait for activity */
+      g_cond_wait (&service->cond, &service->lock);
+      continue;
+    }
+    entry = g_sequence_get (iter);
+
+    if (service->clock) {
+      now = gst_clock_get_time (service->clock);
+
+      if (entry->time > now) {
+        GstClockID id;
+
+        GST_LOG ("waiting until %" GST_TIME_FORMAT,
+            GST_TIME_ARGS (entry->time));
+
+        id = service->clock_id =
+            gst_clock_new_single_shot_id (service->clock, entry->time);
+        service->wait_time = entry->time;
+        g_mutex_unlock (&service->lock);
+
+        gst_clock_id_wait (id, NULL);
+
+        g_mutex_lock (&service->lock);
+        service->clock_id = NULL;
+        gst_clock_id_unref (id);
+        /* check again, entries could have been changed while we waited */
+        continue;
+      }
+    } else {
+      now = GST_CLOCK_TIME_NONE;
+    }
+
+    /* hand all expired entries to the pool */
+    while (!g_sequence_iter_is_end (iter)) {
+      entry = g_sequence_get (iter);
+      if (service->clock && entry->time > now)
+        break;
+
+      g_sequence_remove (iter);
+      entry->iter = NULL;
+      entry->time = GST_CLOCK_TIME_NONE;
+      entry->dispatch_time = now;
+
+      if (entry->dispatching) {
+        /* the dispatching thread calls the function again */
+        entry->redispatch = TRUE;
+      } else {
+        entry->dispatching = TRUE;
+        g_thread_pool_push (service->pool, entry, NULL);
+      }
+
+      iter = g_sequence_get_begin_iter (service->entries);
+    }
+  }
+  g_mutex_unlock (&service->lock);
+
+  return NULL;
+}
+
+/**
+ * rtp_timer_service_get:
+ * @clock: a #GstClock or %NULL
+ *
+ * Get the timer service for @clock, the service is created and its thread
+ * started when it did not exist yet. Entries of a service without a clock
+ * are called as soon as they are scheduled. Users must get the service of
+ * their new clock when their clock changes.
+ *
+ * Returns: the #RTPTimerService for @clock. Use rtp_timer_service_unref()
+ * after usage.
+ */
+RTPTimerService *
+rtp_timer_service_get (GstClock * clock)
+{
+  RTPTimerService *service = NULL;
+  GList *walk;
+
+  g_mutex_lock (&services_lock);
+  for (walk = services; walk; walk = g_list_next (walk)) {
+    RTPTimerService *test = walk->data;
+
+    if (test->clock == clock) {
+      service = test;
+      service->refcount++;
+      break;
+    }
+  }
+
+  if (service == NULL) {
+    if (!rtp_timer_service_debug)
+      GST_DEBUG_CATEGORY_INIT (rtp_timer_service_debug, "rtptimerservice", 0,
+          "RTP timer service");
+
+    service = g_slice_new0 (RTPTimerService);
+    service->refcount = 1;
+    if (clock)
+      service->clock = gst_object_ref (clock);
+    g_mutex_init (&service->lock);
+    g_cond_init (&service->cond);
+    service->entries = g_sequence_new (NULL);
+    service->wait_time = GST_CLOCK_TIME_NONE;
+    service->running = TRUE;
+    service->pool = g_thread_pool_new ((GFunc) rtp_timer_service_dispatch,
+        service, MAX_DISPATCH_THREADS, FALSE, NULL);
+    service->thread = g_thread_new ("rtptimer",
+        (GThreadFunc) rtp_timer_service_thread, service);
+
+    GST_DEBUG ("new timer service %p for clock %" GST_PTR_FORMAT, service,
+        clock);
+
+    services = g_list_prepend (services, service);
+  }
+  g_mutex_unlock (&services_lock);
+
+  return service;
+}
+
+/**
+ * rtp_timer_service_unref:
+ * @service: an #RTPTimerService
+ *
+ * Release a reference to @service. When the last reference is released, the
+ * thread of @service is stopped. All entries must have been removed.
+ */
+void
+rtp_timer_service_unref (RTPTimerService * service)
+{
+  g_return_if_fail (service != NULL);
+
+  g_mutex_lock (&services_lock);
+  if (--service->refcount > 0) {
+    g_mutex_unlock (&services_lock);
+    return;
+  }
+  services = g_list_remove (services, service);
+  g_mutex_unlock (&services_lock);
+
+  GST_DEBUG ("stopping timer service %p", service);
+
+  g_mutex_lock (&service->lock);
+  service->running = FALSE;
+  if (service->clock_id)
+    gst_clock_id_unschedule (service->clock_id);
+  g_cond_broadcast (&service->cond);
+  g_mutex_unlock (&service->lock);
+
+  g_thread_join (service->thread);
+  /* all entries were removed, so nothing is being dispatched */
+  g_thread_pool_free (service->pool, FALSE, TRUE);
+
+  g_warn_if_fail (g_sequence_get_length (service->entries) == 0);
+  g_sequence_free (service->entries);
+  g_mutex_clear (&service->lock);
+  g_cond_clear (&service->cond);
+  if (service->clock)
+    gst_object_unref (service->clock);
+  g_slice_free (RTPTimerService, service);
+}
+
+/**
+ * rtp_timer_service_add:
+ * @service: an #RTPTimerService
+ * @func: function to call when the entry expires
+ * @user_data: user data passed to @func
+ *
+ * Add a new, unscheduled, entry to @service.
+ *
+ * Returns: a new #RTPTimerServiceEntry. Use rtp_timer_service_remove() to
+ * free it.
+ */
+RTPTimerServiceEntry *
+rtp_timer_service_add (RTPTimerService * service, RTPTimerServiceFunc func,
+    gpointer user_data)
+{
+  RTPTimerServiceEntry *entry;
+
+  g_return_val_if_fail (service != NULL, NULL);
+  g_return_val_if_fail (func != NULL, NULL);
+
+  entry = g_slice_new0 (RTPTimerServiceEntry);
+  entry->time = GST_CLOCK_TIME_NONE;
+  entry->func = func;
+  entry->user_data = user_data;
+
+  return entry;
+}
+
+/**
+ * rtp_timer_service_remove:
+ * @service: an #RTPTimerService
+ * @entry: an #RTPTimerServiceEntry of @service
+ *
+ * Unschedule and free @entry. When the function of @entry is being called,
+ * this function waits until it returned, so it must not be called with a lock
+ * held that the function takes. It can be called from the function of @entry
+ * itself, @entry is then freed after the function returned.
+ */
+void
+rtp_timer_service_remove (RTPTimerService * service,
+    RTPTimerServiceEntry * entry)
+{
+  g_return_if_fail (service != NULL);
+  g_return_if_fail (entry != NULL);
+
+  g_mutex_lock (&service->lock);
+  if (entry->iter) {
+    g_sequence_remove (entry->iter);
+    entry->iter = NULL;
+  }
+  if (entry->dispatching && entry->dispatch_thread == g_thread_self ()) {
+    /* called from the function of the entry */
+    entry->removed = TRUE;
+    g_mutex_unlock (&service->lock);
+    return;
+  }
+  /* an entry that is dispatching but not running yet runs once more, the
+   * function must check whether it is still in use */
+  while (entry->dispatching)
+    g_cond_wait (&service->cond, &service->lock);
+  g_mutex_unlock (&service->lock);
+
+  g_slice_free (RTPTimerServiceEntry, entry);
+}
+
+/**
+ * rtp_timer_service_schedule:
+ * @service: an #RTPTimerService
+ * @entry: an #RTPTimerServiceEntry of @service
+ * @time: the clock time
+ *
+ * Schedule @entry to be called when the clock of @service reaches @time. Any
+ * previously scheduled time of @entry is replaced. Use 0 to have @entry called
+ * as soon as possible and #GST_CLOCK_TIME_NONE to unschedule @entry.
+ */
+void
+rtp_timer_service_schedule (RTPTimerService * service,
+    RTPTimerServiceEntry * entry, GstClockTime time)
+{
+  g_return_if_fail (service != NULL);
+  g_return_if_fail (entry != NULL);
+
+  /* round up to the next deadline */
+  if (time != 0 && time != GST_CLOCK_TIME_NONE)
+    time = ((time + RTP_TIMER_SERVICE_GRANULARITY - 1) /
+        RTP_TIMER_SERVICE_GRANULARITY) * RTP_TIMER_SERVICE_GRANULARITY;
+
+  g_mutex_lock (&service->lock);
+  if (entry->time == time)
+    goto done;
+
+  if (entry->iter) {
+    g_sequence_remove (entry->iter);
+    entry->iter = NULL;
+  }
+  entry->time = time;
+
+  if (time != GST_CLOCK_TIME_NONE) {
+    entry->iter = g_sequence_insert_sorted (service->entries, entry,
+        compare_entries, NULL);
+
+    /* wake up the thread when it needs to wait less */
+    if (service->clock_id) {
+      if (time < service->wait_time)
+        gst_clock_id_unschedule (service->clock_id);
+    } else {
+      g_cond_broadcast (&service->cond);
+    }
+  }
+
+done:
+  g_mutex_unlock (&service->lock);
+}
@@ -0,0 +1,57 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __RTP_TIMER_SERVICE_H__
+#define __RTP_TIMER_SERVICE_H__
+
+#include <gst/gst.h>
+
+typedef struct _RTPTimerService RTPTimerService;
+typedef struct _RTPTimerServiceEntry RTPTimerServiceEntry;
+
+/**
+ * RTPTimerServiceFunc:
+ * @entry: the #RTPTimerServiceEntry that expired
+ * @time: the current time of the clock of the service or
+ *   #GST_CLOCK_TIME_NONE when the service has no clock
+ * @user_data: user data passed to rtp_timer_service_add()
+ *
+ * Called from the thread of the service when @entry expired. The entry is
+ * unscheduled before the function is called.
+ */
+typedef void (*RTPTimerServiceFunc) (RTPTimerServiceEntry *entry,
+                                     GstClockTime time, gpointer user_data);
+
+/* the granularity of the deadlines, entries that expire within the same
+ * period are handled with one clock wait */
+#define RTP_TIMER_SERVICE_GRANULARITY (GST_MSECOND / 2)
+
+RTPTimerService *       rtp_timer_service_get       (GstClock *clock);
+void                    rtp_timer_service_unref     (RTPTimerService *service);
+
+RTPTimerServiceEntry *  rtp_timer_service_add       (RTPTimerService *service,
+                                                     RTPTimerServiceFunc func,
+                                                     gpointer user_data);
+void                    rtp_timer_service_remove    (RTPTimerService *service,
+                                                     RTPTimerServiceEntry *entry);
+
+void                    rtp_timer_service_schedule  (RTPTimerService *service,
+                                                     RTPTimerServiceEntry *entry,
+                                                     GstClockTime time);
+
+#endif /* __RTP_TIMER_SERVICE_H__ */
@@ -0,0 +1,433 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/*
+ * The port pool keeps bound UDP socket pairs, an even RTP port and the next
+ * port for RTCP, ready for all rtspsrc elements of the process that use the
+ * same port range. Sockets are leased for a stream and returned to the pool
+ * when the stream is freed, so that restarting many streams does not make
+ * them race each other for free ports.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gstrtspportpool.h"
+
+GST_DEBUG_CATEGORY_STATIC (rtsp_port_pool_debug);
+#define GST_CAT_DEFAULT (rtsp_port_pool_debug)
+
+/* number of pairs we try to bind when no port range is configured */
+#define MAX_BIND_TRIES 100
+
+typedef struct
+{
+  GSocket *rtp;
+  GSocket *rtcp;
+} GstRTSPPortPair;
+
+struct _GstRTSPPortPool
+{
+  gint refcount;
+
+  GSocketFamily family;
+  gint min;
+  gint max;
+  /* number of idle pairs we keep bound */
+  guint size;
+
+  GMutex lock;
+  /* idle GstRTSPPortPair */
+  GQueue idle;
+  /* next port to try in the range */
+  gint next_port;
+};
+
+static GMutex pools_lock;
+static GList *pools;
+
+static GSocket *
+bind_socket (GSocketFamily family, gint port)
+{
+  GSocket *socket;
+  GInetAddress *any;
+  GSocketAddress *addr;
+  GError *err = NULL;
+  gboolean res;
+
+  socket = g_socket_new (family, G_SOCKET_TYPE_DATAGRAM,
+      G_SOCKET_PROTOCOL_UDP, &err);
+  if (socket == NULL)
+    goto no_socket;
+
+  any = g_inet_address_new_any (family);
+  addr = g_inet_socket_address_new (any, port);
+  g_object_unref (any);
+
+  res = g_socket_bind (socket, addr, FALSE, &err);
+  g_object_unref (addr);
+  if (!res)
+    goto bind_failed;
+
+  return socket;
+
+  /* ERRORS */
+no_socket:
+  {
+    GST_WARNING ("could not create socket: %s", err->message);
+    g_clear_error (&err);
+    return NULL;
+  }
+bind_failed:
+  {
+    GST_DEBUG ("could not bind port %d: %s", port, err->message);
+    g_clear_error (&err);
+    g_object_unref (socket);
+    return NULL;
+  }
+}
+
+static gint
+get_port (GSocket * socket)
+{
+  GSocketAddress *addr;
+  gint port;
+
+  addr = g_socket_get_local_address (socket, NULL);
+  if (addr == NULL)
+    return -1;
+
+  port = g_inet_socket_address_get_port (G_INET_SOCKET_ADDRESS (addr));
+  g_object_unref (addr);
+
+  return port;
+}
+
+/* drop the packets that were queued on @socket */
+static void
+drain_socket (GSocket * socket)
+{
+  gchar buffer[1500];
+
+  while (g_socket_receive_with_blocking (socket, buffer, sizeof (buffer),
+          FALSE, NULL, NULL) >= 0);
+}
+
+/* bind a new pair, call with the pool lock */
+static gboolean
+gst_rtsp_port_pool_bind_pair (GstRTSPPortPool * pool, GstRTSPPortPair * pair)
+{
+  guint count, tries;
+  GSocket *rtp, *rtcp;
+
+  if (pool->min > 0)
+    tries = (pool->max - pool->min + 1) / 2;
+  else
+    tries = MAX_BIND_TRIES;
+
+  for (count = 0; count < tries; count++) {
+    gint port;
+
+    if (pool->min > 0) {
+      /* next even port in the range */
+      if (pool->next_port + 1 > pool->max)
+        pool->next_port = pool->min;
+      port = pool->next_port;
+      pool->next_port += 2;
+    } else {
+      /* let the kernel pick */
+      port = 0;
+    }
+
+    if (!(rtp = bind_socket (pool->family, port)))
+      continue;
+
+    /* the RTP port must be even */
+    port = get_port (rtp);
+    if (port < 0 || (port & 1) != 0 || port == G_MAXUINT16) {
+      g_object_unref (rtp);
+      continue;
+    }
+
+    if (!(rtcp = bind_socket (pool->family, port + 1))) {
+      g_object_unref (rtp);
+      continue;
+    }
+
+    GST_DEBUG ("bound ports %d-%d", port, port + 1);
+
+    pair->rtp = rtp;
+    pair->rtcp = rtcp;
+    return TRUE;
+  }
+
+  GST_WARNING ("could not bind a port pair after %u tries", tries);
+
+  return FALSE;
+}
+
+/* bind pairs until we have @size idle ones, call with the pool lock */
+static void
+gst_rtsp_port_pool_fill (GstRTSPPortPool * pool)
+{
+  while (g_queue_get_length (&pool->idle) < pool->size) {
+    GstRTSPPortPair *pair = g_slice_new (GstRTSPPortPair);
+
+    if (!gst_rtsp_port_pool_bind_pair (pool, pair)) {
+      g_slice_free (GstRTSPPortPair, pair);
+      break;
+    }
+    g_queue_push_tail (&pool->idle, pair);
+  }
+}
+
+static void
+free_pair (GstRTSPPortPair * pair)
+{
+  g_object_unref (pair->rtp);
+  g_object_unref (pair->rtcp);
+  g_slice_free (GstRTSPPortPair, pair);
+}
+
+/**
+ * gst_rtsp_port_pool_get:
+ * @family: the socket family
+ * @min: the minimum port or 0 to let the kernel select ports
+ * @max: the maximum port or 0 when there is no maximum
+ * @size: the number of port pairs to keep bound
+ *
+ * Get the pool of @family for the port range @min to @max. The pool is created
+ * when it did not exist yet. The pool keeps the largest @size any of its users
+ * asked for and binds that many pairs in advance.
+ *
+ * Returns: a #GstRTSPPortPool. Use gst_rtsp_port_pool_unref() after usage.
+ */
+GstRTSPPortPool *
+gst_rtsp_port_pool_get (GSocketFamily family, gint min, gint max, guint size)
+{
+  GstRTSPPortPool *pool = NULL;
+  GList *walk;
+
+  /* the RTP port is even */
+  if (min > 0) {
+    min = GST_ROUND_UP_2 (min);
+    if (max <= 0)
+      max = G_MAXUINT16;
+  } else {
+    min = max = 0;
+  }
+
+  size = MAX (size, 1);
+
+  g_mutex_lock (&pools_lock);
+  for (walk = pools; walk; walk = g_list_next (walk)) {
+    GstRTSPPortPool *test = walk->data;
+
+    if (gst_rtsp_port_pool_matches (test, family, min, max)) {
+      pool = test;
+      pool->refcount++;
+      break;
+    }
+  }
+
+  if (pool == NULL) {
+    if (!rtsp_port_pool_debug)
+      GST_DEBUG_CATEGORY_INIT (rtsp_port_pool_debug, "rtspportpool", 0,
+          "RTSP port pool");
+
+    pool = g_slice_new0 (GstRTSPPortPool);
+    pool->refcount = 1;
+    pool->family = family;
+    pool->min = min;
+    pool->max = max;
+    pool->next_port = min;
+    g_mutex_init (&pool->lock);
+    g_queue_init (&pool->idle);
+
+    GST_DEBUG ("new pool %p for ports %d-%d", pool, min, max);
+
+    pools = g_list_prepend (pools, pool);
+  }
+  g_mutex_unlock (&pools_lock);
+
+  g_mutex_lock (&pool->lock);
+  if (size > pool->size) {
+    GST_DEBUG ("pool %p now keeps %u pairs", pool, size);
+    pool->size = size;
+    gst_rtsp_port_pool_fill (pool);
+  }
+  g_mutex_unlock (&pool->lock);
+
+  return pool;
+}
+
+/**
+ * gst_rtsp_port_pool_ref:
+ * @pool: a #GstRTSPPortPool
+ *
+ * Increase the refcount of @pool.
+ *
+ * Returns: @pool
+ */
+GstRTSPPortPool *
+gst_rtsp_port_pool_ref (GstRTSPPortPool * pool)
+{
+  g_return_val_if_fail (pool != NULL, NULL);
+
+  g_mutex_lock (&pools_lock);
+  pool->refcount++;
+  g_mutex_unlock (&pools_lock);
+
+  return pool;
+}
+
+/**
+ * gst_rtsp_port_pool_unref:
+ * @pool: a #GstRTSPPortPool
+ *
+ * Release a reference to @pool. The idle sockets are closed when the last
+ * reference is released.
+ */
+void
+gst_rtsp_port_pool_unref (GstRTSPPortPool * pool)
+{
+  g_return_if_fail (pool != NULL);
+
+  g_mutex_lock (&pools_lock);
+  if (--pool->refcount > 0) {
+    g_mutex_unlock (&pools_lock);
+    return;
+  }
+  pools = g_list_remove (pools, pool);
+  g_mutex_unlock (&pools_lock);
+
+  GST_DEBUG ("free pool %p", pool);
+
+  g_queue_foreach (&pool->idle, (GFunc) free_pair, NULL);
+  g_queue_clear (&pool->idle);
+  g_mutex_clear (&pool->lock);
+  g_slice_free (GstRTSPPortPool, pool);
+}
+
+/**
+ * gst_rtsp_port_pool_matches:
+ * @pool: a #GstRTSPPortPool
+ * @family: the socket family
+ * @min: the minimum port
+ * @max: the maximum port
+ *
+ * Check if @pool is the pool gst_rtsp_port_pool_get() returns for @family,
+ * @min and @max.
+ *
+ * Returns: %TRUE when @pool hands out ports of @family in the range.
+ */
+gboolean
+gst_rtsp_port_pool_matches (GstRTSPPortPool * pool, GSocketFamily family,
+    gint min, gint max)
+{
+  g_return_val_if_fail (pool != NULL, FALSE);
+
+  if (min > 0) {
+    min = GST_ROUND_UP_2 (min);
+    if (max <= 0)
+      max = G_MAXUINT16;
+  } else {
+    min = max = 0;
+  }
+
+  return pool->family == family && pool->min == min && pool->max == max;
+}
+
+/**
+ * gst_rtsp_port_pool_lease:
+ * @pool: a #GstRTSPPortPool
+ * @rtp: (out): the socket of the even RTP port
+ * @rtcp: (out): the socket of the RTCP port
+ *
+ * Take a bound pair of sockets from @pool. When the pool has no idle pairs,
+ * new pairs are bound.
+ *
+ * Returns: %TRUE when a pair was leased. Return the sockets with
+ * gst_rtsp_port_pool_release() after usage.
+ */
+gboolean
+gst_rtsp_port_pool_lease (GstRTSPPortPool * pool, GSocket ** rtp,
+    GSocket ** rtcp)
+{
+  GstRTSPPortPair *pair;
+
+  g_return_val_if_fail (pool != NULL, FALSE);
+  g_return_val_if_fail (rtp != NULL, FALSE);
+  g_return_val_if_fail (rtcp != NULL, FALSE);
+
+  g_mutex_lock (&pool->lock);
+  /* bind new pairs when all were leased */
+  if (g_queue_is_empty (&pool->idle))
+    gst_rtsp_port_pool_fill (pool);
+  pair = g_queue_pop_head (&pool->idle);
+  g_mutex_unlock (&pool->lock);
+
+  if (pair == NULL)
+    return FALSE;
+
+  /* a returned pair could still have received packets for its old stream */
+  drain_socket (pair->rtp);
+  drain_socket (pair->rtcp);
+
+  *rtp = pair->rtp;
+  *rtcp = pair->rtcp;
+  g_slice_free (GstRTSPPortPair, pair);
+
+  return TRUE;
+}
+
+/**
+ * gst_rtsp_port_pool_release:
+ * @pool: a #GstRTSPPortPool
+ * @rtp: (transfer full): the RTP socket
+ * @rtcp: (transfer full): the RTCP socket
+ *
+ * Return a pair leased with gst_rtsp_port_pool_lease() to @pool. The sockets
+ * are closed when the pool has enough idle pairs.
+ */
+void
+gst_rtsp_port_pool_release (GstRTSPPortPool * pool, GSocket * rtp,
+    GSocket * rtcp)
+{
+  GstRTSPPortPair *pair;
+
+  g_return_if_fail (pool != NULL);
+  g_return_if_fail (G_IS_SOCKET (rtp));
+  g_return_if_fail (G_IS_SOCKET (rtcp));
+
+  pair = g_slice_new (GstRTSPPortPair);
+  pair->rtp = rtp;
+  pair->rtcp = rtcp;
+
+  g_mutex_lock (&pool->lock);
+  if (g_queue_get_length (&pool->idle) < pool->size) {
+    GST_DEBUG ("pool %p: port %d returned", pool, get_port (rtp));
+    g_queue_push_tail (&pool->idle, pair);
+    pair = NULL;
+  }
+  g_mutex_unlock (&pool->lock);
+
+  if (pair)
+    free_pair (pair);
+}
@@ -0,0 +1,45 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_RTSP_PORT_POOL_H__
+#define __GST_RTSP_PORT_POOL_H__
+
+#include <gst/gst.h>
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+typedef struct _GstRTSPPortPool GstRTSPPortPool;
+
+GstRTSPPortPool *  gst_rtsp_port_pool_get      (GSocketFamily family, gint min,
+                                                gint max, guint size);
+GstRTSPPortPool *  gst_rtsp_port_pool_ref      (GstRTSPPortPool *pool);
+void               gst_rtsp_port_pool_unref    (GstRTSPPortPool *pool);
+
+gboolean           gst_rtsp_port_pool_matches  (GstRTSPPortPool *pool,
+                                                GSocketFamily family,
+                                                gint min, gint max);
+
+gboolean           gst_rtsp_port_pool_lease    (GstRTSPPortPool *pool,
+                                                GSocket **rtp, GSocket **rtcp);
+void               gst_rtsp_port_pool_release  (GstRTSPPortPool *pool,
+                                                GSocket *rtp, GSocket *rtcp);
+
+G_END_DECLS
+
+#endif /* __GST_RTSP_PORT_POOL_H__ */
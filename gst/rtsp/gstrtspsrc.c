@@ -192,6 +192,8 @@ gst_rtsp_src_buffer_mode_get_type (void)
 #define DEFAULT_USE_PIPELINE_CLOCK       FALSE
 #define DEFAULT_TLS_VALIDATION_FLAGS     G_TLS_CERTIFICATE_VALIDATE_ALL
 #define DEFAULT_TLS_DATABASE     NULL
+#define DEFAULT_FAST_START       FALSE
+#define DEFAULT_PORT_POOL_SIZE   0
 
 enum
 {
@@ -226,6 +228,8 @@ enum
   PROP_SDES,
   PROP_TLS_VALIDATION_FLAGS,
   PROP_TLS_DATABASE,
+  PROP_FAST_START,
+  PROP_PORT_POOL_SIZE,
   PROP_LAST
 };
 
@@ -297,6 +301,7 @@ static gboolean gst_rtspsrc_stream_push_event (GstRTSPSrc * src,
     GstRTSPStream * stream, GstEvent * event);
 static gboolean gst_rtspsrc_push_event (GstRTSPSrc * src, GstEvent * event);
 static void gst_rtspsrc_connection_flush (GstRTSPSrc * src, gboolean flush);
+static void gst_rtspsrc_read_reset (GstRTSPSrc * src);
 
 typedef struct
 {
@@ -316,6 +321,17 @@ typedef struct
 /* mask for all commands */
 #define CMD_ALL         ((CMD_LOOP << 1) - 1)
 
+/* max amount of data queued for a channel in interleaved mode, the receive
+ * loop waits when the queue is full */
+#define CHANNEL_QUEUE_MAX_BYTES (4 * 1024 * 1024)
+/* how long the receive loop waits for space before checking the keep-alive */
+#define CHANNEL_QUEUE_WAIT      (100 * G_TIME_SPAN_MILLISECOND)
+
+/* size of the buffer we read interleaved data in and of the largest frame:
+ * '$', channel, 16 bits length and the data */
+#define READ_CHUNK_SIZE         (128 * 1024)
+#define MAX_INTERLEAVED_FRAME   (4 + G_MAXUINT16)
+
 #define GST_ELEMENT_PROGRESS(el, type, code, text)      \
 G_STMT_START {                                          \
   gchar *__txt = _gst_element_error_printf text;        \
@@ -608,6 +624,39 @@ gst_rtspsrc_class_init (GstRTSPSrcClass * klass)
           "TLS database with anchor certificate authorities used to validate the server certificate",
           G_TYPE_TLS_DATABASE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstRTSPSrc::fast-start:
+   *
+   * Reduce the number of round-trips needed to start streaming. The OPTIONS
+   * request is not sent and, when the server aggregates the streams in one
+   * session, the SETUP requests of all but the first stream are sent without
+   * waiting for the previous response. The duration of each startup phase is
+   * posted in a "GstRTSPSrcTiming" element message after the PLAY response.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (gobject_class, PROP_FAST_START,
+      g_param_spec_boolean ("fast-start", "Fast start",
+          "Skip OPTIONS and pipeline SETUP requests to reduce startup time",
+          DEFAULT_FAST_START, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstRTSPSrc::port-pool-size:
+   *
+   * Lease the UDP ports of the streams from a pool that is shared by all
+   * rtspsrc elements of the process with the same #GstRTSPSrc:port-range. The
+   * pool keeps this many RTP/RTCP port pairs bound in advance and takes back
+   * the ports of freed streams. 0 disables the pool and binds new ports for
+   * each stream.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (gobject_class, PROP_PORT_POOL_SIZE,
+      g_param_spec_uint ("port-pool-size", "Port pool size",
+          "Number of pre-bound UDP port pairs in the shared port pool "
+          "(0 = don't use the pool)", 0, G_MAXUINT16, DEFAULT_PORT_POOL_SIZE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   /**
    * GstRTSPSrc::handle-request:
    * @rtspsrc: a #GstRTSPSrc
@@ -736,6 +785,8 @@ gst_rtspsrc_init (GstRTSPSrc * src)
   src->sdes = NULL;
   src->tls_validation_flags = DEFAULT_TLS_VALIDATION_FLAGS;
   src->tls_database = DEFAULT_TLS_DATABASE;
+  src->fast_start = DEFAULT_FAST_START;
+  src->port_pool_size = DEFAULT_PORT_POOL_SIZE;
 
   /* get a list of all extensions */
   src->extensions = gst_rtsp_ext_list_get ();
@@ -751,6 +802,9 @@ gst_rtspsrc_init (GstRTSPSrc * src)
   /* protects our state changes from multiple invocations */
   g_rec_mutex_init (&src->state_rec_lock);
 
+  /* interrupts reading interleaved data */
+  src->read_cancellable = g_cancellable_new ();
+
   src->state = GST_RTSP_STATE_INVALID;
 
   GST_OBJECT_FLAG_SET (src, GST_ELEMENT_FLAG_SOURCE);
@@ -784,6 +838,15 @@ gst_rtspsrc_finalize (GObject * object)
   if (rtspsrc->tls_database)
     g_object_unref (rtspsrc->tls_database);
 
+  if (rtspsrc->timing)
+    gst_structure_free (rtspsrc->timing);
+
+  if (rtspsrc->port_pool)
+    gst_rtsp_port_pool_unref (rtspsrc->port_pool);
+
+  gst_rtspsrc_read_reset (rtspsrc);
+  g_object_unref (rtspsrc->read_cancellable);
+
   /* free locks */
   g_rec_mutex_clear (&rtspsrc->stream_rec_lock);
   g_rec_mutex_clear (&rtspsrc->state_rec_lock);
@@ -1000,6 +1063,12 @@ gst_rtspsrc_set_property (GObject * object, guint prop_id, const GValue * value,
       g_clear_object (&rtspsrc->tls_database);
       rtspsrc->tls_database = g_value_dup_object (value);
       break;
+    case PROP_FAST_START:
+      rtspsrc->fast_start = g_value_get_boolean (value);
+      break;
+    case PROP_PORT_POOL_SIZE:
+      rtspsrc->port_pool_size = g_value_get_uint (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -1131,6 +1200,12 @@ gst_rtspsrc_get_property (GObject * object, guint prop_id, GValue * value,
     case PROP_TLS_DATABASE:
       g_value_set_object (value, rtspsrc->tls_database);
       break;
+    case PROP_FAST_START:
+      g_value_set_boolean (value, rtspsrc->fast_start);
+      break;
+    case PROP_PORT_POOL_SIZE:
+      g_value_set_uint (value, rtspsrc->port_pool_size);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -1496,6 +1571,227 @@ gst_rtspsrc_create_stream (GstRTSPSrc * src, GstSDPMessage * sdp, gint idx)
   /* ERRORS */
 }
 
+/* In interleaved mode the data of each channel is pushed downstream from its
+ * own thread, so that a slow downstream does not block the receive loop that
+ * also sends the keep-alive requests and receives the other channels. */
+struct _GstRTSPChannelQueue
+{
+  GstRTSPSrc *src;
+  GstPad *pad;
+
+  GThread *thread;
+  GMutex lock;
+  GCond cond;
+  gboolean running;
+  /* between flush-start and flush-stop */
+  gboolean flushing;
+  /* incremented on each flush-start, data taken before is dropped */
+  guint flush_seqnum;
+  /* the connection is flushing, interrupts the receive loop */
+  gboolean interrupted;
+
+  /* buffers and serialized events */
+  GQueue items;
+  gsize bytes;
+  GstFlowReturn last_ret;
+};
+
+/* call with the queue lock */
+static void
+gst_rtspsrc_channel_queue_clear (GstRTSPChannelQueue * queue)
+{
+  GstMiniObject *item;
+
+  while ((item = g_queue_pop_head (&queue->items)))
+    gst_mini_object_unref (item);
+  queue->bytes = 0;
+}
+
+static gpointer
+gst_rtspsrc_channel_queue_thread (GstRTSPChannelQueue * queue)
+{
+  GstRTSPSrc *src = queue->src;
+
+  g_mutex_lock (&queue->lock);
+  while (queue->running) {
+    GstMiniObject *item;
+    GstBufferList *list = NULL;
+    GstFlowReturn ret = GST_FLOW_OK;
+    guint seqnum;
+
+    if (queue->flushing || g_queue_is_empty (&queue->items)) {
+      g_cond_wait (&queue->cond, &queue->lock);
+      continue;
+    }
+
+    item = g_queue_pop_head (&queue->items);
+    if (GST_IS_BUFFER (item)) {
+      GstMiniObject *next;
+
+      queue->bytes -= gst_buffer_get_size (GST_BUFFER_CAST (item));
+
+      /* take all buffers up to the next event */
+      while ((next = g_queue_peek_head (&queue->items)) && GST_IS_BUFFER (next)) {
+        if (list == NULL) {
+          list = gst_buffer_list_new ();
+          gst_buffer_list_add (list, GST_BUFFER_CAST (item));
+          item = GST_MINI_OBJECT_CAST (list);
+        }
+        g_queue_pop_head (&queue->items);
+        queue->bytes -= gst_buffer_get_size (GST_BUFFER_CAST (next));
+        gst_buffer_list_add (list, GST_BUFFER_CAST (next));
+      }
+    }
+    seqnum = queue->flush_seqnum;
+    /* wake up the receive loop when it waits for space */
+    g_cond_broadcast (&queue->cond);
+    g_mutex_unlock (&queue->lock);
+
+    GST_PAD_STREAM_LOCK (queue->pad);
+    g_mutex_lock (&queue->lock);
+    if (seqnum != queue->flush_seqnum) {
+      g_mutex_unlock (&queue->lock);
+      GST_PAD_STREAM_UNLOCK (queue->pad);
+      GST_DEBUG_OBJECT (src, "flushed, dropping data");
+      gst_mini_object_unref (item);
+      g_mutex_lock (&queue->lock);
+      continue;
+    }
+    g_mutex_unlock (&queue->lock);
+
+    if (GST_IS_EVENT (item)) {
+      gst_pad_push_event (queue->pad, GST_EVENT_CAST (item));
+    } else if (list) {
+      GST_LOG_OBJECT (src, "pushing list of %u buffers",
+          gst_buffer_list_length (list));
+      ret = gst_pad_push_list (queue->pad, list);
+    } else {
+      ret = gst_pad_push (queue->pad, GST_BUFFER_CAST (item));
+    }
+    GST_PAD_STREAM_UNLOCK (queue->pad);
+
+    g_mutex_lock (&queue->lock);
+    if (seqnum == queue->flush_seqnum)
+      queue->last_ret = ret;
+  }
+  g_mutex_unlock (&queue->lock);
+
+  return NULL;
+}
+
+static GstRTSPChannelQueue *
+gst_rtspsrc_channel_queue_new (GstRTSPSrc * src, GstPad * pad)
+{
+  GstRTSPChannelQueue *queue;
+
+  queue = g_slice_new0 (GstRTSPChannelQueue);
+  queue->src = src;
+  queue->pad = gst_object_ref (pad);
+  g_mutex_init (&queue->lock);
+  g_cond_init (&queue->cond);
+  g_queue_init (&queue->items);
+  queue->last_ret = GST_FLOW_OK;
+  queue->running = TRUE;
+  queue->thread = g_thread_new ("rtspsrc-push",
+      (GThreadFunc) gst_rtspsrc_channel_queue_thread, queue);
+
+  return queue;
+}
+
+static void
+gst_rtspsrc_channel_queue_free (GstRTSPChannelQueue * queue)
+{
+  g_mutex_lock (&queue->lock);
+  queue->running = FALSE;
+  queue->flush_seqnum++;
+  g_cond_broadcast (&queue->cond);
+  g_mutex_unlock (&queue->lock);
+
+  g_thread_join (queue->thread);
+
+  gst_rtspsrc_channel_queue_clear (queue);
+  g_mutex_clear (&queue->lock);
+  g_cond_clear (&queue->cond);
+  gst_object_unref (queue->pad);
+  g_slice_free (GstRTSPChannelQueue, queue);
+}
+
+/* interrupt the receive loop when it is waiting for space in @queue */
+static void
+gst_rtspsrc_channel_queue_interrupt (GstRTSPChannelQueue * queue,
+    gboolean flush)
+{
+  g_mutex_lock (&queue->lock);
+  queue->interrupted = flush;
+  g_cond_broadcast (&queue->cond);
+  g_mutex_unlock (&queue->lock);
+}
+
+/* serialized events are queued behind the data, flushing events are pushed
+ * right away and flush the queue */
+static gboolean
+gst_rtspsrc_channel_queue_push_event (GstRTSPChannelQueue * queue,
+    GstEvent * event)
+{
+  gboolean res = TRUE;
+
+  switch (GST_EVENT_TYPE (event)) {
+    case GST_EVENT_FLUSH_START:
+      g_mutex_lock (&queue->lock);
+      queue->flushing = TRUE;
+      queue->flush_seqnum++;
+      gst_rtspsrc_channel_queue_clear (queue);
+      g_cond_broadcast (&queue->cond);
+      g_mutex_unlock (&queue->lock);
+      /* this unblocks the thread when it is pushing */
+      res = gst_pad_push_event (queue->pad, event);
+      break;
+    case GST_EVENT_FLUSH_STOP:
+      /* wait for the thread to finish pushing */
+      GST_PAD_STREAM_LOCK (queue->pad);
+      res = gst_pad_push_event (queue->pad, event);
+      g_mutex_lock (&queue->lock);
+      queue->flushing = FALSE;
+      queue->last_ret = GST_FLOW_OK;
+      g_mutex_unlock (&queue->lock);
+      GST_PAD_STREAM_UNLOCK (queue->pad);
+      break;
+    default:
+      if (!GST_EVENT_IS_SERIALIZED (event)) {
+        res = gst_pad_push_event (queue->pad, event);
+        break;
+      }
+      g_mutex_lock (&queue->lock);
+      if (queue->flushing) {
+        gst_event_unref (event);
+        res = FALSE;
+      } else {
+        g_queue_push_tail (&queue->items, event);
+        g_cond_broadcast (&queue->cond);
+      }
+      g_mutex_unlock (&queue->lock);
+      break;
+  }
+  return res;
+}
+
+/* give the sockets of the udp sources back to the port pool, the udp sources
+ * must not be using them anymore */
+static void
+gst_rtspsrc_stream_release_sockets (GstRTSPStream * stream)
+{
+  if (stream->port_pool == NULL)
+    return;
+
+  GST_DEBUG ("release sockets of stream %p", stream);
+
+  gst_rtsp_port_pool_release (stream->port_pool, stream->udpsocket[0],
+      stream->udpsocket[1]);
+  stream->udpsocket[0] = stream->udpsocket[1] = NULL;
+  gst_rtsp_port_pool_unref (stream->port_pool);
+  stream->port_pool = NULL;
+}
+
 static void
 gst_rtspsrc_stream_free (GstRTSPSrc * src, GstRTSPStream * stream)
 {
@@ -1515,6 +1811,8 @@ gst_rtspsrc_stream_free (GstRTSPSrc * src, GstRTSPStream * stream)
       gst_bin_remove (GST_BIN_CAST (src), stream->udpsrc[i]);
       gst_object_unref (stream->udpsrc[i]);
     }
+    if (stream->channelqueue[i])
+      gst_rtspsrc_channel_queue_free (stream->channelqueue[i]);
     if (stream->channelpad[i])
       gst_object_unref (stream->channelpad[i]);
 
@@ -1524,6 +1822,7 @@ gst_rtspsrc_stream_free (GstRTSPSrc * src, GstRTSPStream * stream)
       gst_object_unref (stream->udpsink[i]);
     }
   }
+  gst_rtspsrc_stream_release_sockets (stream);
   if (stream->fakesrc) {
     gst_element_set_state (stream->fakesrc, GST_STATE_NULL);
     gst_bin_remove (GST_BIN_CAST (src), stream->fakesrc);
@@ -2013,6 +2312,110 @@ no_rate:
   }
 }
 
+static GstElement *
+gst_rtspsrc_make_pooled_udpsrc (GstRTSPSrc * src, const gchar * host,
+    GSocket * socket)
+{
+  GstElement *udpsrc;
+
+  udpsrc = gst_element_make_from_uri (GST_URI_SRC, host, NULL, NULL);
+  if (udpsrc == NULL)
+    return NULL;
+
+  /* the socket goes back to the pool, udpsrc must not close it */
+  g_object_set (G_OBJECT (udpsrc), "socket", socket, "close-socket", FALSE,
+      NULL);
+  if (src->udp_buffer_size != 0)
+    g_object_set (G_OBJECT (udpsrc), "buffer-size", src->udp_buffer_size,
+        NULL);
+
+  if (gst_element_set_state (udpsrc, GST_STATE_READY) ==
+      GST_STATE_CHANGE_FAILURE) {
+    gst_element_set_state (udpsrc, GST_STATE_NULL);
+    gst_object_unref (udpsrc);
+    return NULL;
+  }
+  return udpsrc;
+}
+
+/* make the udp sources with a port pair leased from the shared port pool */
+static gboolean
+gst_rtspsrc_alloc_pooled_udp_ports (GstRTSPStream * stream,
+    gint * rtpport, gint * rtcpport)
+{
+  GstRTSPSrc *src;
+  GSocketFamily family;
+  GSocket *rtp, *rtcp;
+  GstElement *udpsrc0 = NULL, *udpsrc1 = NULL;
+  const gchar *host;
+
+  src = stream->parent;
+
+  if (stream->is_ipv6) {
+    family = G_SOCKET_FAMILY_IPV6;
+    host = "udp://[::0]";
+  } else {
+    family = G_SOCKET_FAMILY_IPV4;
+    host = "udp://0.0.0.0";
+  }
+
+  /* we keep our pool until we are finalized so that its sockets stay bound
+   * when all our streams are freed */
+  if (src->port_pool && !gst_rtsp_port_pool_matches (src->port_pool, family,
+          src->client_port_range.min, src->client_port_range.max)) {
+    gst_rtsp_port_pool_unref (src->port_pool);
+    src->port_pool = NULL;
+  }
+  if (src->port_pool == NULL)
+    src->port_pool = gst_rtsp_port_pool_get (family,
+        src->client_port_range.min, src->client_port_range.max,
+        src->port_pool_size);
+
+  if (!gst_rtsp_port_pool_lease (src->port_pool, &rtp, &rtcp))
+    goto no_ports;
+
+  udpsrc0 = gst_rtspsrc_make_pooled_udpsrc (src, host, rtp);
+  if (udpsrc0 == NULL)
+    goto no_udp_protocol;
+  udpsrc1 = gst_rtspsrc_make_pooled_udpsrc (src, host, rtcp);
+  if (udpsrc1 == NULL)
+    goto no_udp_protocol;
+
+  g_object_get (G_OBJECT (udpsrc0), "port", rtpport, NULL);
+  g_object_get (G_OBJECT (udpsrc1), "port", rtcpport, NULL);
+  GST_DEBUG_OBJECT (src, "leased ports %d-%d", *rtpport, *rtcpport);
+
+  stream->port_pool = gst_rtsp_port_pool_ref (src->port_pool);
+  stream->udpsocket[0] = rtp;
+  stream->udpsocket[1] = rtcp;
+
+  /* we keep these elements, we configure all in configure_transport when the
+   * server told us to really use the UDP ports. */
+  stream->udpsrc[0] = gst_object_ref_sink (udpsrc0);
+  stream->udpsrc[1] = gst_object_ref_sink (udpsrc1);
+  gst_element_set_locked_state (stream->udpsrc[0], TRUE);
+  gst_element_set_locked_state (stream->udpsrc[1], TRUE);
+
+  return TRUE;
+
+  /* ERRORS */
+no_ports:
+  {
+    GST_DEBUG_OBJECT (src, "could not lease UDP port pair");
+    return FALSE;
+  }
+no_udp_protocol:
+  {
+    GST_DEBUG_OBJECT (src, "could not get UDP source");
+    if (udpsrc0) {
+      gst_element_set_state (udpsrc0, GST_STATE_NULL);
+      gst_object_unref (udpsrc0);
+    }
+    gst_rtsp_port_pool_release (src->port_pool, rtp, rtcp);
+    return FALSE;
+  }
+}
+
 static gboolean
 gst_rtspsrc_alloc_udp_ports (GstRTSPStream * stream,
     gint * rtpport, gint * rtcpport)
@@ -2026,6 +2429,9 @@ gst_rtspsrc_alloc_udp_ports (GstRTSPStream * stream,
 
   src = stream->parent;
 
+  if (src->port_pool_size > 0)
+    return gst_rtspsrc_alloc_pooled_udp_ports (stream, rtpport, rtcpport);
+
   udpsrc0 = NULL;
   udpsrc1 = NULL;
   count = 0;
@@ -3216,6 +3622,7 @@ gst_rtspsrc_stream_free_udp (GstRTSPStream * stream)
       stream->udpsrc[i] = NULL;
     }
   }
+  gst_rtspsrc_stream_release_sockets (stream);
 }
 
 /* for TCP, create pads to send and receive data to and from the manager and to
@@ -3228,6 +3635,7 @@ gst_rtspsrc_stream_configure_tcp (GstRTSPSrc * src, GstRTSPStream * stream,
   gchar *name;
   GstPadTemplate *template;
   GstPad *pad0, *pad1;
+  gint i;
 
   /* configure for interleaved delivery, nothing needs to be done
    * here, the loop function will call the chain functions of the
@@ -3284,6 +3692,21 @@ gst_rtspsrc_stream_configure_tcp (GstRTSPSrc * src, GstRTSPStream * stream,
     }
     gst_object_unref (template);
   }
+
+  /* push the data of the channels into the manager from their own threads.
+   * Without a manager the pad is exposed and its caps are set from the
+   * receive loop, so we keep pushing from there. */
+  for (i = 0; src->manager && i < 2; i++) {
+    if (stream->channelqueue[i] &&
+        stream->channelqueue[i]->pad != stream->channelpad[i]) {
+      gst_rtspsrc_channel_queue_free (stream->channelqueue[i]);
+      stream->channelqueue[i] = NULL;
+    }
+    if (stream->channelqueue[i] == NULL && stream->channelpad[i] &&
+        GST_PAD_IS_SRC (stream->channelpad[i]))
+      stream->channelqueue[i] =
+          gst_rtspsrc_channel_queue_new (src, stream->channelpad[i]);
+  }
   /* setup RTCP transport back to the server if we have to. */
   if (src->manager && src->do_rtcp) {
     GstPad *pad;
@@ -3998,6 +4421,9 @@ gst_rtspsrc_stream_push_event (GstRTSPSrc * src, GstRTSPStream * stream,
   if (stream->udpsrc[0]) {
     gst_event_ref (event);
     res = gst_element_send_event (stream->udpsrc[0], event);
+  } else if (stream->channelqueue[0]) {
+    gst_event_ref (event);
+    res = gst_rtspsrc_channel_queue_push_event (stream->channelqueue[0], event);
   } else if (stream->channelpad[0]) {
     gst_event_ref (event);
     if (GST_PAD_IS_SRC (stream->channelpad[0]))
@@ -4009,6 +4435,10 @@ gst_rtspsrc_stream_push_event (GstRTSPSrc * src, GstRTSPStream * stream,
   if (stream->udpsrc[1]) {
     gst_event_ref (event);
     res &= gst_element_send_event (stream->udpsrc[1], event);
+  } else if (stream->channelqueue[1]) {
+    gst_event_ref (event);
+    res &= gst_rtspsrc_channel_queue_push_event (stream->channelqueue[1],
+        event);
   } else if (stream->channelpad[1]) {
     gst_event_ref (event);
     if (GST_PAD_IS_SRC (stream->channelpad[1]))
@@ -4053,6 +4483,10 @@ gst_rtsp_conninfo_connect (GstRTSPSrc * src, GstRTSPConnInfo * info,
         goto parse_error;
     }
 
+    /* a new connection starts without pending interleaved data */
+    if (info == &src->conninfo)
+      gst_rtspsrc_read_reset (src);
+
     /* create connection */
     GST_DEBUG_OBJECT (src, "creating connection (%s)...", info->location);
     if ((res = gst_rtsp_connection_create (info->url, &info->connection)) < 0)
@@ -4167,6 +4601,10 @@ gst_rtspsrc_connection_flush (GstRTSPSrc * src, gboolean flush)
     gst_rtsp_connection_flush (src->conninfo.connection, flush);
     src->conninfo.flushing = flush;
   }
+  if (flush)
+    g_cancellable_cancel (src->read_cancellable);
+  else
+    g_cancellable_reset (src->read_cancellable);
   for (walk = src->streams; walk; walk = g_list_next (walk)) {
     GstRTSPStream *stream = (GstRTSPStream *) walk->data;
     if (stream->conninfo.connection && stream->conninfo.flushing != flush) {
@@ -4174,6 +4612,10 @@ gst_rtspsrc_connection_flush (GstRTSPSrc * src, gboolean flush)
       gst_rtsp_connection_flush (stream->conninfo.connection, flush);
       stream->conninfo.flushing = flush;
     }
+    if (stream->channelqueue[0])
+      gst_rtspsrc_channel_queue_interrupt (stream->channelqueue[0], flush);
+    if (stream->channelqueue[1])
+      gst_rtspsrc_channel_queue_interrupt (stream->channelqueue[1], flush);
   }
   GST_RTSP_STATE_UNLOCK (src);
 }
@@ -4290,44 +4732,91 @@ send_error:
   }
 }
 
+/* queue @buf for pushing from the thread of @queue. When the queue is full
+ * we wait for space and keep the session alive in the meantime. */
 static GstFlowReturn
-gst_rtspsrc_handle_data (GstRTSPSrc * src, GstRTSPMessage * message)
+gst_rtspsrc_channel_queue_push (GstRTSPSrc * src, GstRTSPChannelQueue * queue,
+    GstBuffer * buf)
+{
+  GstFlowReturn ret;
+  gsize size;
+
+  size = gst_buffer_get_size (buf);
+
+  g_mutex_lock (&queue->lock);
+  while (queue->bytes > 0 && queue->bytes + size > CHANNEL_QUEUE_MAX_BYTES &&
+      !queue->flushing && !queue->interrupted) {
+    GTimeVal tv_timeout;
+    gint64 end_time;
+
+    end_time = g_get_monotonic_time () + CHANNEL_QUEUE_WAIT;
+    if (g_cond_wait_until (&queue->cond, &queue->lock, end_time))
+      continue;
+
+    g_mutex_unlock (&queue->lock);
+    gst_rtsp_connection_next_timeout (src->conninfo.connection, &tv_timeout);
+    if ((tv_timeout.tv_sec | tv_timeout.tv_usec) == 0) {
+      GST_DEBUG_OBJECT (src, "queue full, sending keep-alive");
+      gst_rtspsrc_send_keep_alive (src);
+    }
+    g_mutex_lock (&queue->lock);
+  }
+
+  if (queue->flushing || queue->interrupted) {
+    ret = GST_FLOW_FLUSHING;
+    gst_buffer_unref (buf);
+  } else {
+    g_queue_push_tail (&queue->items, buf);
+    queue->bytes += size;
+    g_cond_broadcast (&queue->cond);
+    ret = queue->last_ret;
+  }
+  g_mutex_unlock (&queue->lock);
+
+  return ret;
+}
+
+/* push @buf received on @channel, takes ownership of @buf */
+static GstFlowReturn
+gst_rtspsrc_handle_channel_data (GstRTSPSrc * src, gint channel,
+    GstBuffer * buf)
 {
   GstFlowReturn ret = GST_FLOW_OK;
-  gint channel;
   GstRTSPStream *stream;
   GstPad *outpad = NULL;
-  guint8 *data;
-  guint size;
-  GstBuffer *buf;
+  GstRTSPChannelQueue *queue = NULL;
+  gsize size;
+  guint8 pt;
   gboolean is_rtcp;
   GstEvent *event;
 
-  channel = message->type_data.data.channel;
-
   stream = find_stream (src, &channel, (gpointer) find_stream_by_channel);
   if (!stream)
     goto unknown_stream;
 
   if (channel == stream->channel[0]) {
     outpad = stream->channelpad[0];
+    queue = stream->channelqueue[0];
     is_rtcp = FALSE;
   } else if (channel == stream->channel[1]) {
     outpad = stream->channelpad[1];
+    queue = stream->channelqueue[1];
     is_rtcp = TRUE;
   } else {
     is_rtcp = FALSE;
   }
 
-  /* take a look at the body to figure out what we have */
-  gst_rtsp_message_get_body (message, &data, &size);
-  if (size < 2)
+  /* take a look at the data to figure out what we have */
+  size = gst_buffer_get_size (buf);
+  if (size < 1)
     goto invalid_length;
 
   /* channels are not correct on some servers, do extra check */
-  if (data[1] >= 200 && data[1] <= 204) {
+  if (size >= 2 && gst_buffer_extract (buf, 1, &pt, 1) == 1 &&
+      pt >= 200 && pt <= 204) {
     /* hmm RTCP message switch to the RTCP pad of the same stream. */
     outpad = stream->channelpad[1];
+    queue = stream->channelqueue[1];
     is_rtcp = TRUE;
   }
 
@@ -4335,21 +4824,8 @@ gst_rtspsrc_handle_data (GstRTSPSrc * src, GstRTSPMessage * message)
   if (outpad == NULL)
     goto unknown_stream;
 
-  /* take the message body for further processing */
-  gst_rtsp_message_steal_body (message, &data, &size);
-
-  /* strip the trailing \0 */
-  size -= 1;
-
-  buf = gst_buffer_new ();
-  gst_buffer_append_memory (buf,
-      gst_memory_new_wrapped (0, data, size, 0, size, data, g_free));
-
-  /* don't need message anymore */
-  gst_rtsp_message_unset (message);
-
-  GST_DEBUG_OBJECT (src, "pushing data of size %d on channel %d", size,
-      channel);
+  GST_DEBUG_OBJECT (src, "pushing data of size %" G_GSIZE_FORMAT
+      " on channel %d", size, channel);
 
   if (src->need_activate) {
     gchar *stream_id;
@@ -4422,7 +4898,9 @@ gst_rtspsrc_handle_data (GstRTSPSrc * src, GstRTSPMessage * message)
   }
 
   /* chain to the peer pad */
-  if (GST_PAD_IS_SINK (outpad))
+  if (queue)
+    ret = gst_rtspsrc_channel_queue_push (src, queue, buf);
+  else if (GST_PAD_IS_SINK (outpad))
     ret = gst_pad_chain (outpad, buf);
   else
     ret = gst_pad_push (outpad, buf);
@@ -4437,18 +4915,219 @@ gst_rtspsrc_handle_data (GstRTSPSrc * src, GstRTSPMessage * message)
 unknown_stream:
   {
     GST_DEBUG_OBJECT (src, "unknown stream on channel %d, ignored", channel);
-    gst_rtsp_message_unset (message);
+    gst_buffer_unref (buf);
     return GST_FLOW_OK;
   }
 invalid_length:
   {
     GST_ELEMENT_WARNING (src, RESOURCE, READ, (NULL),
         ("Short message received, ignoring."));
-    gst_rtsp_message_unset (message);
+    gst_buffer_unref (buf);
     return GST_FLOW_OK;
   }
 }
 
+static GstFlowReturn
+gst_rtspsrc_handle_data (GstRTSPSrc * src, GstRTSPMessage * message)
+{
+  gint channel;
+  guint8 *data;
+  guint size;
+  GstBuffer *buf;
+
+  channel = message->type_data.data.channel;
+
+  /* take the message body for further processing */
+  gst_rtsp_message_steal_body (message, &data, &size);
+
+  /* don't need message anymore */
+  gst_rtsp_message_unset (message);
+
+  buf = gst_buffer_new ();
+  if (size > 1) {
+    /* strip the trailing \0 */
+    size -= 1;
+    gst_buffer_append_memory (buf,
+        gst_memory_new_wrapped (0, data, size, 0, size, data, g_free));
+  } else {
+    g_free (data);
+  }
+
+  return gst_rtspsrc_handle_channel_data (src, channel, buf);
+}
+
+/* release the buffer for reading interleaved data */
+static void
+gst_rtspsrc_read_reset (GstRTSPSrc * src)
+{
+  if (src->read_buf) {
+    gst_buffer_unmap (src->read_buf, &src->read_map);
+    gst_buffer_unref (src->read_buf);
+    src->read_buf = NULL;
+  }
+  src->read_offset = 0;
+  src->read_size = 0;
+  src->read_message = FALSE;
+}
+
+/* make sure a complete frame fits after the start of the pending data */
+static void
+gst_rtspsrc_read_ensure_space (GstRTSPSrc * src)
+{
+  GstBuffer *buf;
+  GstMapInfo map;
+  gsize pending;
+
+  if (src->read_buf &&
+      src->read_map.size - src->read_offset >= MAX_INTERLEAVED_FRAME)
+    return;
+
+  pending = src->read_size - src->read_offset;
+
+  /* when nothing refers to the data anymore we can start over */
+  if (src->read_buf && pending == 0 &&
+      GST_MINI_OBJECT_REFCOUNT_VALUE (gst_buffer_peek_memory (src->read_buf,
+              0)) == 1) {
+    src->read_offset = 0;
+    src->read_size = 0;
+    return;
+  }
+
+  buf = gst_buffer_new_allocate (NULL, READ_CHUNK_SIZE, NULL);
+  gst_buffer_map (buf, &map, GST_MAP_WRITE);
+  if (pending > 0)
+    memcpy (map.data, src->read_map.data + src->read_offset, pending);
+
+  /* the frames we pushed keep the old memory alive */
+  if (src->read_buf) {
+    gst_buffer_unmap (src->read_buf, &src->read_map);
+    gst_buffer_unref (src->read_buf);
+  }
+  src->read_buf = buf;
+  src->read_map = map;
+  src->read_offset = 0;
+  src->read_size = pending;
+}
+
+/* Read all interleaved frames that are available on the socket into our
+ * buffer and push them as sub-buffers of it, without parsing them into a
+ * message. Only frames are taken from the socket, when something else is next
+ * *is_data is set to FALSE and the message needs to be read with the
+ * connection. */
+static GstRTSPResult
+gst_rtspsrc_receive_interleaved (GstRTSPSrc * src, GTimeVal * timeout,
+    gboolean * is_data, GstFlowReturn * ret)
+{
+  GSocket *socket;
+  GInputVector vec;
+  GError *err = NULL;
+  gint flags;
+  gssize n;
+  guint8 *data;
+  gsize pos, end, complete;
+
+  *is_data = TRUE;
+  *ret = GST_FLOW_OK;
+
+  socket = gst_rtsp_connection_get_read_socket (src->conninfo.connection);
+  gst_rtspsrc_read_ensure_space (src);
+  data = src->read_map.data;
+
+  if (!g_socket_condition_timed_wait (socket, G_IO_IN,
+          timeout ? timeout->tv_sec * G_USEC_PER_SEC + timeout->tv_usec : -1,
+          src->read_cancellable, &err))
+    goto read_error;
+
+  /* look at the data without taking it from the socket */
+  vec.buffer = data + src->read_size;
+  vec.size = src->read_map.size - src->read_size;
+  flags = G_SOCKET_MSG_PEEK;
+  n = g_socket_receive_message (socket, NULL, &vec, 1, NULL, NULL, &flags,
+      src->read_cancellable, &err);
+  if (n < 0)
+    goto read_error;
+  if (n == 0)
+    return GST_RTSP_EEOF;
+
+  /* find the frames, the pending data is always the start of a frame */
+  end = src->read_size + n;
+  pos = complete = src->read_offset;
+  while (pos < end && data[pos] == '$') {
+    gsize len = 4;
+
+    if (end - pos >= 4)
+      len += GST_READ_UINT16_BE (data + pos + 2);
+    if (end - pos < len) {
+      /* take what we have of the last frame and wait for the rest */
+      pos = end;
+      break;
+    }
+    pos += len;
+    complete = pos;
+  }
+
+  if (pos == src->read_size) {
+    GST_DEBUG_OBJECT (src, "no interleaved data");
+    *is_data = FALSE;
+    return GST_RTSP_OK;
+  }
+
+  /* now take the frames from the socket */
+  while (src->read_size < pos) {
+    n = g_socket_receive (socket, (gchar *) data + src->read_size,
+        pos - src->read_size, src->read_cancellable, &err);
+    if (n < 0)
+      goto read_error;
+    if (n == 0)
+      return GST_RTSP_EEOF;
+    src->read_size += n;
+  }
+
+  while (src->read_offset < complete) {
+    gint channel = data[src->read_offset + 1];
+    gsize len = GST_READ_UINT16_BE (data + src->read_offset + 2);
+    GstBuffer *buf;
+
+    buf = gst_buffer_copy_region (src->read_buf, GST_BUFFER_COPY_MEMORY,
+        src->read_offset + 4, len);
+    src->read_offset += 4 + len;
+
+    if (*ret == GST_FLOW_OK)
+      *ret = gst_rtspsrc_handle_channel_data (src, channel, buf);
+    else
+      gst_buffer_unref (buf);
+  }
+  return GST_RTSP_OK;
+
+  /* ERRORS */
+read_error:
+  {
+    GstRTSPResult res;
+
+    if (g_error_matches (err, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+      res = GST_RTSP_EINTR;
+    else if (g_error_matches (err, G_IO_ERROR, G_IO_ERROR_TIMED_OUT))
+      res = GST_RTSP_ETIMEOUT;
+    else if (g_error_matches (err, G_IO_ERROR, G_IO_ERROR_WOULD_BLOCK))
+      res = GST_RTSP_OK;
+    else {
+      GST_WARNING_OBJECT (src, "read error: %s", err->message);
+      res = GST_RTSP_ESYS;
+    }
+    g_clear_error (&err);
+    return res;
+  }
+}
+
+/* we read the socket of the connection directly, which is not possible when
+ * the data is encrypted or tunneled over HTTP */
+static gboolean
+gst_rtspsrc_can_read_interleaved (GstRTSPSrc * src)
+{
+  return !gst_rtsp_connection_is_tunneled (src->conninfo.connection) &&
+      !(src->conninfo.url->transports & GST_RTSP_LOWER_TRANS_TLS);
+}
+
 static GstFlowReturn
 gst_rtspsrc_loop_interleaved (GstRTSPSrc * src)
 {
@@ -4456,6 +5135,10 @@ gst_rtspsrc_loop_interleaved (GstRTSPSrc * src)
   GstRTSPResult res;
   GstFlowReturn ret = GST_FLOW_OK;
   GTimeVal tv_timeout;
+  gboolean is_data;
+  gboolean can_read;
+
+  can_read = gst_rtspsrc_can_read_interleaved (src);
 
   while (TRUE) {
     /* get the next timeout interval */
@@ -4475,11 +5158,28 @@ gst_rtspsrc_loop_interleaved (GstRTSPSrc * src)
     GST_DEBUG_OBJECT (src, "doing receive with timeout %ld seconds, %ld usec",
         tv_timeout.tv_sec, tv_timeout.tv_usec);
 
-    /* protect the connection with the connection lock so that we can see when
-     * we are finished doing server communication */
-    res =
-        gst_rtspsrc_connection_receive (src, src->conninfo.connection,
-        &message, src->ptcp_timeout);
+    /* read the interleaved frames ourselves, unless the connection is in the
+     * middle of a message */
+    is_data = FALSE;
+    if (can_read && !src->read_message) {
+      res = gst_rtspsrc_receive_interleaved (src, src->ptcp_timeout, &is_data,
+          &ret);
+      if (res == GST_RTSP_OK && is_data) {
+        if (ret != GST_FLOW_OK)
+          goto handle_data_failed;
+        continue;
+      }
+    }
+
+    if (!is_data) {
+      /* protect the connection with the connection lock so that we can see
+       * when we are finished doing server communication */
+      res =
+          gst_rtspsrc_connection_receive (src, src->conninfo.connection,
+          &message, src->ptcp_timeout);
+      /* the connection keeps a partially received message */
+      src->read_message = (res == GST_RTSP_ETIMEOUT || res == GST_RTSP_EINTR);
+    }
 
     switch (res) {
       case GST_RTSP_OK:
@@ -5282,16 +5982,11 @@ no_user_pass:
 }
 
 static GstRTSPResult
-gst_rtspsrc_try_send (GstRTSPSrc * src, GstRTSPConnection * conn,
-    GstRTSPMessage * request, GstRTSPMessage * response,
-    GstRTSPStatusCode * code)
+gst_rtspsrc_send_request (GstRTSPSrc * src, GstRTSPConnection * conn,
+    GstRTSPMessage * request)
 {
   GstRTSPResult res;
-  GstRTSPStatusCode thecode;
-  gchar *content_base = NULL;
-  gint try = 0;
 
-again:
   if (!src->short_header)
     gst_rtsp_ext_list_before_send (src->extensions, request);
 
@@ -5306,6 +6001,43 @@ again:
 
   gst_rtsp_connection_reset_timeout (conn);
 
+  return GST_RTSP_OK;
+
+  /* ERRORS */
+send_error:
+  {
+    gchar *str = gst_rtsp_strresult (res);
+
+    if (res != GST_RTSP_EINTR) {
+      GST_ELEMENT_ERROR (src, RESOURCE, WRITE, (NULL),
+          ("Could not send message. (%s)", str));
+    } else {
+      GST_WARNING_OBJECT (src, "send interrupted");
+    }
+    g_free (str);
+    return res;
+  }
+}
+
+/* when @sent is TRUE, @request was already sent with
+ * gst_rtspsrc_send_request() and only its response is read */
+static GstRTSPResult
+gst_rtspsrc_try_send (GstRTSPSrc * src, GstRTSPConnection * conn,
+    GstRTSPMessage * request, gboolean sent, GstRTSPMessage * response,
+    GstRTSPStatusCode * code)
+{
+  GstRTSPResult res;
+  GstRTSPStatusCode thecode;
+  gchar *content_base = NULL;
+  gint try = 0;
+
+  if (sent)
+    goto next;
+
+again:
+  if ((res = gst_rtspsrc_send_request (src, conn, request)) < 0)
+    return res;
+
 next:
   res = gst_rtspsrc_connection_receive (src, conn, response, src->ptcp_timeout);
   if (res < 0)
@@ -5361,25 +6093,13 @@ next:
   return GST_RTSP_OK;
 
   /* ERRORS */
-send_error:
-  {
-    gchar *str = gst_rtsp_strresult (res);
-
-    if (res != GST_RTSP_EINTR) {
-      GST_ELEMENT_ERROR (src, RESOURCE, WRITE, (NULL),
-          ("Could not send message. (%s)", str));
-    } else {
-      GST_WARNING_OBJECT (src, "send interrupted");
-    }
-    g_free (str);
-    return res;
-  }
 receive_error:
   {
     switch (res) {
       case GST_RTSP_EEOF:
         GST_WARNING_OBJECT (src, "server closed connection");
-        if ((try == 0) && !src->interleaved && src->udp_reconnect) {
+        /* a pipelined request can't be sent again on its own */
+        if (!sent && (try == 0) && !src->interleaved && src->udp_reconnect) {
           try++;
           /* if reconnect succeeds, try again */
           if ((res =
@@ -5466,7 +6186,8 @@ gst_rtspsrc_send (GstRTSPSrc * src, GstRTSPConnection * conn,
     method = request->type_data.request.method;
 
     if ((res =
-            gst_rtspsrc_try_send (src, conn, request, response, &int_code)) < 0)
+            gst_rtspsrc_try_send (src, conn, request, FALSE, response,
+                &int_code)) < 0)
       goto error;
 
     switch (int_code) {
@@ -5894,6 +6615,215 @@ gst_rtspsrc_stream_make_keymgmt (GstRTSPSrc * src, GstRTSPStream * stream)
 }
 
 
+/* a SETUP request that was sent without waiting for the response of the
+ * previous one */
+typedef struct
+{
+  GList *walk;
+  GstRTSPMessage request;
+} GstRTSPPendingSetup;
+
+static void
+gst_rtspsrc_pending_setup_free (GArray * pending)
+{
+  guint i;
+
+  if (pending == NULL)
+    return;
+
+  for (i = 0; i < pending->len; i++) {
+    GstRTSPPendingSetup *setup;
+
+    setup = &g_array_index (pending, GstRTSPPendingSetup, i);
+    gst_rtsp_message_unset (&setup->request);
+  }
+  g_array_free (pending, TRUE);
+}
+
+/* skip all streams after @walk with the same control url */
+static void
+gst_rtspsrc_skip_same_control (GstRTSPSrc * src, GList * walk)
+{
+  GstRTSPStream *stream = (GstRTSPStream *) walk->data;
+  GList *skip = walk;
+
+  while (TRUE) {
+    GstRTSPStream *sskip;
+
+    skip = g_list_next (skip);
+    if (skip == NULL)
+      break;
+
+    sskip = (GstRTSPStream *) skip->data;
+
+    if (g_str_equal (stream->conninfo.location, sskip->conninfo.location)) {
+      GST_DEBUG_OBJECT (src, "found stream %p with same control %s",
+          sskip, sskip->conninfo.location);
+      sskip->skipped = TRUE;
+    }
+  }
+}
+
+/* configure the stream in @walk with the transport of the SETUP @response.
+ * Returns FALSE when the server did not select a transport. */
+static gboolean
+gst_rtspsrc_stream_setup_response (GstRTSPSrc * src, GList * walk,
+    GstRTSPMessage * response, GstRTSPLowerTrans * protocols, gint retry,
+    gint * rtpport, gint * rtcpport)
+{
+  GstRTSPStream *stream = (GstRTSPStream *) walk->data;
+  gchar *resptrans = NULL;
+  GstRTSPTransport transport = { 0 };
+
+  gst_rtsp_message_get_header (response, GST_RTSP_HDR_TRANSPORT, &resptrans,
+      0);
+  if (!resptrans) {
+    gst_rtspsrc_stream_free_udp (stream);
+    return FALSE;
+  }
+
+  /* parse transport, go to next stream on parse error */
+  if (gst_rtsp_transport_parse (resptrans, &transport) != GST_RTSP_OK) {
+    GST_WARNING_OBJECT (src, "failed to parse transport %s", resptrans);
+    goto done;
+  }
+
+  /* update allowed transports for other streams. once the transport of
+   * one stream has been determined, we make sure that all other streams
+   * are configured in the same way */
+  switch (transport.lower_transport) {
+    case GST_RTSP_LOWER_TRANS_TCP:
+      GST_DEBUG_OBJECT (src, "stream %p as TCP interleaved", stream);
+      *protocols = GST_RTSP_LOWER_TRANS_TCP;
+      src->interleaved = TRUE;
+      /* update free channels */
+      src->free_channel = MAX (transport.interleaved.min, src->free_channel);
+      src->free_channel = MAX (transport.interleaved.max, src->free_channel);
+      src->free_channel++;
+      break;
+    case GST_RTSP_LOWER_TRANS_UDP_MCAST:
+      /* only allow multicast for other streams */
+      GST_DEBUG_OBJECT (src, "stream %p as UDP multicast", stream);
+      *protocols = GST_RTSP_LOWER_TRANS_UDP_MCAST;
+      /* if the server selected our ports, increment our counters so that
+       * we select a new port later */
+      if (src->next_port_num == transport.port.min &&
+          src->next_port_num + 1 == transport.port.max) {
+        src->next_port_num += 2;
+      }
+      break;
+    case GST_RTSP_LOWER_TRANS_UDP:
+      /* only allow unicast for other streams */
+      GST_DEBUG_OBJECT (src, "stream %p as UDP unicast", stream);
+      *protocols = GST_RTSP_LOWER_TRANS_UDP;
+      break;
+    default:
+      GST_DEBUG_OBJECT (src, "stream %p unknown transport %d", stream,
+          transport.lower_transport);
+      break;
+  }
+
+  if (!stream->container || (!src->interleaved && !retry)) {
+    /* now configure the stream with the selected transport */
+    if (!gst_rtspsrc_stream_configure_transport (stream, &transport)) {
+      GST_DEBUG_OBJECT (src,
+          "could not configure stream %p transport, skipping stream", stream);
+      goto done;
+    } else if (stream->udpsrc[0] && stream->udpsrc[1]) {
+      /* retain the first allocated UDP port pair */
+      g_object_get (G_OBJECT (stream->udpsrc[0]), "port", rtpport, NULL);
+      g_object_get (G_OBJECT (stream->udpsrc[1]), "port", rtcpport, NULL);
+    }
+  }
+  /* we need to activate at least one streams when we detect activity */
+  src->need_activate = TRUE;
+
+  /* stream is setup now */
+  stream->setup = TRUE;
+  gst_rtspsrc_skip_same_control (src, walk);
+
+done:
+  /* clean up our transport struct */
+  gst_rtsp_transport_init (&transport);
+
+  return TRUE;
+}
+
+/* read the responses of the SETUP requests in @pending in the order they were
+ * sent. All requests are released, also when an error occurs. */
+static GstRTSPResult
+gst_rtspsrc_setup_pipelined (GstRTSPSrc * src, GstRTSPConnection * conn,
+    GArray * pending, GstRTSPLowerTrans * protocols,
+    gboolean * unsupported_real)
+{
+  GstRTSPResult res = GST_RTSP_OK;
+  GstRTSPMessage response = { 0 };
+  GstRTSPStatusCode code = GST_RTSP_STS_OK;
+  gint rtpport = 0, rtcpport = 0;
+  guint i;
+
+  for (i = 0; i < pending->len; i++) {
+    GstRTSPPendingSetup *setup;
+    GstRTSPStream *stream;
+
+    setup = &g_array_index (pending, GstRTSPPendingSetup, i);
+    stream = (GstRTSPStream *) setup->walk->data;
+
+    if (res < 0) {
+      /* an earlier response failed, the others don't matter anymore */
+      gst_rtspsrc_stream_free_udp (stream);
+      goto next;
+    }
+
+    GST_DEBUG_OBJECT (src, "receive setup response of stream %p", stream);
+
+    res = gst_rtspsrc_try_send (src, conn, &setup->request, TRUE, &response,
+        &code);
+    if (res < 0) {
+      /* error was posted */
+      gst_rtspsrc_stream_free_udp (stream);
+      goto next;
+    }
+
+    switch (code) {
+      case GST_RTSP_STS_OK:
+        if (!gst_rtspsrc_stream_setup_response (src, setup->walk, &response,
+                protocols, 0, &rtpport, &rtcpport)) {
+          GST_ELEMENT_ERROR (src, RESOURCE, SETTINGS, (NULL),
+              ("Server did not select transport."));
+          res = GST_RTSP_ERROR;
+        }
+        break;
+      case GST_RTSP_STS_UNSUPPORTED_TRANSPORT:
+        /* the transport was fixed by the first stream, there is nothing else
+         * we can try for this stream */
+        GST_DEBUG_OBJECT (src, "skipping stream %p, unsupported transport",
+            stream);
+        gst_rtspsrc_stream_free_udp (stream);
+        if (!*unsupported_real)
+          *unsupported_real = stream->is_real;
+        break;
+      default:
+      {
+        const gchar *str = gst_rtsp_status_as_text (code);
+
+        gst_rtspsrc_stream_free_udp (stream);
+        GST_ELEMENT_ERROR (src, RESOURCE, WRITE, (NULL),
+            ("Error (%d): %s", code, GST_STR_NULL (str)));
+        res = GST_RTSP_ERROR;
+        break;
+      }
+    }
+
+  next:
+    gst_rtsp_message_unset (&setup->request);
+    gst_rtsp_message_unset (&response);
+  }
+  g_array_set_size (pending, 0);
+
+  return res;
+}
+
 /* Perform the SETUP request for all the streams.
  *
  * We ask the server for a specific transport, which initially includes all the
@@ -5920,6 +6850,8 @@ gst_rtspsrc_setup_streams (GstRTSPSrc * src, gboolean async)
   gint rtpport, rtcpport;
   GstRTSPUrl *url;
   gchar *hval;
+  gboolean aggregate = FALSE;
+  GArray *pending = NULL;
 
   if (src->conninfo.connection) {
     url = gst_rtsp_connection_get_url (src->conninfo.connection);
@@ -5950,7 +6882,7 @@ gst_rtspsrc_setup_streams (GstRTSPSrc * src, gboolean async)
     gchar *transports;
     gint retry = 0;
     guint mask = 0;
-    gboolean selected;
+    gboolean selected, pipelined;
     GstCaps *caps;
 
     stream = (GstRTSPStream *) walk->data;
@@ -6022,6 +6954,19 @@ gst_rtspsrc_setup_streams (GstRTSPSrc * src, gboolean async)
     if (stream->is_multicast)
       protocols &= GST_RTSP_LOWER_TRANS_UDP_MCAST;
 
+    /* once the first stream selected a unicast transport in an aggregated
+     * session, the other streams will use the same transport and we can send
+     * their requests without waiting for the responses */
+    pipelined = aggregate && !stream->container &&
+        (protocols == GST_RTSP_LOWER_TRANS_UDP ||
+        protocols == GST_RTSP_LOWER_TRANS_TCP);
+
+    if (!pipelined && pending && pending->len > 0) {
+      if ((res = gst_rtspsrc_setup_pipelined (src, conn, pending, &protocols,
+                  &unsupported_real)) < 0)
+        goto cleanup_error;
+    }
+
   next_protocol:
     /* first selectable protocol */
     while (protocol_masks[mask] && !(protocols & protocol_masks[mask]))
@@ -6089,6 +7034,32 @@ gst_rtspsrc_setup_streams (GstRTSPSrc * src, gboolean async)
       GST_ELEMENT_PROGRESS (src, CONTINUE, "request", ("SETUP stream %d",
               stream->id));
 
+    if (pipelined) {
+      GstRTSPPendingSetup *setup;
+
+      GST_DEBUG_OBJECT (src, "pipelining setup of stream %p", stream);
+
+      if ((res = gst_rtspsrc_send_request (src, conn, &request)) < 0) {
+        /* error was posted */
+        gst_rtspsrc_stream_free_udp (stream);
+        goto cleanup_error;
+      }
+
+      if (pending == NULL)
+        pending = g_array_new (FALSE, TRUE, sizeof (GstRTSPPendingSetup));
+      g_array_set_size (pending, pending->len + 1);
+      setup = &g_array_index (pending, GstRTSPPendingSetup, pending->len - 1);
+      setup->walk = walk;
+      setup->request = request;
+      memset (&request, 0, sizeof (request));
+
+      /* the next stream can't use the same channels */
+      if (protocols == GST_RTSP_LOWER_TRANS_TCP)
+        src->free_channel += 2;
+      gst_rtspsrc_skip_same_control (src, walk);
+      continue;
+    }
+
     /* handle the code ourselves */
     if ((res = gst_rtspsrc_send (src, conn, &request, &response, &code) < 0))
       goto send_error;
@@ -6130,106 +7101,30 @@ gst_rtspsrc_setup_streams (GstRTSPSrc * src, gboolean async)
     }
 
     /* parse response transport */
-    {
-      gchar *resptrans = NULL;
-      GstRTSPTransport transport = { 0 };
-
-      gst_rtsp_message_get_header (&response, GST_RTSP_HDR_TRANSPORT,
-          &resptrans, 0);
-      if (!resptrans) {
-        gst_rtspsrc_stream_free_udp (stream);
-        goto no_transport;
-      }
-
-      /* parse transport, go to next stream on parse error */
-      if (gst_rtsp_transport_parse (resptrans, &transport) != GST_RTSP_OK) {
-        GST_WARNING_OBJECT (src, "failed to parse transport %s", resptrans);
-        goto next;
-      }
-
-      /* update allowed transports for other streams. once the transport of
-       * one stream has been determined, we make sure that all other streams
-       * are configured in the same way */
-      switch (transport.lower_transport) {
-        case GST_RTSP_LOWER_TRANS_TCP:
-          GST_DEBUG_OBJECT (src, "stream %p as TCP interleaved", stream);
-          protocols = GST_RTSP_LOWER_TRANS_TCP;
-          src->interleaved = TRUE;
-          /* update free channels */
-          src->free_channel =
-              MAX (transport.interleaved.min, src->free_channel);
-          src->free_channel =
-              MAX (transport.interleaved.max, src->free_channel);
-          src->free_channel++;
-          break;
-        case GST_RTSP_LOWER_TRANS_UDP_MCAST:
-          /* only allow multicast for other streams */
-          GST_DEBUG_OBJECT (src, "stream %p as UDP multicast", stream);
-          protocols = GST_RTSP_LOWER_TRANS_UDP_MCAST;
-          /* if the server selected our ports, increment our counters so that
-           * we select a new port later */
-          if (src->next_port_num == transport.port.min &&
-              src->next_port_num + 1 == transport.port.max) {
-            src->next_port_num += 2;
-          }
-          break;
-        case GST_RTSP_LOWER_TRANS_UDP:
-          /* only allow unicast for other streams */
-          GST_DEBUG_OBJECT (src, "stream %p as UDP unicast", stream);
-          protocols = GST_RTSP_LOWER_TRANS_UDP;
-          break;
-        default:
-          GST_DEBUG_OBJECT (src, "stream %p unknown transport %d", stream,
-              transport.lower_transport);
-          break;
-      }
-
-      if (!stream->container || (!src->interleaved && !retry)) {
-        /* now configure the stream with the selected transport */
-        if (!gst_rtspsrc_stream_configure_transport (stream, &transport)) {
-          GST_DEBUG_OBJECT (src,
-              "could not configure stream %p transport, skipping stream",
-              stream);
-          goto next;
-        } else if (stream->udpsrc[0] && stream->udpsrc[1]) {
-          /* retain the first allocated UDP port pair */
-          g_object_get (G_OBJECT (stream->udpsrc[0]), "port", &rtpport, NULL);
-          g_object_get (G_OBJECT (stream->udpsrc[1]), "port", &rtcpport, NULL);
-        }
-      }
-      /* we need to activate at least one streams when we detect activity */
-      src->need_activate = TRUE;
-
-      /* stream is setup now */
-      stream->setup = TRUE;
-      {
-        GList *skip = walk;
-
-        while (TRUE) {
-          GstRTSPStream *sskip;
-
-          skip = g_list_next (skip);
-          if (skip == NULL)
-            break;
+    if (!gst_rtspsrc_stream_setup_response (src, walk, &response, &protocols,
+            retry, &rtpport, &rtcpport))
+      goto no_transport;
+
+    /* with one session for all streams on our connection, the following
+     * SETUP requests don't have to wait for each other */
+    if (src->fast_start && stream->setup && conn == src->conninfo.connection
+        && gst_rtsp_message_get_header (&response, GST_RTSP_HDR_SESSION,
+            &hval, 0) == GST_RTSP_OK)
+      aggregate = TRUE;
 
-          sskip = (GstRTSPStream *) skip->data;
+    /* clean up used RTSP messages */
+    gst_rtsp_message_unset (&request);
+    gst_rtsp_message_unset (&response);
+  }
 
-          /* skip all streams with the same control url */
-          if (g_str_equal (stream->conninfo.location, sskip->conninfo.location)) {
-            GST_DEBUG_OBJECT (src, "found stream %p with same control %s",
-                sskip, sskip->conninfo.location);
-            sskip->skipped = TRUE;
-          }
-        }
-      }
-    next:
-      /* clean up our transport struct */
-      gst_rtsp_transport_init (&transport);
-      /* clean up used RTSP messages */
-      gst_rtsp_message_unset (&request);
-      gst_rtsp_message_unset (&response);
-    }
+  /* collect the responses of the requests we did not wait for */
+  if (pending && pending->len > 0) {
+    if ((res = gst_rtspsrc_setup_pipelined (src, src->conninfo.connection,
+                pending, &protocols, &unsupported_real)) < 0)
+      goto cleanup_error;
   }
+  gst_rtspsrc_pending_setup_free (pending);
+  pending = NULL;
 
   /* store the transport protocol that was configured */
   src->cur_protocols = protocols;
@@ -6248,6 +7143,7 @@ no_protocols:
     /* no transport possible, post an error and stop */
     GST_ELEMENT_ERROR (src, RESOURCE, READ, (NULL),
         ("Could not connect to server, no protocols left"));
+    gst_rtspsrc_pending_setup_free (pending);
     return GST_RTSP_ERROR;
   }
 no_streams:
@@ -6319,6 +7215,7 @@ nothing_to_activate:
   }
 cleanup_error:
   {
+    gst_rtspsrc_pending_setup_free (pending);
     gst_rtsp_message_unset (&request);
     gst_rtsp_message_unset (&response);
     return res;
@@ -6570,6 +7467,46 @@ setup_failed:
   }
 }
 
+/* store the time since the previous mark as the duration of @phase */
+static void
+gst_rtspsrc_timing_mark (GstRTSPSrc * src, const gchar * phase)
+{
+  gint64 now;
+  GstClockTime duration;
+
+  if (src->timing == NULL)
+    return;
+
+  now = g_get_monotonic_time ();
+  duration = (now - src->timing_mark) * GST_USECOND;
+  src->timing_mark = now;
+
+  GST_DEBUG_OBJECT (src, "%s took %" GST_TIME_FORMAT, phase,
+      GST_TIME_ARGS (duration));
+  gst_structure_set (src->timing, phase, G_TYPE_UINT64, duration, NULL);
+}
+
+/* post the durations of the startup phases when we started in fast-start
+ * mode */
+static void
+gst_rtspsrc_post_timing (GstRTSPSrc * src)
+{
+  GstStructure *timing;
+
+  if (src->timing == NULL)
+    return;
+
+  gst_rtspsrc_timing_mark (src, "play");
+
+  timing = src->timing;
+  src->timing = NULL;
+  gst_structure_set (timing, "total", G_TYPE_UINT64,
+      (guint64) (src->timing_mark - src->timing_start) * GST_USECOND, NULL);
+
+  gst_element_post_message (GST_ELEMENT_CAST (src),
+      gst_message_new_element (GST_OBJECT_CAST (src), timing));
+}
+
 static GstRTSPResult
 gst_rtspsrc_retrieve_sdp (GstRTSPSrc * src, GstSDPMessage ** sdp,
     gboolean async)
@@ -6594,6 +7531,14 @@ restart:
   if ((res = gst_rtsp_conninfo_connect (src, &src->conninfo, async)) < 0)
     goto connect_failed;
 
+  gst_rtspsrc_timing_mark (src, "connect");
+
+  /* the methods we assume in gst_rtspsrc_open() are enough to start */
+  if (src->fast_start) {
+    GST_DEBUG_OBJECT (src, "fast start, skipping options");
+    goto describe;
+  }
+
   /* create OPTIONS */
   GST_DEBUG_OBJECT (src, "create options...");
   res =
@@ -6617,6 +7562,7 @@ restart:
   if (!gst_rtspsrc_parse_methods (src, &response))
     goto methods_error;
 
+describe:
   /* create DESCRIBE */
   GST_DEBUG_OBJECT (src, "create describe...");
   res =
@@ -6653,6 +7599,8 @@ restart:
     goto restart;
   }
 
+  gst_rtspsrc_timing_mark (src, "describe");
+
   /* it could be that the DESCRIBE method was not implemented */
   if (!src->methods & GST_RTSP_DESCRIBE)
     goto no_describe;
@@ -6757,6 +7705,15 @@ gst_rtspsrc_open (GstRTSPSrc * src, gboolean async)
   src->methods =
       GST_RTSP_SETUP | GST_RTSP_PLAY | GST_RTSP_PAUSE | GST_RTSP_TEARDOWN;
 
+  if (src->timing) {
+    gst_structure_free (src->timing);
+    src->timing = NULL;
+  }
+  if (src->fast_start) {
+    src->timing = gst_structure_new_empty ("GstRTSPSrcTiming");
+    src->timing_start = src->timing_mark = g_get_monotonic_time ();
+  }
+
   if (src->sdp == NULL) {
     if ((ret = gst_rtspsrc_retrieve_sdp (src, &src->sdp, async)) < 0)
       goto no_sdp;
@@ -6765,6 +7722,8 @@ gst_rtspsrc_open (GstRTSPSrc * src, gboolean async)
   if ((ret = gst_rtspsrc_open_from_sdp (src, src->sdp, async)) < 0)
     goto open_failed;
 
+  gst_rtspsrc_timing_mark (src, "setup");
+
 done:
   if (async)
     gst_rtspsrc_loop_end_cmd (src, CMD_OPEN, ret);
@@ -7257,6 +8216,8 @@ gst_rtspsrc_play (GstRTSPSrc * src, GstSegment * segment, gboolean async)
   src->base_time = -1;
   src->state = GST_RTSP_STATE_PLAYING;
 
+  gst_rtspsrc_post_timing (src);
+
   /* mark discont */
   GST_DEBUG_OBJECT (src, "mark DISCONT, we did a seek to another position");
   for (walk = src->streams; walk; walk = g_list_next (walk)) {
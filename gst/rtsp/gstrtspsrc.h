@@ -55,6 +55,7 @@ G_BEGIN_DECLS
 #include <gio/gio.h>
 
 #include "gstrtspext.h"
+#include "gstrtspportpool.h"
 
 #define GST_TYPE_RTSPSRC \
   (gst_rtspsrc_get_type())
@@ -92,6 +93,7 @@ struct _GstRTSPConnInfo {
 };
 
 typedef struct _GstRTSPStream GstRTSPStream;
+typedef struct _GstRTSPChannelQueue GstRTSPChannelQueue;
 
 struct _GstRTSPStream {
   gint          id;
@@ -110,9 +112,14 @@ struct _GstRTSPStream {
   /* for interleaved mode */
   guint8        channel[2];
   GstPad       *channelpad[2];
+  /* queues and threads that push the data of the channels */
+  GstRTSPChannelQueue *channelqueue[2];
 
   /* our udp sources */
   GstElement   *udpsrc[2];
+  /* sockets of the udp sources leased from port_pool */
+  GstRTSPPortPool *port_pool;
+  GSocket      *udpsocket[2];
   GstPad       *blockedpad;
   gulong        blockid;
   gboolean      is_ipv6;
@@ -187,6 +194,14 @@ struct _GstRTSPSrc {
   GstEvent        *start_segment;
   GstClockTime     base_time;
 
+  /* reading interleaved data from the socket */
+  GCancellable    *read_cancellable;
+  GstBuffer       *read_buf;
+  GstMapInfo       read_map;
+  gsize            read_offset;
+  gsize            read_size;
+  gboolean         read_message;
+
   /* UDP mode loop */
   gint             pending_cmd;
   gint             busy_cmd;
@@ -236,6 +251,8 @@ struct _GstRTSPSrc {
   GstStructure     *sdes;
   GTlsCertificateFlags tls_validation_flags;
   GTlsDatabase     *tls_database;
+  gboolean          fast_start;
+  guint             port_pool_size;
 
   /* state */
   GstRTSPState       state;
@@ -247,8 +264,14 @@ struct _GstRTSPSrc {
   GstRTSPTimeRange  *range;
   gchar             *control;
   guint              next_port_num;
+  GstRTSPPortPool   *port_pool;
   GstClock          *provided_clock;
 
+  /* per-phase timing of the startup in fast-start mode */
+  GstStructure      *timing;
+  gint64             timing_start;
+  gint64             timing_mark;
+
   /* supported methods */
   gint               methods;
 
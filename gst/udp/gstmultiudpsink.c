@@ -27,6 +27,11 @@
  * multiudpsink is a network sink that sends UDP packets to multiple
  * clients.
  * It can be combined with rtp payload encoders to implement RTP streaming.
+ *
+ * Where sendmmsg() is available, the packets for all clients, and for all
+ * buffers of a buffer list, are sent in batches with a single system call per
+ * batch. When the running kernel does not implement sendmmsg(), the packets
+ * are sent one by one.
  */
 
 /* FIXME 0.11: suppress warnings for deprecated API such as GValueArray
@@ -36,8 +41,14 @@
 #ifdef HAVE_CONFIG_H
 #include "config.h"
 #endif
+
+#ifndef _GNU_SOURCE
+# define _GNU_SOURCE            /* sendmmsg */
+#endif
+
 #include "gstmultiudpsink.h"
 
+#include <errno.h>
 #include <string.h>
 #ifdef HAVE_SYS_SOCKET_H
 #include <sys/socket.h>
@@ -47,6 +58,22 @@
 #include <netinet/in.h>
 #endif
 
+#ifdef HAVE_SENDMMSG
+#include <netinet/udp.h>
+/* UDP segmentation offload, available since Linux 4.18 */
+#if defined (__linux__) && !defined (UDP_SEGMENT)
+#define UDP_SEGMENT 103
+#endif
+#ifndef SOL_UDP
+#define SOL_UDP 17
+#endif
+#ifdef UDP_SEGMENT
+#define HAVE_UDP_GSO 1
+/* maximum number of segments the kernel accepts in one GSO send */
+#define UDP_MAX_GSO_SEGMENTS 64
+#endif
+#endif
+
 #include "gst/glib-compat-private.h"
 
 GST_DEBUG_CATEGORY_STATIC (multiudpsink_debug);
@@ -54,6 +81,9 @@ GST_DEBUG_CATEGORY_STATIC (multiudpsink_debug);
 
 #define UDP_MAX_SIZE 65507
 
+/* maximum number of datagrams handed to one sendmmsg() call */
+#define MULTIUDPSINK_MAX_BATCH 256
+
 static GstStaticPadTemplate sink_template = GST_STATIC_PAD_TEMPLATE ("sink",
     GST_PAD_SINK,
     GST_PAD_ALWAYS,
@@ -94,6 +124,7 @@ enum
 #define DEFAULT_BUFFER_SIZE        0
 #define DEFAULT_BIND_ADDRESS       NULL
 #define DEFAULT_BIND_PORT          0
+#define DEFAULT_ENABLE_GSO         FALSE
 
 enum
 {
@@ -117,6 +148,7 @@ enum
   PROP_BUFFER_SIZE,
   PROP_BIND_ADDRESS,
   PROP_BIND_PORT,
+  PROP_ENABLE_GSO,
   PROP_LAST
 };
 
@@ -124,6 +156,10 @@ static void gst_multiudpsink_finalize (GObject * object);
 
 static GstFlowReturn gst_multiudpsink_render (GstBaseSink * sink,
     GstBuffer * buffer);
+#ifdef HAVE_SENDMMSG
+static GstFlowReturn gst_multiudpsink_render_list (GstBaseSink * bsink,
+    GstBufferList * list);
+#endif
 
 static gboolean gst_multiudpsink_start (GstBaseSink * bsink);
 static gboolean gst_multiudpsink_stop (GstBaseSink * bsink);
@@ -135,13 +171,28 @@ static void gst_multiudpsink_set_property (GObject * object, guint prop_id,
 static void gst_multiudpsink_get_property (GObject * object, guint prop_id,
     GValue * value, GParamSpec * pspec);
 
+static void free_client (GstUDPClient * client);
 static void gst_multiudpsink_add_internal (GstMultiUDPSink * sink,
-    const gchar * host, gint port, gboolean lock);
+    GstUDPClient * newclient, gboolean lock);
 static void gst_multiudpsink_clear_internal (GstMultiUDPSink * sink,
     gboolean lock);
 
 static guint gst_multiudpsink_signals[LAST_SIGNAL] = { 0 };
 
+typedef struct
+{
+  GstUDPClient *client;
+  gint count;
+} GstUDPClientEntry;
+
+struct _GstUDPClientList
+{
+  volatile gint refcount;
+
+  guint n_clients;
+  GstUDPClientEntry *entries;
+};
+
 #define gst_multiudpsink_parent_class parent_class
 G_DEFINE_TYPE (GstMultiUDPSink, gst_multiudpsink, GST_TYPE_BASE_SINK);
 
@@ -216,7 +267,9 @@ gst_multiudpsink_class_init (GstMultiUDPSinkClass * klass)
    * Get the statistics of the client with destination @host and @port.
    *
    * Returns: a GstStructure: bytes_sent, packets_sent,
-   *           connect_time (in epoch seconds), disconnect_time (in epoch seconds)
+   *           connect_time (in epoch seconds), disconnect_time (in epoch seconds),
+   *           gso_batches_sent and gso_packets_sent (number of segmentation
+   *           offload sends and the packets they contained)
    */
   gst_multiudpsink_signals[SIGNAL_GET_STATS] =
       g_signal_new ("get-stats", G_TYPE_FROM_CLASS (klass),
@@ -245,7 +298,8 @@ gst_multiudpsink_class_init (GstMultiUDPSinkClass * klass)
    * @port: the port of the removed client
    *
    * Signal emited when a client is removed from the list of
-   * clients.
+   * clients. The client is only dropped after the signal, so its final
+   * statistics can still be retrieved with #GstMultiUDPSink::get-stats.
    */
   gst_multiudpsink_signals[SIGNAL_CLIENT_REMOVED] =
       g_signal_new ("client-removed", G_TYPE_FROM_CLASS (klass),
@@ -350,6 +404,19 @@ gst_multiudpsink_class_init (GstMultiUDPSinkClass * klass)
       g_param_spec_int ("bind-port", "Bind Port",
           "Port to bind the socket to", 0, G_MAXUINT16,
           DEFAULT_BIND_PORT, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  /**
+   * GstMultiUDPSink::enable-gso:
+   *
+   * Use UDP segmentation offload (UDP_SEGMENT) to send runs of equally sized
+   * packets of a buffer list as one large datagram that the kernel, or the
+   * network device, splits into the individual packets. Falls back to
+   * sending the packets separately when offload is not available.
+   */
+  g_object_class_install_property (gobject_class, PROP_ENABLE_GSO,
+      g_param_spec_boolean ("enable-gso", "Enable GSO",
+          "Use UDP segmentation offload for runs of equally sized packets "
+          "in buffer lists (Linux only)", DEFAULT_ENABLE_GSO,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
   gst_element_class_add_pad_template (gstelement_class,
       gst_static_pad_template_get (&sink_template));
@@ -360,6 +427,9 @@ gst_multiudpsink_class_init (GstMultiUDPSinkClass * klass)
       "Wim Taymans <wim.taymans@gmail.com>");
 
   gstbasesink_class->render = gst_multiudpsink_render;
+#ifdef HAVE_SENDMMSG
+  gstbasesink_class->render_list = gst_multiudpsink_render_list;
+#endif
   gstbasesink_class->start = gst_multiudpsink_start;
   gstbasesink_class->stop = gst_multiudpsink_stop;
   gstbasesink_class->unlock = gst_multiudpsink_unlock;
@@ -373,12 +443,117 @@ gst_multiudpsink_class_init (GstMultiUDPSinkClass * klass)
 }
 
 
+static guint
+client_hash (GstUDPClient * client)
+{
+  return g_str_hash (client->host) ^ client->port;
+}
+
+static gboolean
+client_equal (GstUDPClient * a, GstUDPClient * b)
+{
+  return (a->port == b->port) && (strcmp (a->host, b->host) == 0);
+}
+
+static GstUDPClient *
+client_ref (GstUDPClient * client)
+{
+  g_atomic_int_inc (&client->ref);
+
+  return client;
+}
+
+static void
+client_unref (GstUDPClient * client)
+{
+  if (g_atomic_int_dec_and_test (&client->ref))
+    free_client (client);
+}
+
+/* the statistics are 64 bits and read by the application, update them under
+ * the stats_lock so they are never seen half written */
+static void
+gst_multiudpsink_update_stats (GstMultiUDPSink * sink, GstUDPClient * client,
+    guint64 bytes, guint64 packets, guint64 gso_batches, guint64 gso_packets)
+{
+  g_mutex_lock (&sink->stats_lock);
+  client->bytes_sent += bytes;
+  client->packets_sent += packets;
+  client->gso_batches_sent += gso_batches;
+  client->gso_packets_sent += gso_packets;
+  sink->bytes_served += bytes;
+  g_mutex_unlock (&sink->stats_lock);
+}
+
+static void
+client_list_unref (GstUDPClientList * list)
+{
+  guint i;
+
+  if (!g_atomic_int_dec_and_test (&list->refcount))
+    return;
+
+  for (i = 0; i < list->n_clients; i++)
+    client_unref (list->entries[i].client);
+  g_free (list->entries);
+  g_slice_free (GstUDPClientList, list);
+}
+
+/* make a new snapshot of the clients for the streaming thread. Must be called
+ * with the client_lock after each change to the clients. */
+static void
+gst_multiudpsink_publish_clients (GstMultiUDPSink * sink)
+{
+  GstUDPClientList *list, *old;
+  GList *walk;
+  guint i;
+
+  list = g_slice_new (GstUDPClientList);
+  list->refcount = 1;
+  list->n_clients = g_hash_table_size (sink->client_index);
+  list->entries = g_new (GstUDPClientEntry, list->n_clients);
+
+  for (walk = sink->clients, i = 0; walk; walk = g_list_next (walk), i++) {
+    GstUDPClient *client = (GstUDPClient *) walk->data;
+
+    list->entries[i].client = client_ref (client);
+    list->entries[i].count = client->refcount;
+  }
+
+  g_mutex_lock (&sink->client_list_lock);
+  old = sink->client_list;
+  sink->client_list = list;
+  g_mutex_unlock (&sink->client_list_lock);
+
+  client_list_unref (old);
+}
+
+/* get a reference to the current snapshot of the clients */
+static GstUDPClientList *
+gst_multiudpsink_get_clients (GstMultiUDPSink * sink)
+{
+  GstUDPClientList *list;
+
+  g_mutex_lock (&sink->client_list_lock);
+  list = sink->client_list;
+  g_atomic_int_inc (&list->refcount);
+  g_mutex_unlock (&sink->client_list_lock);
+
+  return list;
+}
+
 static void
 gst_multiudpsink_init (GstMultiUDPSink * sink)
 {
   guint max_mem;
 
   g_mutex_init (&sink->client_lock);
+  g_mutex_init (&sink->client_list_lock);
+  g_mutex_init (&sink->stats_lock);
+  sink->client_index = g_hash_table_new ((GHashFunc) client_hash,
+      (GEqualFunc) client_equal);
+  sink->client_list = g_slice_new0 (GstUDPClientList);
+  sink->client_list->refcount = 1;
   sink->socket = DEFAULT_SOCKET;
   sink->socket_v6 = DEFAULT_SOCKET;
   sink->used_socket = DEFAULT_USED_SOCKET;
@@ -403,6 +578,22 @@ gst_multiudpsink_init (GstMultiUDPSink * sink)
 
   sink->vec = g_new (GOutputVector, max_mem);
   sink->map = g_new (GstMapInfo, max_mem);
+
+#ifdef HAVE_SENDMMSG
+  /* for sendmmsg() the vectors and maps are grown on demand because a buffer
+   * list can contain any number of memory blocks */
+  sink->n_vec = max_mem;
+  sink->iov = g_new (struct iovec, max_mem);
+  sink->msgs = g_new0 (struct mmsghdr, MULTIUDPSINK_MAX_BATCH);
+  sink->msg_clients = g_new0 (GstUDPClient *, MULTIUDPSINK_MAX_BATCH);
+  sink->msg_segments = g_new0 (guint, MULTIUDPSINK_MAX_BATCH);
+  sink->msg_seg_size = g_new0 (gsize, MULTIUDPSINK_MAX_BATCH);
+#ifdef HAVE_UDP_GSO
+  sink->msg_control = g_malloc0 (MULTIUDPSINK_MAX_BATCH *
+      CMSG_SPACE (sizeof (guint16)));
+#endif
+#endif
+  sink->enable_gso = DEFAULT_ENABLE_GSO;
 }
 
 static GstUDPClient *
@@ -438,11 +629,20 @@ create_client (GstMultiUDPSink * sink, const gchar * host, gint port)
 
   client = g_slice_new0 (GstUDPClient);
   client->refcount = 1;
+  client->ref = 1;
   client->host = g_strdup (host);
   client->port = port;
   client->addr = g_inet_socket_address_new (addr, port);
   g_object_unref (addr);
 
+  client->native_addrlen = g_socket_address_get_native_size (client->addr);
+  client->native_addr = g_malloc0 (client->native_addrlen);
+  if (!g_socket_address_to_native (client->addr, client->native_addr,
+          client->native_addrlen, &err)) {
+    GST_WARNING_OBJECT (sink, "could not convert address: %s", err->message);
+    g_clear_error (&err);
+  }
+
   return client;
 
 name_resolve:
@@ -458,18 +658,10 @@ free_client (GstUDPClient * client)
 {
   g_object_unref (client->addr);
   g_free (client->host);
+  g_free (client->native_addr);
   g_slice_free (GstUDPClient, client);
 }
 
-static gint
-client_compare (GstUDPClient * a, GstUDPClient * b)
-{
-  if ((a->port == b->port) && (strcmp (a->host, b->host) == 0))
-    return 0;
-
-  return 1;
-}
-
 static void
 gst_multiudpsink_finalize (GObject * object)
 {
@@ -477,7 +669,11 @@ gst_multiudpsink_finalize (GObject * object)
 
   sink = GST_MULTIUDPSINK (object);
 
-  g_list_foreach (sink->clients, (GFunc) free_client, NULL);
+  client_list_unref (sink->client_list);
+  sink->client_list = NULL;
+  g_hash_table_destroy (sink->client_index);
+  sink->client_index = NULL;
+  g_list_foreach (sink->clients, (GFunc) client_unref, NULL);
   g_list_free (sink->clients);
 
   if (sink->socket)
@@ -507,26 +703,454 @@ gst_multiudpsink_finalize (GObject * object)
   sink->vec = NULL;
   g_free (sink->map);
   sink->map = NULL;
+  g_free (sink->iov);
+  sink->iov = NULL;
+  g_free (sink->msgs);
+  sink->msgs = NULL;
+  g_free (sink->msg_clients);
+  sink->msg_clients = NULL;
+  g_free (sink->msg_segments);
+  sink->msg_segments = NULL;
+  g_free (sink->msg_seg_size);
+  sink->msg_seg_size = NULL;
+  g_free (sink->msg_control);
+  sink->msg_control = NULL;
+  g_free (sink->buf_info);
+  sink->buf_info = NULL;
 
   g_free (sink->bind_address);
   sink->bind_address = NULL;
 
   g_mutex_clear (&sink->client_lock);
+  g_mutex_clear (&sink->client_list_lock);
+  g_mutex_clear (&sink->stats_lock);
 
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
+#ifdef HAVE_SENDMMSG
+typedef struct
+{
+  guint first;                  /* index of the first vector of the buffer */
+  guint n_mem;
+  gsize size;
+} GstUDPBufferInfo;
+
+static gsize
+gst_multiudpsink_msg_size (struct mmsghdr *msg)
+{
+  gsize i, size = 0;
+
+  for (i = 0; i < msg->msg_hdr.msg_iovlen; i++)
+    size += msg->msg_hdr.msg_iov[i].iov_len;
+
+  return size;
+}
+
+#ifdef HAVE_UDP_GSO
+/* send the segments of a GSO message one by one, used when the kernel or the
+ * network device turns out to not support UDP segmentation offload */
+static void
+gst_multiudpsink_send_segments (GstMultiUDPSink * sink, gint fd,
+    struct mmsghdr *msg, GstUDPClient * client, gint * num)
+{
+  struct msghdr hdr;
+  gsize seg_size, acc;
+  guint i, first;
+  guint64 bytes = 0, packets = 0;
+
+  seg_size = sink->msg_seg_size[msg - (struct mmsghdr *) sink->msgs];
+
+  memset (&hdr, 0, sizeof (hdr));
+  hdr.msg_name = msg->msg_hdr.msg_name;
+  hdr.msg_namelen = msg->msg_hdr.msg_namelen;
+
+  /* buffers of a run are all seg_size bytes, except maybe the last one */
+  first = 0;
+  acc = 0;
+  for (i = 0; i < msg->msg_hdr.msg_iovlen; i++) {
+    acc += msg->msg_hdr.msg_iov[i].iov_len;
+    if (acc >= seg_size || i + 1 == msg->msg_hdr.msg_iovlen) {
+      gssize res;
+
+      hdr.msg_iov = &msg->msg_hdr.msg_iov[first];
+      hdr.msg_iovlen = i + 1 - first;
+
+      do {
+        res = sendmsg (fd, &hdr, 0);
+      } while (res < 0 && errno == EINTR);
+
+      if (res >= 0) {
+        bytes += res;
+        packets++;
+        (*num)++;
+      } else {
+        GST_WARNING_OBJECT (sink, "failed to send segment: %s",
+            g_strerror (errno));
+      }
+      first = i + 1;
+      acc = 0;
+    }
+  }
+  gst_multiudpsink_update_stats (sink, client, bytes, packets, 0, 0);
+}
+#endif
+
+/* send the first n_msgs queued messages on @socket with as few sendmmsg()
+ * calls as possible and update the statistics of the clients. The clients in
+ * msg_clients are kept alive by the snapshot of the caller. */
+static GstFlowReturn
+gst_multiudpsink_send_batch (GstMultiUDPSink * sink, GSocket * socket,
+    guint n_msgs, gint * num)
+{
+  struct mmsghdr *msgs = sink->msgs;
+  GError *err = NULL;
+  guint i = 0;
+  gint fd;
+
+  fd = g_socket_get_fd (socket);
+
+  GST_LOG_OBJECT (sink, "sending batch of %u messages", n_msgs);
+
+  while (i < n_msgs) {
+    gint ret, j;
+
+    if (G_LIKELY (!sink->sendmmsg_failed)) {
+      ret = sendmmsg (fd, msgs + i, n_msgs - i, 0);
+    } else {
+      /* sendmmsg() is not available, send the messages one by one */
+      ret = sendmsg (fd, &msgs[i].msg_hdr, 0);
+      if (ret >= 0) {
+        msgs[i].msg_len = ret;
+        ret = 1;
+      }
+    }
+
+    if (G_UNLIKELY (ret < 0)) {
+      gint errnum = errno;
+      gsize size;
+
+      if (errnum == EINTR)
+        continue;
+
+      /* the C library has sendmmsg() but the kernel does not, use sendmsg()
+       * from now on and send the same messages again */
+      if (errnum == ENOSYS && !sink->sendmmsg_failed) {
+        GST_WARNING_OBJECT (sink, "sendmmsg() is not supported, falling back "
+            "to sendmsg()");
+        sink->sendmmsg_failed = TRUE;
+        continue;
+      }
+
+      /* the socket buffer is full, wait for space like g_socket_send_message()
+       * does on blocking sockets */
+      if ((errnum == EAGAIN || errnum == EWOULDBLOCK)
+          && g_socket_get_blocking (socket)) {
+        if (!g_socket_condition_wait (socket, G_IO_OUT, sink->cancellable,
+                &err)) {
+          if (g_error_matches (err, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+            goto flushing;
+          g_clear_error (&err);
+        }
+        continue;
+      }
+#ifdef HAVE_UDP_GSO
+      /* segmentation offload is not available for this socket or device,
+       * send this message packet by packet and don't try again */
+      if (sink->msg_segments[i] > 1 && (errnum == EIO || errnum == EINVAL
+              || errnum == ENOPROTOOPT || errnum == EOPNOTSUPP)) {
+        GST_WARNING_OBJECT (sink, "UDP segmentation offload failed: %s, "
+            "disabling", g_strerror (errnum));
+        sink->gso_failed = TRUE;
+        gst_multiudpsink_send_segments (sink, fd, &msgs[i],
+            sink->msg_clients[i], num);
+        i++;
+        continue;
+      }
+#endif
+
+      /* we continue after posting a warning, next packets might be ok
+       * again */
+      size = gst_multiudpsink_msg_size (&msgs[i]);
+      if (size > UDP_MAX_SIZE) {
+        GST_ELEMENT_WARNING (sink, RESOURCE, WRITE,
+            ("Attempting to send a UDP packet larger than maximum size "
+                "(%" G_GSIZE_FORMAT " > %d)", size, UDP_MAX_SIZE),
+            ("Reason: %s", g_strerror (errnum)));
+      } else {
+        GST_ELEMENT_WARNING (sink, RESOURCE, WRITE,
+            ("Error sending UDP packet"), ("Reason: %s",
+                g_strerror (errnum)));
+      }
+      /* skip the message that failed */
+      i++;
+      continue;
+    }
+
+    g_mutex_lock (&sink->stats_lock);
+    for (j = 0; j < ret; j++) {
+      GstUDPClient *client = sink->msg_clients[i + j];
+      guint segments = sink->msg_segments[i + j];
+
+      client->bytes_sent += msgs[i + j].msg_len;
+      client->packets_sent += segments;
+      if (segments > 1) {
+        client->gso_batches_sent++;
+        client->gso_packets_sent += segments;
+      }
+      sink->bytes_served += msgs[i + j].msg_len;
+      *num += segments;
+    }
+    g_mutex_unlock (&sink->stats_lock);
+    i += ret;
+  }
+  return GST_FLOW_OK;
+
+  /* ERRORS */
+flushing:
+  {
+    GST_DEBUG ("we are flushing");
+    g_clear_error (&err);
+    return GST_FLOW_FLUSHING;
+  }
+}
+
+/* find how many buffers, starting at @start, can be sent as one GSO message:
+ * they all need to have the same size, except for the last one which can be
+ * smaller, and the total has to fit in one UDP datagram */
+static guint
+gst_multiudpsink_gso_run (GstMultiUDPSink * sink, GstUDPBufferInfo * info,
+    guint start, guint n_buffers)
+{
+#ifdef HAVE_UDP_GSO
+  gsize seg_size, total;
+  guint n;
+
+  if (!sink->enable_gso || sink->gso_failed)
+    return 1;
+
+  seg_size = info[start].size;
+  if (seg_size == 0)
+    return 1;
+
+  total = seg_size;
+  for (n = 1; start + n < n_buffers && n < UDP_MAX_GSO_SEGMENTS; n++) {
+    gsize size = info[start + n].size;
+
+    if (info[start + n].n_mem == 0 || size == 0 || size > seg_size
+        || total + size > UDP_MAX_SIZE)
+      break;
+
+    total += size;
+    if (size < seg_size) {
+      n++;
+      break;
+    }
+  }
+  return n;
+#else
+  return 1;
+#endif
+}
+
+/* send @buffer, or all buffers of @list, to all clients. One message is
+ * queued per buffer and client (and per duplicate) and the messages are sent
+ * in batches with sendmmsg(). With enable-gso, runs of equally sized buffers
+ * are sent as a single message that the kernel segments. */
+static GstFlowReturn
+gst_multiudpsink_render_buffers (GstMultiUDPSink * sink, GstBuffer * buffer,
+    GstBufferList * list)
+{
+  struct mmsghdr *msgs;
+  struct iovec *iov;
+  GstMapInfo *map;
+  GstUDPBufferInfo *info;
+  GstFlowReturn ret = GST_FLOW_OK;
+  GSocket *batch_socket = NULL;
+  GstUDPClientList *clients;
+  guint n_buffers, n_vec, n_msgs, i, j, k, c;
+  gsize size;
+  gint num, no_clients;
+
+  n_buffers = list ? gst_buffer_list_length (list) : 1;
+
+  /* make sure we have room to map all memory of all buffers, the vectors
+   * are referenced from the messages so they can't move afterwards */
+  n_vec = 0;
+  for (i = 0; i < n_buffers; i++) {
+    GstBuffer *buf = list ? gst_buffer_list_get (list, i) : buffer;
+
+    n_vec += gst_buffer_n_memory (buf);
+  }
+  if (n_vec == 0)
+    goto no_data;
+
+  if (n_vec > sink->n_vec) {
+    sink->n_vec = n_vec;
+    sink->iov = g_renew (struct iovec, sink->iov, n_vec);
+    sink->map = g_renew (GstMapInfo, sink->map, n_vec);
+  }
+  if (n_buffers > sink->n_buf_info) {
+    sink->n_buf_info = n_buffers;
+    sink->buf_info = g_renew (GstUDPBufferInfo, sink->buf_info, n_buffers);
+  }
+
+  msgs = sink->msgs;
+  iov = sink->iov;
+  map = sink->map;
+  info = sink->buf_info;
+
+  /* map all buffers, the vectors of one buffer are consecutive so that
+   * consecutive buffers can be sent with one message */
+  k = 0;
+  size = 0;
+  for (i = 0; i < n_buffers; i++) {
+    GstBuffer *buf = list ? gst_buffer_list_get (list, i) : buffer;
+
+    info[i].first = k;
+    info[i].n_mem = gst_buffer_n_memory (buf);
+    info[i].size = 0;
+    for (j = 0; j < info[i].n_mem; j++, k++) {
+      GstMemory *mem = gst_buffer_get_memory (buf, j);
+
+      gst_memory_map (mem, &map[k], GST_MAP_READ);
+
+      iov[k].iov_base = map[k].data;
+      iov[k].iov_len = map[k].size;
+
+      info[i].size += map[k].size;
+    }
+    size += info[i].size;
+  }
+
+  /* work on a snapshot of the clients, clients can be added and removed while
+   * we are sending */
+  clients = gst_multiudpsink_get_clients (sink);
+
+  num = 0;
+  no_clients = clients->n_clients;
+  n_msgs = 0;
+  for (i = 0; i < n_buffers; i += j) {
+    guint n_iov;
+
+    j = 1;
+    if (info[i].n_mem == 0)
+      continue;
+
+    j = gst_multiudpsink_gso_run (sink, info, i, n_buffers);
+    n_iov = info[i + j - 1].first + info[i + j - 1].n_mem - info[i].first;
+
+    for (c = 0; c < clients->n_clients; c++) {
+      GstUDPClient *client;
+      GSocket *socket;
+      GSocketFamily family;
+      gint count;
+
+      client = clients->entries[c].client;
+
+      family = g_socket_address_get_family (G_SOCKET_ADDRESS (client->addr));
+      /* Select socket to send from for this address */
+      if (family == G_SOCKET_FAMILY_IPV6 || !sink->used_socket)
+        socket = sink->used_socket_v6;
+      else
+        socket = sink->used_socket;
+
+      count = sink->send_duplicates ? clients->entries[c].count : 1;
+
+      while (count--) {
+        /* one sendmmsg() call can only use one socket */
+        if (n_msgs == MULTIUDPSINK_MAX_BATCH
+            || (n_msgs > 0 && socket != batch_socket)) {
+          ret = gst_multiudpsink_send_batch (sink, batch_socket, n_msgs, &num);
+          n_msgs = 0;
+          if (ret != GST_FLOW_OK)
+            goto done;
+        }
+        batch_socket = socket;
+
+        memset (&msgs[n_msgs], 0, sizeof (struct mmsghdr));
+        msgs[n_msgs].msg_hdr.msg_name = client->native_addr;
+        msgs[n_msgs].msg_hdr.msg_namelen = client->native_addrlen;
+        msgs[n_msgs].msg_hdr.msg_iov = &iov[info[i].first];
+        msgs[n_msgs].msg_hdr.msg_iovlen = n_iov;
+        sink->msg_clients[n_msgs] = client;
+        sink->msg_segments[n_msgs] = j;
+#ifdef HAVE_UDP_GSO
+        if (j > 1) {
+          guint8 *control = (guint8 *) sink->msg_control +
+              n_msgs * CMSG_SPACE (sizeof (guint16));
+          struct cmsghdr *cmsg;
+
+          msgs[n_msgs].msg_hdr.msg_control = control;
+          msgs[n_msgs].msg_hdr.msg_controllen =
+              CMSG_SPACE (sizeof (guint16));
+
+          cmsg = CMSG_FIRSTHDR (&msgs[n_msgs].msg_hdr);
+          cmsg->cmsg_level = SOL_UDP;
+          cmsg->cmsg_type = UDP_SEGMENT;
+          cmsg->cmsg_len = CMSG_LEN (sizeof (guint16));
+          *(guint16 *) CMSG_DATA (cmsg) = info[i].size;
+          sink->msg_seg_size[n_msgs] = info[i].size;
+        }
+#endif
+        n_msgs++;
+      }
+    }
+  }
+
+  if (n_msgs > 0)
+    ret = gst_multiudpsink_send_batch (sink, batch_socket, n_msgs, &num);
+
+done:
+  client_list_unref (clients);
+
+  g_mutex_lock (&sink->stats_lock);
+  sink->bytes_to_serve += size;
+  g_mutex_unlock (&sink->stats_lock);
+
+  /* unmap all memory again */
+  for (i = 0; i < k; i++) {
+    gst_memory_unmap (map[i].memory, &map[i]);
+    gst_memory_unref (map[i].memory);
+  }
+
+  GST_LOG_OBJECT (sink, "sent %" G_GSIZE_FORMAT " bytes in %u buffers, "
+      "%d packets to %d clients", size, n_buffers, num, no_clients);
+
+  return ret;
+
+no_data:
+  {
+    return GST_FLOW_OK;
+  }
+}
+
+static GstFlowReturn
+gst_multiudpsink_render_list (GstBaseSink * bsink, GstBufferList * list)
+{
+  return gst_multiudpsink_render_buffers (GST_MULTIUDPSINK (bsink), NULL,
+      list);
+}
+
+static GstFlowReturn
+gst_multiudpsink_render (GstBaseSink * bsink, GstBuffer * buffer)
+{
+  return gst_multiudpsink_render_buffers (GST_MULTIUDPSINK (bsink), buffer,
+      NULL);
+}
+#else
 static GstFlowReturn
 gst_multiudpsink_render (GstBaseSink * bsink, GstBuffer * buffer)
 {
   GstMultiUDPSink *sink;
-  GList *clients;
+  GstUDPClientList *clients;
   GOutputVector *vec;
   GstMapInfo *map;
-  guint n_mem, i;
+  guint n_mem, i, c;
   gsize size;
   GstMemory *mem;
   gint num, no_clients;
+  guint64 bytes, packets;
   GError *err = NULL;
 
   sink = GST_MULTIUDPSINK (bsink);
@@ -551,23 +1175,25 @@ gst_multiudpsink_render (GstBaseSink * bsink, GstBuffer * buffer)
     size += map[i].size;
   }
 
+  g_mutex_lock (&sink->stats_lock);
   sink->bytes_to_serve += size;
+  g_mutex_unlock (&sink->stats_lock);
 
-  /* grab lock while iterating and sending to clients, this should be
-   * fast as UDP never blocks */
-  g_mutex_lock (&sink->client_lock);
+  /* work on a snapshot of the clients, clients can be added and removed while
+   * we are sending */
+  clients = gst_multiudpsink_get_clients (sink);
   GST_LOG_OBJECT (bsink, "about to send %" G_GSIZE_FORMAT " bytes in %u blocks",
       size, n_mem);
 
   no_clients = 0;
   num = 0;
-  for (clients = sink->clients; clients; clients = g_list_next (clients)) {
+  for (c = 0; c < clients->n_clients; c++) {
     GstUDPClient *client;
     GSocket *socket;
     GSocketFamily family;
     gint count;
 
-    client = (GstUDPClient *) clients->data;
+    client = clients->entries[c].client;
     no_clients++;
     GST_LOG_OBJECT (sink, "sending %" G_GSIZE_FORMAT " bytes to client %p",
         size, client);
@@ -579,7 +1205,8 @@ gst_multiudpsink_render (GstBaseSink * bsink, GstBuffer * buffer)
     else
       socket = sink->used_socket;
 
-    count = sink->send_duplicates ? client->refcount : 1;
+    count = sink->send_duplicates ? clients->entries[c].count : 1;
+    bytes = packets = 0;
 
     while (count--) {
       gssize ret;
@@ -589,8 +1216,10 @@ gst_multiudpsink_render (GstBaseSink * bsink, GstBuffer * buffer)
           NULL, 0, 0, sink->cancellable, &err);
 
       if (G_UNLIKELY (ret < 0)) {
-        if (g_error_matches (err, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+        if (g_error_matches (err, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+          gst_multiudpsink_update_stats (sink, client, bytes, packets, 0, 0);
           goto flushing;
+        }
 
         /* we continue after posting a warning, next packets might be ok
          * again */
@@ -607,13 +1236,13 @@ gst_multiudpsink_render (GstBaseSink * bsink, GstBuffer * buffer)
         g_clear_error (&err);
       } else {
         num++;
-        client->bytes_sent += ret;
-        client->packets_sent++;
-        sink->bytes_served += ret;
+        bytes += ret;
+        packets++;
       }
     }
+    gst_multiudpsink_update_stats (sink, client, bytes, packets, 0, 0);
   }
-  g_mutex_unlock (&sink->client_lock);
+  client_list_unref (clients);
 
   /* unmap all memory again */
   for (i = 0; i < n_mem; i++) {
@@ -633,7 +1262,7 @@ no_data:
 flushing:
   {
     GST_DEBUG ("we are flushing");
-    g_mutex_unlock (&sink->client_lock);
+    client_list_unref (clients);
     g_clear_error (&err);
 
     /* unmap all memory */
@@ -645,22 +1274,23 @@ flushing:
     return GST_FLOW_FLUSHING;
   }
 }
+#endif
 
 static void
 gst_multiudpsink_set_clients_string (GstMultiUDPSink * sink,
     const gchar * string)
 {
   gchar **clients;
+  GList *newclients = NULL, *walk;
   gint i;
 
   clients = g_strsplit (string, ",", 0);
 
-  g_mutex_lock (&sink->client_lock);
-  /* clear all existing clients */
-  gst_multiudpsink_clear_internal (sink, FALSE);
+  /* resolve the host names before taking the client_lock, this can block */
   for (i = 0; clients[i]; i++) {
     gchar *host, *p;
     gint64 port = 0;
+    GstUDPClient *client;
 
     host = clients[i];
     p = strstr (clients[i], ":");
@@ -668,11 +1298,25 @@ gst_multiudpsink_set_clients_string (GstMultiUDPSink * sink,
       *p = '\0';
       port = g_ascii_strtoll (p + 1, NULL, 10);
     }
-    if (port != 0)
-      gst_multiudpsink_add_internal (sink, host, port, FALSE);
+    if (port == 0)
+      continue;
+
+    if ((client = create_client (sink, host, port)))
+      newclients = g_list_prepend (newclients, client);
+    else
+      GST_DEBUG_OBJECT (sink, "did not add client on host %s, port %d", host,
+          (gint) port);
   }
+  newclients = g_list_reverse (newclients);
+
+  g_mutex_lock (&sink->client_lock);
+  /* clear all existing clients */
+  gst_multiudpsink_clear_internal (sink, FALSE);
+  for (walk = newclients; walk; walk = g_list_next (walk))
+    gst_multiudpsink_add_internal (sink, walk->data, FALSE);
   g_mutex_unlock (&sink->client_lock);
 
+  g_list_free (newclients);
   g_strfreev (clients);
 }
 
@@ -828,6 +1472,9 @@ gst_multiudpsink_set_property (GObject * object, guint prop_id,
     case PROP_BIND_PORT:
       udpsink->bind_port = g_value_get_int (value);
       break;
+    case PROP_ENABLE_GSO:
+      udpsink->enable_gso = g_value_get_boolean (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -844,10 +1491,14 @@ gst_multiudpsink_get_property (GObject * object, guint prop_id, GValue * value,
 
   switch (prop_id) {
     case PROP_BYTES_TO_SERVE:
+      g_mutex_lock (&udpsink->stats_lock);
       g_value_set_uint64 (value, udpsink->bytes_to_serve);
+      g_mutex_unlock (&udpsink->stats_lock);
       break;
     case PROP_BYTES_SERVED:
+      g_mutex_lock (&udpsink->stats_lock);
       g_value_set_uint64 (value, udpsink->bytes_served);
+      g_mutex_unlock (&udpsink->stats_lock);
       break;
     case PROP_SOCKET:
       g_value_set_object (value, udpsink->socket);
@@ -901,6 +1552,9 @@ gst_multiudpsink_get_property (GObject * object, guint prop_id, GValue * value,
     case PROP_BIND_PORT:
       g_value_set_int (value, udpsink->bind_port);
       break;
+    case PROP_ENABLE_GSO:
+      g_value_set_boolean (value, udpsink->enable_gso);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -1160,8 +1814,12 @@ gst_multiudpsink_start (GstBaseSink * bsink)
   if (sink->used_socket_v6)
     g_socket_set_broadcast (sink->used_socket_v6, TRUE);
 
+  g_mutex_lock (&sink->stats_lock);
   sink->bytes_to_serve = 0;
   sink->bytes_served = 0;
+  g_mutex_unlock (&sink->stats_lock);
+  sink->gso_failed = FALSE;
+  sink->sendmmsg_failed = FALSE;
 
   gst_multiudpsink_setup_qos_dscp (sink, sink->used_socket);
   gst_multiudpsink_setup_qos_dscp (sink, sink->used_socket_v6);
@@ -1239,35 +1897,40 @@ gst_multiudpsink_stop (GstBaseSink * bsink)
   return TRUE;
 }
 
+/* add @newclient to the clients, or add another reference to the client
+ * with the same host and port. Takes ownership of @newclient, which must have
+ * been created without the client_lock because it resolves the host name. */
 static void
-gst_multiudpsink_add_internal (GstMultiUDPSink * sink, const gchar * host,
-    gint port, gboolean lock)
+gst_multiudpsink_add_internal (GstMultiUDPSink * sink,
+    GstUDPClient * newclient, gboolean lock)
 {
   GstUDPClient *client;
-  GstUDPClient udpclient;
+  const gchar *host = newclient->host;
+  gint port = newclient->port;
   GTimeVal now;
   GList *find;
 
-  udpclient.host = (gchar *) host;
-  udpclient.port = port;
-
   GST_DEBUG_OBJECT (sink, "adding client on host %s, port %d", host, port);
 
   if (lock)
     g_mutex_lock (&sink->client_lock);
 
-  find = g_list_find_custom (sink->clients, &udpclient,
-      (GCompareFunc) client_compare);
+  find = g_hash_table_lookup (sink->client_index, newclient);
   if (find) {
     client = (GstUDPClient *) find->data;
 
     GST_DEBUG_OBJECT (sink, "found %d existing clients with host %s, port %d",
         client->refcount, host, port);
+    /* added back while it was being removed */
+    if (client->refcount == 0) {
+      client->disconnect_time = 0;
+      if (sink->used_socket)
+        gst_multiudpsink_configure_client (sink, client);
+    }
     client->refcount++;
   } else {
-    client = create_client (sink, host, port);
-    if (!client)
-      goto error;
+    /* the client table takes a reference */
+    client = client_ref (newclient);
 
     g_get_current_time (&now);
     client->connect_time = GST_TIMEVAL_TO_TIME (now);
@@ -1277,7 +1940,9 @@ gst_multiudpsink_add_internal (GstMultiUDPSink * sink, const gchar * host,
 
     GST_DEBUG_OBJECT (sink, "add client with host %s, port %d", host, port);
     sink->clients = g_list_prepend (sink->clients, client);
+    g_hash_table_insert (sink->client_index, client, sink->clients);
   }
+  gst_multiudpsink_publish_clients (sink);
 
   if (lock)
     g_mutex_unlock (&sink->client_lock);
@@ -1286,23 +1951,24 @@ gst_multiudpsink_add_internal (GstMultiUDPSink * sink, const gchar * host,
       gst_multiudpsink_signals[SIGNAL_CLIENT_ADDED], 0, host, port);
 
   GST_DEBUG_OBJECT (sink, "added client on host %s, port %d", host, port);
-  return;
 
-  /* ERRORS */
-error:
-  {
-    GST_DEBUG_OBJECT (sink, "did not add client on host %s, port %d", host,
-        port);
-    if (lock)
-      g_mutex_unlock (&sink->client_lock);
-    return;
-  }
+  /* @host and @port belong to @newclient */
+  client_unref (newclient);
 }
 
 void
 gst_multiudpsink_add (GstMultiUDPSink * sink, const gchar * host, gint port)
 {
-  gst_multiudpsink_add_internal (sink, host, port, TRUE);
+  GstUDPClient *client;
+
+  /* resolve the host name before taking the client_lock, this can block */
+  client = create_client (sink, host, port);
+  if (!client) {
+    GST_DEBUG_OBJECT (sink, "did not add client on host %s, port %d", host,
+        port);
+    return;
+  }
+  gst_multiudpsink_add_internal (sink, client, TRUE);
 }
 
 void
@@ -1317,13 +1983,16 @@ gst_multiudpsink_remove (GstMultiUDPSink * sink, const gchar * host, gint port)
   udpclient.port = port;
 
   g_mutex_lock (&sink->client_lock);
-  find = g_list_find_custom (sink->clients, &udpclient,
-      (GCompareFunc) client_compare);
+  find = g_hash_table_lookup (sink->client_index, &udpclient);
   if (!find)
     goto not_found;
 
   client = (GstUDPClient *) find->data;
 
+  /* already being removed by another thread */
+  if (client->refcount == 0)
+    goto not_found;
+
   GST_DEBUG_OBJECT (sink, "found %d clients with host %s, port %d",
       client->refcount, host, port);
 
@@ -1358,16 +2027,32 @@ gst_multiudpsink_remove (GstMultiUDPSink * sink, const gchar * host, gint port)
       }
     }
 
-    /* Unlock to emit signal before we delete the actual client */
+    /* Unlock to emit the signal while the client can still be found, so
+     * that get-stats from the handler returns its final statistics */
+    client_ref (client);
     g_mutex_unlock (&sink->client_lock);
     g_signal_emit (G_OBJECT (sink),
         gst_multiudpsink_signals[SIGNAL_CLIENT_REMOVED], 0, host, port);
     g_mutex_lock (&sink->client_lock);
 
-    sink->clients = g_list_delete_link (sink->clients, find);
+    /* the client could have been added again or cleared in the meantime */
+    find = g_hash_table_lookup (sink->client_index, client);
+    if (find && find->data == client && client->refcount == 0) {
+      g_hash_table_remove (sink->client_index, client);
+      sink->clients = g_list_delete_link (sink->clients, find);
+      gst_multiudpsink_publish_clients (sink);
+      g_mutex_unlock (&sink->client_lock);
 
-    free_client (client);
+      /* the streaming thread might still use it from an older snapshot, this
+       * only drops the reference of the client table */
+      client_unref (client);
+    } else {
+      g_mutex_unlock (&sink->client_lock);
+    }
+    client_unref (client);
+    return;
   }
+  gst_multiudpsink_publish_clients (sink);
   g_mutex_unlock (&sink->client_lock);
 
   return;
@@ -1390,9 +2075,11 @@ gst_multiudpsink_clear_internal (GstMultiUDPSink * sink, gboolean lock)
    * socket or anything to free for UDP */
   if (lock)
     g_mutex_lock (&sink->client_lock);
-  g_list_foreach (sink->clients, (GFunc) free_client, sink);
+  g_hash_table_remove_all (sink->client_index);
+  g_list_foreach (sink->clients, (GFunc) client_unref, NULL);
   g_list_free (sink->clients);
   sink->clients = NULL;
+  gst_multiudpsink_publish_clients (sink);
   if (lock)
     g_mutex_unlock (&sink->client_lock);
 }
@@ -1417,8 +2104,7 @@ gst_multiudpsink_get_stats (GstMultiUDPSink * sink, const gchar * host,
 
   g_mutex_lock (&sink->client_lock);
 
-  find = g_list_find_custom (sink->clients, &udpclient,
-      (GCompareFunc) client_compare);
+  find = g_hash_table_lookup (sink->client_index, &udpclient);
   if (!find)
     goto not_found;
 
@@ -1428,11 +2114,15 @@ gst_multiudpsink_get_stats (GstMultiUDPSink * sink, const gchar * host,
 
   result = gst_structure_new_empty ("multiudpsink-stats");
 
+  g_mutex_lock (&sink->stats_lock);
   gst_structure_set (result,
       "bytes-sent", G_TYPE_UINT64, client->bytes_sent,
       "packets-sent", G_TYPE_UINT64, client->packets_sent,
       "connect-time", G_TYPE_UINT64, client->connect_time,
-      "disconnect-time", G_TYPE_UINT64, client->disconnect_time, NULL);
+      "disconnect-time", G_TYPE_UINT64, client->disconnect_time,
+      "gso-batches-sent", G_TYPE_UINT64, client->gso_batches_sent,
+      "gso-packets-sent", G_TYPE_UINT64, client->gso_packets_sent, NULL);
+  g_mutex_unlock (&sink->stats_lock);
 
   g_mutex_unlock (&sink->client_lock);
 
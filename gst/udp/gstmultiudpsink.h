@@ -38,19 +38,30 @@ typedef struct _GstMultiUDPSink GstMultiUDPSink;
 typedef struct _GstMultiUDPSinkClass GstMultiUDPSinkClass;
 
 typedef struct {
+  /* number of times the client was added */
   gint refcount;
+  /* references held by the client table and the client snapshots */
+  volatile gint ref;
 
   GSocketAddress *addr;
   gchar *host;
   gint port;
 
-  /* Per-client stats */
+  /* native address, cached for sendmmsg() */
+  gpointer native_addr;
+  guint native_addrlen;
+
+  /* Per-client stats, the counters are protected by the stats_lock */
   guint64 bytes_sent;
   guint64 packets_sent;
+  guint64 gso_batches_sent;
+  guint64 gso_packets_sent;
   guint64 connect_time;
   guint64 disconnect_time;
 } GstUDPClient;
 
+typedef struct _GstUDPClientList GstUDPClientList;
+
 /* sends udp packets to multiple host/port pairs.
  */
 struct _GstMultiUDPSink {
@@ -61,10 +72,36 @@ struct _GstMultiUDPSink {
 
   GMutex         client_lock;
   GList         *clients;
+  /* GstUDPClient -> GList link in clients, protected by client_lock */
+  GHashTable    *client_index;
+
+  /* immutable snapshot of clients used by the streaming thread, replaced
+   * whenever the clients change. client_list_lock is only held to swap or
+   * ref the snapshot, never while sending or emitting signals */
+  GMutex            client_list_lock;
+  GstUDPClientList *client_list;
 
   GOutputVector *vec;
   GstMapInfo *map;
 
+  /* batched sending with sendmmsg(), the msg_ arrays hold
+   * MULTIUDPSINK_MAX_BATCH entries, iov and map hold n_vec entries */
+  gpointer       msgs;
+  GstUDPClient **msg_clients;
+  guint         *msg_segments;
+  gsize         *msg_seg_size;
+  gpointer       msg_control;
+  gpointer       iov;
+  guint          n_vec;
+  gpointer       buf_info;
+  guint          n_buf_info;
+  gboolean       gso_failed;
+  gboolean       sendmmsg_failed;
+
+  /* protects the byte counters below and the counters of the clients, the
+   * streaming thread takes it without the client_lock */
+  GMutex         stats_lock;
+
   /* properties */
   guint64        bytes_to_serve;
   guint64        bytes_served;
@@ -85,6 +122,7 @@ struct _GstMultiUDPSink {
   gint           buffer_size;
   gchar         *bind_address;
   gint           bind_port;
+  gboolean       enable_gso;
 };
 
 struct _GstMultiUDPSinkClass {
@@ -79,6 +79,25 @@
  * The message is typically used to detect that no UDP arrives in the receiver
  * because it is blocked by a firewall.
  *
+ * When the #GstUDPSrc:batch-size property is set to a value bigger than 1 and
+ * the platform provides recvmmsg(), udpsrc reads up to that many datagrams
+ * with a single system call whenever the socket becomes readable. Every
+ * datagram is received in its own buffer from a pool that is allocated up
+ * front, so buffers that are kept downstream do not hold on to the rest of
+ * the batch and return to the pool when they are freed. The batch size is
+ * applied when the socket is opened. On platforms without recvmmsg() the
+ * property has no effect and every datagram is read separately.
+ *
+ * By default the buffers are timestamped with the running time at which
+ * they are read from the socket, which includes the scheduling latency of the
+ * streaming thread. When the #GstUDPSrc:kernel-timestamps property is set,
+ * udpsrc asks the kernel for the arrival time of each datagram
+ * (SO_TIMESTAMPNS) and sets the DTS of the buffers to that time converted to
+ * running time, the PTS stays the time the datagram was read. rtpjitterbuffer
+ * uses the DTS as the arrival time, so its jitter and clock skew estimation
+ * reflects the network rather than the load of the machine. This is
+ * currently only supported on Linux.
+ *
  * A custom file descriptor can be configured with the
  * #GstUDPSrc:sockfd property. The socket will be closed when setting the
  * element to READY by default. This behaviour can be
@@ -107,6 +126,10 @@
 #include "config.h"
 #endif
 
+#ifndef _GNU_SOURCE
+# define _GNU_SOURCE            /* recvmmsg */
+#endif
+
 #include "gstudpsrc.h"
 
 #include <gst/net/gstnetaddressmeta.h>
@@ -130,6 +153,12 @@
 #endif
 #endif
 
+#include <errno.h>
+#include <string.h>
+#ifdef HAVE_SYS_SOCKET_H
+#include <sys/socket.h>
+#endif
+
 /* not 100% correct, but a good upper bound for memory allocation purposes */
 #define MAX_IPV4_UDP_PACKET_SIZE (65536 - 8)
 
@@ -154,6 +183,14 @@ static GstStaticPadTemplate src_template = GST_STATIC_PAD_TEMPLATE ("src",
 #define UDP_DEFAULT_USED_SOCKET        NULL
 #define UDP_DEFAULT_AUTO_MULTICAST     TRUE
 #define UDP_DEFAULT_REUSE              TRUE
+#define UDP_DEFAULT_BATCH_SIZE         1
+#define UDP_DEFAULT_KERNEL_TIMESTAMPS  FALSE
+
+/* maximum number of datagrams read with one recvmmsg() call */
+#define UDP_MAX_BATCH_SIZE             1024
+/* initial size of one datagram slot in a batch, grown when bigger
+ * datagrams are seen */
+#define UDP_BATCH_SLOT_SIZE            1500
 
 enum
 {
@@ -173,6 +210,8 @@ enum
   PROP_AUTO_MULTICAST,
   PROP_REUSE,
   PROP_ADDRESS,
+  PROP_BATCH_SIZE,
+  PROP_KERNEL_TIMESTAMPS,
 
   PROP_LAST
 };
@@ -182,6 +221,7 @@ static void gst_udpsrc_uri_handler_init (gpointer g_iface, gpointer iface_data);
 static GstCaps *gst_udpsrc_getcaps (GstBaseSrc * src, GstCaps * filter);
 static GstFlowReturn gst_udpsrc_create (GstPushSrc * psrc, GstBuffer ** buf);
 static gboolean gst_udpsrc_close (GstUDPSrc * src);
+static void gst_udpsrc_batch_free (GstUDPSrc * src);
 static gboolean gst_udpsrc_unlock (GstBaseSrc * bsrc);
 static gboolean gst_udpsrc_unlock_stop (GstBaseSrc * bsrc);
 
@@ -281,6 +321,18 @@ gst_udpsrc_class_init (GstUDPSrcClass * klass)
           "Address to receive packets for. This is equivalent to the "
           "multicast-group property for now", UDP_DEFAULT_MULTICAST_GROUP,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_BATCH_SIZE,
+      g_param_spec_uint ("batch-size", "Batch Size",
+          "Maximum number of datagrams to read per wakeup using recvmmsg "
+          "(1 = read one datagram at a time)", 1, UDP_MAX_BATCH_SIZE,
+          UDP_DEFAULT_BATCH_SIZE, G_PARAM_READWRITE | GST_PARAM_MUTABLE_READY |
+          G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_KERNEL_TIMESTAMPS,
+      g_param_spec_boolean ("kernel-timestamps", "Kernel Timestamps",
+          "Set the DTS of buffers to the time the kernel received the "
+          "datagram instead of the time it was read (Linux only)",
+          UDP_DEFAULT_KERNEL_TIMESTAMPS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
   gst_element_class_add_pad_template (gstelement_class,
       gst_static_pad_template_get (&src_template));
@@ -319,6 +371,9 @@ gst_udpsrc_init (GstUDPSrc * udpsrc)
   udpsrc->auto_multicast = UDP_DEFAULT_AUTO_MULTICAST;
   udpsrc->used_socket = UDP_DEFAULT_USED_SOCKET;
   udpsrc->reuse = UDP_DEFAULT_REUSE;
+  udpsrc->batch_size = UDP_DEFAULT_BATCH_SIZE;
+  udpsrc->batch_slot_size = UDP_BATCH_SLOT_SIZE;
+  udpsrc->kernel_timestamps = UDP_DEFAULT_KERNEL_TIMESTAMPS;
 
   udpsrc->cancellable = g_cancellable_new ();
 
@@ -363,6 +418,8 @@ gst_udpsrc_finalize (GObject * object)
     g_object_unref (udpsrc->cancellable);
   udpsrc->cancellable = NULL;
 
+  gst_udpsrc_batch_free (udpsrc);
+
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
@@ -392,28 +449,14 @@ gst_udpsrc_getcaps (GstBaseSrc * src, GstCaps * filter)
   return result;
 }
 
+/* wait until the socket becomes readable, posting a timeout message every
+ * time the configured timeout expires */
 static GstFlowReturn
-gst_udpsrc_create (GstPushSrc * psrc, GstBuffer ** buf)
+gst_udpsrc_wait (GstUDPSrc * udpsrc)
 {
-  GstFlowReturn ret;
-  GstUDPSrc *udpsrc;
-  GstBuffer *outbuf = NULL;
-  GstMapInfo info;
-  GSocketAddress *saddr = NULL;
-  gsize offset;
-  gssize readsize;
-  gssize res;
   gboolean try_again;
   GError *err = NULL;
 
-  udpsrc = GST_UDPSRC_CAST (psrc);
-
-retry:
-  /* quick check, avoid going in select when we already have data */
-  readsize = g_socket_get_available_bytes (udpsrc->used_socket);
-  if (readsize > 0)
-    goto no_select;
-
   do {
     gint64 timeout;
 
@@ -446,6 +489,564 @@ retry:
     }
   } while (G_UNLIKELY (try_again));
 
+  return GST_FLOW_OK;
+
+  /* ERRORS */
+select_error:
+  {
+    GST_ELEMENT_ERROR (udpsrc, RESOURCE, READ, (NULL),
+        ("select error: %s", err->message));
+    g_clear_error (&err);
+    return GST_FLOW_ERROR;
+  }
+stopped:
+  {
+    GST_DEBUG ("stop called");
+    g_clear_error (&err);
+    return GST_FLOW_FLUSHING;
+  }
+}
+
+#ifdef SO_TIMESTAMPNS
+/* get the offset to add to a system real time to get the running time of
+ * the element. Returns FALSE when there is no clock yet. */
+static gboolean
+gst_udpsrc_get_real_time_offset (GstUDPSrc * udpsrc, GstClockTimeDiff * offset)
+{
+  GstClock *clock;
+  GstClockTime base_time, now;
+  GstClockTime real_now;
+
+  GST_OBJECT_LOCK (udpsrc);
+  if ((clock = GST_ELEMENT_CLOCK (udpsrc)))
+    gst_object_ref (clock);
+  base_time = GST_ELEMENT_CAST (udpsrc)->base_time;
+  GST_OBJECT_UNLOCK (udpsrc);
+
+  if (clock == NULL)
+    return FALSE;
+
+  now = gst_clock_get_time (clock);
+  real_now = g_get_real_time () * GST_USECOND;
+  gst_object_unref (clock);
+
+  *offset = GST_CLOCK_DIFF (real_now, now) - base_time;
+
+  return TRUE;
+}
+
+/* get the kernel receive time of a datagram from its control messages */
+static GstClockTime
+gst_udpsrc_get_kernel_timestamp (struct msghdr *msg)
+{
+  struct cmsghdr *cmsg;
+
+  for (cmsg = CMSG_FIRSTHDR (msg); cmsg; cmsg = CMSG_NXTHDR (msg, cmsg)) {
+    if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_TIMESTAMPNS) {
+      struct timespec ts;
+
+      memcpy (&ts, CMSG_DATA (cmsg), sizeof (ts));
+      return GST_TIMESPEC_TO_TIME (ts);
+    }
+  }
+  return GST_CLOCK_TIME_NONE;
+}
+
+/* set the DTS of @buffer to the running time at which the kernel received
+ * it, basesrc sets the PTS to the time it was read */
+static void
+gst_udpsrc_set_arrival_time (GstUDPSrc * udpsrc, GstBuffer * buffer,
+    GstClockTime kernel_ts, GstClockTimeDiff offset)
+{
+  GstClockTimeDiff running_time;
+
+  if (!GST_CLOCK_TIME_IS_VALID (kernel_ts))
+    return;
+
+  running_time = MAX ((GstClockTimeDiff) kernel_ts + offset, 0);
+
+  GST_LOG_OBJECT (udpsrc, "kernel arrival time %" GST_TIME_FORMAT,
+      GST_TIME_ARGS (running_time));
+
+  GST_BUFFER_DTS (buffer) = running_time;
+}
+
+/* like g_socket_receive_from() on a readable socket, but also retrieves the
+ * kernel receive time of the datagram */
+static gssize
+gst_udpsrc_receive_timestamped (GstUDPSrc * udpsrc, GSocketAddress ** saddr,
+    guint8 * data, gsize size, GstClockTime * kernel_ts, GError ** err)
+{
+  struct sockaddr_storage addr;
+  guint8 control[CMSG_SPACE (sizeof (struct timespec))];
+  struct iovec iov;
+  struct msghdr msg;
+  gssize res;
+  gint errnum;
+
+  iov.iov_base = data;
+  iov.iov_len = size;
+
+  memset (&msg, 0, sizeof (msg));
+  msg.msg_name = &addr;
+  msg.msg_namelen = sizeof (addr);
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control;
+  msg.msg_controllen = sizeof (control);
+
+  do {
+    res = recvmsg (g_socket_get_fd (udpsrc->used_socket), &msg, MSG_DONTWAIT);
+    errnum = errno;
+  } while (G_UNLIKELY (res < 0 && errnum == EINTR));
+
+  if (G_UNLIKELY (res < 0)) {
+    g_set_error (err, G_IO_ERROR, g_io_error_from_errno (errnum),
+        "Error receiving message: %s", g_strerror (errnum));
+    return -1;
+  }
+
+  if (msg.msg_namelen > 0)
+    *saddr = g_socket_address_new_from_native (&addr, msg.msg_namelen);
+  *kernel_ts = gst_udpsrc_get_kernel_timestamp (&msg);
+
+  return res;
+}
+#endif
+
+static void
+gst_udpsrc_batch_flush (GstUDPSrc * udpsrc)
+{
+  while (udpsrc->batch_pos < udpsrc->batch_len)
+    gst_buffer_unref (udpsrc->batch[udpsrc->batch_pos++]);
+
+  udpsrc->batch_pos = udpsrc->batch_len = 0;
+}
+
+#ifdef HAVE_RECVMMSG
+static void
+gst_udpsrc_batch_setup (GstUDPSrc * udpsrc)
+{
+  guint n_slots;
+
+  /* the arrays are sized for the batch-size at the time the socket is
+   * opened, later changes of the property only apply after a reopen */
+  GST_OBJECT_LOCK (udpsrc);
+  n_slots = udpsrc->batch_size;
+  GST_OBJECT_UNLOCK (udpsrc);
+
+  if (n_slots <= 1)
+    return;
+
+  GST_DEBUG_OBJECT (udpsrc, "reading up to %u datagrams per batch", n_slots);
+
+  udpsrc->batch_allocated = n_slots;
+  udpsrc->batch_msgs = g_new0 (struct mmsghdr, n_slots);
+  /* one vector for the slot and one for the shared spill area */
+  udpsrc->batch_iov = g_new0 (struct iovec, 2 * n_slots);
+  udpsrc->batch_addrs = g_new0 (struct sockaddr_storage, n_slots);
+#ifdef SO_TIMESTAMPNS
+  if (udpsrc->kernel_ts_enabled)
+    udpsrc->batch_control = g_malloc0 (n_slots *
+        CMSG_SPACE (sizeof (struct timespec)));
+#endif
+  udpsrc->batch_slots = g_new0 (GstBuffer *, n_slots);
+  udpsrc->batch_maps = g_new0 (GstMapInfo, n_slots);
+  /* the spill area is shared by all slots and only touched by datagrams
+   * that are bigger than their slot, after which the slots are grown */
+  if (udpsrc->batch_slot_size < MAX_IPV4_UDP_PACKET_SIZE)
+    udpsrc->batch_spill = g_malloc (MAX_IPV4_UDP_PACKET_SIZE);
+  udpsrc->batch = g_new0 (GstBuffer *, n_slots);
+  udpsrc->batch_pos = udpsrc->batch_len = 0;
+}
+#endif
+
+/* give the buffers of the slots back to the pool and drop the pool, buffers
+ * that are still used downstream are freed when they are released */
+static void
+gst_udpsrc_batch_free_pool (GstUDPSrc * udpsrc)
+{
+  guint i;
+
+  if (udpsrc->batch_slots) {
+    for (i = 0; i < udpsrc->batch_allocated; i++) {
+      if (udpsrc->batch_slots[i]) {
+        gst_buffer_unmap (udpsrc->batch_slots[i], &udpsrc->batch_maps[i]);
+        gst_buffer_unref (udpsrc->batch_slots[i]);
+        udpsrc->batch_slots[i] = NULL;
+      }
+    }
+  }
+  if (udpsrc->batch_pool) {
+    gst_buffer_pool_set_active (udpsrc->batch_pool, FALSE);
+    gst_object_unref (udpsrc->batch_pool);
+    udpsrc->batch_pool = NULL;
+  }
+}
+
+static void
+gst_udpsrc_batch_free (GstUDPSrc * udpsrc)
+{
+  gst_udpsrc_batch_flush (udpsrc);
+  gst_udpsrc_batch_free_pool (udpsrc);
+
+  g_free (udpsrc->batch_slots);
+  udpsrc->batch_slots = NULL;
+  g_free (udpsrc->batch_maps);
+  udpsrc->batch_maps = NULL;
+  g_free (udpsrc->batch_spill);
+  udpsrc->batch_spill = NULL;
+  g_free (udpsrc->batch_msgs);
+  udpsrc->batch_msgs = NULL;
+  g_free (udpsrc->batch_iov);
+  udpsrc->batch_iov = NULL;
+  g_free (udpsrc->batch_addrs);
+  udpsrc->batch_addrs = NULL;
+  g_free (udpsrc->batch_control);
+  udpsrc->batch_control = NULL;
+  g_free (udpsrc->batch);
+  udpsrc->batch = NULL;
+  udpsrc->batch_allocated = 0;
+}
+
+#ifdef HAVE_RECVMMSG
+/* make the pool of slot buffers of the current slot size, with a buffer
+ * for every slot allocated up front */
+static gboolean
+gst_udpsrc_batch_setup_pool (GstUDPSrc * udpsrc)
+{
+  GstBufferPool *pool;
+  GstStructure *config;
+  GstAllocator *allocator;
+  GstAllocationParams params;
+
+  gst_base_src_get_allocator (GST_BASE_SRC_CAST (udpsrc), &allocator, &params);
+
+  pool = gst_buffer_pool_new ();
+  config = gst_buffer_pool_get_config (pool);
+  gst_buffer_pool_config_set_params (config, NULL, udpsrc->batch_slot_size,
+      udpsrc->batch_allocated, 0);
+  gst_buffer_pool_config_set_allocator (config, allocator, &params);
+  if (allocator)
+    gst_object_unref (allocator);
+
+  if (!gst_buffer_pool_set_config (pool, config) ||
+      !gst_buffer_pool_set_active (pool, TRUE)) {
+    gst_object_unref (pool);
+    return FALSE;
+  }
+  udpsrc->batch_pool = pool;
+
+  return TRUE;
+}
+
+/* make sure every slot has a mapped buffer from the pool */
+static gboolean
+gst_udpsrc_batch_fill_slots (GstUDPSrc * udpsrc)
+{
+  guint i;
+
+  if (G_UNLIKELY (udpsrc->batch_pool == NULL) &&
+      !gst_udpsrc_batch_setup_pool (udpsrc))
+    return FALSE;
+
+  for (i = 0; i < udpsrc->batch_allocated; i++) {
+    GstBuffer *buf;
+    gsize offset;
+
+    if (udpsrc->batch_slots[i])
+      continue;
+
+    if (gst_buffer_pool_acquire_buffer (udpsrc->batch_pool, &buf,
+            NULL) != GST_FLOW_OK)
+      return FALSE;
+
+    /* undo the trimming of the datagram the buffer held before */
+    if (gst_buffer_get_sizes (buf, &offset, NULL) != udpsrc->batch_slot_size
+        || offset != 0)
+      gst_buffer_resize (buf, -(gssize) offset, udpsrc->batch_slot_size);
+
+    /* the slots stay mapped until they are handed out */
+    gst_buffer_map (buf, &udpsrc->batch_maps[i], GST_MAP_WRITE);
+    udpsrc->batch_slots[i] = buf;
+  }
+
+  return TRUE;
+}
+
+/* read up to batch-size datagrams with one recvmmsg() call. Every datagram
+ * is received in the pool buffer of its own slot, which is handed out and
+ * replaced for the next call, so a buffer that is kept downstream only
+ * holds on to its own datagram. The part of a datagram that does not fit in
+ * its slot is received in the spill area and the datagram is copied out, as
+ * are small datagrams once the slots were grown.
+ *
+ * Returns GST_FLOW_CUSTOM_SUCCESS when nothing could be read without
+ * blocking. */
+static GstFlowReturn
+gst_udpsrc_receive_batch (GstUDPSrc * udpsrc)
+{
+  struct mmsghdr *msgs = udpsrc->batch_msgs;
+  struct iovec *iov = udpsrc->batch_iov;
+  struct sockaddr_storage *addrs = udpsrc->batch_addrs;
+  GstMapInfo *maps = udpsrc->batch_maps;
+  guint i, n_slots, slot_size, max_len;
+  gint res, errnum, spilled;
+#ifdef SO_TIMESTAMPNS
+  GstClockTimeDiff ts_offset = 0;
+  gboolean have_offset = FALSE;
+#endif
+
+  n_slots = udpsrc->batch_allocated;
+  slot_size = udpsrc->batch_slot_size;
+
+  if (G_UNLIKELY (!gst_udpsrc_batch_fill_slots (udpsrc)))
+    goto alloc_failed;
+
+  for (i = 0; i < n_slots; i++) {
+    iov[2 * i].iov_base = maps[i].data;
+    iov[2 * i].iov_len = slot_size;
+
+    memset (&msgs[i].msg_hdr, 0, sizeof (struct msghdr));
+    msgs[i].msg_hdr.msg_name = &addrs[i];
+    msgs[i].msg_hdr.msg_namelen = sizeof (struct sockaddr_storage);
+    msgs[i].msg_hdr.msg_iov = &iov[2 * i];
+    msgs[i].msg_hdr.msg_iovlen = 1;
+    msgs[i].msg_len = 0;
+    if (udpsrc->batch_spill) {
+      iov[2 * i + 1].iov_base = udpsrc->batch_spill;
+      iov[2 * i + 1].iov_len = MAX_IPV4_UDP_PACKET_SIZE - slot_size;
+      msgs[i].msg_hdr.msg_iovlen = 2;
+    }
+#ifdef SO_TIMESTAMPNS
+    if (udpsrc->batch_control) {
+      msgs[i].msg_hdr.msg_control = (guint8 *) udpsrc->batch_control +
+          i * CMSG_SPACE (sizeof (struct timespec));
+      msgs[i].msg_hdr.msg_controllen = CMSG_SPACE (sizeof (struct timespec));
+    }
+#endif
+  }
+
+  /* MSG_TRUNC makes msg_len report the real size of truncated datagrams */
+  do {
+    res = recvmmsg (g_socket_get_fd (udpsrc->used_socket), msgs, n_slots,
+        MSG_DONTWAIT | MSG_TRUNC, NULL);
+    errnum = errno;
+  } while (G_UNLIKELY (res < 0 && errnum == EINTR));
+
+  if (G_UNLIKELY (res < 0))
+    goto receive_error;
+
+  GST_LOG_OBJECT (udpsrc, "read %d datagrams in one batch", res);
+
+#ifdef SO_TIMESTAMPNS
+  /* the offset between real time and running time is the same for the
+   * whole batch */
+  if (udpsrc->batch_control)
+    have_offset = gst_udpsrc_get_real_time_offset (udpsrc, &ts_offset);
+#endif
+
+  /* the spill area is shared, it holds the rest of the last datagram that
+   * did not fit in its slot */
+  max_len = 0;
+  spilled = -1;
+  for (i = 0; i < (guint) res; i++) {
+    max_len = MAX (max_len, msgs[i].msg_len);
+    if (msgs[i].msg_len > slot_size)
+      spilled = i;
+  }
+
+  for (i = 0; i < (guint) res; i++) {
+    GstBuffer *outbuf;
+    GSocketAddress *saddr;
+    gsize offset, len;
+
+    len = msgs[i].msg_len;
+
+    /* empty datagrams are ignored, like in the non-batched path */
+    if (G_UNLIKELY (len == 0))
+      continue;
+
+    /* only the last datagram that did not fit has the rest of its data in
+     * the spill area, the slots are grown below so this is rare */
+    if (G_UNLIKELY (len > slot_size && (udpsrc->batch_spill == NULL ||
+                i != (guint) spilled || len > MAX_IPV4_UDP_PACKET_SIZE))) {
+      GST_WARNING_OBJECT (udpsrc, "dropping truncated datagram of %"
+          G_GSIZE_FORMAT " bytes", len);
+      continue;
+    }
+
+    offset = 0;
+    if (G_UNLIKELY (udpsrc->skip_first_bytes != 0)) {
+      if (G_UNLIKELY (len < udpsrc->skip_first_bytes))
+        goto skip_error;
+
+      offset = udpsrc->skip_first_bytes;
+    }
+
+    if (G_UNLIKELY (len > slot_size) || G_UNLIKELY (len * 4 < slot_size &&
+            slot_size > UDP_BATCH_SLOT_SIZE)) {
+      GstMapInfo map;
+      gsize in_slot = MIN (len, slot_size);
+
+      /* copy out datagrams that did not fit in their slot and small ones
+       * that would hold on to a lot of unused memory in grown slots, the
+       * slot keeps its memory */
+      GST_LOG_OBJECT (udpsrc, "copying datagram of %" G_GSIZE_FORMAT
+          " bytes out of a slot of %u bytes", len, slot_size);
+      outbuf = gst_buffer_new_allocate (NULL, len, NULL);
+      gst_buffer_map (outbuf, &map, GST_MAP_WRITE);
+      memcpy (map.data, maps[i].data, in_slot);
+      if (len > in_slot)
+        memcpy (map.data + in_slot, udpsrc->batch_spill, len - in_slot);
+      gst_buffer_unmap (outbuf, &map);
+    } else {
+      outbuf = udpsrc->batch_slots[i];
+      gst_buffer_unmap (outbuf, &maps[i]);
+      udpsrc->batch_slots[i] = NULL;
+    }
+    gst_buffer_resize (outbuf, offset, len - offset);
+
+    /* use buffer metadata so receivers can also track the address */
+    saddr = g_socket_address_new_from_native (&addrs[i],
+        msgs[i].msg_hdr.msg_namelen);
+    if (saddr) {
+      gst_buffer_add_net_address_meta (outbuf, saddr);
+      g_object_unref (saddr);
+    }
+
+#ifdef SO_TIMESTAMPNS
+    if (have_offset)
+      gst_udpsrc_set_arrival_time (udpsrc, outbuf,
+          gst_udpsrc_get_kernel_timestamp (&msgs[i].msg_hdr), ts_offset);
+#endif
+
+    udpsrc->batch[udpsrc->batch_len++] = outbuf;
+  }
+
+  /* make the slots big enough for the largest datagram we have seen so far */
+  if (G_UNLIKELY (max_len > slot_size)) {
+    udpsrc->batch_slot_size = MIN (max_len, MAX_IPV4_UDP_PACKET_SIZE);
+    GST_DEBUG_OBJECT (udpsrc, "growing batch slots to %u bytes",
+        udpsrc->batch_slot_size);
+
+    /* the next call makes a new pool with bigger buffers */
+    gst_udpsrc_batch_free_pool (udpsrc);
+
+    if (udpsrc->batch_slot_size == MAX_IPV4_UDP_PACKET_SIZE) {
+      g_free (udpsrc->batch_spill);
+      udpsrc->batch_spill = NULL;
+    }
+  }
+
+  return GST_FLOW_OK;
+
+  /* ERRORS */
+alloc_failed:
+  {
+    GST_ELEMENT_ERROR (udpsrc, RESOURCE, READ, (NULL),
+        ("failed to allocate %u bytes for a batch slot", slot_size));
+    return GST_FLOW_ERROR;
+  }
+receive_error:
+  {
+    if (errnum == EAGAIN || errnum == EWOULDBLOCK)
+      return GST_FLOW_CUSTOM_SUCCESS;
+
+    /* EHOSTUNREACH for a UDP socket means that a packet sent with udpsink
+     * generated a "port unreachable" ICMP response. We ignore that and try
+     * again. */
+    if (errnum == EHOSTUNREACH || errnum == ECONNREFUSED)
+      return GST_FLOW_OK;
+
+    if (errnum == ENOSYS) {
+      GST_WARNING_OBJECT (udpsrc, "recvmmsg not supported, falling back to "
+          "reading one datagram at a time");
+      gst_udpsrc_batch_free (udpsrc);
+      return GST_FLOW_OK;
+    }
+
+    GST_ELEMENT_ERROR (udpsrc, RESOURCE, READ, (NULL),
+        ("receive error %d: %s", errnum, g_strerror (errnum)));
+    return GST_FLOW_ERROR;
+  }
+skip_error:
+  {
+    GST_ELEMENT_ERROR (udpsrc, STREAM, DECODE, (NULL),
+        ("UDP buffer to small to skip header"));
+    return GST_FLOW_ERROR;
+  }
+}
+
+static GstFlowReturn
+gst_udpsrc_create_batched (GstUDPSrc * udpsrc, GstBuffer ** buf)
+{
+  GstFlowReturn ret;
+
+  while (udpsrc->batch_pos == udpsrc->batch_len) {
+    udpsrc->batch_pos = udpsrc->batch_len = 0;
+
+    /* try to read without waiting first, under load there is almost always
+     * something queued in the socket */
+    ret = gst_udpsrc_receive_batch (udpsrc);
+    if (ret == GST_FLOW_CUSTOM_SUCCESS) {
+      ret = gst_udpsrc_wait (udpsrc);
+      if (G_UNLIKELY (ret != GST_FLOW_OK))
+        return ret;
+    } else if (G_UNLIKELY (ret != GST_FLOW_OK)) {
+      gst_udpsrc_batch_flush (udpsrc);
+      return ret;
+    }
+
+    /* recvmmsg turned out to be unavailable */
+    if (G_UNLIKELY (udpsrc->batch_msgs == NULL))
+      return gst_udpsrc_create (GST_PUSH_SRC_CAST (udpsrc), buf);
+  }
+
+  *buf = udpsrc->batch[udpsrc->batch_pos];
+  udpsrc->batch[udpsrc->batch_pos++] = NULL;
+
+  GST_LOG_OBJECT (udpsrc, "returning buffer of %" G_GSIZE_FORMAT " bytes, "
+      "%u left in batch", gst_buffer_get_size (*buf),
+      udpsrc->batch_len - udpsrc->batch_pos);
+
+  return GST_FLOW_OK;
+}
+#endif
+
+static GstFlowReturn
+gst_udpsrc_create (GstPushSrc * psrc, GstBuffer ** buf)
+{
+  GstFlowReturn ret;
+  GstUDPSrc *udpsrc;
+  GstBuffer *outbuf = NULL;
+  GstMapInfo info;
+  GSocketAddress *saddr = NULL;
+  gsize offset;
+  gssize readsize;
+  gssize res;
+  GError *err = NULL;
+#ifdef SO_TIMESTAMPNS
+  GstClockTime kernel_ts = GST_CLOCK_TIME_NONE;
+#endif
+
+  udpsrc = GST_UDPSRC_CAST (psrc);
+
+#ifdef HAVE_RECVMMSG
+  if (udpsrc->batch_msgs != NULL)
+    return gst_udpsrc_create_batched (udpsrc, buf);
+#endif
+
+retry:
+  /* quick check, avoid going in select when we already have data */
+  readsize = g_socket_get_available_bytes (udpsrc->used_socket);
+  if (readsize > 0)
+    goto no_select;
+
+  ret = gst_udpsrc_wait (udpsrc);
+  if (G_UNLIKELY (ret != GST_FLOW_OK))
+    return ret;
+
   /* ask how much is available for reading on the socket, this should be exactly
    * one UDP packet. We will check the return value, though, because in some
    * case it can return 0 and we don't want a 0 sized buffer. */
@@ -491,15 +1092,22 @@ no_select:
     g_object_unref (saddr);
   saddr = NULL;
 
-  res =
-      g_socket_receive_from (udpsrc->used_socket, &saddr, (gchar *) info.data,
-      info.size, udpsrc->cancellable, &err);
+#ifdef SO_TIMESTAMPNS
+  if (udpsrc->kernel_ts_enabled)
+    res = gst_udpsrc_receive_timestamped (udpsrc, &saddr, info.data,
+        info.size, &kernel_ts, &err);
+  else
+#endif
+    res =
+        g_socket_receive_from (udpsrc->used_socket, &saddr, (gchar *) info.data,
+        info.size, udpsrc->cancellable, &err);
 
   if (G_UNLIKELY (res < 0)) {
     /* EHOSTUNREACH for a UDP socket means that a packet sent with udpsink
      * generated a "port unreachable" ICMP response. We ignore that and try
-     * again. */
-    if (g_error_matches (err, G_IO_ERROR, G_IO_ERROR_HOST_UNREACHABLE)) {
+     * again. The raw receive path can also see spurious wakeups. */
+    if (g_error_matches (err, G_IO_ERROR, G_IO_ERROR_HOST_UNREACHABLE)
+        || g_error_matches (err, G_IO_ERROR, G_IO_ERROR_WOULD_BLOCK)) {
       gst_buffer_unmap (outbuf, &info);
       gst_buffer_unref (outbuf);
       outbuf = NULL;
@@ -528,6 +1136,15 @@ no_select:
   }
   saddr = NULL;
 
+#ifdef SO_TIMESTAMPNS
+  if (GST_CLOCK_TIME_IS_VALID (kernel_ts)) {
+    GstClockTimeDiff ts_offset;
+
+    if (gst_udpsrc_get_real_time_offset (udpsrc, &ts_offset))
+      gst_udpsrc_set_arrival_time (udpsrc, outbuf, kernel_ts, ts_offset);
+  }
+#endif
+
   GST_LOG_OBJECT (udpsrc, "read %d bytes", (int) readsize);
 
   *buf = GST_BUFFER_CAST (outbuf);
@@ -535,19 +1152,6 @@ no_select:
   return ret;
 
   /* ERRORS */
-select_error:
-  {
-    GST_ELEMENT_ERROR (udpsrc, RESOURCE, READ, (NULL),
-        ("select error: %s", err->message));
-    g_clear_error (&err);
-    return GST_FLOW_ERROR;
-  }
-stopped:
-  {
-    GST_DEBUG ("stop called");
-    g_clear_error (&err);
-    return GST_FLOW_FLUSHING;
-  }
 get_available_error:
   {
     GST_ELEMENT_ERROR (udpsrc, RESOURCE, READ, (NULL),
@@ -716,6 +1320,14 @@ gst_udpsrc_set_property (GObject * object, guint prop_id, const GValue * value,
     case PROP_REUSE:
       udpsrc->reuse = g_value_get_boolean (value);
       break;
+    case PROP_BATCH_SIZE:
+      GST_OBJECT_LOCK (udpsrc);
+      udpsrc->batch_size = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (udpsrc);
+      break;
+    case PROP_KERNEL_TIMESTAMPS:
+      udpsrc->kernel_timestamps = g_value_get_boolean (value);
+      break;
     default:
       break;
   }
@@ -770,6 +1382,12 @@ gst_udpsrc_get_property (GObject * object, guint prop_id, GValue * value,
     case PROP_REUSE:
       g_value_set_boolean (value, udpsrc->reuse);
       break;
+    case PROP_BATCH_SIZE:
+      g_value_set_uint (value, udpsrc->batch_size);
+      break;
+    case PROP_KERNEL_TIMESTAMPS:
+      g_value_set_boolean (value, udpsrc->kernel_timestamps);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -999,6 +1617,28 @@ gst_udpsrc_open (GstUDPSrc * src)
     g_object_unref (addr);
   }
 
+  src->kernel_ts_enabled = FALSE;
+  if (src->kernel_timestamps) {
+#ifdef SO_TIMESTAMPNS
+    gint on = 1;
+
+    if (setsockopt (g_socket_get_fd (src->used_socket), SOL_SOCKET,
+            SO_TIMESTAMPNS, &on, sizeof (on)) == 0) {
+      GST_DEBUG_OBJECT (src, "enabled kernel receive timestamps");
+      src->kernel_ts_enabled = TRUE;
+    } else {
+      GST_ELEMENT_WARNING (src, RESOURCE, SETTINGS, (NULL),
+          ("Could not enable kernel timestamps: %s", g_strerror (errno)));
+    }
+#else
+    GST_WARNING_OBJECT (src, "kernel timestamps are not supported on this "
+        "platform");
+#endif
+  }
+#ifdef HAVE_RECVMMSG
+  gst_udpsrc_batch_setup (src);
+#endif
+
   return TRUE;
 
   /* ERRORS */
@@ -1063,6 +1703,7 @@ gst_udpsrc_unlock_stop (GstBaseSrc * bsrc)
 
   GST_LOG_OBJECT (src, "No longer flushing");
   g_cancellable_reset (src->cancellable);
+  gst_udpsrc_batch_flush (src);
 
   return TRUE;
 }
@@ -1104,6 +1745,8 @@ gst_udpsrc_close (GstUDPSrc * src)
     src->addr = NULL;
   }
 
+  gst_udpsrc_batch_free (src);
+
   return TRUE;
 }
 
@@ -60,12 +60,36 @@ struct _GstUDPSrc {
   gboolean   close_socket;
   gboolean   auto_multicast;
   gboolean   reuse;
+  guint      batch_size;
+  gboolean   kernel_timestamps;
 
   /* our sockets */
   GSocket   *used_socket;
   GCancellable *cancellable;
   GInetSocketAddress *addr;
   gboolean   external_socket;
+  gboolean   kernel_ts_enabled;
+
+  /* batched receive state, the message arrays are only allocated when
+   * batch_size > 1 and recvmmsg() is available. batch_allocated is the
+   * number of slots they were allocated for. */
+  guint      batch_allocated;
+  gpointer   batch_msgs;
+  gpointer   batch_iov;
+  gpointer   batch_addrs;
+  gpointer   batch_control;
+  guint      batch_slot_size;
+  /* the pool of the slot buffers, the buffer of every slot, handed out with
+   * the datagram it received, and its mapping */
+  GstBufferPool *batch_pool;
+  GstBuffer **batch_slots;
+  GstMapInfo *batch_maps;
+  /* receives the part of a datagram that did not fit in its slot, shared by
+   * all slots */
+  guint8    *batch_spill;
+  GstBuffer **batch;
+  guint      batch_len;
+  guint      batch_pos;
 
   gchar     *uri;
 };
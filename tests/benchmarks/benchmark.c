@@ -0,0 +1,142 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/*
+ * Setup and measurements shared by the benchmarks.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>
+
+#include "benchmark.h"
+
+#ifdef G_OS_UNIX
+#include <sys/resource.h>
+#endif
+
+/* allocation counting */
+static gint n_allocs;
+
+static gpointer
+counting_malloc (gsize n_bytes)
+{
+  g_atomic_int_inc (&n_allocs);
+  return malloc (n_bytes);
+}
+
+static gpointer
+counting_realloc (gpointer mem, gsize n_bytes)
+{
+  if (mem == NULL)
+    g_atomic_int_inc (&n_allocs);
+  return realloc (mem, n_bytes);
+}
+
+static gpointer
+counting_calloc (gsize n_blocks, gsize n_block_bytes)
+{
+  g_atomic_int_inc (&n_allocs);
+  return calloc (n_blocks, n_block_bytes);
+}
+
+static GMemVTable counting_vtable = {
+  counting_malloc,
+  counting_realloc,
+  free,
+  counting_calloc,
+  counting_malloc,
+  counting_realloc
+};
+
+/**
+ * benchmark_init:
+ * @argc: pointer to the number of arguments of main()
+ * @argv: pointer to the arguments of main()
+ * @summary: the text after the program name in --help
+ * @entries: the options of the benchmark
+ * @count_allocs: set to TRUE when the allocations can be counted, this needs
+ *   a GLib where g_mem_set_vtable() works (before 2.46)
+ *
+ * Installs the allocation counter and parses the options of the benchmark
+ * and of GStreamer, which initializes GStreamer. Must be called before
+ * anything else allocates memory.
+ *
+ * Returns: FALSE when the options could not be parsed
+ */
+gboolean
+benchmark_init (int *argc, char ***argv, const gchar * summary,
+    const GOptionEntry * entries, gboolean * count_allocs)
+{
+  GOptionContext *ctx;
+  GError *err = NULL;
+  gpointer mem;
+
+  G_GNUC_BEGIN_IGNORE_DEPRECATIONS;
+  g_mem_set_vtable (&counting_vtable);
+  G_GNUC_END_IGNORE_DEPRECATIONS;
+  /* count the slices as well */
+  g_setenv ("G_SLICE", "always-malloc", TRUE);
+
+  mem = g_malloc (1);
+  *count_allocs = g_atomic_int_get (&n_allocs) > 0;
+  g_free (mem);
+
+  ctx = g_option_context_new (summary);
+  g_option_context_add_main_entries (ctx, entries, NULL);
+  g_option_context_add_group (ctx, gst_init_get_option_group ());
+  if (!g_option_context_parse (ctx, argc, argv, &err)) {
+    g_printerr ("Error initializing: %s\n", err->message);
+    g_clear_error (&err);
+    g_option_context_free (ctx);
+    return FALSE;
+  }
+  g_option_context_free (ctx);
+
+  return TRUE;
+}
+
+void
+take_sample (Sample * sample)
+{
+#ifdef G_OS_UNIX
+  struct rusage usage;
+
+  getrusage (RUSAGE_SELF, &usage);
+  sample->csw = usage.ru_nvcsw;
+  sample->cpu = (gint64) (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) *
+      G_USEC_PER_SEC + usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+#else
+  sample->csw = 0;
+  sample->cpu = 0;
+#endif
+  sample->allocs = g_atomic_int_get (&n_allocs);
+  sample->time = g_get_monotonic_time ();
+}
+
+/* add the difference between @start and @end to @res */
+void
+sample_add_diff (Sample * res, const Sample * start, const Sample * end)
+{
+  res->time += end->time - start->time;
+  res->allocs += end->allocs - start->allocs;
+  res->csw += end->csw - start->csw;
+  res->cpu += end->cpu - start->cpu;
+}
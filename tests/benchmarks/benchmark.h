@@ -0,0 +1,48 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __BENCHMARK_H__
+#define __BENCHMARK_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+/* resource usage at a point in time */
+typedef struct
+{
+  /* monotonic time in microseconds */
+  gint64 time;
+  /* number of allocations */
+  gint allocs;
+  /* voluntary context switches */
+  glong csw;
+  /* user and system time of all threads in microseconds */
+  gint64 cpu;
+} Sample;
+
+gboolean benchmark_init (int *argc, char ***argv, const gchar * summary,
+    const GOptionEntry * entries, gboolean * count_allocs);
+
+void take_sample (Sample * sample);
+
+void sample_add_diff (Sample * res, const Sample * start, const Sample * end);
+
+G_END_DECLS
+
+#endif /* __BENCHMARK_H__ */
@@ -0,0 +1,675 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/*
+ * Measures the cost of the RTP depayloaders.
+ *
+ * For every payload type a stream of RTP packets is recorded once, then the
+ * packets are pushed from the main thread straight into the sinkpad of the
+ * depayloader and its output is consumed by a pad without any further
+ * processing.
+ *
+ * The packets are read from NAME.rtpdump, in the format of the rtpdump tool
+ * of rtptools, and NAME.caps, with the caps of the stream, in the directory
+ * given with --dump-dir. When there is no recording for a payload type, the
+ * packets are made by encoding a test stream with its payloader and are
+ * written to the directory. Payload types whose encoder is not available are
+ * skipped.
+ *
+ * For every depayloader it reports:
+ *  - the throughput in Mbit/s of RTP packets and the time per packet
+ *  - the CPU time per packet, user and system time of all threads, which
+ *    is more than the time per packet when the depayloader uses threads
+ *  - the number of output buffers, frames for most depayloaders
+ *  - the percentage of the output bytes that are not in the memory of the
+ *    input packets, the bytes that were copied or produced by the
+ *    depayloader
+ *  - the number of allocations per output buffer, this needs a GLib where
+ *    g_mem_set_vtable() works (before 2.46)
+ *
+ * The cost of copying the packets before they are pushed is measured in a
+ * separate pass and subtracted. Run from the build tree with:
+ *
+ *   GST_PLUGIN_PATH=gst tests/benchmarks/rtpdepay --only=h264,mp4v
+ *
+ * With --check, used by make check-rtpdepay, the program fails when a
+ * depayloader is missing, posts an error or produces no output.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+
+#include <gst/gst.h>
+#include <gst/app/gstappsink.h>
+
+#include "benchmark.h"
+
+static gint frames = 100;
+static gint iterations = 3;
+static gchar *dump_dir = NULL;
+static gchar *only = NULL;
+static gboolean check = FALSE;
+
+static GOptionEntry entries[] = {
+  {"frames", 'f', 0, G_OPTION_ARG_INT, &frames,
+      "Number of frames to encode for new recordings", "N"},
+  {"iterations", 'i', 0, G_OPTION_ARG_INT, &iterations,
+      "Number of times the packets are depayloaded", "N"},
+  {"dump-dir", 'd', 0, G_OPTION_ARG_FILENAME, &dump_dir,
+      "Directory with the NAME.rtpdump and NAME.caps recordings", "DIR"},
+  {"only", 'o', 0, G_OPTION_ARG_STRING, &only,
+      "Comma separated list of the payload types to run", "NAMES"},
+  {"check", 'c', 0, G_OPTION_ARG_NONE, &check,
+      "Fail when a depayloader does not work", NULL},
+  {NULL}
+};
+
+typedef struct
+{
+  const gchar *name;
+  /* the source element, num-buffers is set to the number of frames */
+  const gchar *source;
+  /* the caps filter and encoder after the source */
+  const gchar *encoder;
+  const gchar *payloader;
+  const gchar *depayloader;
+} Payload;
+
+static const Payload payloads[] = {
+  {"h264", "videotestsrc", "video/x-raw,width=640,height=480 ! "
+        "x264enc tune=zerolatency key-int-max=30", "rtph264pay",
+      "rtph264depay"},
+  {"h263", "videotestsrc", "video/x-raw,width=352,height=288 ! avenc_h263",
+      "rtph263pay", "rtph263depay"},
+  {"h263p", "videotestsrc", "video/x-raw,width=352,height=288 ! avenc_h263p",
+      "rtph263ppay", "rtph263pdepay"},
+  {"mp4v", "videotestsrc", "video/x-raw,width=640,height=480 ! avenc_mpeg4",
+      "rtpmp4vpay", "rtpmp4vdepay"},
+  {"theora", "videotestsrc", "video/x-raw,width=640,height=480 ! theoraenc",
+      "rtptheorapay", "rtptheoradepay"},
+  {"vp8", "videotestsrc", "video/x-raw,width=640,height=480 ! vp8enc",
+      "rtpvp8pay", "rtpvp8depay"},
+  {"jpeg", "videotestsrc", "video/x-raw,width=640,height=480 ! jpegenc",
+      "rtpjpegpay", "rtpjpegdepay"},
+  {"mp2t", "videotestsrc", "video/x-raw,width=640,height=480 ! "
+        "x264enc tune=zerolatency ! mpegtsmux", "rtpmp2tpay", "rtpmp2tdepay"},
+  {"vraw", "videotestsrc", "video/x-raw,format=UYVY,width=320,height=240",
+      "rtpvrawpay", "rtpvrawdepay"},
+  {"mp4g", "audiotestsrc", "faac", "rtpmp4gpay", "rtpmp4gdepay"},
+  {"mp4a", "audiotestsrc", "faac", "rtpmp4apay", "rtpmp4adepay"},
+  {"mpa", "audiotestsrc", "lamemp3enc", "rtpmpapay", "rtpmpadepay"},
+  {"vorbis", "audiotestsrc", "vorbisenc", "rtpvorbispay", "rtpvorbisdepay"},
+  {"speex", "audiotestsrc", "speexenc", "rtpspeexpay", "rtpspeexdepay"},
+  {"L16", "audiotestsrc", "audio/x-raw,format=S16BE,rate=44100,channels=2",
+      "rtpL16pay", "rtpL16depay"},
+  {"pcma", "audiotestsrc", "audio/x-raw,rate=8000 ! alawenc", "rtppcmapay",
+      "rtppcmadepay"},
+};
+
+/* recordings */
+typedef struct
+{
+  GstCaps *caps;
+  GPtrArray *packets;
+  guint64 bytes;
+} Recording;
+
+static void
+recording_init (Recording * rec)
+{
+  rec->caps = NULL;
+  rec->packets = g_ptr_array_new_with_free_func ((GDestroyNotify)
+      gst_buffer_unref);
+  rec->bytes = 0;
+}
+
+static void
+recording_clear (Recording * rec)
+{
+  if (rec->caps)
+    gst_caps_unref (rec->caps);
+  g_ptr_array_free (rec->packets, TRUE);
+}
+
+/* every packet is placed in its own memory so that the output of the
+ * depayloader can be traced back to the packets */
+static void
+recording_add (Recording * rec, const guint8 * data, gsize size,
+    GstClockTime pts)
+{
+  GstBuffer *buf;
+
+  buf = gst_buffer_new_wrapped (g_memdup (data, size), size);
+  GST_BUFFER_PTS (buf) = pts;
+  g_ptr_array_add (rec->packets, buf);
+  rec->bytes += size;
+}
+
+static GstFlowReturn
+on_new_sample (GstAppSink * sink, Recording * rec)
+{
+  GstSample *sample;
+  GstBuffer *buf;
+  GstMapInfo map;
+
+  sample = gst_app_sink_pull_sample (sink);
+  if (sample == NULL)
+    return GST_FLOW_EOS;
+
+  /* the last caps have the complete configuration of the stream */
+  gst_caps_replace (&rec->caps, gst_sample_get_caps (sample));
+
+  buf = gst_sample_get_buffer (sample);
+  gst_buffer_map (buf, &map, GST_MAP_READ);
+  recording_add (rec, map.data, map.size, GST_BUFFER_PTS (buf));
+  gst_buffer_unmap (buf, &map);
+  gst_sample_unref (sample);
+
+  return GST_FLOW_OK;
+}
+
+/* encode and payload a test stream. Returns FALSE when the pipeline failed,
+ * @missing is set when that was because an element is not available */
+static gboolean
+record_packets (const Payload * payload, Recording * rec, gboolean * missing)
+{
+  GstElement *pipeline, *sink;
+  GstBus *bus;
+  GstMessage *msg;
+  GError *err = NULL;
+  gchar *desc;
+  gboolean ret = TRUE;
+
+  *missing = FALSE;
+
+  desc = g_strdup_printf ("%s num-buffers=%d ! %s ! %s ! "
+      "appsink name=sink sync=false emit-signals=true", payload->source,
+      frames, payload->encoder, payload->payloader);
+  pipeline = gst_parse_launch (desc, &err);
+  g_free (desc);
+  if (err != NULL)
+    goto no_pipeline;
+
+  sink = gst_bin_get_by_name (GST_BIN (pipeline), "sink");
+  g_signal_connect (sink, "new-sample", G_CALLBACK (on_new_sample), rec);
+  gst_object_unref (sink);
+
+  gst_element_set_state (pipeline, GST_STATE_PLAYING);
+  bus = gst_element_get_bus (pipeline);
+  msg = gst_bus_timed_pop_filtered (bus, GST_CLOCK_TIME_NONE,
+      GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+  if (GST_MESSAGE_TYPE (msg) == GST_MESSAGE_ERROR) {
+    gst_message_parse_error (msg, &err, NULL);
+    g_printerr ("%s: recording failed: %s\n", payload->name, err->message);
+    g_clear_error (&err);
+    ret = FALSE;
+  }
+  gst_message_unref (msg);
+  gst_object_unref (bus);
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (pipeline);
+
+  if (ret && (rec->packets->len == 0 || rec->caps == NULL)) {
+    g_printerr ("%s: recording produced no packets\n", payload->name);
+    ret = FALSE;
+  }
+
+  return ret;
+
+  /* ERRORS */
+no_pipeline:
+  {
+    if (g_error_matches (err, GST_PARSE_ERROR,
+            GST_PARSE_ERROR_NO_SUCH_ELEMENT)) {
+      /* usually a missing encoder */
+      g_print ("%s: skipped, %s\n", payload->name, err->message);
+      *missing = TRUE;
+    } else {
+      g_printerr ("%s: invalid pipeline: %s\n", payload->name, err->message);
+    }
+    g_clear_error (&err);
+    if (pipeline)
+      gst_object_unref (pipeline);
+    return FALSE;
+  }
+}
+
+/* the rtpdump file header, followed by RD_hdr_t */
+#define RTPDUMP_HEADER "#!rtpplay1.0 127.0.0.1/5004\n"
+#define RTPDUMP_HEADER_SIZE 16
+/* RD_packet_t, before every packet */
+#define RTPDUMP_PACKET_SIZE 8
+
+/* load the packets from @dir, returns FALSE when there is no recording */
+static gboolean
+load_packets (const Payload * payload, const gchar * dir, Recording * rec)
+{
+  gchar *filename, *contents, *caps_str = NULL;
+  const guint8 *data, *nl;
+  gsize size;
+  GstClockTime start = GST_CLOCK_TIME_NONE;
+
+  filename = g_strdup_printf ("%s" G_DIR_SEPARATOR_S "%s.caps", dir,
+      payload->name);
+  g_file_get_contents (filename, &caps_str, NULL, NULL);
+  g_free (filename);
+  if (caps_str == NULL)
+    return FALSE;
+
+  rec->caps = gst_caps_from_string (g_strstrip (caps_str));
+  g_free (caps_str);
+  if (rec->caps == NULL)
+    goto invalid_caps;
+
+  filename = g_strdup_printf ("%s" G_DIR_SEPARATOR_S "%s.rtpdump", dir,
+      payload->name);
+  if (!g_file_get_contents (filename, &contents, &size, NULL)) {
+    g_free (filename);
+    return FALSE;
+  }
+  g_free (filename);
+
+  data = (const guint8 *) contents;
+  nl = memchr (data, '\n', size);
+  if (size < 12 || memcmp (data, "#!rtpplay1.0", 12) != 0 || nl == NULL ||
+      size - (nl + 1 - data) < RTPDUMP_HEADER_SIZE)
+    goto invalid_dump;
+
+  size -= nl + 1 - data + RTPDUMP_HEADER_SIZE;
+  data = nl + 1 + RTPDUMP_HEADER_SIZE;
+
+  while (size >= RTPDUMP_PACKET_SIZE) {
+    guint len, plen;
+    GstClockTime offset;
+
+    len = GST_READ_UINT16_BE (data);
+    plen = GST_READ_UINT16_BE (data + 2);
+    offset = GST_READ_UINT32_BE (data + 4) * GST_MSECOND;
+    if (len < RTPDUMP_PACKET_SIZE || len > size)
+      break;
+
+    /* a plen of 0 marks RTCP packets */
+    if (plen > 0) {
+      if (start == GST_CLOCK_TIME_NONE)
+        start = offset;
+      recording_add (rec, data + RTPDUMP_PACKET_SIZE,
+          len - RTPDUMP_PACKET_SIZE, offset > start ? offset - start : 0);
+    }
+    size -= len;
+    data += len;
+  }
+  g_free (contents);
+
+  return rec->packets->len > 0;
+
+  /* ERRORS */
+invalid_caps:
+  {
+    g_printerr ("%s: invalid caps in %s\n", payload->name, dir);
+    return FALSE;
+  }
+invalid_dump:
+  {
+    g_printerr ("%s: invalid rtpdump file in %s\n", payload->name, dir);
+    g_free (contents);
+    return FALSE;
+  }
+}
+
+static void
+save_packets (const Payload * payload, const gchar * dir, Recording * rec)
+{
+  GByteArray *dump;
+  gchar *filename, *caps_str;
+  guint8 header[RTPDUMP_HEADER_SIZE] = { 0, };
+  GstClockTime start;
+  guint i;
+
+  dump = g_byte_array_new ();
+  g_byte_array_append (dump, (const guint8 *) RTPDUMP_HEADER,
+      strlen (RTPDUMP_HEADER));
+  g_byte_array_append (dump, header, sizeof (header));
+
+  start = GST_BUFFER_PTS (g_ptr_array_index (rec->packets, 0));
+  for (i = 0; i < rec->packets->len; i++) {
+    GstBuffer *buf = g_ptr_array_index (rec->packets, i);
+    guint8 packet[RTPDUMP_PACKET_SIZE];
+    GstClockTime offset = 0;
+    GstMapInfo map;
+
+    gst_buffer_map (buf, &map, GST_MAP_READ);
+    if (map.size + RTPDUMP_PACKET_SIZE > G_MAXUINT16) {
+      gst_buffer_unmap (buf, &map);
+      continue;
+    }
+    if (GST_CLOCK_TIME_IS_VALID (start) &&
+        GST_BUFFER_PTS_IS_VALID (buf) && GST_BUFFER_PTS (buf) > start)
+      offset = GST_BUFFER_PTS (buf) - start;
+
+    GST_WRITE_UINT16_BE (packet, map.size + RTPDUMP_PACKET_SIZE);
+    GST_WRITE_UINT16_BE (packet + 2, map.size);
+    GST_WRITE_UINT32_BE (packet + 4, offset / GST_MSECOND);
+    g_byte_array_append (dump, packet, sizeof (packet));
+    g_byte_array_append (dump, map.data, map.size);
+    gst_buffer_unmap (buf, &map);
+  }
+
+  filename = g_strdup_printf ("%s" G_DIR_SEPARATOR_S "%s.rtpdump", dir,
+      payload->name);
+  if (!g_file_set_contents (filename, (const gchar *) dump->data, dump->len,
+          NULL))
+    g_printerr ("%s: could not write %s\n", payload->name, filename);
+  g_free (filename);
+  g_byte_array_free (dump, TRUE);
+
+  filename = g_strdup_printf ("%s" G_DIR_SEPARATOR_S "%s.caps", dir,
+      payload->name);
+  caps_str = gst_caps_to_string (rec->caps);
+  if (!g_file_set_contents (filename, caps_str, -1, NULL))
+    g_printerr ("%s: could not write %s\n", payload->name, filename);
+  g_free (caps_str);
+  g_free (filename);
+}
+
+/* output accounting */
+typedef struct
+{
+  /* the memory of the recorded packets */
+  GHashTable *inputs;
+  guint buffers;
+  guint64 bytes;
+  /* output bytes that are not in the memory of the packets */
+  guint64 copied;
+} Output;
+
+static Output output;
+
+static void
+account_buffer (GstBuffer * buf)
+{
+  guint i, n;
+
+  output.buffers++;
+
+  n = gst_buffer_n_memory (buf);
+  for (i = 0; i < n; i++) {
+    GstMemory *mem = gst_buffer_peek_memory (buf, i);
+    GstMemory *root = mem->parent ? mem->parent : mem;
+
+    output.bytes += mem->size;
+    if (!g_hash_table_contains (output.inputs, root))
+      output.copied += mem->size;
+  }
+}
+
+static GstFlowReturn
+sink_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
+{
+  account_buffer (buf);
+  gst_buffer_unref (buf);
+
+  return GST_FLOW_OK;
+}
+
+static GstFlowReturn
+sink_chain_list (GstPad * pad, GstObject * parent, GstBufferList * list)
+{
+  guint i, len;
+
+  len = gst_buffer_list_length (list);
+  for (i = 0; i < len; i++)
+    account_buffer (gst_buffer_list_get (list, i));
+  gst_buffer_list_unref (list);
+
+  return GST_FLOW_OK;
+}
+
+static gboolean
+sink_event (GstPad * pad, GstObject * parent, GstEvent * event)
+{
+  gst_event_unref (event);
+
+  return TRUE;
+}
+
+static void
+measure_copy (Recording * rec, Sample * res)
+{
+  Sample start, end;
+  guint i;
+
+  take_sample (&start);
+  for (i = 0; i < rec->packets->len; i++)
+    gst_buffer_unref (gst_buffer_copy (g_ptr_array_index (rec->packets, i)));
+  take_sample (&end);
+
+  sample_add_diff (res, &start, &end);
+}
+
+static gboolean
+measure_depayloader (const Payload * payload, Recording * rec, Sample * res)
+{
+  GstElement *depay;
+  GstPad *srcpad, *sinkpad, *depay_sink, *depay_src;
+  GstSegment segment;
+  GstBus *bus;
+  GstMessage *msg;
+  GstFlowReturn flow = GST_FLOW_OK;
+  Sample start, end;
+  gboolean ret = TRUE;
+  guint i;
+
+  depay = gst_element_factory_make (payload->depayloader, NULL);
+  bus = gst_bus_new ();
+  gst_element_set_bus (depay, bus);
+
+  srcpad = gst_pad_new ("src", GST_PAD_SRC);
+  sinkpad = gst_pad_new ("sink", GST_PAD_SINK);
+  gst_pad_set_chain_function (sinkpad, sink_chain);
+  gst_pad_set_chain_list_function (sinkpad, sink_chain_list);
+  gst_pad_set_event_function (sinkpad, sink_event);
+
+  depay_sink = gst_element_get_static_pad (depay, "sink");
+  depay_src = gst_element_get_static_pad (depay, "src");
+  gst_pad_link (srcpad, depay_sink);
+  gst_pad_link (depay_src, sinkpad);
+  gst_object_unref (depay_sink);
+  gst_object_unref (depay_src);
+
+  gst_pad_set_active (sinkpad, TRUE);
+  gst_element_set_state (depay, GST_STATE_PLAYING);
+  gst_pad_set_active (srcpad, TRUE);
+
+  gst_segment_init (&segment, GST_FORMAT_TIME);
+  gst_pad_push_event (srcpad, gst_event_new_stream_start (payload->name));
+  gst_pad_push_event (srcpad, gst_event_new_caps (rec->caps));
+  gst_pad_push_event (srcpad, gst_event_new_segment (&segment));
+
+  output.buffers = 0;
+  output.bytes = 0;
+  output.copied = 0;
+
+  take_sample (&start);
+  for (i = 0; i < rec->packets->len && flow == GST_FLOW_OK; i++)
+    flow = gst_pad_push (srcpad,
+        gst_buffer_copy (g_ptr_array_index (rec->packets, i)));
+  gst_pad_push_event (srcpad, gst_event_new_eos ());
+  take_sample (&end);
+
+  sample_add_diff (res, &start, &end);
+
+  if (flow != GST_FLOW_OK) {
+    g_printerr ("%s: flow %s at packet %u\n", payload->name,
+        gst_flow_get_name (flow), i - 1);
+    ret = FALSE;
+  }
+  if ((msg = gst_bus_pop_filtered (bus, GST_MESSAGE_ERROR))) {
+    GError *err = NULL;
+
+    gst_message_parse_error (msg, &err, NULL);
+    g_printerr ("%s: error: %s\n", payload->name, err->message);
+    g_error_free (err);
+    gst_message_unref (msg);
+    ret = FALSE;
+  }
+
+  gst_pad_set_active (srcpad, FALSE);
+  gst_element_set_state (depay, GST_STATE_NULL);
+  gst_pad_set_active (sinkpad, FALSE);
+  gst_element_set_bus (depay, NULL);
+
+  gst_object_unref (srcpad);
+  gst_object_unref (sinkpad);
+  gst_object_unref (depay);
+  gst_object_unref (bus);
+
+  return ret;
+}
+
+static gboolean
+is_selected (const Payload * payload)
+{
+  gchar **names;
+  gboolean ret = FALSE;
+  gint i;
+
+  if (only == NULL)
+    return TRUE;
+
+  names = g_strsplit (only, ",", -1);
+  for (i = 0; names[i]; i++) {
+    if (g_ascii_strcasecmp (g_strstrip (names[i]), payload->name) == 0) {
+      ret = TRUE;
+      break;
+    }
+  }
+  g_strfreev (names);
+
+  return ret;
+}
+
+/* returns FALSE when the depayloader does not work */
+static gboolean
+run_payload (const Payload * payload, gboolean count_allocs)
+{
+  GstElementFactory *factory;
+  Recording rec;
+  Sample copy = { 0, };
+  Sample run = { 0, };
+  gboolean ret = TRUE, missing;
+  guint i;
+  gint n;
+
+  factory = gst_element_factory_find (payload->depayloader);
+  if (factory == NULL) {
+    g_printerr ("%s: no %s, check GST_PLUGIN_PATH\n", payload->name,
+        payload->depayloader);
+    return FALSE;
+  }
+  gst_object_unref (factory);
+
+  recording_init (&rec);
+  if (dump_dir == NULL || !load_packets (payload, dump_dir, &rec)) {
+    recording_clear (&rec);
+    recording_init (&rec);
+    if (!record_packets (payload, &rec, &missing)) {
+      recording_clear (&rec);
+      /* payload types without an encoder are skipped */
+      return missing;
+    }
+    if (dump_dir)
+      save_packets (payload, dump_dir, &rec);
+  }
+
+  output.inputs = g_hash_table_new (NULL, NULL);
+  for (i = 0; i < rec.packets->len; i++)
+    g_hash_table_add (output.inputs,
+        gst_buffer_peek_memory (g_ptr_array_index (rec.packets, i), 0));
+
+  for (n = 0; n < iterations && ret; n++) {
+    measure_copy (&rec, &copy);
+    ret = measure_depayloader (payload, &rec, &run);
+  }
+  g_hash_table_destroy (output.inputs);
+
+  if (ret && output.buffers == 0) {
+    g_printerr ("%s: no output\n", payload->name);
+    ret = FALSE;
+  }
+
+  if (ret) {
+    gdouble time = MAX (run.time - copy.time, 1) / (gdouble) n;
+
+    g_print ("%-8s %8u %8u %10.1f %10.1f", payload->name,
+        rec.packets->len, output.buffers, rec.bytes * 8 / time,
+        time * 1000.0 / rec.packets->len);
+#ifdef G_OS_UNIX
+    g_print (" %10.1f", MAX (run.cpu - copy.cpu, 0) / (gdouble) n * 1000.0 /
+        rec.packets->len);
+#else
+    g_print (" %10s", "-");
+#endif
+    g_print (" %7.1f%%",
+        output.bytes ? output.copied * 100.0 / output.bytes : 0.0);
+    if (count_allocs)
+      g_print (" %12.2f\n",
+          (gdouble) (run.allocs - copy.allocs) / n / output.buffers);
+    else
+      g_print (" %12s\n", "-");
+  }
+  recording_clear (&rec);
+
+  return ret;
+}
+
+int
+main (int argc, char *argv[])
+{
+  gboolean count_allocs;
+  gboolean failed = FALSE;
+  guint i;
+
+  /* must be done before anything else allocates memory */
+  if (!benchmark_init (&argc, &argv, "- RTP depayloader benchmark", entries,
+          &count_allocs))
+    return 1;
+
+  if (frames < 1 || iterations < 1) {
+    g_printerr ("frames and iterations must be > 0\n");
+    return 1;
+  }
+
+  g_print ("%-8s %8s %8s %10s %10s %10s %8s %12s\n", "payload", "packets",
+      "out", "Mbit/s", "ns/packet", "cpu ns/pkt", "copied", "allocs/out");
+
+  for (i = 0; i < G_N_ELEMENTS (payloads); i++) {
+    if (!is_selected (&payloads[i]))
+      continue;
+    if (!run_payload (&payloads[i], count_allocs))
+      failed = TRUE;
+  }
+
+  if (!count_allocs)
+    g_print ("allocations are not available with this GLib\n");
+
+  return check && failed ? 1 : 0;
+}
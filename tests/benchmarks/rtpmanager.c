@@ -0,0 +1,450 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/*
+ * Measures the per-packet cost of the receive path of rtpbin: rtpsession,
+ * rtpssrcdemux, rtpjitterbuffer and rtpptdemux.
+ *
+ * Synthetic RTP streams with configurable loss and reordering are pushed from
+ * an appsrc into rtpbin and consumed by fakesinks. The pipeline runs on a
+ * test clock that is moved to the arrival time of each packet when it reaches
+ * its jitterbuffer, so the timers of the jitterbuffer fire at the same packets
+ * on every run and the results only depend on the cost of the code.
+ *
+ * For every run it reports:
+ *  - the wall clock time per packet
+ *  - the number of allocations per packet, this needs a GLib where
+ *    g_mem_set_vtable() works (before 2.46)
+ *  - the voluntary context switches per packet, threads that block on a
+ *    contended lock switch out so this follows the lock contention
+ *
+ * The cost of generating the packets is measured in a separate pass and
+ * subtracted. Run from the build tree with:
+ *
+ *   make -C tests benchmarks
+ *   GST_PLUGIN_PATH=gst tests/benchmarks/rtpmanager --streams=16 --loss=1
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+
+#include <gst/gst.h>
+#include <gst/app/gstappsrc.h>
+#include <gst/rtp/gstrtpbuffer.h>
+#include <gst/check/gsttestclock.h>
+
+#include "benchmark.h"
+
+static gint streams = 4;
+static gint bitrate = 2000;
+static gint packet_size = 1200;
+static gint duration = 10;
+static gdouble loss = 0.0;
+static gdouble reorder = 0.0;
+static gint latency = 200;
+static gint seed = 1;
+
+static GOptionEntry entries[] = {
+  {"streams", 's', 0, G_OPTION_ARG_INT, &streams,
+      "Number of streams (SSRCs)", "N"},
+  {"bitrate", 'b', 0, G_OPTION_ARG_INT, &bitrate,
+      "Bitrate of each stream in kbit/s", "KBPS"},
+  {"packet-size", 'p', 0, G_OPTION_ARG_INT, &packet_size,
+      "Payload size of the packets in bytes", "BYTES"},
+  {"duration", 'd', 0, G_OPTION_ARG_INT, &duration,
+      "Duration of the streams in seconds", "SECONDS"},
+  {"loss", 'l', 0, G_OPTION_ARG_DOUBLE, &loss,
+      "Percentage of packets that are lost", "PERCENT"},
+  {"reorder", 'r', 0, G_OPTION_ARG_DOUBLE, &reorder,
+      "Percentage of packets that are swapped with the next one", "PERCENT"},
+  {"latency", 0, 0, G_OPTION_ARG_INT, &latency,
+      "Latency of the jitterbuffers in ms", "MS"},
+  {"seed", 0, 0, G_OPTION_ARG_INT, &seed,
+      "Seed of the loss and reordering pattern", "SEED"},
+  {NULL}
+};
+
+/* packet generation */
+typedef struct
+{
+  GRand *rand;
+  guint k;
+  gint stream;
+  GstClockTime interval;
+  guint packets_per_stream;
+  guint16 *seqnums;
+  GstBuffer **held;
+} Generator;
+
+static void
+generator_init (Generator * gen)
+{
+  gen->rand = g_rand_new_with_seed (seed);
+  gen->k = 0;
+  gen->stream = 0;
+  gen->interval = gst_util_uint64_scale (packet_size * 8, GST_SECOND,
+      bitrate * 1000);
+  gen->packets_per_stream = gst_util_uint64_scale (duration, GST_SECOND,
+      gen->interval);
+  gen->seqnums = g_new0 (guint16, streams);
+  gen->held = g_new0 (GstBuffer *, streams);
+}
+
+static void
+generator_clear (Generator * gen)
+{
+  gint i;
+
+  for (i = 0; i < streams; i++) {
+    if (gen->held[i])
+      gst_buffer_unref (gen->held[i]);
+  }
+  g_free (gen->held);
+  g_free (gen->seqnums);
+  g_rand_free (gen->rand);
+}
+
+static GstBuffer *
+create_packet (Generator * gen, gint stream, GstClockTime time)
+{
+  GstRTPBuffer rtp = GST_RTP_BUFFER_INIT;
+  GstBuffer *buf;
+
+  buf = gst_rtp_buffer_new_allocate (packet_size, 0, 0);
+  gst_rtp_buffer_map (buf, GST_MAP_WRITE, &rtp);
+  gst_rtp_buffer_set_ssrc (&rtp, 0x10000000 + stream);
+  gst_rtp_buffer_set_payload_type (&rtp, 96);
+  gst_rtp_buffer_set_seq (&rtp, gen->seqnums[stream]++);
+  gst_rtp_buffer_set_timestamp (&rtp,
+      gst_util_uint64_scale (time, 90000, GST_SECOND));
+  gst_rtp_buffer_unmap (&rtp);
+
+  return buf;
+}
+
+/* get the next packets to push, the arrival time is placed in the DTS. Lost
+ * packets are skipped and reordered packets are held back until the next
+ * packet of the stream. Returns the number of packets placed in @out, 0 when
+ * the streams are finished. */
+static guint
+generator_next (Generator * gen, GstBuffer ** out)
+{
+  while (gen->k < gen->packets_per_stream) {
+    GstClockTime time;
+    GstBuffer *buf;
+    gint stream = gen->stream;
+    guint n = 0;
+
+    time = gen->k * gen->interval + stream * gen->interval / streams;
+
+    if (++gen->stream == streams) {
+      gen->stream = 0;
+      gen->k++;
+    }
+
+    buf = create_packet (gen, stream, time);
+
+    if (g_rand_double_range (gen->rand, 0.0, 100.0) < loss) {
+      gst_buffer_unref (buf);
+      continue;
+    }
+    if (gen->held[stream] == NULL &&
+        g_rand_double_range (gen->rand, 0.0, 100.0) < reorder) {
+      gen->held[stream] = buf;
+      continue;
+    }
+
+    GST_BUFFER_DTS (buf) = time;
+    out[n++] = buf;
+    if (gen->held[stream]) {
+      GST_BUFFER_DTS (gen->held[stream]) = time;
+      out[n++] = gen->held[stream];
+      gen->held[stream] = NULL;
+    }
+    return n;
+  }
+  return 0;
+}
+
+/* pipeline */
+static gint received;
+
+/* set when the EOS reached a jitterbuffer, all packets are consumed then */
+static GMutex consumed_lock;
+static GCond consumed_cond;
+static gboolean consumed;
+
+/* taken when the EOS is posted */
+static Sample eos_sample;
+
+/* the jitterbuffer takes the arrival time of the packets from the DTS but
+ * runs its timers on the clock, move the clock when the packet arrives */
+static GstPadProbeReturn
+jitterbuffer_probe (GstPad * pad, GstPadProbeInfo * info, GstClock * clock)
+{
+  if (info->type & GST_PAD_PROBE_TYPE_BUFFER) {
+    GstBuffer *buf = GST_PAD_PROBE_INFO_BUFFER (info);
+
+    gst_test_clock_set_time (GST_TEST_CLOCK (clock), GST_BUFFER_DTS (buf));
+  } else if (GST_EVENT_TYPE (GST_PAD_PROBE_INFO_EVENT (info)) ==
+      GST_EVENT_EOS) {
+    g_mutex_lock (&consumed_lock);
+    consumed = TRUE;
+    g_cond_signal (&consumed_cond);
+    g_mutex_unlock (&consumed_lock);
+  }
+  return GST_PAD_PROBE_OK;
+}
+
+static void
+on_new_jitterbuffer (GstElement * rtpbin, GstElement * jitterbuffer,
+    guint session, guint ssrc, GstClock * clock)
+{
+  GstPad *pad;
+
+  pad = gst_element_get_static_pad (jitterbuffer, "sink");
+  gst_pad_add_probe (pad,
+      GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM,
+      (GstPadProbeCallback) jitterbuffer_probe, clock, NULL);
+  gst_object_unref (pad);
+}
+
+static GstBusSyncReply
+eos_sync_handler (GstBus * bus, GstMessage * msg, gpointer user_data)
+{
+  switch (GST_MESSAGE_TYPE (msg)) {
+    case GST_MESSAGE_EOS:
+      take_sample (&eos_sample);
+      break;
+    case GST_MESSAGE_ERROR:
+      /* the packets will not all arrive, stop waiting for them */
+      g_mutex_lock (&consumed_lock);
+      consumed = TRUE;
+      g_cond_signal (&consumed_cond);
+      g_mutex_unlock (&consumed_lock);
+      break;
+    default:
+      break;
+  }
+  return GST_BUS_PASS;
+}
+
+static void
+on_handoff (GstElement * fakesink, GstBuffer * buf, GstPad * pad,
+    gpointer user_data)
+{
+  g_atomic_int_inc (&received);
+}
+
+static void
+on_pad_added (GstElement * rtpbin, GstPad * pad, GstElement * pipeline)
+{
+  GstElement *sink;
+  GstPad *sinkpad;
+
+  if (GST_PAD_DIRECTION (pad) != GST_PAD_SRC)
+    return;
+
+  sink = gst_element_factory_make ("fakesink", NULL);
+  g_object_set (sink, "sync", FALSE, "async", FALSE, "signal-handoffs", TRUE,
+      NULL);
+  g_signal_connect (sink, "handoff", G_CALLBACK (on_handoff), NULL);
+  gst_bin_add (GST_BIN (pipeline), sink);
+  gst_element_sync_state_with_parent (sink);
+
+  sinkpad = gst_element_get_static_pad (sink, "sink");
+  gst_pad_link (pad, sinkpad);
+  gst_object_unref (sinkpad);
+}
+
+static void
+measure_generator (Sample * res)
+{
+  Generator gen;
+  GstBuffer *out[2];
+  Sample start, end;
+  guint i, n;
+
+  generator_init (&gen);
+  take_sample (&start);
+  while ((n = generator_next (&gen, out))) {
+    for (i = 0; i < n; i++)
+      gst_buffer_unref (out[i]);
+  }
+  take_sample (&end);
+  generator_clear (&gen);
+
+  sample_add_diff (res, &start, &end);
+}
+
+static gboolean
+measure_rtpbin (Sample * res, guint * pushed)
+{
+  GstElement *pipeline, *src, *rtpbin;
+  GstPad *srcpad, *sinkpad;
+  GstClock *clock;
+  GstCaps *caps;
+  GstBus *bus;
+  GstMessage *msg;
+  Generator gen;
+  GstBuffer *out[2];
+  Sample start;
+  GstClockTime last = 0;
+  guint i, n;
+  gboolean ret = TRUE;
+
+  pipeline = gst_pipeline_new (NULL);
+  src = gst_element_factory_make ("appsrc", NULL);
+  rtpbin = gst_element_factory_make ("rtpbin", NULL);
+  if (src == NULL || rtpbin == NULL) {
+    g_printerr ("need appsrc and rtpbin, check GST_PLUGIN_PATH\n");
+    return FALSE;
+  }
+
+  caps = gst_caps_new_simple ("application/x-rtp",
+      "media", G_TYPE_STRING, "video",
+      "clock-rate", G_TYPE_INT, 90000,
+      "encoding-name", G_TYPE_STRING, "RAW", "payload", G_TYPE_INT, 96, NULL);
+  g_object_set (src, "caps", caps, "format", GST_FORMAT_TIME,
+      "is-live", TRUE, "block", TRUE, "max-bytes",
+      (guint64) 64 * packet_size, NULL);
+  gst_caps_unref (caps);
+  g_object_set (rtpbin, "latency", latency, NULL);
+  g_signal_connect (rtpbin, "pad-added", G_CALLBACK (on_pad_added), pipeline);
+
+  gst_bin_add_many (GST_BIN (pipeline), src, rtpbin, NULL);
+  srcpad = gst_element_get_static_pad (src, "src");
+  sinkpad = gst_element_get_request_pad (rtpbin, "recv_rtp_sink_0");
+  gst_pad_link (srcpad, sinkpad);
+  gst_object_unref (srcpad);
+  gst_object_unref (sinkpad);
+
+  /* make the running time equal to the time of the test clock */
+  clock = gst_test_clock_new ();
+  gst_pipeline_use_clock (GST_PIPELINE (pipeline), clock);
+  gst_element_set_start_time (pipeline, GST_CLOCK_TIME_NONE);
+  gst_element_set_base_time (pipeline, 0);
+  g_signal_connect (rtpbin, "new-jitterbuffer",
+      G_CALLBACK (on_new_jitterbuffer), clock);
+
+  bus = gst_element_get_bus (pipeline);
+  gst_bus_set_sync_handler (bus, eos_sync_handler, NULL, NULL);
+
+  gst_element_set_state (pipeline, GST_STATE_PLAYING);
+
+  received = 0;
+  consumed = FALSE;
+  *pushed = 0;
+  generator_init (&gen);
+  take_sample (&start);
+  while ((n = generator_next (&gen, out))) {
+    last = GST_BUFFER_DTS (out[0]);
+    for (i = 0; i < n; i++)
+      gst_app_src_push_buffer (GST_APP_SRC (src), out[i]);
+    *pushed += n;
+  }
+  gst_app_src_end_of_stream (GST_APP_SRC (src));
+
+  /* wait until the jitterbuffers have all packets, then move past all their
+   * timers so that everything is pushed out without waiting */
+  g_mutex_lock (&consumed_lock);
+  while (*pushed > 0 && !consumed)
+    g_cond_wait (&consumed_cond, &consumed_lock);
+  g_mutex_unlock (&consumed_lock);
+  gst_test_clock_set_time (GST_TEST_CLOCK (clock),
+      last + (latency + 1000) * GST_MSECOND);
+
+  /* the end sample is taken when the EOS is posted, keep moving the clock
+   * when the timers were not all fired yet */
+  while (TRUE) {
+    msg = gst_bus_timed_pop_filtered (bus, GST_SECOND,
+        GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+    if (msg)
+      break;
+    gst_test_clock_advance_time (GST_TEST_CLOCK (clock), GST_SECOND);
+  }
+  generator_clear (&gen);
+
+  if (GST_MESSAGE_TYPE (msg) == GST_MESSAGE_ERROR) {
+    GError *err = NULL;
+
+    gst_message_parse_error (msg, &err, NULL);
+    g_printerr ("error: %s\n", err->message);
+    g_error_free (err);
+    ret = FALSE;
+  }
+  gst_message_unref (msg);
+  gst_object_unref (bus);
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (pipeline);
+  gst_object_unref (clock);
+
+  sample_add_diff (res, &start, &eos_sample);
+
+  return ret;
+}
+
+int
+main (int argc, char *argv[])
+{
+  Sample gen = { 0, };
+  Sample run = { 0, };
+  gboolean count_allocs;
+  guint pushed;
+
+  /* must be done before anything else allocates memory */
+  if (!benchmark_init (&argc, &argv, "- rtpbin receive benchmark", entries,
+          &count_allocs))
+    return 1;
+
+  if (streams < 1 || bitrate < 1 || packet_size < 1 || duration < 1) {
+    g_printerr ("streams, bitrate, packet-size and duration must be > 0\n");
+    return 1;
+  }
+
+  measure_generator (&gen);
+  if (!measure_rtpbin (&run, &pushed))
+    return 1;
+
+  if (pushed == 0) {
+    g_printerr ("no packets generated\n");
+    return 1;
+  }
+
+  g_print ("streams %d, %d kbit/s, %d bytes, %d s, loss %.2f%%, "
+      "reorder %.2f%%\n", streams, bitrate, packet_size, duration, loss,
+      reorder);
+  g_print ("packets:           %u pushed, %d received\n", pushed,
+      g_atomic_int_get (&received));
+  g_print ("time:              %.1f ns/packet\n",
+      (run.time - gen.time) * 1000.0 / pushed);
+  g_print ("cpu:               %.1f ns/packet\n",
+      (run.cpu - gen.cpu) * 1000.0 / pushed);
+  if (count_allocs)
+    g_print ("allocations:       %.2f /packet\n",
+        (gdouble) (run.allocs - gen.allocs) / pushed);
+  else
+    g_print ("allocations:       not available with this GLib\n");
+  g_print ("context switches:  %.3f /packet\n",
+      (gdouble) (run.csw - gen.csw) / pushed);
+
+  return 0;
+}
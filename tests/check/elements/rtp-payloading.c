@@ -19,6 +19,7 @@
  */
 #include <gst/check/gstcheck.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 
 #define RELEASE_ELEMENT(x) if(x) {gst_object_unref(x); x = NULL;}
@@ -577,6 +578,129 @@ GST_START_TEST (rtp_h264_list_lt_mtu_avc)
 }
 
 GST_END_TEST;
+
+/* two access units of two NAL units each, with 4 bytes NAL sizes: SEI and
+ * IDR slice, then SEI with the forbidden bit set and non-IDR slice */
+static const guint8 rtp_h264_avc_aggregate_frame_data[] = {
+  0x00, 0x00, 0x00, 0x03, 0x06, 0x01, 0x02,
+  0x00, 0x00, 0x00, 0x06, 0x65, 0x88, 0x84, 0x00, 0x10, 0x20,
+  0x00, 0x00, 0x00, 0x04, 0x86, 0xaa, 0xbb, 0xcc,
+  0x00, 0x00, 0x00, 0x05, 0x41, 0x9a, 0x02, 0x03, 0x04
+};
+
+static int rtp_h264_avc_aggregate_frame_data_size = 17;
+
+static int rtp_h264_avc_aggregate_frame_count = 2;
+
+static GstPadProbeReturn
+rtp_h264_collect_packets (GstPad * pad, GstPadProbeInfo * info,
+    GPtrArray * packets)
+{
+  if (GST_PAD_PROBE_INFO_TYPE (info) & GST_PAD_PROBE_TYPE_BUFFER_LIST) {
+    GstBufferList *list = GST_PAD_PROBE_INFO_BUFFER_LIST (info);
+    guint i;
+
+    for (i = 0; i < gst_buffer_list_length (list); i++)
+      g_ptr_array_add (packets, gst_buffer_ref (gst_buffer_list_get (list,
+                  i)));
+  } else {
+    g_ptr_array_add (packets,
+        gst_buffer_ref (GST_PAD_PROBE_INFO_BUFFER (info)));
+  }
+  return GST_PAD_PROBE_OK;
+}
+
+static void
+rtp_h264_collect_output (GstElement * fakesink, GstBuffer * buf, GstPad * pad,
+    GPtrArray * output)
+{
+  g_ptr_array_add (output, gst_buffer_ref (buf));
+}
+
+GST_START_TEST (rtp_h264_list_lt_mtu_avc_aggregate)
+{
+  /* STAP-A header: forbidden bit of any NAL unit, highest NRI, type 24 */
+  static const guint8 stap_headers[] = { 0x60 | 24, 0x80 | 0x40 | 24 };
+  /* the sizes of the aggregated NAL units */
+  static const guint nal_sizes[][2] = { {3, 6}, {4, 5} };
+  const guint8 *frame;
+  GPtrArray *packets, *output;
+  rtp_pipeline *p;
+  GstPad *pad;
+  guint i, j;
+
+  p = rtp_pipeline_create (rtp_h264_avc_aggregate_frame_data,
+      rtp_h264_avc_aggregate_frame_data_size,
+      rtp_h264_avc_aggregate_frame_count,
+      "video/x-h264,stream-format=(string)avc,alignment=(string)au,"
+      "codec_data=(buffer)01640014ffe1001867640014acd94141fb0110000003001773594000f142996001000568ebecb22c",
+      "rtph264pay", "rtph264depay");
+  fail_unless (p != NULL);
+
+  g_object_set (p->rtppay, "aggregate", TRUE, "mtu",
+      rtp_h264_list_lt_mtu_mtu_size, NULL);
+
+  packets = g_ptr_array_new_with_free_func ((GDestroyNotify) gst_buffer_unref);
+  pad = gst_element_get_static_pad (p->rtppay, "src");
+  gst_pad_add_probe (pad,
+      GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_BUFFER_LIST,
+      (GstPadProbeCallback) rtp_h264_collect_packets, packets, NULL);
+  gst_object_unref (pad);
+
+  output = g_ptr_array_new_with_free_func ((GDestroyNotify) gst_buffer_unref);
+  g_object_set (p->fakesink, "signal-handoffs", TRUE, NULL);
+  g_signal_connect (p->fakesink, "handoff",
+      G_CALLBACK (rtp_h264_collect_output), output);
+
+  rtp_pipeline_run (p);
+
+  /* both NAL units of an access unit go in one STAP-A packet */
+  fail_unless_equals_int (packets->len, rtp_h264_avc_aggregate_frame_count);
+  for (i = 0; i < packets->len; i++) {
+    GstBuffer *packet = g_ptr_array_index (packets, i);
+    GstMapInfo map;
+    guint8 *data;
+
+    fail_unless (gst_buffer_map (packet, &map, GST_MAP_READ));
+    fail_unless_equals_int (map.size, 12 + 1 + 2 + nal_sizes[i][0] + 2 +
+        nal_sizes[i][1]);
+    /* each access unit ends with a slice, the marker is set */
+    fail_unless (map.data[1] & 0x80);
+
+    data = map.data + 12;
+    fail_unless_equals_int (data[0], stap_headers[i]);
+    data++;
+    frame = rtp_h264_avc_aggregate_frame_data +
+        i * rtp_h264_avc_aggregate_frame_data_size;
+    for (j = 0; j < 2; j++) {
+      fail_unless_equals_int (GST_READ_UINT16_BE (data), nal_sizes[i][j]);
+      fail_unless (memcmp (data + 2, frame + 4, nal_sizes[i][j]) == 0);
+      data += 2 + nal_sizes[i][j];
+      frame += 4 + nal_sizes[i][j];
+    }
+    gst_buffer_unmap (packet, &map);
+  }
+
+  /* and the depayloader gives back the access units */
+  fail_unless_equals_int (output->len, rtp_h264_avc_aggregate_frame_count);
+  for (i = 0; i < output->len; i++) {
+    GstBuffer *au = g_ptr_array_index (output, i);
+
+    fail_unless_equals_int (gst_buffer_get_size (au),
+        rtp_h264_avc_aggregate_frame_data_size);
+    fail_unless (gst_buffer_memcmp (au, 0,
+            rtp_h264_avc_aggregate_frame_data +
+            i * rtp_h264_avc_aggregate_frame_data_size,
+            rtp_h264_avc_aggregate_frame_data_size) == 0);
+  }
+
+  g_ptr_array_unref (packets);
+  g_ptr_array_unref (output);
+  rtp_pipeline_destroy (p);
+}
+
+GST_END_TEST;
+
 static const guint8 rtp_h264_list_gt_mtu_frame_data[] =
     /* not packetized, next NAL starts with 0001 */
 { 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
@@ -633,6 +757,298 @@ GST_START_TEST (rtp_h264_list_gt_mtu_avc)
 
 GST_END_TEST;
 
+/* SPS and PPS from the codec_data above */
+static const guint8 rtp_h264_depay_sps[] = {
+  0x67, 0x64, 0x00, 0x14, 0xac, 0xd9, 0x41, 0x41, 0xfb, 0x01, 0x10, 0x00,
+  0x00, 0x03, 0x00, 0x17, 0x73, 0x59, 0x40, 0x00, 0xf1, 0x42, 0x99, 0x60
+};
+
+static const guint8 rtp_h264_depay_pps[] = { 0x68, 0xeb, 0xec, 0xb2, 0x2c };
+
+/* SEI and the first slice of an IDR picture, aggregated in a STAP-A */
+static const guint8 rtp_h264_depay_sei[] = { 0x06, 0x05, 0x01, 0x80 };
+
+static const guint8 rtp_h264_depay_slice[] = { 0x65, 0x88, 0x84, 0x21, 0xa0 };
+
+/*
+ * Makes an RTP packet for rtph264depay with @size bytes of @payload.
+ */
+static GstBuffer *
+rtp_h264_depay_packet (guint16 seqnum, gboolean marker, const guint8 * payload,
+    gsize size)
+{
+  GstBuffer *buf;
+  GstMapInfo map;
+
+  buf = gst_buffer_new_allocate (NULL, 12 + size, NULL);
+  gst_buffer_map (buf, &map, GST_MAP_WRITE);
+  memset (map.data, 0, 12);
+  /* version 2, payload type 96 */
+  map.data[0] = 0x80;
+  map.data[1] = (marker ? 0x80 : 0x00) | 96;
+  GST_WRITE_UINT16_BE (map.data + 2, seqnum);
+  GST_WRITE_UINT32_BE (map.data + 8, 0x12345678);
+  memcpy (map.data + 12, payload, size);
+  gst_buffer_unmap (buf, &map);
+
+  GST_BUFFER_PTS (buf) = 0;
+
+  return buf;
+}
+
+/*
+ * Appends the NAL unit @nal of @size bytes to @out, with a start code or a 4
+ * bytes NAL size before it.
+ */
+static void
+rtp_h264_depay_append_nal (GByteArray * out, gboolean byte_stream,
+    const guint8 * nal, gsize size)
+{
+  guint8 prefix[4];
+
+  if (byte_stream) {
+    prefix[0] = prefix[1] = prefix[2] = 0;
+    prefix[3] = 1;
+  } else {
+    GST_WRITE_UINT32_BE (prefix, size);
+  }
+  g_byte_array_append (out, prefix, 4);
+  g_byte_array_append (out, nal, size);
+}
+
+/*
+ * Adds the FU-A packets of the NAL unit @nal of @size bytes to @packets,
+ * @n_fragments packets of at most @fragment_size bytes of payload. The marker
+ * is set on the last packet when @marker is TRUE.
+ */
+static void
+rtp_h264_depay_add_fu_a (GPtrArray * packets, const guint8 * nal, gsize size,
+    gsize fragment_size, gboolean marker)
+{
+  guint8 *payload;
+  gsize offset, len;
+
+  payload = g_malloc (2 + fragment_size);
+  /* skip the NAL header, it goes in the FU indicator and header */
+  for (offset = 1; offset < size; offset += len) {
+    len = MIN (fragment_size, size - offset);
+
+    /* FU indicator: NRI of the NAL unit, type 28 */
+    payload[0] = (nal[0] & 0xe0) | 28;
+    /* FU header: start and end bits, type of the NAL unit */
+    payload[1] = nal[0] & 0x1f;
+    if (offset == 1)
+      payload[1] |= 0x80;
+    if (offset + len == size)
+      payload[1] |= 0x40;
+    memcpy (payload + 2, nal + offset, len);
+
+    g_ptr_array_add (packets, rtp_h264_depay_packet (packets->len,
+            marker && offset + len == size, payload, 2 + len));
+  }
+  g_free (payload);
+}
+
+/*
+ * Pushes @packets through rtph264depay, with @caps_str downstream, and
+ * returns the buffers it outputs.
+ */
+static GPtrArray *
+rtp_h264_depay_run (GPtrArray * packets, const gchar * caps_str)
+{
+  GstElement *pipeline, *appsrc, *depay, *capsfilter, *fakesink;
+  GPtrArray *output;
+  GstFlowReturn flow_ret;
+  GstMessage *msg;
+  GstCaps *caps;
+  GstBus *bus;
+  guint i;
+
+  pipeline = gst_pipeline_new (NULL);
+  appsrc = gst_element_factory_make ("appsrc", NULL);
+  depay = gst_element_factory_make ("rtph264depay", NULL);
+  capsfilter = gst_element_factory_make ("capsfilter", NULL);
+  fakesink = gst_element_factory_make ("fakesink", NULL);
+  fail_unless (pipeline && appsrc && depay && capsfilter && fakesink);
+
+  caps = gst_caps_from_string ("application/x-rtp,media=(string)video,"
+      "clock-rate=(int)90000,encoding-name=(string)H264");
+  g_object_set (appsrc, "caps", caps, "format", GST_FORMAT_TIME, NULL);
+  gst_caps_unref (caps);
+  caps = gst_caps_from_string (caps_str);
+  g_object_set (capsfilter, "caps", caps, NULL);
+  gst_caps_unref (caps);
+
+  output = g_ptr_array_new_with_free_func ((GDestroyNotify) gst_buffer_unref);
+  g_object_set (fakesink, "sync", FALSE, "signal-handoffs", TRUE, NULL);
+  g_signal_connect (fakesink, "handoff",
+      G_CALLBACK (rtp_h264_collect_output), output);
+
+  gst_bin_add_many (GST_BIN (pipeline), appsrc, depay, capsfilter, fakesink,
+      NULL);
+  fail_unless (gst_element_link_many (appsrc, depay, capsfilter, fakesink,
+          NULL));
+
+  gst_element_set_state (pipeline, GST_STATE_PLAYING);
+
+  for (i = 0; i < packets->len; i++) {
+    g_signal_emit_by_name (appsrc, "push-buffer",
+        g_ptr_array_index (packets, i), &flow_ret);
+    fail_unless_equals_int (flow_ret, GST_FLOW_OK);
+  }
+  g_signal_emit_by_name (appsrc, "end-of-stream", &flow_ret);
+
+  bus = gst_pipeline_get_bus (GST_PIPELINE (pipeline));
+  msg = gst_bus_timed_pop_filtered (bus, 10 * GST_SECOND,
+      GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+  fail_unless (msg != NULL);
+  fail_unless_equals_int (GST_MESSAGE_TYPE (msg), GST_MESSAGE_EOS);
+  gst_message_unref (msg);
+  gst_object_unref (bus);
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (pipeline);
+
+  return output;
+}
+
+/*
+ * Sends SPS and PPS, a STAP-A with an SEI and the first slice of a picture
+ * and a FU-A with the second slice to rtph264depay and checks that it outputs
+ * one access unit with the same NAL units.
+ */
+static void
+rtp_h264_depay_stap_fu_test (gboolean byte_stream)
+{
+  guint8 slice2[100];
+  guint8 stap[1 + 2 + sizeof (rtp_h264_depay_sei) + 2 +
+      sizeof (rtp_h264_depay_slice)];
+  GPtrArray *packets, *output;
+  GByteArray *expected;
+  GstBuffer *au;
+  guint i;
+
+  /* second slice of the picture, first_mb_in_slice is not 0 */
+  slice2[0] = 0x65;
+  for (i = 1; i < sizeof (slice2); i++)
+    slice2[i] = (i * 13) & 0x7f;
+
+  packets = g_ptr_array_new_with_free_func ((GDestroyNotify) gst_buffer_unref);
+  g_ptr_array_add (packets, rtp_h264_depay_packet (packets->len, FALSE,
+          rtp_h264_depay_sps, sizeof (rtp_h264_depay_sps)));
+  g_ptr_array_add (packets, rtp_h264_depay_packet (packets->len, FALSE,
+          rtp_h264_depay_pps, sizeof (rtp_h264_depay_pps)));
+
+  stap[0] = 0x60 | 24;
+  GST_WRITE_UINT16_BE (stap + 1, sizeof (rtp_h264_depay_sei));
+  memcpy (stap + 3, rtp_h264_depay_sei, sizeof (rtp_h264_depay_sei));
+  GST_WRITE_UINT16_BE (stap + 3 + sizeof (rtp_h264_depay_sei),
+      sizeof (rtp_h264_depay_slice));
+  memcpy (stap + 5 + sizeof (rtp_h264_depay_sei), rtp_h264_depay_slice,
+      sizeof (rtp_h264_depay_slice));
+  g_ptr_array_add (packets, rtp_h264_depay_packet (packets->len, FALSE,
+          stap, sizeof (stap)));
+
+  rtp_h264_depay_add_fu_a (packets, slice2, sizeof (slice2), 30, TRUE);
+  fail_unless_equals_int (packets->len, 3 + 4);
+
+  output = rtp_h264_depay_run (packets, byte_stream ?
+      "video/x-h264,stream-format=(string)byte-stream,alignment=(string)au" :
+      "video/x-h264,stream-format=(string)avc,alignment=(string)au");
+
+  /* in avc the SPS and PPS go in the caps */
+  expected = g_byte_array_new ();
+  if (byte_stream) {
+    rtp_h264_depay_append_nal (expected, TRUE, rtp_h264_depay_sps,
+        sizeof (rtp_h264_depay_sps));
+    rtp_h264_depay_append_nal (expected, TRUE, rtp_h264_depay_pps,
+        sizeof (rtp_h264_depay_pps));
+  }
+  rtp_h264_depay_append_nal (expected, byte_stream, rtp_h264_depay_sei,
+      sizeof (rtp_h264_depay_sei));
+  rtp_h264_depay_append_nal (expected, byte_stream, rtp_h264_depay_slice,
+      sizeof (rtp_h264_depay_slice));
+  rtp_h264_depay_append_nal (expected, byte_stream, slice2, sizeof (slice2));
+
+  fail_unless_equals_int (output->len, 1);
+  au = g_ptr_array_index (output, 0);
+  fail_unless_equals_int (gst_buffer_get_size (au), expected->len);
+  fail_unless (gst_buffer_memcmp (au, 0, expected->data, expected->len) == 0);
+  fail_if (GST_BUFFER_FLAG_IS_SET (au, GST_BUFFER_FLAG_DELTA_UNIT));
+
+  g_byte_array_unref (expected);
+  g_ptr_array_unref (output);
+  g_ptr_array_unref (packets);
+}
+
+GST_START_TEST (rtp_h264_depay_stap_fu_byte_stream)
+{
+  rtp_h264_depay_stap_fu_test (TRUE);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (rtp_h264_depay_stap_fu_avc)
+{
+  rtp_h264_depay_stap_fu_test (FALSE);
+}
+
+GST_END_TEST;
+
+/* more memory blocks than a buffer can hold end up in one NAL unit and in
+ * one access unit, the depayloader merges them instead of failing */
+GST_START_TEST (rtp_h264_depay_many_memories)
+{
+  const guint n_fragments = 2 * gst_buffer_get_max_memory ();
+  const guint n_slices = gst_buffer_get_max_memory ();
+  GPtrArray *packets, *output;
+  GByteArray *expected;
+  guint8 slice[10], *nal;
+  gsize nal_size;
+  GstBuffer *au;
+  guint i;
+
+  packets = g_ptr_array_new_with_free_func ((GDestroyNotify) gst_buffer_unref);
+  expected = g_byte_array_new ();
+
+  /* the first slice in more FU-A fragments than a buffer can hold memory */
+  nal_size = 1 + n_fragments * 8;
+  nal = g_malloc (nal_size);
+  nal[0] = 0x65;
+  nal[1] = 0x88;
+  for (i = 2; i < nal_size; i++)
+    nal[i] = (i * 7) & 0x7f;
+  rtp_h264_depay_add_fu_a (packets, nal, nal_size, 8, FALSE);
+  fail_unless_equals_int (packets->len, n_fragments);
+  rtp_h264_depay_append_nal (expected, TRUE, nal, nal_size);
+  g_free (nal);
+
+  /* then more single NAL unit slices of the same picture than a buffer can
+   * hold memory, each one is a start code and a payload block */
+  slice[0] = 0x65;
+  for (i = 0; i < n_slices; i++) {
+    memset (slice + 1, i + 1, sizeof (slice) - 1);
+    g_ptr_array_add (packets, rtp_h264_depay_packet (packets->len,
+            i == n_slices - 1, slice, sizeof (slice)));
+    rtp_h264_depay_append_nal (expected, TRUE, slice, sizeof (slice));
+  }
+
+  output = rtp_h264_depay_run (packets,
+      "video/x-h264,stream-format=(string)byte-stream,alignment=(string)au");
+
+  fail_unless_equals_int (output->len, 1);
+  au = g_ptr_array_index (output, 0);
+  fail_unless (gst_buffer_n_memory (au) <= gst_buffer_get_max_memory ());
+  fail_unless_equals_int (gst_buffer_get_size (au), expected->len);
+  fail_unless (gst_buffer_memcmp (au, 0, expected->data, expected->len) == 0);
+
+  g_byte_array_unref (expected);
+  g_ptr_array_unref (output);
+  g_ptr_array_unref (packets);
+}
+
+GST_END_TEST;
+
 static const guint8 rtp_L16_frame_data[] =
     { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
   0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
@@ -906,6 +1322,251 @@ GST_START_TEST (rtp_g729)
 
 GST_END_TEST;
 
+static void
+rtp_vraw_handoff (GstElement * fakesink, GstBuffer * buf, GstPad * pad,
+    GList ** out_buffers)
+{
+  *out_buffers = g_list_append (*out_buffers, gst_buffer_ref (buf));
+}
+
+static GstPadProbeReturn
+rtp_vraw_count_lists (GstPad * pad, GstPadProbeInfo * info, guint * n_lists)
+{
+  (*n_lists)++;
+  return GST_PAD_PROBE_OK;
+}
+
+/*
+ * Sends @n_frames frames of @frame_size bytes from @frames through rtpvrawpay
+ * and rtpvrawdepay.
+ * @param chunks chunks-per-frame of the payloader, the buffer lists it pushes
+ *   end in the middle of the frame when it is more than 1.
+ * @param n_threads n-threads of the depayloader.
+ * @param n_lists returns the number of buffer lists pushed by the payloader.
+ * @return
+ * Returns the list of depayloaded frames.
+ */
+static GList *
+rtp_vraw_roundtrip (const gchar * caps_str, const guint8 * frames,
+    gsize frame_size, guint n_frames, gint chunks, guint n_threads,
+    guint * n_lists)
+{
+  GstElement *pipeline, *appsrc, *pay, *depay, *fakesink;
+  GList *out_buffers = NULL;
+  GstFlowReturn flow_ret;
+  GstMessage *msg;
+  GstCaps *caps;
+  GstPad *pad;
+  GstBus *bus;
+  guint i;
+
+  pipeline = gst_pipeline_new (NULL);
+  appsrc = gst_element_factory_make ("appsrc", NULL);
+  pay = gst_element_factory_make ("rtpvrawpay", NULL);
+  depay = gst_element_factory_make ("rtpvrawdepay", NULL);
+  fakesink = gst_element_factory_make ("fakesink", NULL);
+  fail_unless (pipeline && appsrc && pay && depay && fakesink);
+
+  caps = gst_caps_from_string (caps_str);
+  g_object_set (appsrc, "caps", caps, "format", GST_FORMAT_TIME, NULL);
+  gst_caps_unref (caps);
+  /* a small MTU splits the lines over several packets */
+  g_object_set (pay, "mtu", 200, "chunks-per-frame", chunks, NULL);
+  g_object_set (depay, "n-threads", n_threads, NULL);
+  g_object_set (fakesink, "sync", FALSE, "signal-handoffs", TRUE, NULL);
+  g_signal_connect (fakesink, "handoff", G_CALLBACK (rtp_vraw_handoff),
+      &out_buffers);
+
+  *n_lists = 0;
+  pad = gst_element_get_static_pad (depay, "sink");
+  gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER_LIST,
+      (GstPadProbeCallback) rtp_vraw_count_lists, n_lists, NULL);
+  gst_object_unref (pad);
+
+  gst_bin_add_many (GST_BIN (pipeline), appsrc, pay, depay, fakesink, NULL);
+  fail_unless (gst_element_link_many (appsrc, pay, depay, fakesink, NULL));
+
+  gst_element_set_state (pipeline, GST_STATE_PLAYING);
+
+  for (i = 0; i < n_frames; i++) {
+    GstBuffer *buf;
+
+    buf = gst_buffer_new_allocate (NULL, frame_size, NULL);
+    gst_buffer_fill (buf, 0, frames + i * frame_size, frame_size);
+    GST_BUFFER_PTS (buf) = i * GST_SECOND / 30;
+    GST_BUFFER_DURATION (buf) = GST_SECOND / 30;
+
+    g_signal_emit_by_name (appsrc, "push-buffer", buf, &flow_ret);
+    fail_unless_equals_int (flow_ret, GST_FLOW_OK);
+    gst_buffer_unref (buf);
+  }
+  g_signal_emit_by_name (appsrc, "end-of-stream", &flow_ret);
+
+  bus = gst_pipeline_get_bus (GST_PIPELINE (pipeline));
+  msg = gst_bus_timed_pop_filtered (bus, 10 * GST_SECOND,
+      GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+  fail_unless (msg != NULL);
+  fail_unless_equals_int (GST_MESSAGE_TYPE (msg), GST_MESSAGE_EOS);
+  gst_message_unref (msg);
+  gst_object_unref (bus);
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (pipeline);
+
+  return out_buffers;
+}
+
+/*
+ * Checks that the depayloader writing buffer lists with @n_threads worker
+ * threads produces exactly the frames that were sent, and the same bytes as
+ * the depayloader writing every packet as it arrives.
+ */
+static void
+rtp_vraw_threads_test (const gchar * caps_str, gsize frame_size)
+{
+  const guint n_frames = 3;
+  GList *ref_buffers, *out_buffers, *r, *o;
+  guint8 *frames;
+  guint i, n_lists;
+
+  frames = g_malloc (frame_size * n_frames);
+  for (i = 0; i < frame_size * n_frames; i++)
+    frames[i] = (i * 7 + i / 251) & 0xff;
+
+  ref_buffers = rtp_vraw_roundtrip (caps_str, frames, frame_size, n_frames,
+      5, 1, &n_lists);
+  fail_unless (n_lists > n_frames);
+  out_buffers = rtp_vraw_roundtrip (caps_str, frames, frame_size, n_frames,
+      5, 4, &n_lists);
+
+  fail_unless_equals_int (g_list_length (ref_buffers), n_frames);
+  fail_unless_equals_int (g_list_length (out_buffers), n_frames);
+
+  for (i = 0, r = ref_buffers, o = out_buffers; i < n_frames;
+      i++, r = r->next, o = o->next) {
+    GstMapInfo ref_map, out_map;
+
+    fail_unless (gst_buffer_map (GST_BUFFER (r->data), &ref_map,
+            GST_MAP_READ));
+    fail_unless (gst_buffer_map (GST_BUFFER (o->data), &out_map,
+            GST_MAP_READ));
+    fail_unless_equals_int (ref_map.size, frame_size);
+    fail_unless_equals_int (out_map.size, frame_size);
+    fail_unless (memcmp (ref_map.data, frames + i * frame_size,
+            frame_size) == 0);
+    fail_unless (memcmp (out_map.data, ref_map.data, frame_size) == 0);
+    gst_buffer_unmap (GST_BUFFER (r->data), &ref_map);
+    gst_buffer_unmap (GST_BUFFER (o->data), &out_map);
+  }
+
+  g_list_free_full (ref_buffers, (GDestroyNotify) gst_buffer_unref);
+  g_list_free_full (out_buffers, (GDestroyNotify) gst_buffer_unref);
+  g_free (frames);
+}
+
+GST_START_TEST (rtp_vraw_threads_uyvy)
+{
+  rtp_vraw_threads_test ("video/x-raw,format=UYVY,width=32,height=24,"
+      "framerate=30/1", 32 * 2 * 24);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (rtp_vraw_threads_i420)
+{
+  rtp_vraw_threads_test ("video/x-raw,format=I420,width=32,height=24,"
+      "framerate=30/1", 32 * 24 * 3 / 2);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (rtp_vraw_threads_interlaced)
+{
+  rtp_vraw_threads_test ("video/x-raw,format=UYVY,width=32,height=24,"
+      "framerate=30/1,interlace-mode=interleaved", 32 * 2 * 24);
+}
+
+GST_END_TEST;
+
+/*
+ * Checks that the formats that the payloader sends without copying the
+ * pixels arrive unchanged and that each frame is pushed in @chunks buffer
+ * lists.
+ */
+static void
+rtp_vraw_zero_copy_test (const gchar * caps_str, gsize frame_size)
+{
+  const guint n_frames = 3;
+  const gint chunks = 4;
+  GList *out_buffers, *o;
+  guint8 *frames;
+  guint i, n_lists;
+
+  frames = g_malloc (frame_size * n_frames);
+  for (i = 0; i < frame_size * n_frames; i++)
+    frames[i] = (i * 11 + i / 241) & 0xff;
+
+  out_buffers = rtp_vraw_roundtrip (caps_str, frames, frame_size, n_frames,
+      chunks, 1, &n_lists);
+
+  /* a line is longer than the payload of a packet, so a list ends at every
+   * 24 / chunks lines */
+  fail_unless_equals_int (n_lists, n_frames * chunks);
+  fail_unless_equals_int (g_list_length (out_buffers), n_frames);
+
+  for (i = 0, o = out_buffers; i < n_frames; i++, o = o->next) {
+    GstMapInfo map;
+
+    fail_unless (gst_buffer_map (GST_BUFFER (o->data), &map, GST_MAP_READ));
+    fail_unless_equals_int (map.size, frame_size);
+    fail_unless (memcmp (map.data, frames + i * frame_size, frame_size) == 0);
+    gst_buffer_unmap (GST_BUFFER (o->data), &map);
+  }
+
+  g_list_free_full (out_buffers, (GDestroyNotify) gst_buffer_unref);
+  g_free (frames);
+}
+
+GST_START_TEST (rtp_vraw_zero_copy_rgb)
+{
+  rtp_vraw_zero_copy_test ("video/x-raw,format=RGB,width=96,height=24,"
+      "framerate=30/1", 96 * 3 * 24);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (rtp_vraw_zero_copy_rgba)
+{
+  rtp_vraw_zero_copy_test ("video/x-raw,format=RGBA,width=96,height=24,"
+      "framerate=30/1", 96 * 4 * 24);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (rtp_vraw_zero_copy_bgr)
+{
+  rtp_vraw_zero_copy_test ("video/x-raw,format=BGR,width=96,height=24,"
+      "framerate=30/1", 96 * 3 * 24);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (rtp_vraw_zero_copy_bgra)
+{
+  rtp_vraw_zero_copy_test ("video/x-raw,format=BGRA,width=96,height=24,"
+      "framerate=30/1", 96 * 4 * 24);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (rtp_vraw_zero_copy_uyvy)
+{
+  rtp_vraw_zero_copy_test ("video/x-raw,format=UYVY,width=96,height=24,"
+      "framerate=30/1", 96 * 2 * 24);
+}
+
+GST_END_TEST;
+
 /*
  * Creates the test suite.
  *
@@ -933,8 +1594,12 @@ rtp_payloading_suite (void)
   tcase_add_test (tc_chain, rtp_h264);
   tcase_add_test (tc_chain, rtp_h264_list_lt_mtu);
   tcase_add_test (tc_chain, rtp_h264_list_lt_mtu_avc);
+  tcase_add_test (tc_chain, rtp_h264_list_lt_mtu_avc_aggregate);
   tcase_add_test (tc_chain, rtp_h264_list_gt_mtu);
   tcase_add_test (tc_chain, rtp_h264_list_gt_mtu_avc);
+  tcase_add_test (tc_chain, rtp_h264_depay_stap_fu_byte_stream);
+  tcase_add_test (tc_chain, rtp_h264_depay_stap_fu_avc);
+  tcase_add_test (tc_chain, rtp_h264_depay_many_memories);
   tcase_add_test (tc_chain, rtp_L16);
   tcase_add_test (tc_chain, rtp_L24);
   tcase_add_test (tc_chain, rtp_mp2t);
@@ -952,6 +1617,14 @@ rtp_payloading_suite (void)
   tcase_add_test (tc_chain, rtp_jpeg_list_height_greater_than_2040);
   tcase_add_test (tc_chain, rtp_jpeg_list_width_and_height_greater_than_2040);
   tcase_add_test (tc_chain, rtp_g729);
+  tcase_add_test (tc_chain, rtp_vraw_threads_uyvy);
+  tcase_add_test (tc_chain, rtp_vraw_threads_i420);
+  tcase_add_test (tc_chain, rtp_vraw_threads_interlaced);
+  tcase_add_test (tc_chain, rtp_vraw_zero_copy_rgb);
+  tcase_add_test (tc_chain, rtp_vraw_zero_copy_rgba);
+  tcase_add_test (tc_chain, rtp_vraw_zero_copy_bgr);
+  tcase_add_test (tc_chain, rtp_vraw_zero_copy_bgra);
+  tcase_add_test (tc_chain, rtp_vraw_zero_copy_uyvy);
   return s;
 }
 
@@ -21,6 +21,7 @@
  */
 
 #include <gst/check/gstcheck.h>
+#include <gst/rtp/gstrtpbuffer.h>
 
 GST_START_TEST (test_pads)
 {
@@ -686,6 +687,135 @@ GST_START_TEST (test_aux_receiver)
 
 GST_END_TEST;
 
+static GList *lightweight_seqnums = NULL;
+
+static GstFlowReturn
+lightweight_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
+{
+  GstRTPBuffer rtp = GST_RTP_BUFFER_INIT;
+
+  fail_unless (gst_rtp_buffer_map (buffer, GST_MAP_READ, &rtp));
+  lightweight_seqnums = g_list_append (lightweight_seqnums,
+      GUINT_TO_POINTER (gst_rtp_buffer_get_seq (&rtp)));
+  gst_rtp_buffer_unmap (&rtp);
+  gst_buffer_unref (buffer);
+
+  return GST_FLOW_OK;
+}
+
+static void
+lightweight_pad_added_cb (GstElement * rtpbin, GstPad * pad,
+    CleanupData * data)
+{
+  GstPad *sinkpad;
+
+  if (GST_PAD_IS_SINK (pad))
+    return;
+
+  fail_unless (data->pad_added == FALSE);
+  fail_unless_equals_string (GST_PAD_NAME (pad),
+      "recv_rtp_src_0_1151923068_96");
+
+  sinkpad = make_sinkpad (data);
+  gst_pad_set_chain_function (sinkpad, lightweight_chain);
+  fail_unless (gst_pad_link (pad, sinkpad) == GST_PAD_LINK_OK);
+
+  data->pad_added = TRUE;
+  data->pad = pad;
+}
+
+static GstFlowReturn
+chain_lightweight_packet (GstPad * pad, guint16 seqnum, GstClockTime dts)
+{
+  GstBuffer *buffer;
+  GstMapInfo map;
+
+  buffer = gst_buffer_new_and_alloc (sizeof (rtp_packet));
+  gst_buffer_map (buffer, &map, GST_MAP_WRITE);
+  memcpy (map.data, rtp_packet, sizeof (rtp_packet));
+  map.data[2] = (seqnum >> 8) & 0xff;
+  map.data[3] = seqnum & 0xff;
+  gst_buffer_unmap (buffer, &map);
+  GST_BUFFER_DTS (buffer) = dts;
+
+  return gst_pad_chain (pad, buffer);
+}
+
+GST_START_TEST (test_lightweight_recv)
+{
+  GstElement *rtpbin;
+  GstPad *rtp_sink;
+  CleanupData data;
+  GstStateChangeReturn ret;
+  GstCaps *caps;
+  GstSegment segment;
+  GList *walk;
+  guint i;
+
+  init_data (&data);
+
+  rtpbin = gst_element_factory_make ("rtpbin", "rtpbin");
+  g_object_set (rtpbin, "lightweight", TRUE, "latency", 100, NULL);
+
+  g_signal_connect (rtpbin, "pad-added", (GCallback) lightweight_pad_added_cb,
+      &data);
+
+  ret = gst_element_set_state (rtpbin, GST_STATE_PLAYING);
+  fail_unless (ret == GST_STATE_CHANGE_SUCCESS);
+
+  rtp_sink = gst_element_get_request_pad (rtpbin, "recv_rtp_sink_0");
+  fail_unless (rtp_sink != NULL);
+
+  caps = gst_caps_from_string ("application/x-rtp,"
+      "media=(string)audio, clock-rate=(int)44100, "
+      "encoding-name=(string)L16, encoding-params=(string)1, channels=(int)1");
+  gst_pad_send_event (rtp_sink, gst_event_new_stream_start ("lightweight"));
+  gst_pad_send_event (rtp_sink, gst_event_new_caps (caps));
+  gst_caps_unref (caps);
+  gst_segment_init (&segment, GST_FORMAT_TIME);
+  gst_pad_send_event (rtp_sink, gst_event_new_segment (&segment));
+
+  /* the packets wait for the missing packet 2 */
+  fail_unless (chain_lightweight_packet (rtp_sink, 0, 0) == GST_FLOW_OK);
+  fail_unless (chain_lightweight_packet (rtp_sink, 1,
+          10 * GST_MSECOND) == GST_FLOW_OK);
+  fail_unless (chain_lightweight_packet (rtp_sink, 3,
+          20 * GST_MSECOND) == GST_FLOW_OK);
+  fail_unless (chain_lightweight_packet (rtp_sink, 2,
+          30 * GST_MSECOND) == GST_FLOW_OK);
+  fail_unless (lightweight_seqnums == NULL);
+
+  /* after the latency, all packets are pushed in order */
+  fail_unless (chain_lightweight_packet (rtp_sink, 4,
+          200 * GST_MSECOND) == GST_FLOW_OK);
+  fail_unless (data.pad_added);
+  fail_unless_equals_int (g_list_length (lightweight_seqnums), 5);
+  for (walk = lightweight_seqnums, i = 0; walk; walk = g_list_next (walk), i++)
+    fail_unless_equals_int (GPOINTER_TO_UINT (walk->data), i);
+
+  /* only the session and the SSRC demuxer are in the bin */
+  fail_unless_equals_int (GST_BIN_NUMCHILDREN (rtpbin), 2);
+  fail_unless (rtpbin->numsrcpads == 1);
+
+  gst_element_release_request_pad (rtpbin, rtp_sink);
+  gst_object_unref (rtp_sink);
+
+  /* the payload pad is removed with the stream */
+  fail_unless (rtpbin->numsinkpads == 0);
+  fail_unless (rtpbin->numsrcpads == 0);
+
+  ret = gst_element_set_state (rtpbin, GST_STATE_NULL);
+  fail_unless (ret == GST_STATE_CHANGE_SUCCESS);
+
+  gst_object_unref (rtpbin);
+
+  g_list_free (lightweight_seqnums);
+  lightweight_seqnums = NULL;
+  clean_data (&data);
+}
+
+GST_END_TEST;
+
 static Suite *
 gstrtpbin_suite (void)
 {
@@ -702,6 +832,7 @@ gstrtpbin_suite (void)
   tcase_add_test (tc_chain, test_decoder);
   tcase_add_test (tc_chain, test_aux_sender);
   tcase_add_test (tc_chain, test_aux_receiver);
+  tcase_add_test (tc_chain, test_lightweight_recv);
 
   return s;
 }
@@ -294,6 +294,96 @@ GST_START_TEST (test_push_unordered)
 
 GST_END_TEST;
 
+GST_START_TEST (test_push_unordered_shared_timer)
+{
+  GstElement *jitterbuffer;
+  const guint num_buffers = 4;
+  GstBuffer *buffer;
+
+  jitterbuffer = setup_jitterbuffer (num_buffers);
+  g_object_set (jitterbuffer, "shared-timer", TRUE, NULL);
+  fail_unless (start_jitterbuffer (jitterbuffer)
+      == GST_STATE_CHANGE_SUCCESS, "could not set to playing");
+
+  /* push buffers; 0,2,1,3 */
+  buffer = (GstBuffer *) inbuffers->data;
+  fail_unless (gst_pad_push (mysrcpad, buffer) == GST_FLOW_OK);
+  buffer = g_list_nth_data (inbuffers, 2);
+  fail_unless (gst_pad_push (mysrcpad, buffer) == GST_FLOW_OK);
+  buffer = g_list_nth_data (inbuffers, 1);
+  fail_unless (gst_pad_push (mysrcpad, buffer) == GST_FLOW_OK);
+  buffer = g_list_nth_data (inbuffers, 3);
+  fail_unless (gst_pad_push (mysrcpad, buffer) == GST_FLOW_OK);
+
+  /* check the buffer list, the buffers are only pushed out after the
+   * deadline timer of the first buffer fired */
+  check_jitterbuffer_results (jitterbuffer, num_buffers);
+
+  /* cleanup */
+  cleanup_jitterbuffer (jitterbuffer);
+}
+
+GST_END_TEST;
+
+static guint num_lists = 0;
+
+static GstFlowReturn
+test_sink_pad_chain_list_cb (GstPad * pad, GstObject * parent,
+    GstBufferList * list)
+{
+  guint i, len;
+
+  len = gst_buffer_list_length (list);
+  GST_DEBUG ("received list of %u buffers", len);
+
+  g_mutex_lock (&check_mutex);
+  num_lists++;
+  for (i = 0; i < len; i++)
+    buffers = g_list_append (buffers,
+        gst_buffer_ref (gst_buffer_list_get (list, i)));
+  g_cond_signal (&check_cond);
+  g_mutex_unlock (&check_mutex);
+
+  gst_buffer_list_unref (list);
+
+  return GST_FLOW_OK;
+}
+
+GST_START_TEST (test_push_consecutive_list)
+{
+  GstElement *jitterbuffer;
+  const guint num_buffers = 5;
+  GstBuffer *buffer;
+
+  jitterbuffer = setup_jitterbuffer (num_buffers);
+  gst_pad_set_chain_list_function (mysinkpad, test_sink_pad_chain_list_cb);
+  num_lists = 0;
+  fail_unless (start_jitterbuffer (jitterbuffer)
+      == GST_STATE_CHANGE_SUCCESS, "could not set to playing");
+
+  /* push buffers; 0,2,3,4,1, the last one makes 1-4 ready at once */
+  buffer = (GstBuffer *) inbuffers->data;
+  fail_unless (gst_pad_push (mysrcpad, buffer) == GST_FLOW_OK);
+  buffer = g_list_nth_data (inbuffers, 2);
+  fail_unless (gst_pad_push (mysrcpad, buffer) == GST_FLOW_OK);
+  buffer = g_list_nth_data (inbuffers, 3);
+  fail_unless (gst_pad_push (mysrcpad, buffer) == GST_FLOW_OK);
+  buffer = g_list_nth_data (inbuffers, 4);
+  fail_unless (gst_pad_push (mysrcpad, buffer) == GST_FLOW_OK);
+  buffer = g_list_nth_data (inbuffers, 1);
+  fail_unless (gst_pad_push (mysrcpad, buffer) == GST_FLOW_OK);
+
+  /* check the buffer list */
+  check_jitterbuffer_results (jitterbuffer, num_buffers);
+  /* 1-4 were pushed as one list */
+  fail_unless_equals_int (num_lists, 1);
+
+  /* cleanup */
+  cleanup_jitterbuffer (jitterbuffer);
+}
+
+GST_END_TEST;
+
 GST_START_TEST (test_basetime)
 {
   GstElement *jitterbuffer;
@@ -476,7 +566,7 @@ test_src_pad_event_cb (GstPad * pad, GstObject * parent, GstEvent * event)
 }
 
 static void
-setup_testharness (TestData * data)
+setup_testharness_full (TestData * data, gboolean shared_timer)
 {
   GstPad *jb_sink_pad, *jb_src_pad;
   GstSegment seg;
@@ -492,7 +582,8 @@ setup_testharness (TestData * data)
   data->jitter_buffer = gst_element_factory_make ("rtpjitterbuffer", NULL);
   g_assert (data->jitter_buffer);
   gst_element_set_clock (data->jitter_buffer, data->clock);
-  g_object_set (data->jitter_buffer, "do-lost", TRUE, NULL);
+  g_object_set (data->jitter_buffer, "do-lost", TRUE, "shared-timer",
+      shared_timer, NULL);
   g_assert_cmpint (gst_element_set_state (data->jitter_buffer,
           GST_STATE_PLAYING), !=, GST_STATE_CHANGE_FAILURE);
 
@@ -547,6 +638,12 @@ setup_testharness (TestData * data)
   gst_mini_object_unref (obj);
 }
 
+static void
+setup_testharness (TestData * data)
+{
+  setup_testharness_full (data, FALSE);
+}
+
 static void
 destroy_testharness (TestData * data)
 {
@@ -641,6 +738,51 @@ verify_rtx_event (GstEvent * event, guint32 expected_seqnum,
   gst_event_unref (event);
 }
 
+GST_START_TEST (test_push_reordered_many)
+{
+  GstElement *jitterbuffer;
+  const guint num_buffers = 300;
+  GstClockTime tso = gst_util_uint64_scale (RTP_FRAME_SIZE, GST_SECOND, 8000);
+  GstBuffer *buffer;
+  guint i;
+
+  jitterbuffer = setup_jitterbuffer (0);
+  for (i = 0; i < num_buffers; i++) {
+    buffer = generate_test_buffer (i * tso, FALSE, i, i * RTP_FRAME_SIZE);
+    inbuffers = g_list_append (inbuffers, buffer);
+  }
+  fail_unless (start_jitterbuffer (jitterbuffer)
+      == GST_STATE_CHANGE_SUCCESS, "could not set to playing");
+
+  /* push buffers in blocks of 8 in reverse order, this makes the internal
+   * seqnum index grow. Keep buffer 100 for last so that it is far away from
+   * its neighbours. */
+  fail_unless (gst_pad_push (mysrcpad, inbuffers->data) == GST_FLOW_OK);
+  for (i = 1; i < num_buffers; i += 8) {
+    guint j;
+
+    for (j = MIN (i + 7, num_buffers - 1) + 1; j > i; j--) {
+      if (j - 1 == 100)
+        continue;
+      buffer = g_list_nth_data (inbuffers, j - 1);
+      fail_unless (gst_pad_push (mysrcpad, buffer) == GST_FLOW_OK);
+    }
+  }
+  buffer = g_list_nth_data (inbuffers, 100);
+  fail_unless (gst_pad_push (mysrcpad, buffer) == GST_FLOW_OK);
+
+  /* wait until all buffers are due, the check waits for the latency */
+  g_usleep (GST_TIME_AS_USECONDS (num_buffers * tso));
+
+  /* check the buffer list */
+  check_jitterbuffer_results (jitterbuffer, num_buffers);
+
+  /* cleanup */
+  cleanup_jitterbuffer (jitterbuffer);
+}
+
+GST_END_TEST;
+
 GST_START_TEST (test_only_one_lost_event_on_large_gaps)
 {
   TestData data;
@@ -846,6 +988,110 @@ GST_START_TEST (test_two_lost_one_arrives_in_time)
 
 GST_END_TEST;
 
+GST_START_TEST (test_lost_event_shared_timer)
+{
+  TestData data;
+  GstClockID id, test_id;
+  GstBuffer *in_buf, *out_buf;
+  GstEvent *out_event;
+  gint jb_latency_ms = 100;
+  GstClockTime buffer_time, now;
+  GstClock *clock;
+  gint b;
+  GstRTPBuffer rtp = GST_RTP_BUFFER_INIT;
+
+  setup_testharness_full (&data, TRUE);
+
+  g_object_set (data.jitter_buffer, "latency", jb_latency_ms, NULL);
+
+  /* the first buffer is pushed out by the deadline timer */
+  in_buf = generate_test_buffer (0 * GST_MSECOND, TRUE, 0, 0);
+  gst_test_clock_set_time (GST_TEST_CLOCK (data.clock), 0);
+  g_assert_cmpint (gst_pad_push (data.test_src_pad, in_buf), ==, GST_FLOW_OK);
+  gst_test_clock_wait_for_next_pending_id (GST_TEST_CLOCK (data.clock), &id);
+  now = jb_latency_ms * GST_MSECOND;
+  gst_test_clock_set_time (GST_TEST_CLOCK (data.clock), now);
+  test_id = gst_test_clock_process_next_clock_id (GST_TEST_CLOCK (data.clock));
+  g_assert (test_id == id);
+  gst_clock_id_unref (test_id);
+  gst_clock_id_unref (id);
+  out_buf = g_async_queue_pop (data.buf_queue);
+  g_assert (out_buf != NULL);
+  gst_buffer_unref (out_buf);
+
+  /* push some buffers arriving in perfect time */
+  for (b = 1; b < 3; b++) {
+    buffer_time = b * GST_MSECOND * 20;
+    in_buf = generate_test_buffer (buffer_time, TRUE, b, b * 160);
+    gst_test_clock_set_time (GST_TEST_CLOCK (data.clock), now + buffer_time);
+    g_assert_cmpint (gst_pad_push (data.test_src_pad, in_buf), ==, GST_FLOW_OK);
+
+    out_buf = g_async_queue_pop (data.buf_queue);
+    g_assert (out_buf != NULL);
+    g_assert_cmpint (GST_BUFFER_PTS (out_buf), ==, buffer_time);
+    gst_buffer_unref (out_buf);
+  }
+
+  /* hop over 2 packets */
+  b = 5;
+  buffer_time = b * GST_MSECOND * 20;
+  in_buf = generate_test_buffer (buffer_time, TRUE, b, b * 160);
+  g_assert_cmpint (gst_pad_push (data.test_src_pad, in_buf), ==, GST_FLOW_OK);
+
+  /* the timer service waits for the lost timer of buffer 3 */
+  gst_test_clock_wait_for_next_pending_id (GST_TEST_CLOCK (data.clock), &id);
+  g_assert_cmpint (gst_clock_id_get_time (id), ==,
+      (3 * GST_MSECOND * 20) + (jb_latency_ms * GST_MSECOND));
+  gst_test_clock_set_time (GST_TEST_CLOCK (data.clock),
+      gst_clock_id_get_time (id));
+  test_id = gst_test_clock_process_next_clock_id (GST_TEST_CLOCK (data.clock));
+  g_assert (test_id == id);
+  gst_clock_id_unref (test_id);
+  gst_clock_id_unref (id);
+
+  /* the timer fired and made a lost event for buffer 3 */
+  out_event = g_async_queue_pop (data.sink_event_queue);
+  g_assert (out_event != NULL);
+  g_assert_cmpint (data.lost_event_count, ==, 1);
+  verify_lost_event (out_event, 3, 3 * GST_MSECOND * 20, GST_MSECOND * 20,
+      FALSE);
+
+  /* a new clock moves the jitterbuffer to the timer service of that clock,
+   * the lost timer of buffer 4 is now waited for on the new clock */
+  clock = gst_test_clock_new ();
+  gst_test_clock_set_time (GST_TEST_CLOCK (clock),
+      gst_clock_get_time (data.clock));
+  gst_element_set_clock (data.jitter_buffer, clock);
+
+  gst_test_clock_wait_for_next_pending_id (GST_TEST_CLOCK (clock), &id);
+  g_assert_cmpint (gst_clock_id_get_time (id), ==,
+      (4 * GST_MSECOND * 20) + (jb_latency_ms * GST_MSECOND));
+  gst_test_clock_set_time (GST_TEST_CLOCK (clock), gst_clock_id_get_time (id));
+  test_id = gst_test_clock_process_next_clock_id (GST_TEST_CLOCK (clock));
+  g_assert (test_id == id);
+  gst_clock_id_unref (test_id);
+  gst_clock_id_unref (id);
+
+  out_event = g_async_queue_pop (data.sink_event_queue);
+  g_assert (out_event != NULL);
+  g_assert_cmpint (data.lost_event_count, ==, 2);
+  verify_lost_event (out_event, 4, 4 * GST_MSECOND * 20, GST_MSECOND * 20,
+      FALSE);
+
+  /* and buffer 5 follows */
+  out_buf = g_async_queue_pop (data.buf_queue);
+  g_assert (out_buf != NULL);
+  gst_rtp_buffer_map (out_buf, GST_MAP_READ, &rtp);
+  g_assert_cmpint (gst_rtp_buffer_get_seq (&rtp), ==, 5);
+  gst_rtp_buffer_unmap (&rtp);
+  gst_buffer_unref (out_buf);
+
+  destroy_testharness (&data);
+  gst_object_unref (clock);
+}
+
+GST_END_TEST;
+
 GST_START_TEST (test_late_packets_still_makes_lost_events)
 {
   TestData data;
@@ -1399,6 +1645,62 @@ GST_START_TEST (test_rtx_packet_delay)
 
 GST_END_TEST;
 
+GST_START_TEST (test_rtx_reorder_after_discont)
+{
+  TestData data;
+  GstBuffer *in_buf;
+  GstEvent *out_event;
+  gint jb_latency_ms = 200;
+  gint i;
+
+  setup_testharness (&data);
+  g_object_set (data.jitter_buffer, "do-retransmission", TRUE, NULL);
+  g_object_set (data.jitter_buffer, "latency", jb_latency_ms, NULL);
+  g_object_set (data.jitter_buffer, "rtx-retry-period", 120, NULL);
+
+  gst_test_clock_set_time (GST_TEST_CLOCK (data.clock), 0);
+
+  /* push the first buffer in */
+  in_buf = generate_test_buffer (0 * GST_MSECOND, TRUE, 0, 0);
+  GST_BUFFER_FLAG_SET (in_buf, GST_BUFFER_FLAG_DISCONT);
+  g_assert_cmpint (gst_pad_push (data.test_src_pad, in_buf), ==, GST_FLOW_OK);
+
+  gst_test_clock_set_time (GST_TEST_CLOCK (data.clock), 20 * GST_MSECOND);
+
+  in_buf = generate_test_buffer (20 * GST_MSECOND, TRUE, 1, 160);
+  g_assert_cmpint (gst_pad_push (data.test_src_pad, in_buf), ==, GST_FLOW_OK);
+
+  /* push buffer 8, 2 -> 7 are missing and 2 -> 4 exceed the max allowed
+   * reorder distance, their retransmission is requested right away */
+  in_buf = generate_test_buffer (20 * GST_MSECOND, TRUE, 8, 8 * 160);
+  g_assert_cmpint (gst_pad_push (data.test_src_pad, in_buf), ==, GST_FLOW_OK);
+
+  out_event = g_async_queue_pop (data.src_event_queue);
+  g_assert (out_event != NULL);
+  verify_rtx_event (out_event, 2, 20 * GST_MSECOND, 40, 20 * GST_MSECOND);
+  for (i = 3; i < 5; i++) {
+    out_event = g_async_queue_pop (data.src_event_queue);
+    g_assert (out_event != NULL);
+    verify_rtx_event (out_event, i, 20 * GST_MSECOND, 0, 20 * GST_MSECOND);
+  }
+  g_assert_cmpint (data.rtx_event_count, ==, 3);
+
+  /* push 9 with the discont flag, all timers are checked again and 5 now
+   * exceeds the reorder distance */
+  in_buf = generate_test_buffer (20 * GST_MSECOND, TRUE, 9, 9 * 160);
+  GST_BUFFER_FLAG_SET (in_buf, GST_BUFFER_FLAG_DISCONT);
+  g_assert_cmpint (gst_pad_push (data.test_src_pad, in_buf), ==, GST_FLOW_OK);
+
+  out_event = g_async_queue_pop (data.src_event_queue);
+  g_assert (out_event != NULL);
+  verify_rtx_event (out_event, 5, 20 * GST_MSECOND, 0, 20 * GST_MSECOND);
+  g_assert_cmpint (data.rtx_event_count, ==, 4);
+
+  destroy_testharness (&data);
+}
+
+GST_END_TEST;
+
 static Suite *
 rtpjitterbuffer_suite (void)
 {
@@ -1409,15 +1711,20 @@ rtpjitterbuffer_suite (void)
   tcase_add_test (tc_chain, test_push_forward_seq);
   tcase_add_test (tc_chain, test_push_backward_seq);
   tcase_add_test (tc_chain, test_push_unordered);
+  tcase_add_test (tc_chain, test_push_reordered_many);
+  tcase_add_test (tc_chain, test_push_unordered_shared_timer);
+  tcase_add_test (tc_chain, test_push_consecutive_list);
   tcase_add_test (tc_chain, test_basetime);
   tcase_add_test (tc_chain, test_clear_pt_map);
   tcase_add_test (tc_chain, test_only_one_lost_event_on_large_gaps);
   tcase_add_test (tc_chain, test_two_lost_one_arrives_in_time);
+  tcase_add_test (tc_chain, test_lost_event_shared_timer);
   tcase_add_test (tc_chain, test_late_packets_still_makes_lost_events);
   tcase_add_test (tc_chain, test_all_packets_are_timestamped_zero);
   tcase_add_test (tc_chain, test_rtx_expected_next);
   tcase_add_test (tc_chain, test_rtx_two_missing);
   tcase_add_test (tc_chain, test_rtx_packet_delay);
+  tcase_add_test (tc_chain, test_rtx_reorder_after_discont);
 
   return s;
 }
@@ -1365,6 +1365,137 @@ GST_START_TEST (test_rtxsender_max_size_time)
 
 GST_END_TEST;
 
+static void
+rtxsender_push_seqnum (GstPad * pad, guint ssrc, guint16 seqnum)
+{
+  GstRTPBuffer rtp = GST_RTP_BUFFER_INIT;
+  GstBuffer *buffer;
+
+  buffer = gst_rtp_buffer_new_allocate (4, 0, 0);
+  gst_rtp_buffer_map (buffer, GST_MAP_WRITE, &rtp);
+  gst_rtp_buffer_set_ssrc (&rtp, ssrc);
+  gst_rtp_buffer_set_payload_type (&rtp, 96);
+  gst_rtp_buffer_set_seq (&rtp, seqnum);
+  gst_rtp_buffer_set_timestamp (&rtp, seqnum * 3000);
+  GST_WRITE_UINT16_BE (gst_rtp_buffer_get_payload (&rtp), seqnum);
+  gst_rtp_buffer_unmap (&rtp);
+
+  fail_unless_equals_int (gst_pad_push (pad, buffer), GST_FLOW_OK);
+}
+
+/* request @seqnum and, if @expected, wait until its retransmission got
+ * pushed out */
+static void
+rtxsender_request_seqnum (GstPad * pad, guint ssrc, guint16 seqnum,
+    gboolean expected)
+{
+  GList *last_out_buffer;
+  gboolean res = TRUE;
+
+  g_mutex_lock (&check_mutex);
+  last_out_buffer = g_list_last (buffers);
+  fail_unless_equals_int (gst_pad_push_event (pad,
+          create_rtx_event (seqnum, ssrc, 96)), TRUE);
+  if (expected) {
+    guint64 end_time = g_get_monotonic_time () + G_TIME_SPAN_SECOND;
+    GstRTPBuffer rtp = GST_RTP_BUFFER_INIT;
+
+    do
+      res = g_cond_wait_until (&check_cond, &check_mutex, end_time);
+    while (res == TRUE && last_out_buffer == g_list_last (buffers));
+    fail_unless_equals_int (res, TRUE);
+
+    gst_rtp_buffer_map (GST_BUFFER (g_list_last (buffers)->data),
+        GST_MAP_READ, &rtp);
+    fail_unless_equals_int (gst_rtp_buffer_get_payload_type (&rtp), 99);
+    fail_unless_equals_int (GST_READ_UINT16_BE (gst_rtp_buffer_get_payload
+            (&rtp)), seqnum);
+    gst_rtp_buffer_unmap (&rtp);
+  }
+  g_mutex_unlock (&check_mutex);
+}
+
+GST_START_TEST (test_rtxsender_seqnum_wrap_and_jumps)
+{
+  const guint ssrc = 1234567;
+  GstStructure *pt_map;
+  GstStructure *ssrc_map;
+  GstElement *rtxsend;
+  GstPad *srcpad, *sinkpad;
+  GstCaps *caps;
+  guint num_rtx_requests;
+  guint16 seqnum;
+
+  gst_check_drop_buffers ();
+
+  rtxsend = gst_check_setup_element ("rtprtxsend");
+
+  pt_map = gst_structure_new ("application/x-rtp-pt-map",
+      "96", G_TYPE_UINT, 99, NULL);
+  ssrc_map = gst_structure_new ("application/x-rtp-ssrc-map",
+      "1234567", G_TYPE_UINT, 7654321, NULL);
+  g_object_set (rtxsend, "max-size-packets", 10,
+      "payload-type-map", pt_map, "ssrc-map", ssrc_map, NULL);
+  gst_structure_free (pt_map);
+  gst_structure_free (ssrc_map);
+
+  srcpad = gst_check_setup_src_pad (rtxsend, &srctemplate);
+  fail_unless_equals_int (gst_pad_set_active (srcpad, TRUE), TRUE);
+
+  sinkpad = gst_check_setup_sink_pad (rtxsend, &sinktemplate);
+  fail_unless_equals_int (gst_pad_set_active (sinkpad, TRUE), TRUE);
+
+  ASSERT_SET_STATE (rtxsend, GST_STATE_PLAYING, GST_STATE_CHANGE_SUCCESS);
+
+  caps = gst_caps_from_string ("application/x-rtp, "
+      "media = (string)video, payload = (int)96, "
+      "ssrc = (uint)1234567, clock-rate = (int)90000, "
+      "encoding-name = (string)RAW");
+  gst_check_setup_events (srcpad, rtxsend, caps, GST_FORMAT_TIME);
+  gst_caps_unref (caps);
+
+  /* wrap around 65535 */
+  for (seqnum = 65530; seqnum != 5; seqnum++)
+    rtxsender_push_seqnum (srcpad, ssrc, seqnum);
+  rtxsender_request_seqnum (sinkpad, ssrc, 65532, TRUE);
+  rtxsender_request_seqnum (sinkpad, ssrc, 65535, TRUE);
+  rtxsender_request_seqnum (sinkpad, ssrc, 0, TRUE);
+  rtxsender_request_seqnum (sinkpad, ssrc, 4, TRUE);
+
+  /* a slightly late packet is not kept and does not disturb the history */
+  rtxsender_push_seqnum (srcpad, ssrc, 65520);
+  rtxsender_request_seqnum (sinkpad, ssrc, 65520, FALSE);
+  rtxsender_request_seqnum (sinkpad, ssrc, 3, TRUE);
+
+  /* a jump backwards restarts the history */
+  rtxsender_push_seqnum (srcpad, ssrc, 65000);
+  rtxsender_push_seqnum (srcpad, ssrc, 65001);
+  rtxsender_request_seqnum (sinkpad, ssrc, 4, FALSE);
+  rtxsender_request_seqnum (sinkpad, ssrc, 65000, TRUE);
+  rtxsender_request_seqnum (sinkpad, ssrc, 65001, TRUE);
+
+  /* and so does a jump of more than half the seqnum space forwards */
+  rtxsender_push_seqnum (srcpad, ssrc, 40000);
+  rtxsender_push_seqnum (srcpad, ssrc, 40001);
+  rtxsender_request_seqnum (sinkpad, ssrc, 65001, FALSE);
+  rtxsender_request_seqnum (sinkpad, ssrc, 40000, TRUE);
+  rtxsender_request_seqnum (sinkpad, ssrc, 40001, TRUE);
+
+  /* the retransmissions are pushed in order, so once the last expected one
+   * arrived the unexpected ones would have been pushed out as well */
+  g_object_get (rtxsend, "num-rtx-requests", &num_rtx_requests, NULL);
+  fail_unless_equals_int (num_rtx_requests, 12);
+  fail_unless_equals_int (g_list_length (buffers), 11 + 1 + 4 + 9);
+
+  gst_check_drop_buffers ();
+
+  gst_check_teardown_src_pad (rtxsend);
+  gst_check_teardown_sink_pad (rtxsend);
+  gst_check_teardown_element (rtxsend);
+}
+
+GST_END_TEST;
+
 static void
 compare_rtp_packets (GstBuffer * a, GstBuffer * b)
 {
@@ -1506,6 +1637,7 @@ rtprtx_suite (void)
   tcase_add_test (tc_chain, test_drop_multiple_sender);
   tcase_add_test (tc_chain, test_rtxsender_max_size_packets);
   tcase_add_test (tc_chain, test_rtxsender_max_size_time);
+  tcase_add_test (tc_chain, test_rtxsender_seqnum_wrap_and_jumps);
   tcase_add_test (tc_chain, test_rtxreceive_data_reconstruction);
 
   return s;
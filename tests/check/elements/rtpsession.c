@@ -404,6 +404,63 @@ GST_START_TEST (test_multiple_senders_roundrobin_rbs)
 
 GST_END_TEST;
 
+static GstFlowReturn
+test_rtp_sink_pad_chain_list_cb (GstPad * pad, GstObject * parent,
+    GstBufferList * list)
+{
+  GAsyncQueue *queue = gst_pad_get_element_private (pad);
+  g_async_queue_push (queue, list);
+  GST_DEBUG ("chained list");
+  return GST_FLOW_OK;
+}
+
+GST_START_TEST (test_receive_buffer_list)
+{
+  TestData data;
+  GAsyncQueue *rtp_queue;
+  GstBufferList *list;
+  GstFlowReturn res;
+  guint i;
+
+  setup_testharness (&data, FALSE);
+
+  rtp_queue = g_async_queue_new_full ((GDestroyNotify) gst_mini_object_unref);
+  gst_pad_set_element_private (data.rtpsrc, rtp_queue);
+  gst_pad_set_chain_list_function (data.rtpsrc,
+      test_rtp_sink_pad_chain_list_cb);
+  g_assert (gst_pad_set_active (data.rtpsrc, TRUE));
+
+  list = gst_buffer_list_new ();
+  for (i = 0; i < 4; i++)
+    gst_buffer_list_add (list, generate_test_buffer (i * 20 * GST_MSECOND,
+            FALSE, i, i * 160, 0x01BADBAD));
+
+  res = gst_pad_push_list (data.src, list);
+  fail_unless_equals_int (res, GST_FLOW_OK);
+
+  /* the packets come out together, including the one held for probation */
+  list = g_async_queue_try_pop (rtp_queue);
+  fail_unless (list != NULL);
+  fail_unless_equals_int (gst_buffer_list_length (list), 4);
+  for (i = 0; i < 4; i++) {
+    GstRTPBuffer rtp = GST_RTP_BUFFER_INIT;
+
+    fail_unless (gst_rtp_buffer_map (gst_buffer_list_get (list, i),
+            GST_MAP_READ, &rtp));
+    fail_unless_equals_int (gst_rtp_buffer_get_seq (&rtp), i);
+    gst_rtp_buffer_unmap (&rtp);
+  }
+  gst_buffer_list_unref (list);
+  fail_unless (g_async_queue_try_pop (rtp_queue) == NULL);
+
+  g_assert (gst_pad_set_active (data.rtpsrc, FALSE));
+  g_async_queue_unref (rtp_queue);
+
+  destroy_testharness (&data);
+}
+
+GST_END_TEST;
+
 static Suite *
 gstrtpsession_suite (void)
 {
@@ -413,6 +470,7 @@ gstrtpsession_suite (void)
   suite_add_tcase (s, tc_chain);
   tcase_add_test (tc_chain, test_multiple_ssrc_rr);
   tcase_add_test (tc_chain, test_multiple_senders_roundrobin_rbs);
+  tcase_add_test (tc_chain, test_receive_buffer_list);
 
   return s;
 }
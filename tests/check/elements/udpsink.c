@@ -17,11 +17,29 @@
  * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
  * Boston, MA 02110-1301, USA.
  */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
 #include <gst/check/gstcheck.h>
 #include <gst/base/gstbasesink.h>
+#include <gio/gio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 
+#if defined (HAVE_SENDMMSG) && defined (__linux__)
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/udp.h>
+#ifndef UDP_SEGMENT
+#define UDP_SEGMENT 103
+#endif
+#ifndef SOL_UDP
+#define SOL_UDP 17
+#endif
+#endif
+
 #if 0
 static GstStaticPadTemplate srctemplate = GST_STATIC_PAD_TEMPLATE ("src",
     GST_PAD_SRC,
@@ -185,6 +203,215 @@ GST_START_TEST (test_udpsink_bufferlist)
 GST_END_TEST;
 #endif
 
+static GstStaticPadTemplate list_srctemplate = GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS_ANY);
+
+static GSocket *
+create_receiver (gint * port)
+{
+  GSocket *socket;
+  GInetAddress *ia;
+  GSocketAddress *sa;
+
+  socket = g_socket_new (G_SOCKET_FAMILY_IPV4, G_SOCKET_TYPE_DATAGRAM,
+      G_SOCKET_PROTOCOL_UDP, NULL);
+  fail_unless (socket != NULL);
+
+  ia = g_inet_address_new_loopback (G_SOCKET_FAMILY_IPV4);
+  sa = g_inet_socket_address_new (ia, 0);
+  fail_unless (g_socket_bind (socket, sa, TRUE, NULL));
+  g_object_unref (sa);
+  g_object_unref (ia);
+
+  sa = g_socket_get_local_address (socket, NULL);
+  *port = g_inet_socket_address_get_port (G_INET_SOCKET_ADDRESS (sa));
+  g_object_unref (sa);
+
+  return socket;
+}
+
+static guint
+receive_all (GSocket * socket, gsize expected_size)
+{
+  gchar data[2048];
+  guint n = 0;
+
+  g_socket_set_blocking (socket, FALSE);
+  while (g_socket_condition_timed_wait (socket, G_IO_IN,
+          G_USEC_PER_SEC / 2, NULL, NULL)) {
+    gssize res = g_socket_receive (socket, data, sizeof (data), NULL, NULL);
+
+    if (res < 0)
+      break;
+    fail_unless_equals_int (res, expected_size);
+    n++;
+  }
+  return n;
+}
+
+/* check if multiudpsink can use UDP segmentation offload: it needs to be
+ * built with sendmmsg() and the kernel needs to know UDP_SEGMENT */
+static gboolean
+udp_gso_supported (void)
+{
+#if defined (HAVE_SENDMMSG) && defined (__linux__)
+  gint fd, seg_size = 112, ret;
+
+  fd = socket (AF_INET, SOCK_DGRAM, 0);
+  if (fd < 0)
+    return FALSE;
+  ret = setsockopt (fd, SOL_UDP, UDP_SEGMENT, &seg_size, sizeof (seg_size));
+  close (fd);
+
+  return ret == 0;
+#else
+  return FALSE;
+#endif
+}
+
+static void
+multiudpsink_buffer_list_test (gboolean enable_gso)
+{
+  GstElement *sink;
+  GstPad *srcpad;
+  GstBufferList *list;
+  GSocket *recv1, *recv2;
+  GstStructure *stats;
+  guint64 packets_sent, bytes_sent, gso_packets_sent;
+  gchar *clients;
+  gint port1, port2, i;
+
+  recv1 = create_receiver (&port1);
+  recv2 = create_receiver (&port2);
+
+  sink = gst_check_setup_element ("multiudpsink");
+  clients = g_strdup_printf ("127.0.0.1:%d,127.0.0.1:%d", port1, port2);
+  g_object_set (sink, "clients", clients, "sync", FALSE,
+      "enable-gso", enable_gso, NULL);
+  g_free (clients);
+
+  srcpad = gst_check_setup_src_pad_by_name (sink, &list_srctemplate, "sink");
+  gst_pad_set_active (srcpad, TRUE);
+
+  gst_element_set_state (sink, GST_STATE_PLAYING);
+  gst_check_setup_events (srcpad, sink, NULL, GST_FORMAT_TIME);
+
+  /* each packet is made of a header and a payload memory */
+  list = gst_buffer_list_new ();
+  for (i = 0; i < 5; i++) {
+    GstBuffer *buf = gst_buffer_new_allocate (NULL, 12, NULL);
+
+    gst_buffer_memset (buf, 0, i, 12);
+    gst_buffer_append_memory (buf, gst_allocator_alloc (NULL, 100, NULL));
+    gst_buffer_list_add (list, buf);
+  }
+  fail_unless_equals_int (gst_pad_push_list (srcpad, list), GST_FLOW_OK);
+
+  fail_unless_equals_int (receive_all (recv1, 112), 5);
+  fail_unless_equals_int (receive_all (recv2, 112), 5);
+
+  g_signal_emit_by_name (sink, "get-stats", "127.0.0.1", port1, &stats);
+  fail_unless (gst_structure_get_uint64 (stats, "packets-sent", &packets_sent));
+  fail_unless (gst_structure_get_uint64 (stats, "bytes-sent", &bytes_sent));
+  fail_unless_equals_uint64 (packets_sent, 5);
+  fail_unless_equals_uint64 (bytes_sent, 5 * 112);
+  /* the 5 packets of the same size go in one segmentation offload send when
+   * it is enabled and available */
+  fail_unless (gst_structure_get_uint64 (stats, "gso-packets-sent",
+          &gso_packets_sent));
+  if (!enable_gso)
+    fail_unless_equals_uint64 (gso_packets_sent, 0);
+  else if (udp_gso_supported ())
+    fail_unless_equals_uint64 (gso_packets_sent, 5);
+  else
+    GST_INFO ("UDP segmentation offload not available, not checking it");
+  gst_structure_free (stats);
+
+  gst_element_set_state (sink, GST_STATE_NULL);
+  gst_check_teardown_pad_by_name (sink, "sink");
+  gst_check_teardown_element (sink);
+
+  g_object_unref (recv1);
+  g_object_unref (recv2);
+}
+
+GST_START_TEST (test_multiudpsink_buffer_list)
+{
+  multiudpsink_buffer_list_test (FALSE);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_multiudpsink_buffer_list_gso)
+{
+  multiudpsink_buffer_list_test (TRUE);
+}
+
+GST_END_TEST;
+
+static void
+client_removed_cb (GstElement * sink, const gchar * host, gint port,
+    GstStructure ** stats)
+{
+  fail_unless (*stats == NULL);
+  g_signal_emit_by_name (sink, "get-stats", host, port, stats);
+}
+
+GST_START_TEST (test_multiudpsink_client_removed_stats)
+{
+  GstElement *sink;
+  GstPad *srcpad;
+  GSocket *recv;
+  GstStructure *stats = NULL;
+  guint64 packets_sent = 0, bytes_sent = 0, disconnect_time = 0;
+  gint port;
+
+  recv = create_receiver (&port);
+
+  sink = gst_check_setup_element ("multiudpsink");
+  g_object_set (sink, "sync", FALSE, NULL);
+  g_signal_emit_by_name (sink, "add", "127.0.0.1", port, NULL);
+  g_signal_connect (sink, "client-removed", (GCallback) client_removed_cb,
+      &stats);
+
+  srcpad = gst_check_setup_src_pad_by_name (sink, &list_srctemplate, "sink");
+  gst_pad_set_active (srcpad, TRUE);
+
+  gst_element_set_state (sink, GST_STATE_PLAYING);
+  gst_check_setup_events (srcpad, sink, NULL, GST_FORMAT_TIME);
+
+  fail_unless_equals_int (gst_pad_push (srcpad,
+          gst_buffer_new_allocate (NULL, 100, NULL)), GST_FLOW_OK);
+  fail_unless_equals_int (receive_all (recv, 100), 1);
+
+  /* the handler can still get the final statistics of the client */
+  g_signal_emit_by_name (sink, "remove", "127.0.0.1", port, NULL);
+  fail_unless (stats != NULL);
+  fail_unless (gst_structure_get_uint64 (stats, "packets-sent", &packets_sent));
+  fail_unless (gst_structure_get_uint64 (stats, "bytes-sent", &bytes_sent));
+  fail_unless (gst_structure_get_uint64 (stats, "disconnect-time",
+          &disconnect_time));
+  fail_unless_equals_uint64 (packets_sent, 1);
+  fail_unless_equals_uint64 (bytes_sent, 100);
+  fail_unless (disconnect_time != 0);
+  gst_structure_free (stats);
+
+  /* and afterwards it is gone */
+  g_signal_emit_by_name (sink, "get-stats", "127.0.0.1", port, &stats);
+  fail_if (gst_structure_has_field (stats, "packets-sent"));
+  gst_structure_free (stats);
+
+  gst_element_set_state (sink, GST_STATE_NULL);
+  gst_check_teardown_pad_by_name (sink, "sink");
+  gst_check_teardown_element (sink);
+
+  g_object_unref (recv);
+}
+
+GST_END_TEST;
+
 /*
  * Creates the test suite.
  *
@@ -201,6 +428,9 @@ udpsink_suite (void)
   tcase_set_timeout (tc_chain, 60);
 
   suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_multiudpsink_buffer_list);
+  tcase_add_test (tc_chain, test_multiudpsink_buffer_list_gso);
+  tcase_add_test (tc_chain, test_multiudpsink_client_removed_stats);
 #if 0
   tcase_add_test (tc_chain, test_udpsink);
   tcase_add_test (tc_chain, test_udpsink_bufferlist);
@@ -19,6 +19,7 @@
 #include <gst/check/gstcheck.h>
 #include <gio/gio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 
 static GstStaticPadTemplate sinktemplate = GST_STATIC_PAD_TEMPLATE ("sink",
@@ -109,6 +110,314 @@ GST_START_TEST (test_udpsrc_empty_packet)
 
 GST_END_TEST;
 
+GST_START_TEST (test_udpsrc_batch)
+{
+  GstElement *udpsrc;
+  GSocket *socket;
+  GstPad *sinkpad;
+  guint batch_size = 0;
+  int port = 0;
+
+  udpsrc = gst_check_setup_element ("udpsrc");
+  fail_unless (udpsrc != NULL);
+  g_object_set (udpsrc, "port", 0, "batch-size", 8, NULL);
+  g_object_get (udpsrc, "batch-size", &batch_size, NULL);
+  fail_unless_equals_int (batch_size, 8);
+
+  sinkpad = gst_check_setup_sink_pad_by_name (udpsrc, &sinktemplate, "src");
+  fail_unless (sinkpad != NULL);
+  gst_pad_set_active (sinkpad, TRUE);
+
+  gst_element_set_state (udpsrc, GST_STATE_PLAYING);
+  g_object_get (udpsrc, "port", &port, NULL);
+  GST_INFO ("udpsrc port = %d", port);
+
+  socket = g_socket_new (G_SOCKET_FAMILY_IPV4, G_SOCKET_TYPE_DATAGRAM,
+      G_SOCKET_PROTOCOL_UDP, NULL);
+
+  if (socket != NULL) {
+    GSocketAddress *sa;
+    GInetAddress *ia;
+    gchar data[32];
+    guint i, sent = 0;
+
+    ia = g_inet_address_new_loopback (G_SOCKET_FAMILY_IPV4);
+    sa = g_inet_socket_address_new (ia, port);
+
+    /* send more datagrams than fit in one batch, with varying sizes */
+    for (i = 0; i < 20; i++) {
+      memset (data, i, sizeof (data));
+      if (g_socket_send_to (socket, sa, data, 1 + i, NULL, NULL) == 1 + i)
+        sent++;
+    }
+    GST_INFO ("sent %u datagrams", sent);
+
+    g_usleep (G_USEC_PER_SEC / 2);
+
+    fail_unless_equals_int (g_list_length (buffers), sent);
+    for (i = 0; i < sent; i++) {
+      GstBuffer *buf = GST_BUFFER (g_list_nth_data (buffers, i));
+      GstMapInfo map;
+
+      gst_buffer_map (buf, &map, GST_MAP_READ);
+      fail_unless_equals_int (map.size, 1 + i);
+      fail_unless_equals_int (map.data[0], i);
+      fail_unless_equals_int (map.data[map.size - 1], i);
+      gst_buffer_unmap (buf, &map);
+    }
+
+    g_object_unref (sa);
+    g_object_unref (ia);
+  } else {
+    GST_WARNING ("Could not create IPv4 UDP socket for unit test");
+  }
+
+  gst_element_set_state (udpsrc, GST_STATE_NULL);
+
+  gst_check_teardown_pad_by_name (udpsrc, "src");
+  gst_check_teardown_element (udpsrc);
+
+  if (socket)
+    g_object_unref (socket);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_udpsrc_batch_large_datagrams)
+{
+  GstElement *udpsrc;
+  GSocket *socket;
+  GstPad *sinkpad;
+  int port = 0;
+
+  udpsrc = gst_check_setup_element ("udpsrc");
+  fail_unless (udpsrc != NULL);
+  g_object_set (udpsrc, "port", 0, "batch-size", 4, NULL);
+
+  sinkpad = gst_check_setup_sink_pad_by_name (udpsrc, &sinktemplate, "src");
+  fail_unless (sinkpad != NULL);
+  gst_pad_set_active (sinkpad, TRUE);
+
+  gst_element_set_state (udpsrc, GST_STATE_PLAYING);
+  g_object_get (udpsrc, "port", &port, NULL);
+  GST_INFO ("udpsrc port = %d", port);
+
+  /* only applied when the socket is opened again */
+  g_object_set (udpsrc, "batch-size", 64, NULL);
+
+  socket = g_socket_new (G_SOCKET_FAMILY_IPV4, G_SOCKET_TYPE_DATAGRAM,
+      G_SOCKET_PROTOCOL_UDP, NULL);
+
+  if (socket != NULL) {
+    GSocketAddress *sa;
+    GInetAddress *ia;
+    static const gsize sizes[] = { 10, 4000, 20, 3000, 9000, 30, 40, 50 };
+    static const guint again[] = { 1, 3, 4 };
+    gchar *data;
+    guint i, idx, n_buffers, received = 0, sent = 0;
+    gint last = -1;
+
+    ia = g_inet_address_new_loopback (G_SOCKET_FAMILY_IPV4);
+    sa = g_inet_socket_address_new (ia, port);
+
+    /* datagrams bigger than the batch slots, in the same batch as small
+     * ones */
+    data = g_malloc (9000);
+    for (i = 0; i < G_N_ELEMENTS (sizes); i++) {
+      memset (data, i, sizes[i]);
+      if (g_socket_send_to (socket, sa, data, sizes[i], NULL,
+              NULL) == sizes[i])
+        sent |= 1 << i;
+    }
+    GST_INFO ("sent datagrams 0x%x", sent);
+
+    g_usleep (G_USEC_PER_SEC / 2);
+
+    /* the spill area holds the rest of one datagram per batch, so a big
+     * datagram followed by a bigger one in the same batch can be dropped.
+     * All other datagrams are received intact and in order */
+    n_buffers = g_list_length (buffers);
+    for (i = 0; i < n_buffers; i++) {
+      GstBuffer *buf = GST_BUFFER (g_list_nth_data (buffers, i));
+      GstMemory *mem;
+      GstMapInfo map;
+
+      gst_buffer_map (buf, &map, GST_MAP_READ);
+      idx = map.data[0];
+      fail_unless (idx < G_N_ELEMENTS (sizes));
+      fail_unless ((gint) idx > last);
+      fail_unless_equals_int (map.size, sizes[idx]);
+      fail_unless_equals_int (map.data[map.size - 1], idx);
+      gst_buffer_unmap (buf, &map);
+      last = idx;
+      received |= 1 << idx;
+
+      /* every buffer only holds on to the memory of its own datagram */
+      fail_unless_equals_int (gst_buffer_n_memory (buf), 1);
+      mem = gst_buffer_peek_memory (buf, 0);
+      fail_unless (mem->parent == NULL);
+      fail_unless (mem->maxsize < 4 * MAX (sizes[idx], 1500));
+    }
+    for (i = 0; i < G_N_ELEMENTS (sizes); i++) {
+      if (sizes[i] <= 1500 || sizes[i] == 9000)
+        fail_unless_equals_int (received & (1 << i), sent & (1 << i));
+    }
+    gst_check_drop_buffers ();
+
+    /* the slots were grown, now the big datagrams all fit */
+    sent = 0;
+    for (i = 0; i < G_N_ELEMENTS (again); i++) {
+      idx = again[i];
+      memset (data, idx, sizes[idx]);
+      if (g_socket_send_to (socket, sa, data, sizes[idx], NULL,
+              NULL) == sizes[idx])
+        sent++;
+    }
+    g_free (data);
+
+    g_usleep (G_USEC_PER_SEC / 2);
+
+    fail_unless_equals_int (g_list_length (buffers), sent);
+    for (i = 0; i < sent; i++) {
+      GstBuffer *buf = GST_BUFFER (g_list_nth_data (buffers, i));
+      GstMapInfo map;
+
+      idx = again[i];
+      gst_buffer_map (buf, &map, GST_MAP_READ);
+      fail_unless_equals_int (map.size, sizes[idx]);
+      fail_unless_equals_int (map.data[0], idx);
+      fail_unless_equals_int (map.data[map.size - 1], idx);
+      gst_buffer_unmap (buf, &map);
+    }
+
+    g_object_unref (sa);
+    g_object_unref (ia);
+  } else {
+    GST_WARNING ("Could not create IPv4 UDP socket for unit test");
+  }
+
+  gst_element_set_state (udpsrc, GST_STATE_NULL);
+
+  gst_check_teardown_pad_by_name (udpsrc, "src");
+  gst_check_teardown_element (udpsrc);
+
+  if (socket)
+    g_object_unref (socket);
+}
+
+GST_END_TEST;
+
+static GMutex probe_lock;
+static GCond probe_cond;
+static gboolean probe_blocked;
+
+/* hold back the streaming thread after the first buffer, so that the next
+ * datagram is read well after the kernel received it */
+static GstPadProbeReturn
+delay_read_probe (GstPad * pad, GstPadProbeInfo * info, gpointer user_data)
+{
+  g_mutex_lock (&probe_lock);
+  probe_blocked = TRUE;
+  g_cond_signal (&probe_cond);
+  g_mutex_unlock (&probe_lock);
+
+  g_usleep (G_USEC_PER_SEC / 5);
+
+  return GST_PAD_PROBE_REMOVE;
+}
+
+GST_START_TEST (test_udpsrc_kernel_timestamps)
+{
+  GstElement *udpsrc;
+  GSocket *socket;
+  GstClock *clock;
+  GstPad *sinkpad, *srcpad;
+  int port = 0;
+
+  udpsrc = gst_check_setup_element ("udpsrc");
+  fail_unless (udpsrc != NULL);
+  g_object_set (udpsrc, "port", 0, "kernel-timestamps", TRUE, NULL);
+
+  clock = gst_system_clock_obtain ();
+  gst_element_set_clock (udpsrc, clock);
+  gst_element_set_base_time (udpsrc, gst_clock_get_time (clock));
+
+  sinkpad = gst_check_setup_sink_pad_by_name (udpsrc, &sinktemplate, "src");
+  fail_unless (sinkpad != NULL);
+  gst_pad_set_active (sinkpad, TRUE);
+
+  probe_blocked = FALSE;
+  srcpad = gst_element_get_static_pad (udpsrc, "src");
+  gst_pad_add_probe (srcpad, GST_PAD_PROBE_TYPE_BUFFER, delay_read_probe,
+      NULL, NULL);
+  gst_object_unref (srcpad);
+
+  gst_element_set_state (udpsrc, GST_STATE_PLAYING);
+  g_object_get (udpsrc, "port", &port, NULL);
+  GST_INFO ("udpsrc port = %d", port);
+
+  socket = g_socket_new (G_SOCKET_FAMILY_IPV4, G_SOCKET_TYPE_DATAGRAM,
+      G_SOCKET_PROTOCOL_UDP, NULL);
+
+  if (socket != NULL) {
+    GSocketAddress *sa;
+    GInetAddress *ia;
+    GstClockTime sent_time;
+    GstBuffer *buf;
+    gchar data[16] = { 0, };
+
+    ia = g_inet_address_new_loopback (G_SOCKET_FAMILY_IPV4);
+    sa = g_inet_socket_address_new (ia, port);
+
+    fail_unless_equals_int (g_socket_send_to (socket, sa, data,
+            sizeof (data), NULL, NULL), sizeof (data));
+
+    /* send the second datagram while the streaming thread is held back */
+    g_mutex_lock (&probe_lock);
+    while (!probe_blocked)
+      g_cond_wait (&probe_cond, &probe_lock);
+    g_mutex_unlock (&probe_lock);
+
+    sent_time = gst_clock_get_time (clock) - gst_element_get_base_time (udpsrc);
+    fail_unless_equals_int (g_socket_send_to (socket, sa, data,
+            sizeof (data), NULL, NULL), sizeof (data));
+
+    g_usleep (G_USEC_PER_SEC / 2);
+
+    fail_unless_equals_int (g_list_length (buffers), 2);
+    buf = GST_BUFFER (g_list_nth_data (buffers, 1));
+
+    /* the DTS is the time the kernel received the datagram, the PTS is the
+     * time it was read, after the probe let go */
+    fail_unless (GST_BUFFER_DTS_IS_VALID (buf));
+    fail_unless (GST_BUFFER_PTS_IS_VALID (buf));
+    GST_INFO ("sent %" GST_TIME_FORMAT ", DTS %" GST_TIME_FORMAT ", PTS %"
+        GST_TIME_FORMAT, GST_TIME_ARGS (sent_time),
+        GST_TIME_ARGS (GST_BUFFER_DTS (buf)),
+        GST_TIME_ARGS (GST_BUFFER_PTS (buf)));
+    /* allow for the error in the conversion from the kernel clock */
+    fail_unless (GST_BUFFER_DTS (buf) + 10 * GST_MSECOND >= sent_time);
+    fail_unless (GST_BUFFER_DTS (buf) + 100 * GST_MSECOND <
+        GST_BUFFER_PTS (buf));
+
+    g_object_unref (sa);
+    g_object_unref (ia);
+  } else {
+    GST_WARNING ("Could not create IPv4 UDP socket for unit test");
+  }
+
+  gst_element_set_state (udpsrc, GST_STATE_NULL);
+
+  gst_check_teardown_pad_by_name (udpsrc, "src");
+  gst_check_teardown_element (udpsrc);
+
+  gst_object_unref (clock);
+  if (socket)
+    g_object_unref (socket);
+}
+
+GST_END_TEST;
+
 static Suite *
 udpsrc_suite (void)
 {
@@ -117,6 +426,9 @@ udpsrc_suite (void)
 
   suite_add_tcase (s, tc_chain);
   tcase_add_test (tc_chain, test_udpsrc_empty_packet);
+  tcase_add_test (tc_chain, test_udpsrc_batch);
+  tcase_add_test (tc_chain, test_udpsrc_batch_large_datagrams);
+  tcase_add_test (tc_chain, test_udpsrc_kernel_timestamps);
   return s;
 }
 